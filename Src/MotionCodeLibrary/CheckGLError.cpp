@@ -22,7 +22,7 @@
 /****************************************************************************/
 #include "CheckGLError.h"
 #include "Assert2.h"
-#include <gl\glew.h>
+#include <GL/glew.h>
 //#include <GL/glut.h>
 #include <sstream>
 #include <iostream>
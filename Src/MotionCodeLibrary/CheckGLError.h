@@ -23,7 +23,8 @@
 #ifndef _CheckGLError_h_
 #define _CheckGLError_h_
 
-#include "Assert.h"
+#include <assert.h>
+#include "Assert2.h"
 
 /**
  * This macro checks for gl errors using glGetError, it is useful to sprinkle it around the code base, especially
@@ -15,6 +15,7 @@
 #include "math3d.h"
 #include "Logger.h"
 
+
 // Scale all the elements of a matrix.
 void MatrixScale(FBMatrix& pMatrix, double pValue)
 {
@@ -53,6 +54,40 @@ void MatrixAdd(FBMatrix& pDstMatrix, FBMatrix& pSrcMatrix)
     }
 }
 
+// Link deformation matrix for the current cluster index, returns false when link has no model
+static bool ComputeLinkMatrix(FBCluster *pCluster, const int n, FBMatrix &tm)
+{
+	FBModel *linkModel = pCluster->LinkGetModel(n);
+	if (linkModel == nullptr)
+	{
+		return false;
+	}
+
+	FBModel *linkAssociateModel = pCluster->LinkGetAssociateModel(n);
+
+	FBMatrix m, m2;
+	FBVector3d temp;
+	FBRVector rot;
+	FBSVector scale;
+
+	pCluster->VertexGetTransform(temp, rot, scale);
+	FBTVector pos(temp[0], temp[1], temp[2], 1.0);
+	//scale = FBSVector(1.0, 1.0, 1.0);
+	FBTRSToMatrix( tm, pos, rot, scale );
+	//FBMatrixInverse( tm, tm );
+
+	linkModel->GetMatrix( m, kModelTransformation_Geometry );
+			
+	if (linkAssociateModel)
+	{
+		linkAssociateModel->GetMatrix( m2, kModelTransformation_Geometry );
+		FBMatrixMult( m, m2, m );
+	}
+
+	FBMatrixMult( tm, m, tm );
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // LinkedVertex
 
@@ -62,9 +97,9 @@ void LinkedVertex::SetVertex( FBVertex _pos, FBNormal _nor )
 	nor = _nor;
 }
 
-void LinkedVertex::AddVertexLink(FBMatrix tm, FBMatrix tmInvTranspose, const double weight, const FBClusterMode mode)
+void LinkedVertex::AddVertexLink(const int bone, const double weight)
 {
-	links.push_back( Link(tm, tmInvTranspose, weight, mode) );
+	links.push_back( Link(bone, weight) );
 }
 
 
@@ -80,7 +115,7 @@ void LinkedVertex::NormalizeWeights()
 		links[i].weight = links[i].weight / total;
 }
 	
-FBMatrix LinkedVertex::CalculateDeformedPositionMatrix()
+FBMatrix LinkedVertex::CalculateDeformedPositionMatrix(const ClusterBone *bones)
 {
 	double total=0.0;
 
@@ -90,7 +125,8 @@ FBMatrix LinkedVertex::CalculateDeformedPositionMatrix()
 	{
 		
 		double lWeight = links[i].weight;
-		const FBClusterMode mode = links[i].mode;
+		const ClusterBone &bone = bones[links[i].bone];
+		const FBClusterMode mode = bone.mode;
 
 		if (lWeight == 0.0)
 		{
@@ -98,7 +134,7 @@ FBMatrix LinkedVertex::CalculateDeformedPositionMatrix()
 		}
 		
 		// Compute the influence of the link on the vertex
-		FBMatrix lInfluence = links[i].tm;
+		FBMatrix lInfluence = bone.tm;
 		
 		const double lScale = lWeight * 100000.0;
 		MatrixScale(lInfluence, lScale);
@@ -130,12 +166,12 @@ FBMatrix LinkedVertex::CalculateDeformedPositionMatrix()
 
 
 
-FBVertex LinkedVertex::CalculateDeformedPosition()
+FBVertex LinkedVertex::CalculateDeformedPosition(const ClusterBone *bones)
 {
 
 	FBVertex vertex, linkVertex;
 
-	FBMatrix tm = CalculateDeformedPositionMatrix();
+	FBMatrix tm = CalculateDeformedPositionMatrix(bones);
 	FBMatrixInverse( tm, tm );
 	//tm = MatrixInvert(tm);
 
@@ -144,13 +180,13 @@ FBVertex LinkedVertex::CalculateDeformedPosition()
 	return vertex;
 }
 
-FBMatrix LinkedVertex::CalculateDeformedNormalMatrix()
+FBMatrix LinkedVertex::CalculateDeformedNormalMatrix(const ClusterBone *bones)
 {
 	FBMatrix tm;
 
 	for (size_t i=0; i<links.size(); ++i)
 	{	
-		FBMatrix temp(links[i].tmInvTranspose);
+		FBMatrix temp(bones[links[i].bone].tmInvTranspose);
 
 		for (int ii=0; ii<4; ++ii)
 			for (int jj=0; jj<4; ++jj)
@@ -160,7 +196,7 @@ FBMatrix LinkedVertex::CalculateDeformedNormalMatrix()
 	return tm;
 }
 
-FBNormal LinkedVertex::CalculateDeformedNormal()
+FBNormal LinkedVertex::CalculateDeformedNormal(const ClusterBone *bones)
 {
 	FBNormal normal, linkNormal;
 	/*
@@ -174,7 +210,7 @@ FBNormal LinkedVertex::CalculateDeformedNormal()
  	}
 	*/
 
-	FBMatrix tm = CalculateDeformedNormalMatrix();
+	FBMatrix tm = CalculateDeformedNormalMatrix(bones);
 
 	FBVertexMatrixMult( normal, tm, nor );
 
@@ -229,59 +265,34 @@ bool ClusterAdvance::Init(FBModel *pModel)
 
 	if (pCluster && pCluster->LinkGetCount())
 	{
-		FBString linkName;
-		FBModel* linkModel;
-		FBModel		*linkAssociateModel;
 		int numLinks, numVerts, vertIndex;
 		double vertWeight;
 
-		FBMatrix m, m2, tm, tmInvTranspose, pLM;
-		FBTVector pos;
-		FBRVector rot, pDof;
-		FBSVector scale;
-		
 		numLinks = pCluster->LinkGetCount();
+		bones.resize(numLinks);
 
 		for (int n=0; n < numLinks; n++) 
 		{
 			pCluster->ClusterBegin(n);			// Set the current cluster index
 
-			linkName = pCluster->LinkGetName(n);
-			linkModel = pCluster->LinkGetModel(n);
+			ClusterBone &bone = bones[n];
 
-			if (linkModel == nullptr)
+			if (false == ComputeLinkMatrix(pCluster, n, bone.tm))
 			{
+				pCluster->ClusterEnd();
 				continue;
 			}
 
-			linkAssociateModel = pCluster->LinkGetAssociateModel(n);
-			FBClusterMode mode = static_cast<FBClusterMode>(pCluster->ClusterMode.AsInt());
+			bone.mode = static_cast<FBClusterMode>(pCluster->ClusterMode.AsInt());
 			/*
 			if (mode != kFBClusterAdditive)
 			{
 				printf ("only additive skinning is supported!\n" );
 			}
 			*/
-			FBVector3d temp;
-			pCluster->VertexGetTransform(temp, rot, scale);
-			pos = FBTVector(temp[0], temp[1], temp[2], 1.0);
-			//scale = FBSVector(1.0, 1.0, 1.0);
-			FBTRSToMatrix( tm, pos, rot, scale );
-			//FBMatrixInverse( tm, tm );
-
-			FBString linkModelName = linkModel->Name.AsString();
-			linkModel->GetMatrix( m, kModelTransformation_Geometry );
 			
-			if (linkAssociateModel)
-			{
-				linkAssociateModel->GetMatrix( m2, kModelTransformation_Geometry );
-				FBMatrixMult( m, m2, m );
-			}
-
-			FBMatrixMult( tm, m, tm );
-
-			FBMatrixInverse( tmInvTranspose, tm );
-			FBMatrixTranspose( tmInvTranspose, tmInvTranspose );
+			FBMatrixInverse( bone.tmInvTranspose, bone.tm );
+			FBMatrixTranspose( bone.tmInvTranspose, bone.tmInvTranspose );
 
 			numVerts = pCluster->VertexGetCount();	// Using the current cluster index
 			for (int v=0; v < numVerts; v++) 
@@ -289,7 +300,7 @@ bool ClusterAdvance::Init(FBModel *pModel)
 				vertIndex = pCluster->VertexGetNumber(v);		// Using the current cluster index
 				vertWeight = pCluster->VertexGetWeight(v);	// Using the current cluster index
 
-				vertices[vertIndex].AddVertexLink( tm, tmInvTranspose, vertWeight, mode );
+				vertices[vertIndex].AddVertexLink( n, vertWeight );
 
 			}
 			pCluster->ClusterEnd();			
@@ -310,10 +321,182 @@ void ClusterAdvance::Free()
 		delete [] vertices;
 		vertices = nullptr;
 	}
+	bones.clear();
 	count = 0;
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// SkinningEngine
+
+void SkinningEngine::Free()
+{
+	mModel = nullptr;
+	mVertexCount = 0;
+	mBoneCount = 0;
+
+	mPalette.clear();
+	mBoneIndices.clear();
+	mWeights.clear();
+}
+
+bool SkinningEngine::Init(FBModel *pModel)
+{
+	Free();
+
+	if (pModel == nullptr) return false;
+
+	FBGeometry *pGeometry = pModel->Geometry;
+	FBCluster *pCluster = pModel->Cluster;
+
+	if ( pGeometry == nullptr || pCluster == nullptr || pModel->SkeletonDeformable == false ) return false;
+
+	const int vertCount = pGeometry->VertexCount();
+	const int numLinks = pCluster->LinkGetCount();
+
+	if (vertCount == 0 || numLinks == 0) return false;
+
+	// the strongest influences of every vertex, sorted by weight
+
+	struct Influence
+	{
+		int		bone;
+		float	weight;
+	};
+
+	const Influence emptyInfluence = { numLinks, 0.0f };
+	std::vector<Influence>	influences(static_cast<size_t>(vertCount) * SKINNING_MAX_INFLUENCES, emptyInfluence);
+
+	for (int n=0; n < numLinks; ++n)
+	{
+		pCluster->ClusterBegin(n);
+
+		const FBClusterMode mode = static_cast<FBClusterMode>(pCluster->ClusterMode.AsInt());
+		if (mode == kFBClusterAdditive)
+		{
+			pCluster->ClusterEnd();
+			return false;
+		}
+
+		if (pCluster->LinkGetModel(n) == nullptr)
+		{
+			pCluster->ClusterEnd();
+			continue;
+		}
+
+		const int numVerts = pCluster->VertexGetCount();
+		for (int v=0; v < numVerts; ++v)
+		{
+			const int vertIndex = pCluster->VertexGetNumber(v);
+			const float weight = static_cast<float>(pCluster->VertexGetWeight(v));
+
+			if (vertIndex < 0 || vertIndex >= vertCount || weight <= 0.0f)
+				continue;
+
+			Influence *slots = &influences[static_cast<size_t>(vertIndex) * SKINNING_MAX_INFLUENCES];
+			if (weight <= slots[SKINNING_MAX_INFLUENCES-1].weight)
+				continue;
+
+			int pos = SKINNING_MAX_INFLUENCES-1;
+			while (pos > 0 && slots[pos-1].weight < weight)
+			{
+				slots[pos] = slots[pos-1];
+				--pos;
+			}
+			slots[pos].bone = n;
+			slots[pos].weight = weight;
+		}
+
+		pCluster->ClusterEnd();
+	}
+
+	// compact and normalized arrays
+
+	mBoneIndices.resize(influences.size());
+	mWeights.resize(influences.size());
+
+	for (int i=0; i<vertCount; ++i)
+	{
+		const Influence *slots = &influences[static_cast<size_t>(i) * SKINNING_MAX_INFLUENCES];
+		int *indices = &mBoneIndices[static_cast<size_t>(i) * SKINNING_MAX_INFLUENCES];
+		float *weights = &mWeights[static_cast<size_t>(i) * SKINNING_MAX_INFLUENCES];
+
+		float total = 0.0f;
+		for (int j=0; j<SKINNING_MAX_INFLUENCES; ++j)
+			total += slots[j].weight;
+
+		for (int j=0; j<SKINNING_MAX_INFLUENCES; ++j)
+		{
+			indices[j] = slots[j].bone;
+			weights[j] = (total > 0.0f) ? slots[j].weight / total : 0.0f;
+		}
+
+		// unweighted vertex follows the model
+		if (total <= 0.0f)
+		{
+			indices[0] = numLinks;
+			weights[0] = 1.0f;
+		}
+	}
+
+	mModel = pModel;
+	mVertexCount = vertCount;
+	mBoneCount = numLinks;
+	mPalette.resize(static_cast<size_t>(numLinks + 1) * 16);
+
+	UpdatePalette();
+	return true;
+}
+
+void SkinningEngine::UpdatePalette()
+{
+	if (mModel == nullptr)
+		return;
+
+	FBCluster *pCluster = mModel->Cluster;
+	FBMatrix tm, modelTM, invModelTM;
+
+	// the same link matrices as ClusterAdvance uses, they are moved into a model space like MoBu deformed arrays
+	//  palette = invModel * link * model, a blended palette is inverted per vertex in SkinningDeformRange
+	mModel->GetMatrix(modelTM);
+	FBMatrixInverse(invModelTM, modelTM);
+
+	for (int n=0; n <= mBoneCount; ++n)
+	{
+		tm.Identity();
+
+		if (n < mBoneCount)
+		{
+			pCluster->ClusterBegin(n);
+			if (ComputeLinkMatrix(pCluster, n, tm))
+			{
+				FBMatrixMult(tm, tm, modelTM);
+				FBMatrixMult(tm, invModelTM, tm);
+			}
+			pCluster->ClusterEnd();
+		}
+
+		// FBMatrix keeps a translation in elements 12-14, so 4 doubles in a row are a matrix column
+		float *dst = &mPalette[static_cast<size_t>(n) * 16];
+		for (int k=0; k<16; ++k)
+			dst[k] = static_cast<float>(tm[k]);
+	}
+}
+
+void SkinningEngine::Deform(const FBVertex *restPositions, const FBNormal *restNormals, FBVertex *positions, FBNormal *normals)
+{
+	if (false == IsReady() || restPositions == nullptr || positions == nullptr)
+		return;
+
+	SkinningData data;
+	data.palette = mPalette.data();
+	data.boneIndices = mBoneIndices.data();
+	data.weights = mWeights.data();
+	data.vertexCount = mVertexCount;
+
+	mDeformTime = SkinningDeform(data, (const float*) restPositions, (const float*) restNormals, (float*) positions, (float*) normals);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // Skin utilities
 
@@ -17,35 +17,40 @@
 #include <fbsdk/fbsdk.h>
 #include <vector>
 
+#include "SkinningKernel.h"
+
+//! link matrices are shared by all vertices of a cluster
+struct ClusterBone
+{
+	FBMatrix		tm;
+	FBMatrix		tmInvTranspose;
+	FBClusterMode	mode;
+};
+
 struct LinkedVertex
 {
 
 	struct Link
 	{
-		FBMatrix		tm;
-		FBMatrix		tmInvTranspose;
+		int				bone;		//!< index in a bones palette
 		double			weight;
 
-		FBClusterMode	mode;
-
 		//! a constructor
-		Link(FBMatrix _tm, FBMatrix _tmInvTranspose, const double _weight, const FBClusterMode _mode)
-			: tm(_tm)
-			, tmInvTranspose(_tmInvTranspose)
+		Link(const int _bone, const double _weight)
+			: bone(_bone)
 			, weight(_weight)
-			, mode(_mode)
 		{}
 
 	};
 
 	void		SetVertex(FBVertex _pos, FBNormal _nor);
-	void		AddVertexLink(FBMatrix tm, FBMatrix tmInvTranspose, const double weight, const FBClusterMode mode);
+	void		AddVertexLink(const int bone, const double weight);
 
-	FBMatrix	CalculateDeformedPositionMatrix();
-	FBMatrix	CalculateDeformedNormalMatrix();
+	FBMatrix	CalculateDeformedPositionMatrix(const ClusterBone *bones);
+	FBMatrix	CalculateDeformedNormalMatrix(const ClusterBone *bones);
 
-	FBVertex	CalculateDeformedPosition();
-	FBNormal	CalculateDeformedNormal();
+	FBVertex	CalculateDeformedPosition(const ClusterBone *bones);
+	FBNormal	CalculateDeformedNormal(const ClusterBone *bones);
 
 	void		NormalizeWeights();
 
@@ -71,17 +76,63 @@ public:
 
 	const int		GetVertexCount() { return count; }
 
-	FBMatrix		CalculateDeformedPositionMatrix(const int vertIndex) { return vertices[vertIndex].CalculateDeformedPositionMatrix(); }
-	FBMatrix		CalculateDeformedNormalMatrix(const int vertIndex) { return vertices[vertIndex].CalculateDeformedNormalMatrix(); }
+	FBMatrix		CalculateDeformedPositionMatrix(const int vertIndex) { return vertices[vertIndex].CalculateDeformedPositionMatrix(bones.data()); }
+	FBMatrix		CalculateDeformedNormalMatrix(const int vertIndex) { return vertices[vertIndex].CalculateDeformedNormalMatrix(bones.data()); }
 
-	FBVertex		CalculateDeformedPosition(const int vertIndex) { return vertices[vertIndex].CalculateDeformedPosition(); }
-	FBNormal		CalculateDeformedNormal(const int vertIndex) { return vertices[vertIndex].CalculateDeformedNormal(); }
+	FBVertex		CalculateDeformedPosition(const int vertIndex) { return vertices[vertIndex].CalculateDeformedPosition(bones.data()); }
+	FBNormal		CalculateDeformedNormal(const int vertIndex) { return vertices[vertIndex].CalculateDeformedNormal(bones.data()); }
 
 private:
 
-	int					count;
-	LinkedVertex		*vertices;
+	int							count;
+	LinkedVertex				*vertices;
+	std::vector<ClusterBone>	bones;
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+// SkinningEngine - linear blend skinning for baking a deformed geometry
+
+/**	
+*	bones are stored in a float palette, every vertex keeps up to SKINNING_MAX_INFLUENCES (index, weight) pairs.
+*	Palette keeps ClusterAdvance link matrices moved into a model space, blended matrix is inverted per vertex
+*	 like in LinkedVertex::CalculateDeformedPosition. Vertex ranges are deformed in parallel by SkinningDeform.
+*	Only normalize and total1 cluster modes are supported, Init returns false for additive clusters.
+*/
+class SkinningEngine
+{
+public:
+
+	//! collect bone links and per-vertex influences of a model cluster
+	bool			Init(FBModel *pModel);
+	void			Free();
+
+	bool			IsReady() const { return mVertexCount > 0; }
+
+	int				GetVertexCount() const { return mVertexCount; }
+	int				GetBoneCount() const { return mBoneCount; }
+
+	//! time of the last Deform call in milliseconds
+	double			GetDeformTime() const { return mDeformTime; }
+
+	//! recalculate bone matrices from current link transforms
+	void			UpdatePalette();
+
+	//! deform rest vertices (before deform arrays), result is in a model space like MoBu deformed arrays, normals are optional
+	void			Deform(const FBVertex *restPositions, const FBNormal *restNormals, FBVertex *positions, FBNormal *normals);
+
+protected:
+
+	FBModel					*mModel{ nullptr };
+
+	int						mVertexCount{ 0 };
+	int						mBoneCount{ 0 };		//!< cluster links, the last palette matrix is an identity for unweighted vertices
+	double					mDeformTime{ 0.0 };
 
+	std::vector<float>		mPalette;				//!< 16 floats per bone, column major
+	std::vector<int>		mBoneIndices;			//!< SKINNING_MAX_INFLUENCES per vertex
+	std::vector<float>		mWeights;				//!< sorted by weight, unused influences have zero weight
 };
 
 
@@ -46,7 +46,11 @@ class FileReadScope
 public:
 	FileReadScope(const char* filename)
 	{
+#ifdef _WIN32
 		fopen_s(&fp, filename, "r");
+#else
+		fp = fopen(filename, "r");
+#endif
 	}
 
 	~FileReadScope()
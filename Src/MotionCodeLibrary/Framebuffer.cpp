@@ -13,12 +13,29 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include	<stdio.h>
 
 #include	"FrameBuffer.h"
+#include	"RenderTargetPool.h"
 #include	"checkglerror.h"
 #include	"Logger.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // FrameBufferBase
 
+static void FilterToTexParameters(const int filter, GLenum &minFilter, GLenum &magFilter)
+{
+	minFilter = GL_LINEAR;
+	magFilter = GL_LINEAR;
+
+	if (filter == FrameBuffer::filterNearest)
+	{
+		minFilter = GL_NEAREST;
+		magFilter = GL_NEAREST;
+	}
+	else if (filter == FrameBuffer::filterMipmap)
+	{
+		minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	}
+}
+
 FrameBuffer::FrameBuffer( int theWidth, int theHeight, int theFlags, int numberOfColorAttachments )
 {
 	mWidth         = theWidth;
@@ -40,6 +57,7 @@ FrameBuffer::FrameBuffer( int theWidth, int theHeight, int theFlags, int numberO
 		mColorAttachments[i].clamp = GL_REPEAT;
 
 		mColorAttachments[i].deleteOnCleanup = true;
+		mColorAttachments[i].leased = false;
 	}
 
 	// default depth
@@ -52,6 +70,7 @@ FrameBuffer::FrameBuffer( int theWidth, int theHeight, int theFlags, int numberO
 	mDepthAttachment.filter = filterLinear;
 	mDepthAttachment.clamp = GL_REPEAT;
 	mDepthAttachment.deleteOnCleanup = true;
+	mDepthAttachment.leased = false;
 	
 	mStencilAttachment.id = 0;
 	mStencilAttachment.format = GL_LUMINANCE;
@@ -61,6 +80,7 @@ FrameBuffer::FrameBuffer( int theWidth, int theHeight, int theFlags, int numberO
 	mStencilAttachment.filter = filterLinear;
 	mStencilAttachment.clamp = GL_REPEAT;
 	mStencilAttachment.deleteOnCleanup = true;
+	mStencilAttachment.leased = false;
 }
 
 FrameBuffer::~FrameBuffer()
@@ -294,10 +314,27 @@ bool FrameBuffer::Create()
 			}
 			else
 			{
-				id = CreateTexture2D( mWidth, mHeight, mColorAttachments[i].format, mColorAttachments[i].internalFormat, mColorAttachments[i].type, 
-					&mColorAttachments[i].id, mColorAttachments[i].clamp, mColorAttachments[i].filter, false, IsFlag(eUnPackAlignment) );
-				mColorAttachments[i].deleteOnCleanup = false;
-				AttachTexture2D( mColorAttachments[i].target, mColorAttachments[i].target, id, type, true );
+				// a previous texture goes back to the pool first, a lease of the same size could take it back
+				CleanUpAttachment(mColorAttachments[i]);
+
+				if (mColorAttachments[i].id > 0)
+				{
+					// an external texture is still attached, its storage is specified in place
+					id = CreateTexture2D( mWidth, mHeight, mColorAttachments[i].format, mColorAttachments[i].internalFormat, mColorAttachments[i].type, 
+						&mColorAttachments[i].id, mColorAttachments[i].clamp, mColorAttachments[i].filter, false, IsFlag(eUnPackAlignment) );
+					mColorAttachments[i].deleteOnCleanup = false;
+					AttachTexture2D( mColorAttachments[i].target, mColorAttachments[i].target, id, type, true );
+				}
+				else
+				{
+					GLenum minFilter, magFilter;
+					FilterToTexParameters(mColorAttachments[i].filter, minFilter, magFilter);
+
+					id = RenderTargetPool::TheOne().LeaseTexture2D(mWidth, mHeight, mColorAttachments[i].format, mColorAttachments[i].internalFormat, 
+						mColorAttachments[i].type, mColorAttachments[i].clamp, minFilter, magFilter, IsFlag(eUnPackAlignment));
+					AttachTexture2D( mColorAttachments[i].target, mColorAttachments[i].target, id, type, false );
+					mColorAttachments[i].leased = true;
+				}
 			}
 			
 		}
@@ -320,9 +357,24 @@ bool FrameBuffer::Create()
 		}
 		else
 		{
-			id = CreateTexture2D(mWidth, mHeight, mDepthAttachment.format, mDepthAttachment.internalFormat, mDepthAttachment.type, &mDepthAttachment.id);
-			mDepthAttachment.deleteOnCleanup = false;
-			AttachTexture2D( mDepthAttachment.target, mDepthAttachment.target, id, eAttachmentTypeDepth, true );
+			CleanUpAttachment(mDepthAttachment);
+
+			if (mDepthAttachment.id > 0)
+			{
+				id = CreateTexture2D(mWidth, mHeight, mDepthAttachment.format, mDepthAttachment.internalFormat, mDepthAttachment.type, &mDepthAttachment.id);
+				mDepthAttachment.deleteOnCleanup = false;
+				AttachTexture2D( mDepthAttachment.target, mDepthAttachment.target, id, eAttachmentTypeDepth, true );
+			}
+			else
+			{
+				GLenum minFilter, magFilter;
+				FilterToTexParameters(mDepthAttachment.filter, minFilter, magFilter);
+
+				id = RenderTargetPool::TheOne().LeaseTexture2D(mWidth, mHeight, mDepthAttachment.format, mDepthAttachment.internalFormat, 
+					mDepthAttachment.type, mDepthAttachment.clamp, minFilter, magFilter);
+				AttachTexture2D( mDepthAttachment.target, mDepthAttachment.target, id, eAttachmentTypeDepth, false );
+				mDepthAttachment.leased = true;
+			}
 		}
 
 		// if we need additional stencil for that framebuffer
@@ -330,9 +382,10 @@ bool FrameBuffer::Create()
 		{
 			CleanUpAttachment(mStencilAttachment);
 
-			glGenRenderbuffers        ( 1, &mStencilAttachment.id );
-			glBindRenderbuffer       ( GL_RENDERBUFFER, mStencilAttachment.id );
-			glRenderbufferStorage    ( GL_RENDERBUFFER, mStencilAttachment.internalFormat, mWidth, mHeight );
+			mStencilAttachment.id = RenderTargetPool::TheOne().LeaseRenderbuffer(mWidth, mHeight, mStencilAttachment.internalFormat);
+			mStencilAttachment.target = GL_RENDERBUFFER;
+			mStencilAttachment.deleteOnCleanup = false;
+			mStencilAttachment.leased = true;
 			glFramebufferRenderbuffer ( GL_FRAMEBUFFER,  GL_STENCIL_ATTACHMENT,
 											GL_RENDERBUFFER, mStencilAttachment.id );
 		}
@@ -343,14 +396,12 @@ bool FrameBuffer::Create()
 		{
 			CleanUpAttachment(mDepthAttachment);
 
-			glGenRenderbuffers(1, &mDepthAttachment.id);
-			glBindRenderbuffer(GL_RENDERBUFFER, mDepthAttachment.id);
-			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mWidth, mHeight);
-			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+			mDepthAttachment.id = RenderTargetPool::TheOne().LeaseRenderbuffer(mWidth, mHeight, GL_DEPTH24_STENCIL8);
 
 			mDepthAttachment.internalFormat = GL_DEPTH24_STENCIL8;
 			mDepthAttachment.target = GL_RENDERBUFFER;
-			mDepthAttachment.deleteOnCleanup = true;
+			mDepthAttachment.deleteOnCleanup = false;
+			mDepthAttachment.leased = true;
 
 			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, 
 				GL_RENDERBUFFER, mDepthAttachment.id);
@@ -361,9 +412,10 @@ bool FrameBuffer::Create()
 			{
 				CleanUpAttachment(mDepthAttachment);
 
-				glGenRenderbuffers        ( 1, &mDepthAttachment.id );
-				glBindRenderbuffer        ( GL_RENDERBUFFER, mDepthAttachment.id );
-				glRenderbufferStorage     ( GL_RENDERBUFFER, mDepthAttachment.internalFormat, mWidth, mHeight );
+				mDepthAttachment.id = RenderTargetPool::TheOne().LeaseRenderbuffer(mWidth, mHeight, mDepthAttachment.internalFormat);
+				mDepthAttachment.target = GL_RENDERBUFFER;
+				mDepthAttachment.deleteOnCleanup = false;
+				mDepthAttachment.leased = true;
 				glFramebufferRenderbuffer ( GL_FRAMEBUFFER,  GL_DEPTH_ATTACHMENT,
 											   GL_RENDERBUFFER, mDepthAttachment.id );
 			}
@@ -372,9 +424,10 @@ bool FrameBuffer::Create()
 			{
 				CleanUpAttachment(mStencilAttachment);
 
-				glGenRenderbuffers        ( 1, &mStencilAttachment.id );
-				glBindRenderbuffer       ( GL_RENDERBUFFER, mStencilAttachment.id );
-				glRenderbufferStorage    ( GL_RENDERBUFFER, mStencilAttachment.internalFormat, mWidth, mHeight );
+				mStencilAttachment.id = RenderTargetPool::TheOne().LeaseRenderbuffer(mWidth, mHeight, mStencilAttachment.internalFormat);
+				mStencilAttachment.target = GL_RENDERBUFFER;
+				mStencilAttachment.deleteOnCleanup = false;
+				mStencilAttachment.leased = true;
 				glFramebufferRenderbuffer ( GL_FRAMEBUFFER,  GL_STENCIL_ATTACHMENT,
 											   GL_RENDERBUFFER, mStencilAttachment.id );
 			}
@@ -428,7 +481,24 @@ void FrameBuffer::Cleanup()
 
 void FrameBuffer::CleanUpAttachment( AttachmentObject &object )
 {
-	if (object.id > 0 && object.deleteOnCleanup)
+	if (object.id > 0 && object.leased)
+	{
+		RenderTargetPool& pool = RenderTargetPool::TheOne();
+		const bool released = (object.target == GL_RENDERBUFFER) ? pool.ReleaseRenderbuffer(object.id) : pool.ReleaseTexture(object.id);
+
+		// pool was cleared in between, the object is not tracked any more
+		if (false == released)
+		{
+			if (object.target == GL_RENDERBUFFER)
+				glDeleteRenderbuffers(1, &object.id);
+			else
+				glDeleteTextures(1, &object.id);
+		}
+
+		object.id = 0;
+		object.leased = false;
+	}
+	else if (object.id > 0 && object.deleteOnCleanup)
 	{
 		if (object.target == GL_RENDERBUFFER)
 			glDeleteRenderbuffers(1, &object.id);
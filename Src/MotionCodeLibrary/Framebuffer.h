@@ -242,6 +242,7 @@ protected:
 		GLenum		clamp;
 
 		bool		deleteOnCleanup;
+		bool		leased;			//!< object is taken from a RenderTargetPool and goes back there on cleanup
 	};
 	
 	
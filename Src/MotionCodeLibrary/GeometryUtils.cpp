@@ -17,12 +17,108 @@
 #include "CmdFBX.h"
 #include "Logger.h"
 
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
 const char *g_szDefaultUVSet = "DefaultUVSet";
 
+#define LINEAR_SKIN_TOLERANCE	0.001
+
+static double LinearSkinError(FBModelVertexData *pVertexData, const FBVertex *positions, const int vertCount);
+
+// bake a linear skin on CPU from rest arrays, vertex data mapping has to be requested
+// models with shapes or additive clusters keep using MoBu deformed arrays
+// result is compared with MoBu deformed positions (when MoBu has them), on a mismatch the bake is rejected
+static bool BakeLinearSkin(FBModel *pModel, FBModelVertexData *pVertexData, const int vertCount, std::vector<FBVertex> &positions, std::vector<FBNormal> *normals)
+{
+	FBGeometry *pGeometry = pModel->Geometry;
+	if (pGeometry == nullptr || pGeometry->ShapeGetCount() > 0)
+		return false;
+
+	SkinningEngine	skinning;
+	if (false == skinning.Init(pModel) || skinning.GetVertexCount() < vertCount)
+		return false;
+
+	const FBVertex *restPositions = (FBVertex*) pVertexData->GetVertexArray( kFBGeometryArrayID_Point, false );
+	const FBNormal *restNormals = (normals) ? (FBNormal*) pVertexData->GetVertexArray( kFBGeometryArrayID_Normal, false ) : nullptr;
+
+	if (restPositions == nullptr || (normals && restNormals == nullptr) )
+		return false;
+
+	positions.resize(skinning.GetVertexCount());
+	if (normals)
+		normals->resize(skinning.GetVertexCount());
+
+	skinning.Deform( restPositions, restNormals, positions.data(), (normals) ? normals->data() : nullptr );
+
+	LOGI( "skinning - %d vertices, %d bones, %.3f ms\n", skinning.GetVertexCount(), skinning.GetBoneCount(), skinning.GetDeformTime() );
+
+	const double error = LinearSkinError(pVertexData, positions.data(), vertCount);
+	if (error > LINEAR_SKIN_TOLERANCE)
+	{
+		LOGE( "skinning - %s differs from MoBu deformed positions (error %f), MoBu arrays are used\n", (const char*) pModel->LongName, error );
+		return false;
+	}
+	return true;
+}
+
+static double LinearSkinError(FBModelVertexData *pVertexData, const FBVertex *positions, const int vertCount)
+{
+	const FBVertex *restPositions = (FBVertex*) pVertexData->GetVertexArray( kFBGeometryArrayID_Point, false );
+	const FBVertex *deformedPositions = (FBVertex*) pVertexData->GetVertexArray( kFBGeometryArrayID_Point, true );
+
+	// MoBu has no deformed positions on CPU side, nothing to compare with
+	if (deformedPositions == nullptr || deformedPositions == restPositions)
+		return 0.0;
+
+	double maxError = 0.0;
+	for (int i=0; i<vertCount; ++i)
+	{
+		const FBVertex &a = positions[i];
+		const FBVertex &b = deformedPositions[i];
+
+		const double scale = (std::max)(1.0, (std::max)( fabs(b[0]), (std::max)(fabs(b[1]), fabs(b[2])) ));
+
+		for (int k=0; k<3; ++k)
+			maxError = (std::max)(maxError, fabs(a[k] - b[k]) / scale);
+	}
+	return maxError;
+}
+
+double LinearSkinError(FBModel *pModel)
+{
+	FBGeometry *pGeometry = pModel->Geometry;
+	FBModelVertexData *pVertexData = pModel->ModelVertexData;
+
+	if (pGeometry == nullptr || pVertexData == nullptr)
+		return -1.0;
+
+	pVertexData->VertexArrayMappingRequest();
+
+	const int vertCount = pGeometry->VertexCount();
+	std::vector<FBVertex>	positions;
+	double error = -1.0;
+
+	SkinningEngine	skinning;
+	const FBVertex *restPositions = (FBVertex*) pVertexData->GetVertexArray( kFBGeometryArrayID_Point, false );
+
+	if (restPositions && pGeometry->ShapeGetCount() == 0 && skinning.Init(pModel) && skinning.GetVertexCount() >= vertCount)
+	{
+		positions.resize(skinning.GetVertexCount());
+		skinning.Deform( restPositions, nullptr, positions.data(), nullptr );
+
+		error = LinearSkinError(pVertexData, positions.data(), vertCount);
+	}
+
+	pVertexData->VertexArrayMappingRelease();
+	return error;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //
 
-FBModel *MakeSnapshot(FBModel *pModel, const bool ResetXForm)
+FBModel *MakeSnapshot(FBModel *pModel, const bool ResetXForm, const bool CPUSkinning)
 {
 	FBGeometry *lGeom = pModel->Geometry;
 	FBMesh *lMesh = (FBMesh*) lGeom;
@@ -41,6 +137,15 @@ FBModel *MakeSnapshot(FBModel *pModel, const bool ResetXForm)
 	FBNormal *normals = (FBNormal*) pVertexData->GetVertexArray( kFBGeometryArrayID_Normal );
 	//FBUV	*uvs = (FBUV*) pVertexData->GetUVSetArray();
 
+	std::vector<FBVertex>	skinPositions;
+	std::vector<FBNormal>	skinNormals;
+
+	if (CPUSkinning && BakeLinearSkin(pModel, pVertexData, vertCountInMesh, skinPositions, &skinNormals) )
+	{
+		positions = skinPositions.data();
+		normals = skinNormals.data();
+	}
+
 	pVertexData->VertexArrayMappingRelease();
 
 	lMesh->GeometryBegin();
@@ -170,7 +275,7 @@ FBModel *MakeSnapshot(FBModel *pModel, const bool ResetXForm)
 	return pNewModel;
 }
 
-void FillInputModelData(FBModelList &modelList, InputModelData &data, FBArrayTemplate<FBMaterial*> &materialList, const bool DeformedPositions, const bool TransformedPositions)
+void FillInputModelData(FBModelList &modelList, InputModelData &data, FBArrayTemplate<FBMaterial*> &materialList, const bool DeformedPositions, const bool TransformedPositions, const bool CPUSkinning=false)
 {
 	int vertCountInMesh = 0;
 	int	materialIndexCount = 0;
@@ -281,6 +386,13 @@ void FillInputModelData(FBModelList &modelList, InputModelData &data, FBArrayTem
 		FBVertex *positions = (FBVertex*) pVertexData->GetVertexArray( kFBGeometryArrayID_Point, DeformedPositions );
 		FBVertex *lposition = (FBVertex*) &data.positions[vertCountInMesh].x[0];
 		
+		std::vector<FBVertex>	skinPositions;
+
+		if (DeformedPositions && CPUSkinning && BakeLinearSkin(pModel, pVertexData, lvertCountInMesh, skinPositions, nullptr) )
+		{
+			positions = skinPositions.data();
+		}
+
 		if ( TransformedPositions && (pModel->Deformers.GetCount() == 0) )
 		{
 			FBMatrix m;
@@ -685,7 +797,7 @@ FBModel *MakeSnapshot2( FBModel *pModel, const bool ResetXForm, const bool CopyS
 	FBModelList modelList;
 	modelList.Add(pModel);
 
-	FillInputModelData( modelList, data, materialList, true, false );
+	FillInputModelData( modelList, data, materialList, true, false, true );
 
 	//
 	//
@@ -32,7 +32,11 @@ void InvertNormals(FBModel *pModel);
 //
 
 // ResetXForm - bake base model transformation into the snapshot mesh or not ?
-FBModel *MakeSnapshot( FBModel *pModel, const bool ResetXForm );
+// CPUSkinning - bake skinned models with SkinningEngine, MoBu deformed arrays are used when the result doesn't match them
+FBModel *MakeSnapshot( FBModel *pModel, const bool ResetXForm, const bool CPUSkinning=false );
+
+// max relative difference between SkinningEngine and MoBu deformed positions, -1.0 if the model can't be skinned on CPU
+double LinearSkinError(FBModel *pModel);
 // more corrent snapshot using FBX SDK
 FBModel *MakeSnapshot2(FBModel *pModel, const bool ResetXForm, const bool CopyShaders );
 
@@ -0,0 +1,303 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "RenderTargetPool.h"
+#include <algorithm>
+
+#define RENDER_TARGET_POOL_BUDGET		(128 * 1024 * 1024)
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// RenderTargetPool
+
+static std::map<const void*, std::unique_ptr<RenderTargetPool>>& GetPools()
+{
+	static std::map<const void*, std::unique_ptr<RenderTargetPool>>	gPools;
+	return gPools;
+}
+
+const void* RenderTargetPool::GetCurrentContext()
+{
+#ifdef _WIN32
+	return wglGetCurrentContext();
+#else
+	return nullptr;
+#endif
+}
+
+RenderTargetPool& RenderTargetPool::TheOne()
+{
+	auto& pools = GetPools();
+	std::unique_ptr<RenderTargetPool>& pool = pools[GetCurrentContext()];
+
+	if (nullptr == pool)
+		pool.reset(new RenderTargetPool());
+	return *pool;
+}
+
+void RenderTargetPool::ForgetContext(const void* context)
+{
+	GetPools().erase(context);
+}
+
+RenderTargetPool::RenderTargetPool()
+	: mBudget(RENDER_TARGET_POOL_BUDGET)
+{}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	// there is no gl context on a library unload, objects go away with their context
+}
+
+bool RenderTargetPool::Key::operator < (const Key& other) const
+{
+	if (target != other.target) return target < other.target;
+	if (width != other.width) return width < other.width;
+	if (height != other.height) return height < other.height;
+	if (internalFormat != other.internalFormat) return internalFormat < other.internalFormat;
+	if (format != other.format) return format < other.format;
+	return type < other.type;
+}
+
+size_t RenderTargetPool::EstimateSize(const int width, const int height, const GLenum internalFormat)
+{
+	size_t bytesPerPixel = 4;
+
+	switch (internalFormat)
+	{
+	case GL_R8:
+	case GL_STENCIL_INDEX8:
+	case GL_ALPHA8:
+	case GL_LUMINANCE8:
+		bytesPerPixel = 1;
+		break;
+	case GL_RG8:
+	case GL_R16F:
+	case GL_R16:
+	case GL_DEPTH_COMPONENT16:
+		bytesPerPixel = 2;
+		break;
+	case GL_RGBA16F:
+	case GL_RGBA16:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		bytesPerPixel = 8;
+		break;
+	case GL_RGBA32F:
+	case GL_RGB32F:
+		bytesPerPixel = 16;
+		break;
+	default:
+		// 8 bit rgb(a), 32 bit depth and packed formats
+		bytesPerPixel = 4;
+	}
+
+	return static_cast<size_t>(width) * static_cast<size_t>(height) * bytesPerPixel;
+}
+
+GLuint RenderTargetPool::Lease(const Key& key, bool& isNew)
+{
+	mTick += 1;
+	mStats.numberOfLeases += 1;
+
+	const size_t bytes = EstimateSize(key.width, key.height, key.internalFormat);
+	GLuint id = 0;
+
+	auto iter = mBuckets.find(key);
+	if (iter != end(mBuckets) && false == iter->second.empty())
+	{
+		// the most recently released object first
+		id = iter->second.back().id;
+		iter->second.pop_back();
+
+		mStats.numberOfReuses += 1;
+		mStats.freeBytes -= bytes;
+		isNew = false;
+	}
+	else
+	{
+		if (GL_RENDERBUFFER == key.target)
+			glGenRenderbuffers(1, &id);
+		else
+			glGenTextures(1, &id);
+
+		mStats.numberOfAllocations += 1;
+		isNew = true;
+	}
+
+	LeasedObject leased = { key, bytes };
+	if (GL_RENDERBUFFER == key.target)
+		mLeasedRenderbuffers[id] = leased;
+	else
+		mLeasedTextures[id] = leased;
+
+	mStats.leasedBytes += bytes;
+	mStats.peakBytes = (std::max)(mStats.peakBytes, mStats.leasedBytes + mStats.freeBytes);
+	return id;
+}
+
+GLuint RenderTargetPool::LeaseTexture2D(const int width, const int height, const GLenum format, const GLenum internalFormat, const GLenum type,
+	const GLenum clamp, const GLenum minFilter, const GLenum magFilter, const bool unpackAlignment)
+{
+	const Key key = { GL_TEXTURE_2D, width, height, internalFormat, format, type };
+
+	bool isNew = false;
+	const GLuint id = Lease(key, isNew);
+
+	glBindTexture(GL_TEXTURE_2D, id);
+
+	if (isNew)
+	{
+		if (unpackAlignment)
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, clamp);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, clamp);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return id;
+}
+
+GLuint RenderTargetPool::LeaseRenderbuffer(const int width, const int height, const GLenum internalFormat)
+{
+	const Key key = { GL_RENDERBUFFER, width, height, internalFormat, 0, 0 };
+
+	bool isNew = false;
+	const GLuint id = Lease(key, isNew);
+
+	if (isNew)
+	{
+		glBindRenderbuffer(GL_RENDERBUFFER, id);
+		glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+	return id;
+}
+
+bool RenderTargetPool::Release(std::unordered_map<GLuint, LeasedObject>& leased, const GLuint id)
+{
+	auto iter = leased.find(id);
+	if (iter == end(leased))
+		return false;
+
+	mTick += 1;
+
+	FreeObject object = { id, mTick };
+	mBuckets[iter->second.key].push_back(object);
+
+	mStats.numberOfReleases += 1;
+	mStats.leasedBytes -= iter->second.bytes;
+	mStats.freeBytes += iter->second.bytes;
+
+	leased.erase(iter);
+
+	Trim(mBudget);
+	return true;
+}
+
+bool RenderTargetPool::ReleaseTexture(const GLuint id)
+{
+	return Release(mLeasedTextures, id);
+}
+
+bool RenderTargetPool::ReleaseRenderbuffer(const GLuint id)
+{
+	return Release(mLeasedRenderbuffers, id);
+}
+
+void RenderTargetPool::SetBudget(const size_t bytes)
+{
+	mBudget = bytes;
+	Trim(mBudget);
+}
+
+void RenderTargetPool::DeleteObject(const GLenum target, const GLuint id)
+{
+	if (GL_RENDERBUFFER == target)
+		glDeleteRenderbuffers(1, &id);
+	else
+		glDeleteTextures(1, &id);
+}
+
+void RenderTargetPool::Trim(const size_t bytes)
+{
+	while (mStats.freeBytes > bytes)
+	{
+		// objects in a bucket go in a release order, the oldest one is in front
+		auto oldest = end(mBuckets);
+		for (auto iter = begin(mBuckets); iter != end(mBuckets); ++iter)
+		{
+			if (false == iter->second.empty()
+				&& (oldest == end(mBuckets) || iter->second.front().lastUsed < oldest->second.front().lastUsed))
+			{
+				oldest = iter;
+			}
+		}
+
+		if (oldest == end(mBuckets))
+			break;
+
+		const Key& key = oldest->first;
+		DeleteObject(key.target, oldest->second.front().id);
+
+		mStats.numberOfEvictions += 1;
+		mStats.freeBytes -= EstimateSize(key.width, key.height, key.internalFormat);
+
+		oldest->second.erase(begin(oldest->second));
+		if (oldest->second.empty())
+			mBuckets.erase(oldest);
+	}
+}
+
+void RenderTargetPool::Clear()
+{
+	for (auto iter = begin(mBuckets); iter != end(mBuckets); ++iter)
+	{
+		for (const FreeObject& object : iter->second)
+			DeleteObject(iter->first.target, object.id);
+	}
+
+	mBuckets.clear();
+	mLeasedTextures.clear();
+	mLeasedRenderbuffers.clear();
+
+	mStats.freeBytes = 0;
+	mStats.leasedBytes = 0;
+}
+
+void RenderTargetPool::ResetStats()
+{
+	const size_t leasedBytes = mStats.leasedBytes;
+	const size_t freeBytes = mStats.freeBytes;
+
+	mStats = Stats();
+	mStats.leasedBytes = leasedBytes;
+	mStats.freeBytes = freeBytes;
+	mStats.peakBytes = leasedBytes + freeBytes;
+}
+
+int RenderTargetPool::GetNumberOfFreeObjects() const
+{
+	size_t count = 0;
+	for (auto iter = begin(mBuckets); iter != end(mBuckets); ++iter)
+		count += iter->second.size();
+	return static_cast<int>(count);
+}
@@ -0,0 +1,119 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <GL\glew.h>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+///
+/// pool of 2d textures and renderbuffers for framebuffer attachments
+///  objects are bucketed by size and format, a released object waits in its bucket for a next lease of the same kind,
+///  released objects over a memory budget are deleted, least recently used first
+///  GL objects belong to a context (or a share group), so there is a pool per gl context,
+///  an owner calls ForgetContext once when its display context is gone
+///
+class RenderTargetPool
+{
+public:
+
+	struct Stats
+	{
+		unsigned int	numberOfLeases{ 0 };
+		unsigned int	numberOfReuses{ 0 };		//!< leases served from a bucket
+		unsigned int	numberOfAllocations{ 0 };	//!< leases which made a new gl object
+		unsigned int	numberOfReleases{ 0 };
+		unsigned int	numberOfEvictions{ 0 };		//!< released objects deleted by the budget or a trim
+
+		size_t			leasedBytes{ 0 };			//!< estimated memory of objects in use
+		size_t			freeBytes{ 0 };				//!< estimated memory of released objects kept in buckets
+		size_t			peakBytes{ 0 };
+	};
+
+	/// pool of the current gl context
+	static RenderTargetPool& TheOne();
+	/// drop a pool of a context which is gone, its objects are deleted with the context so there are no gl calls
+	static void ForgetContext(const void* context);
+	static const void* GetCurrentContext();
+
+	//! a destructor
+	~RenderTargetPool();
+
+	/// texture storage is specified for a new object only, sampling parameters are applied on every lease
+	GLuint LeaseTexture2D(const int width, const int height, const GLenum format, const GLenum internalFormat, const GLenum type,
+		const GLenum clamp, const GLenum minFilter, const GLenum magFilter, const bool unpackAlignment = false);
+	GLuint LeaseRenderbuffer(const int width, const int height, const GLenum internalFormat);
+
+	/// object goes back to its bucket, returns false when an object was not leased from the pool
+	bool ReleaseTexture(const GLuint id);
+	bool ReleaseRenderbuffer(const GLuint id);
+
+	/// memory budget for released objects
+	void SetBudget(const size_t bytes);
+	size_t GetBudget() const { return mBudget; }
+
+	/// delete released objects until they fit into a given size
+	void Trim(const size_t bytes = 0);
+	/// delete released objects and forget leased ones (they are deleted with their context)
+	void Clear();
+
+	const Stats& GetStats() const { return mStats; }
+	void ResetStats();
+
+	int GetNumberOfFreeObjects() const;
+
+	static size_t EstimateSize(const int width, const int height, const GLenum internalFormat);
+
+private:
+
+	struct Key
+	{
+		GLenum		target;
+		int			width;
+		int			height;
+		GLenum		internalFormat;
+		GLenum		format;
+		GLenum		type;
+
+		bool operator < (const Key& other) const;
+	};
+
+	struct FreeObject
+	{
+		GLuint			id;
+		unsigned int	lastUsed;
+	};
+
+	struct LeasedObject
+	{
+		Key				key;
+		size_t			bytes;
+	};
+
+	std::map<Key, std::vector<FreeObject>>		mBuckets;
+	std::unordered_map<GLuint, LeasedObject>	mLeasedTextures;
+	std::unordered_map<GLuint, LeasedObject>	mLeasedRenderbuffers;
+
+	size_t				mBudget;
+	unsigned int		mTick{ 0 };
+	Stats				mStats;
+
+	RenderTargetPool();
+
+	GLuint Lease(const Key& key, bool& isNew);
+	bool Release(std::unordered_map<GLuint, LeasedObject>& leased, const GLuint id);
+	void DeleteObject(const GLenum target, const GLuint id);
+};
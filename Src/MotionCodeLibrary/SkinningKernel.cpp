@@ -0,0 +1,134 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// SkinningKernel.cpp
+//
+// Sergei <Neill3d> Solokhin 2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SkinningKernel.h"
+
+#include <xmmintrin.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static inline void Cross(float *res, const float *a, const float *b)
+{
+	res[0] = a[1]*b[2] - a[2]*b[1];
+	res[1] = a[2]*b[0] - a[0]*b[2];
+	res[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+static inline float Dot(const float *a, const float *b)
+{
+	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+void SkinningDeformRange(const SkinningData &data, const float *restPositions, const float *restNormals, float *positions, float *normals, const int begin, const int end)
+{
+	const bool doNormals = (restNormals != nullptr && normals != nullptr);
+	const float *palette = data.palette;
+
+	float col0[4], col1[4], col2[4];
+	float row0[3], row1[3], row2[3];
+
+	for (int i=begin; i<end; ++i)
+	{
+		const int *indices = data.boneIndices + static_cast<size_t>(i) * SKINNING_MAX_INFLUENCES;
+		const float *weights = data.weights + static_cast<size_t>(i) * SKINNING_MAX_INFLUENCES;
+
+		// blend matrix columns, influences are sorted so the first zero weight ends the list
+
+		const float *m = palette + static_cast<size_t>(indices[0]) * 16;
+		__m128 w = _mm_set1_ps(weights[0]);
+
+		__m128 c0 = _mm_mul_ps(w, _mm_loadu_ps(m));
+		__m128 c1 = _mm_mul_ps(w, _mm_loadu_ps(m + 4));
+		__m128 c2 = _mm_mul_ps(w, _mm_loadu_ps(m + 8));
+		__m128 c3 = _mm_mul_ps(w, _mm_loadu_ps(m + 12));
+
+		for (int j=1; j<SKINNING_MAX_INFLUENCES && weights[j] > 0.0f; ++j)
+		{
+			m = palette + static_cast<size_t>(indices[j]) * 16;
+			w = _mm_set1_ps(weights[j]);
+
+			c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+			c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+			c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+			c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_loadu_ps(m + 12)));
+		}
+
+		// forward transform of a rest position by the blended matrix,
+		//  LinkedVertex::CalculateDeformedPosition applies the inverse of the same matrix to get rest back
+
+		const float *p = restPositions + static_cast<size_t>(i) * 4;
+
+		__m128 res = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+		res = _mm_add_ps(res, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+		res = _mm_add_ps(res, c3);
+
+		float *dst = positions + static_cast<size_t>(i) * 4;
+		_mm_storeu_ps(dst, res);
+		dst[3] = 1.0f;
+
+		if (doNormals)
+		{
+			// normals use the inverse transpose, its columns are cross products of the blended columns divided by a determinant
+
+			_mm_storeu_ps(col0, c0);
+			_mm_storeu_ps(col1, c1);
+			_mm_storeu_ps(col2, c2);
+
+			Cross(row0, col1, col2);
+			Cross(row1, col2, col0);
+			Cross(row2, col0, col1);
+
+			// keep the sign of a determinant for mirrored links, the length is normalized below
+			const float sign = (Dot(col0, row0) < 0.0f) ? -1.0f : 1.0f;
+			const float *n = restNormals + static_cast<size_t>(i) * 4;
+
+			const float x = sign * (row0[0] * n[0] + row1[0] * n[1] + row2[0] * n[2]);
+			const float y = sign * (row0[1] * n[0] + row1[1] * n[1] + row2[1] * n[2]);
+			const float z = sign * (row0[2] * n[0] + row1[2] * n[1] + row2[2] * n[2]);
+
+			const float len = sqrtf(x*x + y*y + z*z);
+			const float invLen = (len > 0.0f) ? 1.0f / len : 0.0f;
+
+			dst = normals + static_cast<size_t>(i) * 4;
+			dst[0] = x * invLen;
+			dst[1] = y * invLen;
+			dst[2] = z * invLen;
+			dst[3] = 0.0f;
+		}
+	}
+}
+
+double SkinningDeform(const SkinningData &data, const float *restPositions, const float *restNormals, float *positions, float *normals, const int maxThreads)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	const int vertexCount = data.vertexCount;
+	const int hardwareThreads = (maxThreads > 0) ? maxThreads : static_cast<int>(std::thread::hardware_concurrency());
+	const int numThreads = (std::max)(1, (std::min)(hardwareThreads, vertexCount / SKINNING_MIN_THREAD_VERTICES));
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; ++i)
+	{
+		threads.emplace_back(SkinningDeformRange, std::cref(data), restPositions, restNormals, positions, normals,
+			vertexCount * i / numThreads, vertexCount * (i + 1) / numThreads);
+	}
+	SkinningDeformRange(data, restPositions, restNormals, positions, normals, 0, vertexCount / numThreads);
+
+	for (auto &thread : threads)
+		thread.join();
+
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
@@ -0,0 +1,37 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// SkinningKernel.h
+//
+// Sergei <Neill3d> Solokhin 2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// linear blend skinning kernel, it has no sdk dependencies so it could be run in a console benchmark
+
+#define SKINNING_MAX_INFLUENCES		4
+#define SKINNING_MIN_THREAD_VERTICES	4096
+
+/**
+*	palette has 16 floats per bone (column major, translation in elements 12-14),
+*	every vertex keeps SKINNING_MAX_INFLUENCES (index, weight) pairs sorted by weight.
+*	Rest positions are transformed by the blended palette matrix, LinkedVertex::CalculateDeformedPosition is the inverse of it.
+*	Positions and normals are 4 floats per vertex like FBVertex and FBNormal.
+*/
+struct SkinningData
+{
+	const float		*palette;
+	const int		*boneIndices;
+	const float		*weights;
+	int				vertexCount;
+};
+
+void SkinningDeformRange(const SkinningData &data, const float *restPositions, const float *restNormals, float *positions, float *normals, const int begin, const int end);
+
+//! deform all vertices on maxThreads workers (0 - hardware concurrency), returns time in milliseconds
+double SkinningDeform(const SkinningData &data, const float *restPositions, const float *restNormals, float *positions, float *normals, const int maxThreads=0);
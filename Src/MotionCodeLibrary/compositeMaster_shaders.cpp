@@ -480,6 +480,55 @@ bool CompositeShaderManagerImpl::CheckAndLoadShader( const ECompositeShader shad
 	return (nullptr != GetShaderPtr(shader, useMask));
 }
 
+bool CompositeShaderManagerImpl::BeginShader( const ECompositeShader shader, const bool useMask )
+{
+	const int32_t shaderIndex = static_cast<int32_t>(shader);
+
+	UnLoadShader(shader, useMask);
+
+	GLSLShader *pShader = new GLSLShader();
+	mShaderUseMask[shaderIndex] = useMask;
+
+	FBString strHeader("#version 120\n");
+	if (shader >= eCompositeShaderBlendNormal && shader <= eCompositeShaderBlendPhoenix)
+		strHeader = strHeader + CompositeBlendTypeToString( (ECompositeBlendType) (shaderIndex - (int)eCompositeShaderBlendNormal) );
+	else if (shader >= eCompositeShaderFogNormal && shader <= eCompositeShaderFogPhoenix)
+		strHeader = strHeader + CompositeBlendTypeToString( (ECompositeBlendType) (shaderIndex - (int)eCompositeShaderFogNormal) );
+		
+	if (useMask)
+		strHeader = strHeader + "#define USE_MASK\n";
+
+	pShader->SetHeaderText(strHeader);
+
+	if (false == InitShader( GetCompositeShaderVertexName(shader), GetCompositeShaderFragmentName(shader), pShader, useMask ) )
+		return false;
+
+	if (useMask)
+		mShadersWithMask[shaderIndex] = pShader;
+	else
+		mShadersNoMask[shaderIndex] = pShader;
+	
+	return true;
+}
+
+bool CompositeShaderManagerImpl::FinishShader( const ECompositeShader shader, const bool useMask )
+{
+	const int32_t shaderIndex = static_cast<int32_t>(shader);
+
+	GLSLShader *&pShader = (useMask) ? mShadersWithMask[shaderIndex] : mShadersNoMask[shaderIndex];
+	ShaderBaseLocations *&pLocations = (useMask) ? mShaderLocWithMask[shaderIndex] : mShaderLocNoMask[shaderIndex];
+
+	if (pShader == nullptr)
+		return false;
+	
+	// locations are resolved once a link is done
+	if (pLocations != nullptr)
+		return true;
+
+	pLocations = CreateShaderLocations(shader);
+	return InitShaderLocations( GetCompositeShaderFragmentName(shader), pShader, pLocations, useMask );
+}
+
 const GLSLShader* CompositeShaderManagerImpl::GetShaderPtr( const ECompositeShader shader, const bool useMask )
 {
 	const int32_t shaderIndex = static_cast<int32_t>(shader);
@@ -487,53 +536,73 @@ const GLSLShader* CompositeShaderManagerImpl::GetShaderPtr( const ECompositeShad
 	if (shaderIndex < 0 || shaderIndex >= ECompositeShader::eCompositeShaderCount)
 		return nullptr;
 
-	GLSLShader* pShader = nullptr;
-
-	if (useMask)
+	if (nullptr == ((useMask) ? mShadersWithMask[shaderIndex] : mShadersNoMask[shaderIndex]))
 	{
-		pShader = mShadersWithMask[shaderIndex];
+		BeginShader(shader, useMask);
 	}
-	else
+
+	// wait for a pending compilation
+	if (false == FinishShader(shader, useMask))
+		return nullptr;
+
+	return (useMask) ? mShadersWithMask[shaderIndex] : mShadersNoMask[shaderIndex];
+}
+
+bool CompositeShaderManagerImpl::RequestShader( const ECompositeShader shader, const bool useMask )
+{
+	const int32_t shaderIndex = static_cast<int32_t>(shader);
+
+	if (shaderIndex < 0 || shaderIndex >= ECompositeShader::eCompositeShaderCount)
+		return false;
+
+	if (false == GLSLShader::IsParallelCompileSupported())
+		return false;
+
+	if (nullptr != ((useMask) ? mShadersWithMask[shaderIndex] : mShadersNoMask[shaderIndex]))
+		return true;
+
+	return BeginShader(shader, useMask);
+}
+
+void CompositeShaderManagerImpl::RequestShaders( const ECompositeShader first, const ECompositeShader last, const bool useMask )
+{
+	for (int i = static_cast<int>(first); i <= static_cast<int>(last); ++i)
 	{
-		pShader = mShadersNoMask[shaderIndex];
+		RequestShader( static_cast<ECompositeShader>(i), useMask );
 	}
+}
 
-	
-	if (pShader == nullptr)
-	{
-		UnLoadShader(shader, useMask);
+bool CompositeShaderManagerImpl::IsShaderReady( const ECompositeShader shader, const bool useMask )
+{
+	if (false == GLSLShader::IsParallelCompileSupported())
+		return CheckAndLoadShader(shader, useMask);
 
-		pShader = new GLSLShader();
-		ShaderBaseLocations *pLocations = CreateShaderLocations(shader);
-		mShaderUseMask[shaderIndex] = useMask;
+	if (false == RequestShader(shader, useMask))
+		return false;
 
-		FBString strHeader("#version 120\n");
-		if (shader >= eCompositeShaderBlendNormal && shader <= eCompositeShaderBlendPhoenix)
-			strHeader = strHeader + CompositeBlendTypeToString( (ECompositeBlendType) (shaderIndex - (int)eCompositeShaderBlendNormal) );
-		else if (shader >= eCompositeShaderFogNormal && shader <= eCompositeShaderFogPhoenix)
-			strHeader = strHeader + CompositeBlendTypeToString( (ECompositeBlendType) (shaderIndex - (int)eCompositeShaderFogNormal) );
-		
-		if (useMask)
-			strHeader = strHeader + "#define USE_MASK\n";
+	const int32_t shaderIndex = static_cast<int32_t>(shader);
+	const GLSLShader *pShader = (useMask) ? mShadersWithMask[shaderIndex] : mShadersNoMask[shaderIndex];
 
-		pShader->SetHeaderText(strHeader);
+	if (nullptr != ((useMask) ? mShaderLocWithMask[shaderIndex] : mShaderLocNoMask[shaderIndex]))
+		return true;
 
-		if (true == InitShader( GetCompositeShaderVertexName(shader), GetCompositeShaderFragmentName(shader), pShader, pLocations, useMask ) )
-		{
-			if (useMask)
-			{
-				mShadersWithMask[shaderIndex] = pShader;
-				mShaderLocWithMask[shaderIndex] = pLocations;
-			}
-			else
-			{
-				mShadersNoMask[shaderIndex] = pShader;
-				mShaderLocNoMask[shaderIndex] = pLocations;
-			}
-		}
-	}
+	if (false == pShader->IsLinkCompleted())
+		return false;
+
+	return FinishShader(shader, useMask);
+}
 
-	return pShader;
+bool CompositeShaderManagerImpl::IsShaderPending( const ECompositeShader shader, const bool useMask ) const
+{
+	const int32_t shaderIndex = static_cast<int32_t>(shader);
+
+	if (shaderIndex < 0 || shaderIndex >= ECompositeShader::eCompositeShaderCount)
+		return false;
+
+	if (useMask)
+		return (nullptr != mShadersWithMask[shaderIndex] && nullptr == mShaderLocWithMask[shaderIndex]);
+	
+	return (nullptr != mShadersNoMask[shaderIndex] && nullptr == mShaderLocNoMask[shaderIndex]);
 }
 
 const ShaderBaseLocations *CompositeShaderManagerImpl::GetShaderLocationsPtr( const ECompositeShader shader, const bool useMask )
@@ -551,7 +620,15 @@ const ShaderBaseLocations *CompositeShaderManagerImpl::GetShaderLocationsPtr( co
 
 GLhandleARB CompositeShaderManagerImpl::GetVertexShader()
 {
-	const GLSLShader *pShader = GetShaderPtr( eCompositeShaderBlit, mShaderUseMask[eCompositeShaderBlit] );
+	const bool useMask = mShaderUseMask[eCompositeShaderBlit];
+	
+	// a blit program doesn't have to be linked to share its vertex shader
+	if (nullptr == ((useMask) ? mShadersWithMask[eCompositeShaderBlit] : mShadersNoMask[eCompositeShaderBlit]))
+	{
+		BeginShader(eCompositeShaderBlit, useMask);
+	}
+
+	const GLSLShader *pShader = (useMask) ? mShadersWithMask[eCompositeShaderBlit] : mShadersNoMask[eCompositeShaderBlit];
 	if (pShader)
 	{
 		return pShader->GetVertexShader();
@@ -864,13 +941,12 @@ void CompositeShaderManagerImpl::SetSSAOUniforms(	const int	_numberOfSamples,
 	}
 }
 
-bool CompositeShaderManagerImpl::InitShader(const char *vertex_filename, const char *fragment_filename, GLSLShader *&pShader, ShaderBaseLocations *&pLocations, bool useMask)
+bool CompositeShaderManagerImpl::InitShader(const char *vertex_filename, const char *fragment_filename, GLSLShader *&pShader, bool useMask)
 {
-	if (pShader == nullptr || pLocations == nullptr)
+	if (pShader == nullptr)
 		return false;
 
 	bool result = true;
-	FBString effectPath, effectFullName;
 	
 	try
 	{
@@ -879,23 +955,48 @@ bool CompositeShaderManagerImpl::InitShader(const char *vertex_filename, const c
 		if ( !FindEffectLocation( fragment_filename, effectPath, MAX_PATH ) )
 			throw std::exception( "Failed to locate shader files" );
 
+		// compile and link are started here, a status is checked in InitShaderLocations
+
 		// most of shaders share the same simple vertex shader
 		if (vertex_filename == nullptr)
 		{
-			if ( !pShader->LoadShaders( GetVertexShader(), FBString(effectPath, fragment_filename) ) )
+			if ( !pShader->BeginLoadShaders( GetVertexShader(), FBString(effectPath, fragment_filename) ) )
 				throw std::exception( "Failed to load shader" );
 		}	
 		else
 		{
-			if ( !pShader->LoadShaders( FBString(effectPath, vertex_filename), FBString(effectPath, fragment_filename) ) )
+			if ( !pShader->BeginLoadShaders( FBString(effectPath, vertex_filename), FBString(effectPath, fragment_filename) ) )
 				throw std::exception( "Failed to load shader" );
 		}
+	}
+	catch ( const std::exception &e )
+	{
+		FBMessageBox( "Composite Master Tool", e.what(), "Ok" );
+		result = false;
+
+		ShaderBaseLocations *pLocations = nullptr;
+		FreeShader(pShader, pLocations);
+	}
+
+	return result;
+}
+
+bool CompositeShaderManagerImpl::InitShaderLocations(const char *fragment_filename, GLSLShader *&pShader, ShaderBaseLocations *&pLocations, bool useMask)
+{
+	if (pShader == nullptr || pLocations == nullptr)
+		return false;
+
+	bool result = true;
+
+	try
+	{
+		if ( !pShader->FinishLink( fragment_filename ) )
+			throw std::exception( "Failed to load shader" );
 
 		//
 		// find locations for all neede shader uniforms
 		
 		pLocations->Init(pShader, useMask);
-
 	}
 	catch ( const std::exception &e )
 	{
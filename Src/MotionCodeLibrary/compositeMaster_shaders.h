@@ -1260,10 +1260,20 @@ public:
 	//! a destructor
 	~CompositeShaderManagerImpl();
 
-	// get specified composite shader for drawing
+	// get specified composite shader for drawing, it waits for a pending compilation
 	bool		CheckAndLoadShader( const ECompositeShader shader, const bool useMask );
 	void		UnLoadShader( const ECompositeShader shader, const bool useMask );
 
+	/// start compilation of a variant without waiting for a result (GL_KHR_parallel_shader_compile)
+	///  without a parallel compile support a variant is compiled lazy on a first use
+	bool		RequestShader( const ECompositeShader shader, const bool useMask );
+	void		RequestShaders( const ECompositeShader first, const ECompositeShader last, const bool useMask );
+
+	/// non blocking check, locations are resolved here when a link is done
+	bool		IsShaderReady( const ECompositeShader shader, const bool useMask );
+	/// compilation is started, but a variant is not ready yet
+	bool		IsShaderPending( const ECompositeShader shader, const bool useMask ) const;
+
 	const GLSLShader	*GetShaderPtr( const ECompositeShader shader, const bool useMask );
 	const ShaderBaseLocations *GetShaderLocationsPtr( const ECompositeShader shader, const bool useMask );
 
@@ -1383,13 +1393,15 @@ private:
 	GLSLShader				*mShadersWithMask[eCompositeShaderCount];
 	ShaderBaseLocations		*mShaderLocWithMask[eCompositeShaderCount];
 
-	bool	InitShader(const char *vertex_filename, const char *fragment_filename, GLSLShader *&pShader, ShaderBaseLocations *&pLocations, bool useMask);
+	bool	BeginShader(const ECompositeShader shader, const bool useMask);
+	bool	FinishShader(const ECompositeShader shader, const bool useMask);
+
+	bool	InitShader(const char *vertex_filename, const char *fragment_filename, GLSLShader *&pShader, bool useMask);
+	bool	InitShaderLocations(const char *fragment_filename, GLSLShader *&pShader, ShaderBaseLocations *&pLocations, bool useMask);
 	void	FreeShader(GLSLShader *&pShader, ShaderBaseLocations *&pLocations);
 
 	GLhandleARB	GetVertexShader();
 
-	void	InitShaderLocations();
-
 	ShaderBaseLocations *CreateShaderLocations(const ECompositeShader shader );
 
 private:
@@ -1422,6 +1434,23 @@ public:
 		return impl->CheckAndLoadShader(shader, useMask);
 	}
 
+	bool		RequestShader( const ECompositeShader shader, const bool useMask )
+	{
+		return impl->RequestShader(shader, useMask);
+	}
+	void		RequestShaders( const ECompositeShader first, const ECompositeShader last, const bool useMask )
+	{
+		impl->RequestShaders(first, last, useMask);
+	}
+	bool		IsShaderReady( const ECompositeShader shader, const bool useMask )
+	{
+		return impl->IsShaderReady(shader, useMask);
+	}
+	bool		IsShaderPending( const ECompositeShader shader, const bool useMask ) const
+	{
+		return impl->IsShaderPending(shader, useMask);
+	}
+
 	void		UnLoadShader( const ECompositeShader shader, const bool useMask )
 	{
 		impl->UnLoadShader(shader, useMask);
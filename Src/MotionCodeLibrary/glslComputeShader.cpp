@@ -12,9 +12,12 @@
 
 
 #include "glslComputeShader.h"
+#include "glslProgramCache.h"
 #include "FileUtils.h"
 #include "Logger.h"
 
+#include <chrono>
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 CComputeProgram::CComputeProgram(const GLuint shaderid, const GLuint programid)
@@ -169,6 +172,22 @@ bool CComputeProgram::checkLinkStatus(GLuint program, const char* programName)
 
 bool CComputeProgram::loadComputeShaderFromBuffer(const char* buffer, const char* shaderName, const GLuint shaderid, const GLuint programid)
 {
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// included named strings are not a part of the source, so a cache key would not see their changes
+	const bool useCache = (strstr(buffer, "#include") == nullptr);
+
+	GLSLProgramCache& programCache = GLSLProgramCache::TheOne();
+	const unsigned long long cacheKey = (useCache) ? programCache.MakeKey({ buffer }) : 0;
+
+	if (useCache && programCache.Load(programid, cacheKey))
+	{
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		LOGI("[CComputeProgram] %s is loaded from a binary cache in %.2f ms\n", shaderName,
+			std::chrono::duration<double, std::milli>(endTime - startTime).count());
+		return true;
+	}
+
 	const GLcharARB* bufferARB = buffer;
 
 	GLuint shaderCompute = shaderid;
@@ -189,9 +208,19 @@ bool CComputeProgram::loadComputeShaderFromBuffer(const char* buffer, const char
 		return false;
 
 	GLuint programCompute = programid;
+	if (useCache)
+		programCache.PrepareProgram(programCompute);
+
 	glLinkProgram(programCompute);
 	if (!checkLinkStatus(programCompute, shaderName))
 		return false;
+
+	if (useCache)
+		programCache.Store(programCompute, cacheKey);
+
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	LOGI("[CComputeProgram] %s is compiled in %.2f ms\n", shaderName,
+		std::chrono::duration<double, std::milli>(endTime - startTime).count());
 	
 	return true;
 }
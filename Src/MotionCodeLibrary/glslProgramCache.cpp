@@ -0,0 +1,229 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <stdlib.h>
+#endif
+#include <stdio.h>
+#include <vector>
+#include "glslProgramCache.h"
+
+#define PROGRAM_CACHE_MAGIC		0x42504C47	// GLPB
+#define PROGRAM_CACHE_VERSION	1
+#define PROGRAM_CACHE_FOLDER	"OpenMoBu_ShaderCache/"
+#define PROGRAM_CACHE_PATH_LENGTH	1024
+
+namespace
+{
+	struct ProgramCacheHeader
+	{
+		unsigned int		magic;
+		unsigned int		version;
+		unsigned long long	key;
+		GLenum				format;
+		unsigned int		size;
+	};
+
+	// FNV-1a 64 bit
+	unsigned long long HashString(unsigned long long hash, const char* str)
+	{
+		if (str)
+		{
+			for (const unsigned char* c = reinterpret_cast<const unsigned char*>(str); *c; ++c)
+			{
+				hash ^= static_cast<unsigned long long>(*c);
+				hash *= 1099511628211ULL;
+			}
+		}
+		// separator, so moving text from one source to another changes a key
+		hash ^= 0xFFULL;
+		hash *= 1099511628211ULL;
+		return hash;
+	}
+
+	constexpr unsigned long long HASH_OFFSET{ 14695981039346656037ULL };
+
+	FILE* OpenFile(const char* filename, const char* mode)
+	{
+#ifdef _WIN32
+		FILE* fp = nullptr;
+		return (fopen_s(&fp, filename, mode) == 0) ? fp : nullptr;
+#else
+		return fopen(filename, mode);
+#endif
+	}
+};
+
+bool GLSLProgramCache::ENABLED = true;
+
+GLSLProgramCache& GLSLProgramCache::TheOne()
+{
+	static GLSLProgramCache	gProgramCache;
+	return gProgramCache;
+}
+
+GLSLProgramCache::GLSLProgramCache()
+{
+#ifdef _WIN32
+	char tempPath[MAX_PATH]{ 0 };
+	if (GetTempPathA(MAX_PATH, tempPath) > 0)
+	{
+		mFolder = tempPath;
+		mFolder += PROGRAM_CACHE_FOLDER;
+	}
+#else
+	const char* tempPath = getenv("TMPDIR");
+	mFolder = (tempPath) ? tempPath : "/tmp";
+	mFolder += "/";
+	mFolder += PROGRAM_CACHE_FOLDER;
+#endif
+}
+
+void GLSLProgramCache::SetFolder(const char* folder)
+{
+	mFolder = (folder) ? folder : "";
+	if (!mFolder.empty() && mFolder.back() != '\\' && mFolder.back() != '/')
+		mFolder += "/";
+}
+
+bool GLSLProgramCache::IsAvailable() const
+{
+	if (!ENABLED || mFolder.empty() || !GLEW_ARB_get_program_binary)
+		return false;
+
+	GLint numberOfFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+	return numberOfFormats > 0;
+}
+
+unsigned long long GLSLProgramCache::MakeKey(std::initializer_list<const char*> sources)
+{
+	if (0 == mDriverHash)
+	{
+		unsigned long long hash = HASH_OFFSET;
+		hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+		hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+		hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+		mDriverHash = hash;
+	}
+
+	unsigned long long key = mDriverHash;
+	for (const char* source : sources)
+		key = HashString(key, source);
+	return key;
+}
+
+void GLSLProgramCache::MakeFileName(const unsigned long long key, char* buffer, const size_t bufferSize) const
+{
+	snprintf(buffer, bufferSize, "%s%016llx.bin", mFolder.c_str(), key);
+}
+
+void GLSLProgramCache::PrepareProgram(const GLuint program) const
+{
+	if (IsAvailable())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool GLSLProgramCache::Load(const GLuint program, const unsigned long long key) const
+{
+	if (!IsAvailable())
+		return false;
+
+	char filename[PROGRAM_CACHE_PATH_LENGTH];
+	MakeFileName(key, filename, PROGRAM_CACHE_PATH_LENGTH);
+
+	FILE* fp = OpenFile(filename, "rb");
+	if (!fp)
+		return false;
+
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+
+	bool isValid = (fread(&header, sizeof(ProgramCacheHeader), 1, fp) == 1)
+		&& header.magic == PROGRAM_CACHE_MAGIC
+		&& header.version == PROGRAM_CACHE_VERSION
+		&& header.key == key
+		&& header.size > 0;
+
+	if (isValid)
+	{
+		binary.resize(header.size);
+		isValid = (fread(binary.data(), sizeof(char), header.size, fp) == header.size);
+	}
+	fclose(fp);
+
+	if (!isValid)
+		return false;
+
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.size));
+
+	// driver could reject a binary (format is not supported any more), skip an error then
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		glGetError();
+		return false;
+	}
+	return true;
+}
+
+void GLSLProgramCache::Store(const GLuint program, const unsigned long long key) const
+{
+	if (!IsAvailable())
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	ProgramCacheHeader header;
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.format = 0;
+	header.size = 0;
+
+	std::vector<char> binary(static_cast<size_t>(size));
+	GLsizei length = 0;
+	glGetProgramBinary(program, size, &length, &header.format, binary.data());
+	if (length <= 0)
+		return;
+
+	header.size = static_cast<unsigned int>(length);
+
+#ifdef _WIN32
+	CreateDirectoryA(mFolder.c_str(), nullptr);
+#else
+	mkdir(mFolder.c_str(), 0755);
+#endif
+
+	char filename[PROGRAM_CACHE_PATH_LENGTH];
+	MakeFileName(key, filename, PROGRAM_CACHE_PATH_LENGTH);
+
+	FILE* fp = OpenFile(filename, "wb");
+	if (!fp)
+		return;
+
+	const bool isWritten = (fwrite(&header, sizeof(ProgramCacheHeader), 1, fp) == 1)
+		&& (fwrite(binary.data(), sizeof(char), header.size, fp) == header.size);
+	fclose(fp);
+
+	// don't leave a truncated file, it would be rejected on every load
+	if (!isWritten)
+		remove(filename);
+}
@@ -0,0 +1,58 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <GL/glew.h>
+#include <initializer_list>
+#include <string>
+
+///
+/// on-disk cache of linked program binaries (GL_ARB_get_program_binary)
+///  a key is a hash of shader sources (with a header text) and of a driver vendor, renderer and version,
+///  so a driver update or a modified source file just misses the cache and the program is compiled again
+///
+class GLSLProgramCache
+{
+public:
+
+	static bool ENABLED;
+
+	static GLSLProgramCache& TheOne();
+
+	/// hash of a given null terminated sources and of the current driver, GL context must be active
+	unsigned long long MakeKey(std::initializer_list<const char*> sources);
+
+	/// call before linking a program which binary is going to be stored
+	void PrepareProgram(const GLuint program) const;
+
+	/// link a program from a cached binary, returns false when there is no valid binary for the key
+	bool Load(const GLuint program, const unsigned long long key) const;
+
+	/// store a binary of a successfully linked program
+	void Store(const GLuint program, const unsigned long long key) const;
+
+	/// folder for binary files, by default it's a sub folder of a system temp folder
+	void SetFolder(const char* folder);
+	const char* GetFolder() const { return mFolder.c_str(); }
+
+private:
+
+	std::string				mFolder;
+	unsigned long long		mDriverHash{ 0 };
+
+	GLSLProgramCache();
+
+	bool IsAvailable() const;
+	void MakeFileName(const unsigned long long key, char* buffer, const size_t bufferSize) const;
+};
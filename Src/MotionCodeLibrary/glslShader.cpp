@@ -9,10 +9,20 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 */
 
 #include <stdio.h>
+#include <chrono>
 #include "glslShader.h"
+#include "glslProgramCache.h"
 #include "CheckGLError.h"
 #include "FileUtils.h"
 
+#ifdef _WIN32
+#define GetGLProcAddress(name)	wglGetProcAddress(name)
+#else
+// without wgl a headless context is an egl one
+#include <EGL/egl.h>
+#define GetGLProcAddress(name)	eglGetProcAddress(name)
+#endif
+
 //
 extern void LOGI(const char* pFormatString, ...);
 extern void LOGE(const char* pFormatString, ...);
@@ -32,7 +42,18 @@ bool GLSLShader::ReCompileShaders( const char* vertex_file, const char* fragment
 
 	if (FILE* fp = readFragment.Get())
 	{
-		if (fragment)
+		if (mIsFromCache)
+		{
+			// program binary has no attached shaders, relink it from sources
+			glAttachObjectARB(programObj, GetVertexShader());
+			if (fragment)
+				glDeleteObjectARB(fragment);
+
+			mIsFromCache = false;
+			mVertexSource.clear();
+			mFragmentSource.clear();
+		}
+		else if (fragment)
 		{
 			glDetachObjectARB(programObj, fragment);
 			glDeleteObjectARB(fragment);
@@ -73,16 +94,36 @@ bool GLSLShader::ReCompileShaders( const char* vertex_file, const char* fragment
 }
 
 bool GLSLShader::LoadShaders( const char* vertex_file, const char* fragment_file )
+{
+	if (!BeginLoadShaders(vertex_file, fragment_file))
+		return false;
+
+	return FinishLink(fragment_file);
+}
+
+bool GLSLShader::LoadShaders( GLhandleARB	_vertex, const char* fragment_file )
+{
+	if (!BeginLoadShaders(_vertex, fragment_file))
+		return false;
+
+	return FinishLink(fragment_file);
+}
+
+bool GLSLShader::BeginLoadShaders( const char* vertex_file, const char* fragment_file )
 {
 	Free();
 
+	mLinkStartTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<char> vertexSource;
+	std::vector<char> fragmentSource;
+
 	{
 		FileReadScope readVertex(vertex_file);
 
 		if (FILE* fp = readVertex.Get())
 		{
-			vertex = glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
-			LoadShader(vertex, fp, vertex_file);
+			ReadShaderSource(fp, vertexSource, vertex_file);
 		}
 	}
 
@@ -91,106 +132,226 @@ bool GLSLShader::LoadShaders( const char* vertex_file, const char* fragment_file
 
 		if (FILE* fp = readFragment.Get())
 		{
-			fragment = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
-			LoadShader(fragment, fp, fragment_file);
+			ReadShaderSource(fp, fragmentSource, fragment_file);
 		}
 	}
 
-	if (vertex > 0 && fragment > 0)
-	{
-	  programObj = glCreateProgramObjectARB();
-	  // check for errors
-	  //if ( checkopenglerror ) return false;
-	  // attach shader to program object
-	  glAttachObjectARB( programObj, vertex );
-	  // attach shader to program object
-	  glAttachObjectARB( programObj, fragment );
-
-	  GLint linked;
-	  // link the program object and print out the info log
-	  glLinkProgramARB( programObj );
-	
-	  CHECK_GL_ERROR();
-	  //if ( checkopenglerror ) return false;
+	if (vertexSource.empty() || fragmentSource.empty())
+		return false;
 
-	  glGetObjectParameterivARB( programObj, GL_OBJECT_LINK_STATUS_ARB, &linked );
+	programObj = glCreateProgramObjectARB();
 
-	  bool doPrint = PRINT_WARNINGS;
-	  if (doPrint && linked == GL_TRUE)
-	  {
-		  GLint       logLength = 0;
-		  glGetObjectParameterivARB(programObj, GL_OBJECT_INFO_LOG_LENGTH_ARB, &logLength);
-		  doPrint = logLength > 0;
-	  }
+	GLSLProgramCache& programCache = GLSLProgramCache::TheOne();
+	const unsigned long long cacheKey = programCache.MakeKey({ vertexSource.data(), fragmentSource.data() });
 
-	  if (linked == GL_FALSE || doPrint)
-	  {
-		  LOGI("[GLSLShader ] link status for vertex - %s, fragment - %s\n", vertex_file, fragment_file);
-		  LoadLog(programObj, nullptr);
-	  }
-	  
-	  return (linked != 0);
+	if (programCache.Load(programObj, cacheKey))
+	{
+		// shader objects are compiled only on demand
+		mIsFromCache = true;
+		mVertexSource.swap(vertexSource);
+		mFragmentSource.swap(fragmentSource);
+
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		LOGI("[GLSLShader] %s is loaded from a binary cache in %.2f ms\n", fragment_file,
+			std::chrono::duration<double, std::milli>(endTime - mLinkStartTime).count());
+		return true;
 	}
 
-	return false;
+	// compile status is checked together with a link status, so a driver could compile both shaders in parallel
+	vertex = glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
+	CompileShader(vertex, vertexSource, vertex_file, false);
+	fragment = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
+	CompileShader(fragment, fragmentSource, fragment_file, false);
+
+	// attach shader to program object
+	glAttachObjectARB( programObj, vertex );
+	// attach shader to program object
+	glAttachObjectARB( programObj, fragment );
+
+	mOwnVertexLog = true;
+	LinkProgram(cacheKey);
+	return true;
 }
 
-bool GLSLShader::LoadShaders( GLhandleARB	_vertex, const char* fragment_file )
+bool GLSLShader::BeginLoadShaders( GLhandleARB	_vertex, const char* fragment_file )
 {
 	Free();
 
+	mLinkStartTime = std::chrono::high_resolution_clock::now();
+
 	vertex = _vertex;
 
+	std::vector<char> fragmentSource;
+
 	{
 		FileReadScope readFragment(fragment_file);
 
 		if (FILE* fp = readFragment.Get())
 		{
-			fragment = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
-			LoadShader(fragment, fp, fragment_file);
+			ReadShaderSource(fp, fragmentSource, fragment_file);
 		}
 	}
 
-	if (vertex > 0 && fragment > 0)
+	if (vertex > 0 && !fragmentSource.empty())
 	{
+	  // a shared vertex shader is a part of a cache key with its source
+	  GLint vertexSourceLength = 0;
+	  glGetObjectParameterivARB( vertex, GL_OBJECT_SHADER_SOURCE_LENGTH_ARB, &vertexSourceLength );
+
+	  std::vector<char> vertexSource(static_cast<size_t>(vertexSourceLength) + 1, 0);
+	  glGetShaderSourceARB( vertex, vertexSourceLength, nullptr, vertexSource.data() );
 
 	  programObj = glCreateProgramObjectARB();
-	  // check for errors
-	  //if ( checkopenglerror ) return false;
+
+	  GLSLProgramCache& programCache = GLSLProgramCache::TheOne();
+	  const unsigned long long cacheKey = programCache.MakeKey({ vertexSource.data(), fragmentSource.data() });
+
+	  if (programCache.Load(programObj, cacheKey))
+	  {
+		  mIsFromCache = true;
+		  mFragmentSource.swap(fragmentSource);
+
+		  const auto endTime = std::chrono::high_resolution_clock::now();
+		  LOGI("[GLSLShader] %s is loaded from a binary cache in %.2f ms\n", fragment_file,
+			  std::chrono::duration<double, std::milli>(endTime - mLinkStartTime).count());
+		  return true;
+	  }
+
+	  fragment = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
+	  CompileShader(fragment, fragmentSource, fragment_file, false);
+
 	  // attach shader to program object
 	  glAttachObjectARB( programObj, vertex );
 	  // attach shader to program object
 	  glAttachObjectARB( programObj, fragment );
 
-	  GLint linked;
-	  // link the program object and print out the info log
-	  glLinkProgramARB( programObj );
-	//checkopenglerror;
-	  //if ( checkopenglerror ) return false;
+	  mOwnVertexLog = false;
+	  LinkProgram(cacheKey);
+	  return true;
+	}
 
-	  glGetObjectParameterivARB( programObj, GL_OBJECT_LINK_STATUS_ARB, &linked );
-	  
-	  bool doPrint = PRINT_WARNINGS;
-	  if (doPrint && linked == GL_TRUE)
-	  {
-		  GLint       logLength = 0;
-		  glGetObjectParameterivARB(programObj, GL_OBJECT_INFO_LOG_LENGTH_ARB, &logLength);
-		  doPrint = logLength > 0;
-	  }
+	return false;
+}
 
-	  if (linked == GL_FALSE || doPrint)
-	  {
-		  LOGI("[GLSLShader ] link status for fragment - %s\n", fragment_file);
-		  LoadLog(programObj, nullptr);
-	  }
+void GLSLShader::LinkProgram( const unsigned long long cacheKey )
+{
+	GLSLProgramCache::TheOne().PrepareProgram(programObj);
+
+	// link the program object, a status is queried in FinishLink
+	glLinkProgramARB( programObj );
+
+	CHECK_GL_ERROR();
+
+	mCacheKey = cacheKey;
+	mLinkPending = true;
+}
+
+bool GLSLShader::IsLinkCompleted() const
+{
+	if (!mLinkPending || !IsParallelCompileSupported())
+		return true;
+
+	GLint completed{ GL_TRUE };
+	glGetProgramiv( static_cast<GLuint>(programObj), GL_COMPLETION_STATUS_KHR, &completed );
+	return (completed != GL_FALSE);
+}
+
+bool GLSLShader::FinishLink( const char* debugName )
+{
+	if (!mLinkPending)
+		return (programObj != 0);
+
+	mLinkPending = false;
+
+	GLint linked{ 0 };
+	// it waits for a driver when compile and link are still in progress
+	glGetObjectParameterivARB( programObj, GL_OBJECT_LINK_STATUS_ARB, &linked );
+
+	if (linked == GL_FALSE || PRINT_WARNINGS)
+	{
+		// compile logs are deferred until a link result
+		if (mOwnVertexLog)
+			LoadLog(vertex, debugName);
+		LoadLog(fragment, debugName);
+	}
+
+	bool doPrint = PRINT_WARNINGS;
+	if (doPrint && linked == GL_TRUE)
+	{
+		GLint       logLength = 0;
+		glGetObjectParameterivARB(programObj, GL_OBJECT_INFO_LOG_LENGTH_ARB, &logLength);
+		doPrint = logLength > 0;
+	}
+
+	if (linked == GL_FALSE || doPrint)
+	{
+		LOGI("[GLSLShader ] link status for %s\n", debugName);
+		LoadLog(programObj, nullptr);
+	}
+
+	if (linked != 0)
+	{
+		GLSLProgramCache::TheOne().Store(programObj, mCacheKey);
+
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		LOGI("[GLSLShader] %s is compiled in %.2f ms\n", debugName,
+			std::chrono::duration<double, std::milli>(endTime - mLinkStartTime).count());
+	}
 	  
-	  return (linked != 0);
+	return (linked != 0);
+}
+
+bool GLSLShader::IsParallelCompileSupported()
+{
+	static int supported = -1;
+
+	if (supported < 0)
+	{
+		supported = 0;
+
+		GLint numberOfExtensions = 0;
+		glGetIntegerv( GL_NUM_EXTENSIONS, &numberOfExtensions );
+
+		for (GLint i = 0; i < numberOfExtensions; ++i)
+		{
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (name && (0 == strcmp(name, "GL_KHR_parallel_shader_compile") || 0 == strcmp(name, "GL_ARB_parallel_shader_compile")))
+			{
+				supported = 1;
+				break;
+			}
+		}
+
+		if (supported > 0)
+		{
+			typedef void (APIENTRY *PFNGLMAXSHADERCOMPILERTHREADSPROC) (GLuint count);
+
+			PFNGLMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = 
+				reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSPROC>(GetGLProcAddress("glMaxShaderCompilerThreadsKHR"));
+			if (maxShaderCompilerThreads == nullptr)
+				maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSPROC>(GetGLProcAddress("glMaxShaderCompilerThreadsARB"));
+
+			// an implementation specific number of threads
+			if (maxShaderCompilerThreads)
+				maxShaderCompilerThreads(0xFFFFFFFF);
+		}
+
+		LOGI("[GLSLShader] parallel shader compile is %s\n", (supported > 0) ? "supported" : "not supported");
 	}
 
-	return false;
+	return (supported > 0);
 }
 
 bool GLSLShader::LoadShader( GLhandleARB shader, FILE *file, const char* debugName )
+{
+	std::vector<char> source;
+	if (!ReadShaderSource(file, source, debugName))
+		return false;
+
+	return CompileShader(shader, source, debugName);
+}
+
+bool GLSLShader::ReadShaderSource( FILE *file, std::vector<char>& source, const char* debugName ) const
 {
 	const size_t headerLen = strlen(mHeaderText); // number of bytes in header
 
@@ -198,37 +359,41 @@ bool GLSLShader::LoadShader( GLhandleARB shader, FILE *file, const char* debugNa
 	const size_t fileLen = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	std::vector<char> buffer(headerLen + fileLen + 1);
-	const GLcharARB*  bufferARB = buffer.data();
-
-	GLint   len = static_cast<GLint>(fileLen);
-	GLint   compileStatus;
-
-	// read shader from file
-  
-	memset( buffer.data(), 0, sizeof(char) * (headerLen + len + 1));
+	source.assign(headerLen + fileLen + 1, 0);
 	if (headerLen)
 	{
-		memcpy(buffer.data(), &mHeaderText[0], sizeof(char) * headerLen);
+		memcpy(source.data(), &mHeaderText[0], sizeof(char) * headerLen);
 	}
-	void *buf = (void*)&buffer[headerLen];
-  
-	const size_t readlen = fread(buf, sizeof(char), fileLen, file);
   
-	// trick to zero all outside memory
-	memset( &buffer[readlen+headerLen], 0, sizeof(char)*(len + 1 - readlen) );
+	// read shader from file
+	const size_t readlen = fread(&source[headerLen], sizeof(char), fileLen, file);
 
-	if (readlen == 0) //(readlen != len)
+	if (readlen == 0)
 	{
 		LOGE("[GLSLShader] glsl shader %s has empty file size", debugName );
+		source.clear();
 		return false;
 	}
 
-	len = len + static_cast<GLint>(headerLen);
+	// null terminated text without any outside memory
+	source.resize(headerLen + readlen + 1);
+	source.back() = 0;
+	return true;
+}
+
+bool GLSLShader::CompileShader( GLhandleARB shader, const std::vector<char>& source, const char* debugName, const bool checkStatus ) const
+{
+	const GLcharARB*  bufferARB = source.data();
+	GLint   len = static_cast<GLint>(source.size()) - 1;
+	GLint   compileStatus;
+
 	glShaderSourceARB( shader, 1, &bufferARB, &len );
 	// compile shader
 	glCompileShaderARB( shader );
 
+	if (!checkStatus)
+		return true;
+
 	glGetObjectParameterivARB ( shader, GL_OBJECT_COMPILE_STATUS_ARB, &compileStatus );
 
 	if (compileStatus == GL_FALSE || PRINT_WARNINGS)
@@ -307,6 +472,32 @@ void GLSLShader::Free()
   programObj = 0;
   vertex = 0;
   fragment = 0;
+
+  mIsFromCache = false;
+  mLinkPending = false;
+  mOwnVertexLog = false;
+  mVertexSource.clear();
+  mFragmentSource.clear();
+}
+
+GLhandleARB GLSLShader::GetVertexShader() const
+{
+	if (0 == vertex && !mVertexSource.empty())
+	{
+		vertex = glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
+		CompileShader(vertex, mVertexSource, "cached vertex shader");
+	}
+	return vertex;
+}
+
+GLhandleARB GLSLShader::GetFragmentShader() const
+{
+	if (0 == fragment && !mFragmentSource.empty())
+	{
+		fragment = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
+		CompileShader(fragment, mFragmentSource, "cached fragment shader");
+	}
+	return fragment;
 }
 
 GLint GLSLShader::findLocation( const char *name ) const
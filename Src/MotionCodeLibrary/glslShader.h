@@ -10,20 +10,31 @@ GitHub page - https://github.com/Neill3d/OpenMoBu
 Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
 */
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
-#include <GL\glew.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <vector>
+#include <chrono>
+
+// glew headers don't have it yet
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR	0x91B0
+#define GL_COMPLETION_STATUS_KHR			0x91B1
+#endif
 
 ///
 /// profile for GLSL, OpenGL 2.0+
 ///
 class GLSLShader
 {
-	/// vertex shader handle
-	GLhandleARB     vertex{ 0 };
+	/// vertex shader handle, compiled on demand when a program is linked from a binary cache
+	mutable GLhandleARB     vertex{ 0 };
 
-	/// fragment handle
-	GLhandleARB     fragment{ 0 };
+	/// fragment handle, compiled on demand when a program is linked from a binary cache
+	mutable GLhandleARB     fragment{ 0 };
 
 	/// v & f
 	GLhandleARB     programObj{ 0 };
@@ -31,7 +42,23 @@ class GLSLShader
 	/// shader header text (defines)
 	char          mHeaderText[256]{ 0 };
 
+	/// program is linked from a binary cache, shader objects are not attached
+	bool			mIsFromCache{ false };
+	/// sources with a header, kept only for a program from a binary cache
+	std::vector<char>	mVertexSource;
+	std::vector<char>	mFragmentSource;
+
+	/// link is issued, but its status is not queried yet
+	bool			mLinkPending{ false };
+	/// vertex shader is compiled by this program, it's not a shared one
+	bool			mOwnVertexLog{ false };
+	unsigned long long	mCacheKey{ 0 };
+	std::chrono::high_resolution_clock::time_point	mLinkStartTime;
+
   bool LoadShader( GLhandleARB shader, FILE *file, const char* debugName );
+  bool ReadShaderSource( FILE *file, std::vector<char>& source, const char* debugName ) const;
+  bool CompileShader( GLhandleARB shader, const std::vector<char>& source, const char* debugName, const bool checkStatus = true ) const;
+  void LinkProgram( const unsigned long long cacheKey );
   bool LoadLog( GLhandleARB object, const char* debugName ) const;
 
 public:
@@ -46,7 +73,7 @@ public:
 
   void SetHeaderText( const char *text ) {
 	  memset(mHeaderText, 0, sizeof(char) * 256 );
-	  strcpy_s(mHeaderText, 256, text);
+	  snprintf(mHeaderText, 256, "%s", text);
   }
 
   bool LoadShaders( const char* vertex_file, const char* fragment_file );
@@ -54,6 +81,21 @@ bool	LoadShaders( GLhandleARB	_vertex,	const char* fragment_file );
 
 	bool ReCompileShaders(const char* vertex_file, const char* fragment_file );
 
+	/// compile and link without waiting for a status, with GL_KHR_parallel_shader_compile a driver does it on worker threads
+	///  FinishLink must be called before a program is used
+	bool BeginLoadShaders( const char* vertex_file, const char* fragment_file );
+	bool BeginLoadShaders( GLhandleARB _vertex, const char* fragment_file );
+
+	/// non blocking check of a pending link, it's always true without a parallel compile support
+	bool IsLinkCompleted() const;
+	bool IsLinkPending() const { return mLinkPending; }
+
+	/// wait for a pending link, print logs and store a program binary
+	bool FinishLink( const char* debugName );
+
+	/// GL_KHR_parallel_shader_compile (or ARB) support, a driver is asked to use all compiler threads on a first call
+	static bool IsParallelCompileSupported();
+
 
   void Bind() const;
   void UnBind() const;
@@ -100,12 +142,8 @@ bool	LoadShaders( GLhandleARB	_vertex,	const char* fragment_file );
 		bindTexture(GL_TEXTURE_RECTANGLE_ARB, texname, texid, texunit);
 	}
 
-	GLhandleARB		GetVertexShader() const {
-		return vertex;
-	}
-	GLhandleARB		GetFragmentShader() const {
-		return fragment;
-	}
+	GLhandleARB		GetVertexShader() const;
+	GLhandleARB		GetFragmentShader() const;
 	GLhandleARB		GetProgramObj() const {
 		return programObj;
 	}
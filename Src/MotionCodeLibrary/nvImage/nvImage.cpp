@@ -40,7 +40,19 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <string.h>
+#include <stdio.h>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "nvImage.h"
 
@@ -60,6 +72,8 @@ Image::FormatInfo Image::formatTable[] = {
 };
 
 bool Image::upperLeftOrigin = true;
+int Image::flipThreads = 0;
+bool Image::fileMapping = true;
 
 //
 //
@@ -68,11 +82,27 @@ void Image::UpperLeftOrigin( bool ul) {
     upperLeftOrigin = ul;
 }
 
+//
+//
+////////////////////////////////////////////////////////////
+void Image::FlipThreads( int count) {
+    flipThreads = (count > 0) ? count : 0;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void Image::FileMapping( bool use) {
+    fileMapping = use;
+}
+
 //
 //
 ////////////////////////////////////////////////////////////
 Image::Image() : _width(0), _height(0), _depth(0), _levelCount(0), _layers(0), _format(GL_RGBA),
-    _internalFormat(GL_RGBA8), _type(GL_UNSIGNED_BYTE), _elementSize(0), _cubeMap(false) {
+    _internalFormat(GL_RGBA8), _type(GL_UNSIGNED_BYTE), _elementSize(0), _cubeMap(false),
+    _keepFileOrigin(false), _upperLeftData(false),
+    _fileHandle(NULL), _fileMapping(NULL), _fileView(NULL), _fileSize(0), _fileMapped(false) {
 }
 
 //
@@ -86,10 +116,154 @@ Image::~Image() {
 //
 ////////////////////////////////////////////////////////////
 void Image::freeData() {
-    for (vector<GLubyte*>::iterator it = _data.begin(); it != _data.end(); ++it) {
-        delete []*it;
+    if (_fileView) {
+        //levels are pointers into a file view
+        unmapFile();
+    }
+    else {
+        for (vector<GLubyte*>::iterator it = _data.begin(); it != _data.end(); ++it) {
+            delete []*it;
+        }
     }
     _data.clear();
+    _upperLeftData = false;
+}
+
+//
+// map a whole file with a copy-on-write access, a flip in place touches only private pages
+////////////////////////////////////////////////////////////
+bool Image::mapFile( const char* file) {
+    freeData();
+
+    if (!fileMapping)
+        return readFile(file);
+
+#ifdef WIN32
+    HANDLE hFile = CreateFileA( file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx( hFile, &size) || size.QuadPart == 0) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA( hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (hMapping == NULL) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    void *view = MapViewOfFile( hMapping, FILE_MAP_COPY, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    _fileHandle = hFile;
+    _fileMapping = hMapping;
+    _fileView = (GLubyte*) view;
+    _fileSize = (size_t) size.QuadPart;
+#else
+    int fd = open( file, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat( fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    //private mapping is a copy-on-write one, the descriptor is not needed after mmap
+    void *view = mmap( NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    _fileView = (GLubyte*) view;
+    _fileSize = (size_t) st.st_size;
+#endif
+    _fileMapped = true;
+    return true;
+}
+
+//
+// read a whole file with stdio into one block, levels point into it like into a mapped view
+////////////////////////////////////////////////////////////
+bool Image::readFile( const char* file) {
+    FILE *fp = fopen( file, "rb");
+    if (fp == NULL)
+        return false;
+
+    fseek( fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek( fp, 0, SEEK_SET);
+
+    if (size <= 0) {
+        fclose(fp);
+        return false;
+    }
+
+    GLubyte *view = new GLubyte[size];
+    if (fread( view, size, 1, fp) != 1) {
+        delete []view;
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    _fileView = view;
+    _fileSize = (size_t) size;
+    _fileMapped = false;
+    return true;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void Image::unmapFile() {
+    if (_fileView == NULL)
+        return;
+
+    if (!_fileMapped) {
+        delete []_fileView;
+    }
+    else {
+#ifdef WIN32
+        UnmapViewOfFile(_fileView);
+        CloseHandle((HANDLE) _fileMapping);
+        CloseHandle((HANDLE) _fileHandle);
+#else
+        munmap(_fileView, _fileSize);
+#endif
+    }
+
+    _fileHandle = NULL;
+    _fileMapping = NULL;
+    _fileView = NULL;
+    _fileSize = 0;
+    _fileMapped = false;
+}
+
+//
+// own a copy of every level, before the level pointers are replaced or deleted
+////////////////////////////////////////////////////////////
+void Image::copyMappedData() {
+    if (_fileView == NULL)
+        return;
+
+    for (size_t ii = 0; ii < _data.size(); ii++) {
+        const int size = getImageSize( (int) (ii % _levelCount));
+        GLubyte *data = new GLubyte[size];
+        memcpy( data, _data[ii], size);
+        _data[ii] = data;
+    }
+
+    unmapFile();
 }
 
 //
@@ -209,10 +383,31 @@ bool Image::loadImageFromFile( const char* file) {
     return false;
 }
 
+//
+//
+////////////////////////////////////////////////////////////
+static int flipRowPairs( bool compressed, int height)
+{
+    if (!compressed)
+        return height >> 1;
+
+    //an odd middle row of blocks is flipped in place
+    int bh = (height + 3) / 4;
+    return (bh + 1) >> 1;
+}
+
 //
 //
 ////////////////////////////////////////////////////////////
 void Image::flipSurface(GLubyte *surf, int width, int height, int depth)
+{
+    flipSurfaceRows( surf, width, height, depth, 0, flipRowPairs( isCompressed(), height));
+}
+
+//
+// swap rows [firstPair, lastPair) with their mirrored rows, a row is a line of blocks for compressed formats
+////////////////////////////////////////////////////////////
+void Image::flipSurfaceRows(GLubyte *surf, int width, int height, int depth, int firstPair, int lastPair)
 {
     unsigned int lineSize;
 
@@ -222,23 +417,21 @@ void Image::flipSurface(GLubyte *surf, int width, int height, int depth)
         lineSize = _elementSize * width;
         unsigned int sliceSize = lineSize * height;
 
-        GLubyte *tempBuf = new GLubyte[lineSize];
+        vector<GLubyte> tempBuf(lineSize);
 
         for ( int ii = 0; ii < depth; ii++) {
-            GLubyte *top = surf + ii*sliceSize;
-            GLubyte *bottom = top + (sliceSize - lineSize);
+            GLubyte *top = surf + ii*sliceSize + firstPair*lineSize;
+            GLubyte *bottom = surf + ii*sliceSize + (height - 1 - firstPair)*lineSize;
     
-            for ( int jj = 0; jj < (height >> 1); jj++) {
-                memcpy( tempBuf, top, lineSize);
+            for ( int jj = firstPair; jj < lastPair; jj++) {
+                memcpy( tempBuf.data(), top, lineSize);
                 memcpy( top, bottom, lineSize);
-                memcpy( bottom, tempBuf, lineSize);
+                memcpy( bottom, tempBuf.data(), lineSize);
 
                 top += lineSize;
                 bottom -= lineSize;
             }
         }
-
-        delete []tempBuf;
     }
     else
     {
@@ -280,12 +473,12 @@ void Image::flipSurface(GLubyte *surf, int width, int height, int depth)
         }
 
         lineSize = width * blockSize;
-        GLubyte *tempBuf = new GLubyte[lineSize];
+        vector<GLubyte> tempBuf(lineSize);
 
-        GLubyte *top = surf;
-        GLubyte *bottom = surf + (height-1) * lineSize;
+        GLubyte *top = surf + firstPair * lineSize;
+        GLubyte *bottom = surf + (height - 1 - firstPair) * lineSize;
 
-        for (unsigned int j = 0; j < max( (unsigned int)height >> 1, (unsigned int)1); j++)
+        for (int j = firstPair; j < lastPair; j++)
         {
             if (top == bottom)
             {
@@ -296,17 +489,74 @@ void Image::flipSurface(GLubyte *surf, int width, int height, int depth)
             flipblocks(top, width);
             flipblocks(bottom, width);
 
-            memcpy( tempBuf, top, lineSize);
+            memcpy( tempBuf.data(), top, lineSize);
             memcpy( top, bottom, lineSize);
-            memcpy( bottom, tempBuf, lineSize);
+            memcpy( bottom, tempBuf.data(), lineSize);
 
             top += lineSize;
             bottom -= lineSize;
         }
-        delete []tempBuf;
     }
 }    
 
+//
+// split a surface into jobs of about the same amount of memory
+////////////////////////////////////////////////////////////
+void Image::addFlipJobs( vector<FlipJob> &jobs, GLubyte *surf, int width, int height, int depth) const
+{
+    const bool compressed = isCompressed();
+    const int pairs = flipRowPairs( compressed, height);
+    if (pairs <= 0)
+        return;
+
+    const int rowWidth = (compressed) ? (width + 3) / 4 : width;
+    const int d = (depth) ? depth : 1;
+    const int pairSize = 2 * rowWidth * _elementSize * ((compressed) ? 1 : d);
+    const int pairsPerJob = max( 1, (256 * 1024) / max( 1, pairSize));
+
+    for (int first = 0; first < pairs; first += pairsPerJob) {
+        FlipJob job = { surf, width, height, depth, first, std::min( pairs, first + pairsPerJob) };
+        jobs.push_back(job);
+    }
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void Image::runFlipJobs( const vector<FlipJob> &jobs)
+{
+    const int numberOfJobs = (int) jobs.size();
+    int numberOfThreads = (flipThreads > 0) ? flipThreads : (int) std::thread::hardware_concurrency();
+    numberOfThreads = std::min( max( 1, numberOfThreads), numberOfJobs);
+
+    if (numberOfThreads <= 1) {
+        for (int ii = 0; ii < numberOfJobs; ii++) {
+            const FlipJob &job = jobs[ii];
+            flipSurfaceRows( job.surf, job.width, job.height, job.depth, job.firstPair, job.lastPair);
+        }
+        return;
+    }
+
+    //jobs have different sizes (mip levels), threads take a next one when ready
+    std::atomic<int> nextJob(0);
+    auto worker = [this, &jobs, &nextJob, numberOfJobs]() {
+        for (int ii = nextJob++; ii < numberOfJobs; ii = nextJob++) {
+            const FlipJob &job = jobs[ii];
+            flipSurfaceRows( job.surf, job.width, job.height, job.depth, job.firstPair, job.lastPair);
+        }
+    };
+
+    vector<std::thread> threads;
+    threads.reserve(numberOfThreads - 1);
+    for (int ii = 1; ii < numberOfThreads; ii++)
+        threads.push_back( std::thread(worker));
+
+    worker();
+
+    for (auto &thread : threads)
+        thread.join();
+}
+
 //
 //
 ////////////////////////////////////////////////////////////
@@ -327,6 +577,9 @@ bool Image::convertCrossToCubemap() {
     if (  (_width / 3 != _height / 4) || (_width % 3 != 0) || (_height % 4 != 0) || (_depth != 0))
         return false;
 
+    //faces are new allocations, the source level is deleted below
+    copyMappedData();
+
     //get the source data
     GLubyte *data = _data[0];
 
@@ -69,6 +69,12 @@ namespace nv {
         // the texture coordinate conventions of an imported model.
         NVSDKENTRY static void UpperLeftOrigin( bool ul);
 
+        // Number of threads used to flip surfaces of a loaded image (0 - one per hardware thread)
+        NVSDKENTRY static void FlipThreads( int count);
+
+        // Memory-map dds files (default), otherwise a file is read with stdio into one block
+        NVSDKENTRY static void FileMapping( bool use);
+
         NVSDKENTRY Image();
         NVSDKENTRY virtual ~Image();
 
@@ -140,6 +146,16 @@ namespace nv {
         //initialize an image from a file
         NVSDKENTRY bool loadImageFromFile( const char* file);
 
+        //skip the vertical flip on load (call before loading), rows stay in the file order
+        // the caller checks hasUpperLeftOrigin() and flips texture coordinates instead
+        NVSDKENTRY void setKeepFileOrigin( bool keep) { _keepFileOrigin = keep; }
+
+        //return whether the first row of level data is the top row of the image
+        NVSDKENTRY bool hasUpperLeftOrigin() const { return _upperLeftData; }
+
+        //return whether level pointers go straight into a memory-mapped file (dds)
+        NVSDKENTRY bool isMapped() const { return _fileMapped; }
+
         //convert a suitable image from a cubemap cross to a cubemap (returns false for unsuitable images)
         NVSDKENTRY bool convertCrossToCubemap();
 
@@ -160,12 +176,39 @@ namespace nv {
         GLenum _type;
         int _elementSize;
         bool _cubeMap;
+        bool _keepFileOrigin;
+        bool _upperLeftData;
 
         //pointers to the levels
         std::vector<GLubyte*> _data;
 
+        //copy-on-write view of a file (or a block read with stdio), levels point into it and are not freed one by one
+        void *_fileHandle;
+        void *_fileMapping;
+        GLubyte *_fileView;
+        size_t _fileSize;
+        bool _fileMapped;
+
+        //a surface and a range of its row pairs to swap, one job for a flip thread
+        struct FlipJob {
+            GLubyte *surf;
+            int width;
+            int height;
+            int depth;
+            int firstPair;
+            int lastPair;
+        };
+
         NVSDKENTRY void freeData();
         NVSDKENTRY void flipSurface(GLubyte *surf, int width, int height, int depth);
+        NVSDKENTRY void flipSurfaceRows(GLubyte *surf, int width, int height, int depth, int firstPair, int lastPair);
+        NVSDKENTRY void addFlipJobs(std::vector<FlipJob> &jobs, GLubyte *surf, int width, int height, int depth) const;
+        NVSDKENTRY void runFlipJobs(const std::vector<FlipJob> &jobs);
+
+        NVSDKENTRY bool mapFile(const char* file);
+        NVSDKENTRY bool readFile(const char* file);
+        NVSDKENTRY void unmapFile();
+        NVSDKENTRY void copyMappedData();
 
 
         //
@@ -180,6 +223,8 @@ namespace nv {
 
         static FormatInfo formatTable[]; 
         static bool upperLeftOrigin;
+        static int flipThreads;
+        static bool fileMapping;
 
         NVSDKENTRY static bool readPng( const char *file, Image& i)
         {
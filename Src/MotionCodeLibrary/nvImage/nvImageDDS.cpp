@@ -40,6 +40,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "nvImage.h"
 
@@ -54,216 +56,216 @@ namespace nv {
 //////////////////////////////////////////////////////////////////////
 
 // surface description flags
-const unsigned long DDSF_CAPS           = 0x00000001l;
-const unsigned long DDSF_HEIGHT         = 0x00000002l;
-const unsigned long DDSF_WIDTH          = 0x00000004l;
-const unsigned long DDSF_PITCH          = 0x00000008l;
-const unsigned long DDSF_PIXELFORMAT    = 0x00001000l;
-const unsigned long DDSF_MIPMAPCOUNT    = 0x00020000l;
-const unsigned long DDSF_LINEARSIZE     = 0x00080000l;
-const unsigned long DDSF_DEPTH          = 0x00800000l;
+const uint32_t DDSF_CAPS           = 0x00000001l;
+const uint32_t DDSF_HEIGHT         = 0x00000002l;
+const uint32_t DDSF_WIDTH          = 0x00000004l;
+const uint32_t DDSF_PITCH          = 0x00000008l;
+const uint32_t DDSF_PIXELFORMAT    = 0x00001000l;
+const uint32_t DDSF_MIPMAPCOUNT    = 0x00020000l;
+const uint32_t DDSF_LINEARSIZE     = 0x00080000l;
+const uint32_t DDSF_DEPTH          = 0x00800000l;
 
 // pixel format flags
-const unsigned long DDSF_ALPHAPIXELS    = 0x00000001l;
-const unsigned long DDSF_FOURCC         = 0x00000004l;
-const unsigned long DDSF_RGB            = 0x00000040l;
-const unsigned long DDSF_RGBA           = 0x00000041l;
+const uint32_t DDSF_ALPHAPIXELS    = 0x00000001l;
+const uint32_t DDSF_FOURCC         = 0x00000004l;
+const uint32_t DDSF_RGB            = 0x00000040l;
+const uint32_t DDSF_RGBA           = 0x00000041l;
 
 // dwCaps1 flags
-const unsigned long DDSF_COMPLEX         = 0x00000008l;
-const unsigned long DDSF_TEXTURE         = 0x00001000l;
-const unsigned long DDSF_MIPMAP          = 0x00400000l;
+const uint32_t DDSF_COMPLEX         = 0x00000008l;
+const uint32_t DDSF_TEXTURE         = 0x00001000l;
+const uint32_t DDSF_MIPMAP          = 0x00400000l;
 
 // dwCaps2 flags
-const unsigned long DDSF_CUBEMAP         = 0x00000200l;
-const unsigned long DDSF_CUBEMAP_POSITIVEX  = 0x00000400l;
-const unsigned long DDSF_CUBEMAP_NEGATIVEX  = 0x00000800l;
-const unsigned long DDSF_CUBEMAP_POSITIVEY  = 0x00001000l;
-const unsigned long DDSF_CUBEMAP_NEGATIVEY  = 0x00002000l;
-const unsigned long DDSF_CUBEMAP_POSITIVEZ  = 0x00004000l;
-const unsigned long DDSF_CUBEMAP_NEGATIVEZ  = 0x00008000l;
-const unsigned long DDSF_CUBEMAP_ALL_FACES  = 0x0000FC00l;
-const unsigned long DDSF_VOLUME          = 0x00200000l;
+const uint32_t DDSF_CUBEMAP         = 0x00000200l;
+const uint32_t DDSF_CUBEMAP_POSITIVEX  = 0x00000400l;
+const uint32_t DDSF_CUBEMAP_NEGATIVEX  = 0x00000800l;
+const uint32_t DDSF_CUBEMAP_POSITIVEY  = 0x00001000l;
+const uint32_t DDSF_CUBEMAP_NEGATIVEY  = 0x00002000l;
+const uint32_t DDSF_CUBEMAP_POSITIVEZ  = 0x00004000l;
+const uint32_t DDSF_CUBEMAP_NEGATIVEZ  = 0x00008000l;
+const uint32_t DDSF_CUBEMAP_ALL_FACES  = 0x0000FC00l;
+const uint32_t DDSF_VOLUME          = 0x00200000l;
 
 // compressed texture types
-const unsigned long FOURCC_UNKNOWN       = 0;
+const uint32_t FOURCC_UNKNOWN       = 0;
 
 #ifndef MAKEFOURCC
 #define MAKEFOURCC(c0,c1,c2,c3) \
-	((unsigned long)(unsigned char)(c0)| \
-	((unsigned long)(unsigned char)(c1) << 8)| \
-	((unsigned long)(unsigned char)(c2) << 16)| \
-	((unsigned long)(unsigned char)(c3) << 24))
+	((uint32_t)(unsigned char)(c0)| \
+	((uint32_t)(unsigned char)(c1) << 8)| \
+	((uint32_t)(unsigned char)(c2) << 16)| \
+	((uint32_t)(unsigned char)(c3) << 24))
 #endif
 
-const unsigned long FOURCC_R8G8B8        = 20;
-const unsigned long FOURCC_A8R8G8B8      = 21;
-const unsigned long FOURCC_X8R8G8B8      = 22;
-const unsigned long FOURCC_R5G6B5        = 23;
-const unsigned long FOURCC_X1R5G5B5      = 24;
-const unsigned long FOURCC_A1R5G5B5      = 25;
-const unsigned long FOURCC_A4R4G4B4      = 26;
-const unsigned long FOURCC_R3G3B2        = 27;
-const unsigned long FOURCC_A8            = 28;
-const unsigned long FOURCC_A8R3G3B2      = 29;
-const unsigned long FOURCC_X4R4G4B4      = 30;
-const unsigned long FOURCC_A2B10G10R10   = 31;
-const unsigned long FOURCC_A8B8G8R8      = 32;
-const unsigned long FOURCC_X8B8G8R8      = 33;
-const unsigned long FOURCC_G16R16        = 34;
-const unsigned long FOURCC_A2R10G10B10   = 35;
-const unsigned long FOURCC_A16B16G16R16  = 36;
-
-const unsigned long FOURCC_L8            = 50;
-const unsigned long FOURCC_A8L8          = 51;
-const unsigned long FOURCC_A4L4          = 52;
-const unsigned long FOURCC_DXT1          = 0x31545844l; //(MAKEFOURCC('D','X','T','1'))
-const unsigned long FOURCC_DXT2          = 0x32545844l; //(MAKEFOURCC('D','X','T','1'))
-const unsigned long FOURCC_DXT3          = 0x33545844l; //(MAKEFOURCC('D','X','T','3'))
-const unsigned long FOURCC_DXT4          = 0x34545844l; //(MAKEFOURCC('D','X','T','3'))
-const unsigned long FOURCC_DXT5          = 0x35545844l; //(MAKEFOURCC('D','X','T','5'))
-const unsigned long FOURCC_ATI1          = MAKEFOURCC('A','T','I','1');
-const unsigned long FOURCC_ATI2          = MAKEFOURCC('A','T','I','2');
-const unsigned long FOURCC_BC4U          = MAKEFOURCC('B','C','4','U');
-const unsigned long FOURCC_BC4S          = MAKEFOURCC('B','C','4','S');
-const unsigned long FOURCC_BC5S          = MAKEFOURCC('B','C','5','S');
-
-const unsigned long FOURCC_D16_LOCKABLE  = 70;
-const unsigned long FOURCC_D32           = 71;
-const unsigned long FOURCC_D24X8         = 77;
-const unsigned long FOURCC_D16           = 80;
-
-const unsigned long FOURCC_D32F_LOCKABLE = 82;
-
-const unsigned long FOURCC_L16           = 81;
-
-const unsigned long FOURCC_DX10          = MAKEFOURCC('D','X','1','0');
+const uint32_t FOURCC_R8G8B8        = 20;
+const uint32_t FOURCC_A8R8G8B8      = 21;
+const uint32_t FOURCC_X8R8G8B8      = 22;
+const uint32_t FOURCC_R5G6B5        = 23;
+const uint32_t FOURCC_X1R5G5B5      = 24;
+const uint32_t FOURCC_A1R5G5B5      = 25;
+const uint32_t FOURCC_A4R4G4B4      = 26;
+const uint32_t FOURCC_R3G3B2        = 27;
+const uint32_t FOURCC_A8            = 28;
+const uint32_t FOURCC_A8R3G3B2      = 29;
+const uint32_t FOURCC_X4R4G4B4      = 30;
+const uint32_t FOURCC_A2B10G10R10   = 31;
+const uint32_t FOURCC_A8B8G8R8      = 32;
+const uint32_t FOURCC_X8B8G8R8      = 33;
+const uint32_t FOURCC_G16R16        = 34;
+const uint32_t FOURCC_A2R10G10B10   = 35;
+const uint32_t FOURCC_A16B16G16R16  = 36;
+
+const uint32_t FOURCC_L8            = 50;
+const uint32_t FOURCC_A8L8          = 51;
+const uint32_t FOURCC_A4L4          = 52;
+const uint32_t FOURCC_DXT1          = 0x31545844l; //(MAKEFOURCC('D','X','T','1'))
+const uint32_t FOURCC_DXT2          = 0x32545844l; //(MAKEFOURCC('D','X','T','1'))
+const uint32_t FOURCC_DXT3          = 0x33545844l; //(MAKEFOURCC('D','X','T','3'))
+const uint32_t FOURCC_DXT4          = 0x34545844l; //(MAKEFOURCC('D','X','T','3'))
+const uint32_t FOURCC_DXT5          = 0x35545844l; //(MAKEFOURCC('D','X','T','5'))
+const uint32_t FOURCC_ATI1          = MAKEFOURCC('A','T','I','1');
+const uint32_t FOURCC_ATI2          = MAKEFOURCC('A','T','I','2');
+const uint32_t FOURCC_BC4U          = MAKEFOURCC('B','C','4','U');
+const uint32_t FOURCC_BC4S          = MAKEFOURCC('B','C','4','S');
+const uint32_t FOURCC_BC5S          = MAKEFOURCC('B','C','5','S');
+
+const uint32_t FOURCC_D16_LOCKABLE  = 70;
+const uint32_t FOURCC_D32           = 71;
+const uint32_t FOURCC_D24X8         = 77;
+const uint32_t FOURCC_D16           = 80;
+
+const uint32_t FOURCC_D32F_LOCKABLE = 82;
+
+const uint32_t FOURCC_L16           = 81;
+
+const uint32_t FOURCC_DX10          = MAKEFOURCC('D','X','1','0');
 
 // signed normalized formats
-const unsigned long FOURCC_Q16W16V16U16  = 110;
+const uint32_t FOURCC_Q16W16V16U16  = 110;
 
 // Floating point surface formats
 
 // s10e5 formats (16-bits per channel)
-const unsigned long FOURCC_R16F          = 111;
-const unsigned long FOURCC_G16R16F       = 112;
-const unsigned long FOURCC_A16B16G16R16F = 113;
+const uint32_t FOURCC_R16F          = 111;
+const uint32_t FOURCC_G16R16F       = 112;
+const uint32_t FOURCC_A16B16G16R16F = 113;
 
 // IEEE s23e8 formats (32-bits per channel)
-const unsigned long FOURCC_R32F          = 114;
-const unsigned long FOURCC_G32R32F       = 115;
-const unsigned long FOURCC_A32B32G32R32F = 116;
+const uint32_t FOURCC_R32F          = 114;
+const uint32_t FOURCC_G32R32F       = 115;
+const uint32_t FOURCC_A32B32G32R32F = 116;
 
 //DXGI enums
-const unsigned long DDS10_FORMAT_UNKNOWN = 0;
-const unsigned long DDS10_FORMAT_R32G32B32A32_TYPELESS = 1;
-const unsigned long DDS10_FORMAT_R32G32B32A32_FLOAT = 2;
-const unsigned long DDS10_FORMAT_R32G32B32A32_UINT = 3;
-const unsigned long DDS10_FORMAT_R32G32B32A32_SINT = 4;
-const unsigned long DDS10_FORMAT_R32G32B32_TYPELESS = 5;
-const unsigned long DDS10_FORMAT_R32G32B32_FLOAT = 6;
-const unsigned long DDS10_FORMAT_R32G32B32_UINT = 7;
-const unsigned long DDS10_FORMAT_R32G32B32_SINT = 8;
-const unsigned long DDS10_FORMAT_R16G16B16A16_TYPELESS = 9;
-const unsigned long DDS10_FORMAT_R16G16B16A16_FLOAT = 10;
-const unsigned long DDS10_FORMAT_R16G16B16A16_UNORM = 11;
-const unsigned long DDS10_FORMAT_R16G16B16A16_UINT = 12;
-const unsigned long DDS10_FORMAT_R16G16B16A16_SNORM = 13;
-const unsigned long DDS10_FORMAT_R16G16B16A16_SINT = 14;
-const unsigned long DDS10_FORMAT_R32G32_TYPELESS = 15;
-const unsigned long DDS10_FORMAT_R32G32_FLOAT = 16;
-const unsigned long DDS10_FORMAT_R32G32_UINT = 17;
-const unsigned long DDS10_FORMAT_R32G32_SINT = 18;
-const unsigned long DDS10_FORMAT_R32G8X24_TYPELESS = 19;
-const unsigned long DDS10_FORMAT_D32_FLOAT_S8X24_UINT = 20;
-const unsigned long DDS10_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21;
-const unsigned long DDS10_FORMAT_X32_TYPELESS_G8X24_UINT = 22;
-const unsigned long DDS10_FORMAT_R10G10B10A2_TYPELESS = 23;
-const unsigned long DDS10_FORMAT_R10G10B10A2_UNORM = 24;
-const unsigned long DDS10_FORMAT_R10G10B10A2_UINT = 25;
-const unsigned long DDS10_FORMAT_R11G11B10_FLOAT = 26;
-const unsigned long DDS10_FORMAT_R8G8B8A8_TYPELESS = 27;
-const unsigned long DDS10_FORMAT_R8G8B8A8_UNORM = 28;
-const unsigned long DDS10_FORMAT_R8G8B8A8_UNORM_SRGB = 29;
-const unsigned long DDS10_FORMAT_R8G8B8A8_UINT = 30;
-const unsigned long DDS10_FORMAT_R8G8B8A8_SNORM = 31;
-const unsigned long DDS10_FORMAT_R8G8B8A8_SINT = 32;
-const unsigned long DDS10_FORMAT_R16G16_TYPELESS = 33;
-const unsigned long DDS10_FORMAT_R16G16_FLOAT = 34;
-const unsigned long DDS10_FORMAT_R16G16_UNORM = 35;
-const unsigned long DDS10_FORMAT_R16G16_UINT = 36;
-const unsigned long DDS10_FORMAT_R16G16_SNORM = 37;
-const unsigned long DDS10_FORMAT_R16G16_SINT = 38;
-const unsigned long DDS10_FORMAT_R32_TYPELESS = 39;
-const unsigned long DDS10_FORMAT_D32_FLOAT = 40;
-const unsigned long DDS10_FORMAT_R32_FLOAT = 41;
-const unsigned long DDS10_FORMAT_R32_UINT = 42;
-const unsigned long DDS10_FORMAT_R32_SINT = 43;
-const unsigned long DDS10_FORMAT_R24G8_TYPELESS = 44;
-const unsigned long DDS10_FORMAT_D24_UNORM_S8_UINT = 45;
-const unsigned long DDS10_FORMAT_R24_UNORM_X8_TYPELESS = 46;
-const unsigned long DDS10_FORMAT_X24_TYPELESS_G8_UINT = 47;
-const unsigned long DDS10_FORMAT_R8G8_TYPELESS = 48;
-const unsigned long DDS10_FORMAT_R8G8_UNORM = 49;
-const unsigned long DDS10_FORMAT_R8G8_UINT = 50;
-const unsigned long DDS10_FORMAT_R8G8_SNORM = 51;
-const unsigned long DDS10_FORMAT_R8G8_SINT = 52;
-const unsigned long DDS10_FORMAT_R16_TYPELESS = 53;
-const unsigned long DDS10_FORMAT_R16_FLOAT = 54;
-const unsigned long DDS10_FORMAT_D16_UNORM = 55;
-const unsigned long DDS10_FORMAT_R16_UNORM = 56;
-const unsigned long DDS10_FORMAT_R16_UINT = 57;
-const unsigned long DDS10_FORMAT_R16_SNORM = 58;
-const unsigned long DDS10_FORMAT_R16_SINT = 59;
-const unsigned long DDS10_FORMAT_R8_TYPELESS = 60;
-const unsigned long DDS10_FORMAT_R8_UNORM = 61;
-const unsigned long DDS10_FORMAT_R8_UINT = 62;
-const unsigned long DDS10_FORMAT_R8_SNORM = 63;
-const unsigned long DDS10_FORMAT_R8_SINT = 64;
-const unsigned long DDS10_FORMAT_A8_UNORM = 65;
-const unsigned long DDS10_FORMAT_R1_UNORM = 66;
-const unsigned long DDS10_FORMAT_R9G9B9E5_SHAREDEXP = 67;
-const unsigned long DDS10_FORMAT_R8G8_B8G8_UNORM = 68;
-const unsigned long DDS10_FORMAT_G8R8_G8B8_UNORM = 69;
-const unsigned long DDS10_FORMAT_BC1_TYPELESS = 70;
-const unsigned long DDS10_FORMAT_BC1_UNORM = 71;
-const unsigned long DDS10_FORMAT_BC1_UNORM_SRGB = 72;
-const unsigned long DDS10_FORMAT_BC2_TYPELESS = 73;
-const unsigned long DDS10_FORMAT_BC2_UNORM = 74;
-const unsigned long DDS10_FORMAT_BC2_UNORM_SRGB = 75;
-const unsigned long DDS10_FORMAT_BC3_TYPELESS = 76;
-const unsigned long DDS10_FORMAT_BC3_UNORM = 77;
-const unsigned long DDS10_FORMAT_BC3_UNORM_SRGB = 78;
-const unsigned long DDS10_FORMAT_BC4_TYPELESS = 79;
-const unsigned long DDS10_FORMAT_BC4_UNORM = 80;
-const unsigned long DDS10_FORMAT_BC4_SNORM = 81;
-const unsigned long DDS10_FORMAT_BC5_TYPELESS = 82;
-const unsigned long DDS10_FORMAT_BC5_UNORM = 83;
-const unsigned long DDS10_FORMAT_BC5_SNORM = 84;
-const unsigned long DDS10_FORMAT_B5G6R5_UNORM = 85;
-const unsigned long DDS10_FORMAT_B5G5R5A1_UNORM = 86;
-const unsigned long DDS10_FORMAT_B8G8R8A8_UNORM = 87;
-const unsigned long DDS10_FORMAT_B8G8R8X8_UNORM = 88;
-const unsigned long DDS10_FORMAT_R10G10B10_XR_BIAS_A2_UNORM = 89;
-const unsigned long DDS10_FORMAT_B8G8R8A8_TYPELESS = 90;
-const unsigned long DDS10_FORMAT_B8G8R8A8_UNORM_SRGB = 91;
-const unsigned long DDS10_FORMAT_B8G8R8X8_TYPELESS = 92;
-const unsigned long DDS10_FORMAT_B8G8R8X8_UNORM_SRGB = 93;
-const unsigned long DDS10_FORMAT_BC6H_TYPELESS = 94;
-const unsigned long DDS10_FORMAT_BC6H_UF16 = 95;
-const unsigned long DDS10_FORMAT_BC6H_SF16 = 96;
-const unsigned long DDS10_FORMAT_BC7_TYPELESS = 97;
-const unsigned long DDS10_FORMAT_BC7_UNORM = 98;
-const unsigned long DDS10_FORMAT_BC7_UNORM_SRGB = 99;
-const unsigned long DDS10_FORMAT_FORCE_UINT = 0xffffffffUL;
+const uint32_t DDS10_FORMAT_UNKNOWN = 0;
+const uint32_t DDS10_FORMAT_R32G32B32A32_TYPELESS = 1;
+const uint32_t DDS10_FORMAT_R32G32B32A32_FLOAT = 2;
+const uint32_t DDS10_FORMAT_R32G32B32A32_UINT = 3;
+const uint32_t DDS10_FORMAT_R32G32B32A32_SINT = 4;
+const uint32_t DDS10_FORMAT_R32G32B32_TYPELESS = 5;
+const uint32_t DDS10_FORMAT_R32G32B32_FLOAT = 6;
+const uint32_t DDS10_FORMAT_R32G32B32_UINT = 7;
+const uint32_t DDS10_FORMAT_R32G32B32_SINT = 8;
+const uint32_t DDS10_FORMAT_R16G16B16A16_TYPELESS = 9;
+const uint32_t DDS10_FORMAT_R16G16B16A16_FLOAT = 10;
+const uint32_t DDS10_FORMAT_R16G16B16A16_UNORM = 11;
+const uint32_t DDS10_FORMAT_R16G16B16A16_UINT = 12;
+const uint32_t DDS10_FORMAT_R16G16B16A16_SNORM = 13;
+const uint32_t DDS10_FORMAT_R16G16B16A16_SINT = 14;
+const uint32_t DDS10_FORMAT_R32G32_TYPELESS = 15;
+const uint32_t DDS10_FORMAT_R32G32_FLOAT = 16;
+const uint32_t DDS10_FORMAT_R32G32_UINT = 17;
+const uint32_t DDS10_FORMAT_R32G32_SINT = 18;
+const uint32_t DDS10_FORMAT_R32G8X24_TYPELESS = 19;
+const uint32_t DDS10_FORMAT_D32_FLOAT_S8X24_UINT = 20;
+const uint32_t DDS10_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21;
+const uint32_t DDS10_FORMAT_X32_TYPELESS_G8X24_UINT = 22;
+const uint32_t DDS10_FORMAT_R10G10B10A2_TYPELESS = 23;
+const uint32_t DDS10_FORMAT_R10G10B10A2_UNORM = 24;
+const uint32_t DDS10_FORMAT_R10G10B10A2_UINT = 25;
+const uint32_t DDS10_FORMAT_R11G11B10_FLOAT = 26;
+const uint32_t DDS10_FORMAT_R8G8B8A8_TYPELESS = 27;
+const uint32_t DDS10_FORMAT_R8G8B8A8_UNORM = 28;
+const uint32_t DDS10_FORMAT_R8G8B8A8_UNORM_SRGB = 29;
+const uint32_t DDS10_FORMAT_R8G8B8A8_UINT = 30;
+const uint32_t DDS10_FORMAT_R8G8B8A8_SNORM = 31;
+const uint32_t DDS10_FORMAT_R8G8B8A8_SINT = 32;
+const uint32_t DDS10_FORMAT_R16G16_TYPELESS = 33;
+const uint32_t DDS10_FORMAT_R16G16_FLOAT = 34;
+const uint32_t DDS10_FORMAT_R16G16_UNORM = 35;
+const uint32_t DDS10_FORMAT_R16G16_UINT = 36;
+const uint32_t DDS10_FORMAT_R16G16_SNORM = 37;
+const uint32_t DDS10_FORMAT_R16G16_SINT = 38;
+const uint32_t DDS10_FORMAT_R32_TYPELESS = 39;
+const uint32_t DDS10_FORMAT_D32_FLOAT = 40;
+const uint32_t DDS10_FORMAT_R32_FLOAT = 41;
+const uint32_t DDS10_FORMAT_R32_UINT = 42;
+const uint32_t DDS10_FORMAT_R32_SINT = 43;
+const uint32_t DDS10_FORMAT_R24G8_TYPELESS = 44;
+const uint32_t DDS10_FORMAT_D24_UNORM_S8_UINT = 45;
+const uint32_t DDS10_FORMAT_R24_UNORM_X8_TYPELESS = 46;
+const uint32_t DDS10_FORMAT_X24_TYPELESS_G8_UINT = 47;
+const uint32_t DDS10_FORMAT_R8G8_TYPELESS = 48;
+const uint32_t DDS10_FORMAT_R8G8_UNORM = 49;
+const uint32_t DDS10_FORMAT_R8G8_UINT = 50;
+const uint32_t DDS10_FORMAT_R8G8_SNORM = 51;
+const uint32_t DDS10_FORMAT_R8G8_SINT = 52;
+const uint32_t DDS10_FORMAT_R16_TYPELESS = 53;
+const uint32_t DDS10_FORMAT_R16_FLOAT = 54;
+const uint32_t DDS10_FORMAT_D16_UNORM = 55;
+const uint32_t DDS10_FORMAT_R16_UNORM = 56;
+const uint32_t DDS10_FORMAT_R16_UINT = 57;
+const uint32_t DDS10_FORMAT_R16_SNORM = 58;
+const uint32_t DDS10_FORMAT_R16_SINT = 59;
+const uint32_t DDS10_FORMAT_R8_TYPELESS = 60;
+const uint32_t DDS10_FORMAT_R8_UNORM = 61;
+const uint32_t DDS10_FORMAT_R8_UINT = 62;
+const uint32_t DDS10_FORMAT_R8_SNORM = 63;
+const uint32_t DDS10_FORMAT_R8_SINT = 64;
+const uint32_t DDS10_FORMAT_A8_UNORM = 65;
+const uint32_t DDS10_FORMAT_R1_UNORM = 66;
+const uint32_t DDS10_FORMAT_R9G9B9E5_SHAREDEXP = 67;
+const uint32_t DDS10_FORMAT_R8G8_B8G8_UNORM = 68;
+const uint32_t DDS10_FORMAT_G8R8_G8B8_UNORM = 69;
+const uint32_t DDS10_FORMAT_BC1_TYPELESS = 70;
+const uint32_t DDS10_FORMAT_BC1_UNORM = 71;
+const uint32_t DDS10_FORMAT_BC1_UNORM_SRGB = 72;
+const uint32_t DDS10_FORMAT_BC2_TYPELESS = 73;
+const uint32_t DDS10_FORMAT_BC2_UNORM = 74;
+const uint32_t DDS10_FORMAT_BC2_UNORM_SRGB = 75;
+const uint32_t DDS10_FORMAT_BC3_TYPELESS = 76;
+const uint32_t DDS10_FORMAT_BC3_UNORM = 77;
+const uint32_t DDS10_FORMAT_BC3_UNORM_SRGB = 78;
+const uint32_t DDS10_FORMAT_BC4_TYPELESS = 79;
+const uint32_t DDS10_FORMAT_BC4_UNORM = 80;
+const uint32_t DDS10_FORMAT_BC4_SNORM = 81;
+const uint32_t DDS10_FORMAT_BC5_TYPELESS = 82;
+const uint32_t DDS10_FORMAT_BC5_UNORM = 83;
+const uint32_t DDS10_FORMAT_BC5_SNORM = 84;
+const uint32_t DDS10_FORMAT_B5G6R5_UNORM = 85;
+const uint32_t DDS10_FORMAT_B5G5R5A1_UNORM = 86;
+const uint32_t DDS10_FORMAT_B8G8R8A8_UNORM = 87;
+const uint32_t DDS10_FORMAT_B8G8R8X8_UNORM = 88;
+const uint32_t DDS10_FORMAT_R10G10B10_XR_BIAS_A2_UNORM = 89;
+const uint32_t DDS10_FORMAT_B8G8R8A8_TYPELESS = 90;
+const uint32_t DDS10_FORMAT_B8G8R8A8_UNORM_SRGB = 91;
+const uint32_t DDS10_FORMAT_B8G8R8X8_TYPELESS = 92;
+const uint32_t DDS10_FORMAT_B8G8R8X8_UNORM_SRGB = 93;
+const uint32_t DDS10_FORMAT_BC6H_TYPELESS = 94;
+const uint32_t DDS10_FORMAT_BC6H_UF16 = 95;
+const uint32_t DDS10_FORMAT_BC6H_SF16 = 96;
+const uint32_t DDS10_FORMAT_BC7_TYPELESS = 97;
+const uint32_t DDS10_FORMAT_BC7_UNORM = 98;
+const uint32_t DDS10_FORMAT_BC7_UNORM_SRGB = 99;
+const uint32_t DDS10_FORMAT_FORCE_UINT = 0xffffffffUL;
 
 
 //DDS 10 resource dimension enums
-const unsigned long DDS10_RESOURCE_DIMENSION_UNKNOWN = 0;
-const unsigned long DDS10_RESOURCE_DIMENSION_BUFFER = 1;
-const unsigned long DDS10_RESOURCE_DIMENSION_TEXTURE1D = 2;
-const unsigned long DDS10_RESOURCE_DIMENSION_TEXTURE2D = 3;
-const unsigned long DDS10_RESOURCE_DIMENSION_TEXTURE3D = 4;
+const uint32_t DDS10_RESOURCE_DIMENSION_UNKNOWN = 0;
+const uint32_t DDS10_RESOURCE_DIMENSION_BUFFER = 1;
+const uint32_t DDS10_RESOURCE_DIMENSION_TEXTURE1D = 2;
+const uint32_t DDS10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+const uint32_t DDS10_RESOURCE_DIMENSION_TEXTURE3D = 4;
 
 
 struct DXTColBlock
@@ -289,45 +291,48 @@ struct DXT5AlphaBlock
 
 struct DDS_PIXELFORMAT
 {
-    unsigned long dwSize;
-    unsigned long dwFlags;
-    unsigned long dwFourCC;
-    unsigned long dwRGBBitCount;
-    unsigned long dwRBitMask;
-    unsigned long dwGBitMask;
-    unsigned long dwBBitMask;
-    unsigned long dwABitMask;
+    uint32_t dwSize;
+    uint32_t dwFlags;
+    uint32_t dwFourCC;
+    uint32_t dwRGBBitCount;
+    uint32_t dwRBitMask;
+    uint32_t dwGBitMask;
+    uint32_t dwBBitMask;
+    uint32_t dwABitMask;
 };
 
 struct DDS_HEADER
 {
-    unsigned long dwSize;
-    unsigned long dwFlags;
-    unsigned long dwHeight;
-    unsigned long dwWidth;
-    unsigned long dwPitchOrLinearSize;
-    unsigned long dwDepth;
-    unsigned long dwMipMapCount;
-    unsigned long dwReserved1[11];
+    uint32_t dwSize;
+    uint32_t dwFlags;
+    uint32_t dwHeight;
+    uint32_t dwWidth;
+    uint32_t dwPitchOrLinearSize;
+    uint32_t dwDepth;
+    uint32_t dwMipMapCount;
+    uint32_t dwReserved1[11];
     DDS_PIXELFORMAT ddspf;
-    unsigned long dwCaps1;
-    unsigned long dwCaps2;
-    unsigned long dwReserved2[3];
+    uint32_t dwCaps1;
+    uint32_t dwCaps2;
+    uint32_t dwReserved2[3];
 };
 
+// dds headers have fixed 32 bit fields, the file layout has to match on LP64 too
+static_assert(sizeof(DDS_HEADER) == 124, "DDS_HEADER has to be 124 bytes");
+
 struct DDS_HEADER_10
 {
-    unsigned long dxgiFormat;  // check type
-    unsigned long resourceDimension; //check type
-    unsigned long miscFlag;
-    unsigned long arraySize;
-    unsigned long reserved;
+    uint32_t dxgiFormat;  // check type
+    uint32_t resourceDimension; //check type
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t reserved;
 };
 
 //
 //
 ////////////////////////////////////////////////////////////
-bool nv::TranslateDX10Format( const void *ptr, Image &i, int &bytesPerElement, bool &btcCompressed) {
+bool TranslateDX10Format( const void *ptr, Image &i, int &bytesPerElement, bool &btcCompressed) {
     const DDS_HEADER_10 &header = *(const DDS_HEADER_10*)ptr;
 
     printf( "translating DX10 Format\n");
@@ -691,24 +696,27 @@ bool nv::TranslateDX10Format( const void *ptr, Image &i, int &bytesPerElement, b
 ////////////////////////////////////////////////////////////
 bool Image::readDDS( const char *file, Image& i) {
 
-    // open file
-    FILE *fp = fopen(file, "rb");
-    if (fp == NULL)
+    // map the file, levels are handed out as pointers into the view
+    if (!i.mapFile(file))
         return false;
 
+    const GLubyte *fileData = i._fileView;
+    const size_t fileSize = i._fileSize;
+    size_t offset = 0;
+
     // read in file marker, make sure its a DDS file
-    char filecode[4];
-    fread(filecode, 1, 4, fp);
-    if (strncmp(filecode, "DDS ", 4) != 0)
+    if (fileSize < 4 + sizeof(DDS_HEADER) || strncmp((const char*) fileData, "DDS ", 4) != 0)
     {
-        fclose(fp);
+        i.freeData();
         return false;
     }
+    offset += 4;
 
     // read in DDS header
     DDS_HEADER ddsh;
     DDS_HEADER_10 ddsh10;
-    fread(&ddsh, sizeof(DDS_HEADER), 1, fp);
+    memcpy(&ddsh, fileData + offset, sizeof(DDS_HEADER));
+    offset += sizeof(DDS_HEADER);
 
     // check if image is a volume texture
     if ((ddsh.dwCaps2 & DDSF_VOLUME) && (ddsh.dwDepth > 0))
@@ -718,7 +726,12 @@ bool Image::readDDS( const char *file, Image& i) {
 
     if ((ddsh.ddspf.dwFlags & DDSF_FOURCC) && (ddsh.ddspf.dwFourCC == FOURCC_DX10)) {
         //This DDS file uses the DX10 header extension
-        fread(&ddsh10, sizeof(DDS_HEADER_10), 1, fp);
+        if (offset + sizeof(DDS_HEADER_10) > fileSize) {
+            i.freeData();
+            return false;
+        }
+        memcpy(&ddsh10, fileData + offset, sizeof(DDS_HEADER_10));
+        offset += sizeof(DDS_HEADER_10);
     }
 
     // There are flags that are supposed to mark these fields as valid, but some dds files don't set them properly
@@ -744,7 +757,7 @@ bool Image::readDDS( const char *file, Image& i) {
 
         //check for a complete cubemap
         if ( (i._layers != 6) || (i._width != i._height) ) {
-            fclose(fp);
+            i.freeData();
             return false;
         }
 
@@ -979,7 +992,7 @@ bool Image::readDDS( const char *file, Image& i) {
 
             case FOURCC_DX10:
                 if (!TranslateDX10Format( &ddsh10, i, bytesPerElement, btcCompressed)) {
-                    fclose(fp);
+                    i.freeData();
                     return false; //translation from DX10 failed
                 }
                 break;
@@ -999,7 +1012,7 @@ bool Image::readDDS( const char *file, Image& i) {
             case FOURCC_D32F_LOCKABLE:
                 //these are unsupported for now
             default:
-                fclose(fp);
+                i.freeData();
                 return false;
         }
     }
@@ -1078,27 +1091,35 @@ bool Image::readDDS( const char *file, Image& i) {
 	}
     else 
     {
-        fclose(fp);
+        i.freeData();
         return false;
     }
 
     i._elementSize = bytesPerElement;
 
+    const bool flip = Image::upperLeftOrigin && !i._cubeMap && !i._keepFileOrigin;
+    vector<FlipJob> flipJobs;
+
     for (int face = 0; face < i._layers; face++) {
         int w = i._width, h = i._height, d = (i._depth) ? i._depth : 1;
         for (int level = 0; level < i._levelCount; level++) {
             int bw = (btcCompressed) ? (w+3)/4 : w;
             int bh = (btcCompressed) ? (h+3)/4 : h;
-            int size = bw*bh*d*bytesPerElement;
+            size_t size = (size_t) bw*bh*d*bytesPerElement;
 
-            GLubyte *data = new GLubyte[size];
+            // truncated file
+            if (offset + size > fileSize) {
+                i.freeData();
+                return false;
+            }
 
-            fread( data, size, 1, fp);
+            GLubyte *data = i._fileView + offset;
+            offset += size;
 
             i._data.push_back(data);
 
-            if ( Image::upperLeftOrigin && !i._cubeMap)
-                i.flipSurface( data, w, h, d);
+            if (flip)
+                i.addFlipJobs( flipJobs, data, w, h, d);
 
             //reduce mip sizes
             w = ( w > 1) ? w >> 1 : 1;
@@ -1107,7 +1128,10 @@ bool Image::readDDS( const char *file, Image& i) {
         }
     }
 
-    fclose(fp);
+    // all mips, faces and layers are flipped in parallel, in place of the copy-on-write view
+    i.runFlipJobs(flipJobs);
+    i._upperLeftData = !flip;
+
     return true;
 }
 
@@ -1172,8 +1196,8 @@ void flip_dxt5_alpha(DXT5AlphaBlock *block)
 {
     GLubyte gBits[4][4];
     
-    const unsigned long mask = 0x00000007;          // bits = 00 00 01 11
-    unsigned long bits = 0;
+    const uint32_t mask = 0x00000007;          // bits = 00 00 01 11
+    uint32_t bits = 0;
     memcpy(&bits, &block->row[0], sizeof(unsigned char) * 3);
 
     gBits[0][0] = (GLubyte)(bits & mask);
@@ -1214,7 +1238,7 @@ void flip_dxt5_alpha(DXT5AlphaBlock *block)
     // clear existing alpha bits
     memset(block->row, 0, sizeof(GLubyte) * 6);
 
-    unsigned long *pBits = ((unsigned long*) &(block->row[0]));
+    uint32_t *pBits = ((uint32_t*) &(block->row[0]));
 
     *pBits = *pBits | (gBits[3][0] << 0);
     *pBits = *pBits | (gBits[3][1] << 3);
@@ -1226,7 +1250,7 @@ void flip_dxt5_alpha(DXT5AlphaBlock *block)
     *pBits = *pBits | (gBits[2][2] << 18);
     *pBits = *pBits | (gBits[2][3] << 21);
 
-    pBits = ((unsigned long*) &(block->row[3]));
+    pBits = ((uint32_t*) &(block->row[3]));
 
     *pBits = *pBits | (gBits[1][0] << 0);
     *pBits = *pBits | (gBits[1][1] << 3);
@@ -0,0 +1,639 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "xmlPullParser.h"
+#include <stdlib.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	inline bool IsSpace(const char c)
+	{
+		return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+	}
+
+	inline bool IsNameEnd(const char c)
+	{
+		return IsSpace(c) || '/' == c || '>' == c || '=' == c;
+	}
+
+	inline bool StartsWith(const char* curr, const char* end, const char* pattern, const size_t len)
+	{
+		return static_cast<size_t>(end - curr) >= len && 0 == memcmp(curr, pattern, len);
+	}
+
+	// utf-8 encoding of a character reference
+	char* EncodeCodePoint(char* dst, const unsigned long code)
+	{
+		if (code < 0x80)
+		{
+			*dst++ = static_cast<char>(code);
+		}
+		else if (code < 0x800)
+		{
+			*dst++ = static_cast<char>(0xC0 | (code >> 6));
+			*dst++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000)
+		{
+			*dst++ = static_cast<char>(0xE0 | (code >> 12));
+			*dst++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			*dst++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			*dst++ = static_cast<char>(0xF0 | (code >> 18));
+			*dst++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			*dst++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			*dst++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+		return dst;
+	}
+
+	constexpr size_t MAX_NUMBER_LENGTH{ 63 };
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// XmlStringView
+
+int XmlStringView::ToInt(const int defValue) const
+{
+	if (0 == len || len > MAX_NUMBER_LENGTH)
+		return defValue;
+
+	char buffer[MAX_NUMBER_LENGTH + 1];
+	memcpy(buffer, ptr, len);
+	buffer[len] = 0;
+
+	char* end = nullptr;
+	const long value = strtol(buffer, &end, 10);
+	return (end != buffer) ? static_cast<int>(value) : defValue;
+}
+
+double XmlStringView::ToDouble(const double defValue) const
+{
+	if (0 == len || len > MAX_NUMBER_LENGTH)
+		return defValue;
+
+	char buffer[MAX_NUMBER_LENGTH + 1];
+	memcpy(buffer, ptr, len);
+	buffer[len] = 0;
+
+	char* end = nullptr;
+	const double value = strtod(buffer, &end);
+	return (end != buffer) ? value : defValue;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// XmlArena
+
+XmlArena::XmlArena(const size_t blockSize)
+	: mBlockSize(blockSize)
+{}
+
+void* XmlArena::Alloc(const size_t size, const size_t align)
+{
+	mUsedBytes += size;
+	mPeakBytes = std::max(mPeakBytes, mUsedBytes);
+
+	if (size > mBlockSize / 2)
+	{
+		mLargeBlocks.emplace_back(new char[size]);
+		mLargeBytes += size;
+		return mLargeBlocks.back().get();
+	}
+
+	size_t offset = (mOffset + align - 1) & ~(align - 1);
+
+	if (mCurrBlock >= mBlocks.size() || offset + size > mBlockSize)
+	{
+		if (mCurrBlock < mBlocks.size())
+			mCurrBlock += 1;
+		if (mCurrBlock >= mBlocks.size())
+			mBlocks.emplace_back(new char[mBlockSize]);
+		offset = 0;
+	}
+
+	mOffset = offset + size;
+	return mBlocks[mCurrBlock].get() + offset;
+}
+
+void XmlArena::Rewind()
+{
+	mLargeBlocks.clear();
+	mLargeBytes = 0;
+
+	mCurrBlock = 0;
+	mOffset = 0;
+	mUsedBytes = 0;
+}
+
+void XmlArena::Free()
+{
+	Rewind();
+	mBlocks.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// XmlPullParser
+
+XmlPullParser::~XmlPullParser()
+{
+	Close();
+}
+
+bool XmlPullParser::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (INVALID_HANDLE_VALUE == hFile)
+		return false;
+	mFile = hFile;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || 0 == fileSize.QuadPart)
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mMappedData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (nullptr == mMappedData)
+	{
+		Close();
+		return false;
+	}
+
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (0 != fstat(fd, &fileStat) || 0 == fileStat.st_size)
+	{
+		close(fd);
+		return false;
+	}
+
+	// a mapping stays valid after a descriptor is closed
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == data)
+		return false;
+
+	mMappedData = static_cast<const char*>(data);
+	mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	mData = mMappedData;
+	Reset();
+	return true;
+}
+
+bool XmlPullParser::OpenBuffer(const char* data, const size_t size)
+{
+	Close();
+
+	if (nullptr == data)
+		return false;
+
+	mData = data;
+	mSize = size;
+	Reset();
+	return true;
+}
+
+void XmlPullParser::Close()
+{
+#ifdef _WIN32
+	if (mMappedData)
+		UnmapViewOfFile(mMappedData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile)
+		CloseHandle(mFile);
+#else
+	if (mMappedData)
+		munmap(const_cast<char*>(mMappedData), mSize);
+#endif
+
+	mMappedData = nullptr;
+	mMapping = nullptr;
+	mFile = nullptr;
+
+	mData = nullptr;
+	mSize = 0;
+	Reset();
+	mArena.Free();
+}
+
+void XmlPullParser::Reset()
+{
+	mCurr = mData;
+	mEnd = mData + mSize;
+
+	// utf-8 byte order mark
+	if (mSize >= 3 && 0 == memcmp(mData, "\xEF\xBB\xBF", 3))
+		mCurr += 3;
+
+	mEvent = eXmlEventNone;
+	mDepth = 0;
+	mPendingEnd = false;
+	mName = XmlStringView();
+	mText = XmlStringView();
+
+	mAttributes = nullptr;
+	mNumberOfAttributes = 0;
+	mAttributesCapacity = 0;
+
+	mStack.clear();
+	mArena.Rewind();
+
+	mErrorText = nullptr;
+	mErrorPos = nullptr;
+}
+
+XmlPullParser::EEvent XmlPullParser::SetError(const char* text)
+{
+	mErrorText = text;
+	mErrorPos = mCurr;
+	mEvent = eXmlEventError;
+	return mEvent;
+}
+
+int XmlPullParser::GetErrorLine() const
+{
+	if (nullptr == mErrorPos)
+		return 0;
+	return 1 + static_cast<int>(std::count(mData, mErrorPos, '\n'));
+}
+
+const XmlAttributeView* XmlPullParser::FindAttribute(const char* name) const
+{
+	for (int i = 0; i < mNumberOfAttributes; ++i)
+	{
+		if (mAttributes[i].name.Equals(name))
+			return &mAttributes[i];
+	}
+	return nullptr;
+}
+
+bool XmlPullParser::SkipTo(const char* pattern)
+{
+	const size_t len = strlen(pattern);
+	const char* found = std::search(mCurr, mEnd, pattern, pattern + len);
+
+	if (found == mEnd)
+		return false;
+
+	mCurr = found + len;
+	return true;
+}
+
+bool XmlPullParser::ReadName(XmlStringView& name)
+{
+	const char* start = mCurr;
+	while (mCurr < mEnd && !IsNameEnd(*mCurr))
+		++mCurr;
+
+	name.ptr = start;
+	name.len = static_cast<size_t>(mCurr - start);
+	return name.len > 0;
+}
+
+XmlPullParser::EEvent XmlPullParser::Next()
+{
+	if (eXmlEventError == mEvent || eXmlEventEndDocument == mEvent || nullptr == mData)
+		return mEvent;
+
+	// everything from a previous event is released here
+	mArena.Rewind();
+	mAttributes = nullptr;
+	mNumberOfAttributes = 0;
+	mAttributesCapacity = 0;
+
+	if (mPendingEnd)
+	{
+		mPendingEnd = false;
+		mDepth = static_cast<int>(mStack.size());
+		mName = mStack.back();
+		mStack.pop_back();
+		mEvent = eXmlEventEndElement;
+		return mEvent;
+	}
+
+	while (mCurr < mEnd)
+	{
+		if ('<' != *mCurr)
+		{
+			if (eXmlEventText == ReadText())
+				return mEvent;
+			continue;
+		}
+
+		if (StartsWith(mCurr, mEnd, "<?", 2))
+		{
+			if (!SkipTo("?>"))
+				return SetError("unclosed declaration");
+		}
+		else if (StartsWith(mCurr, mEnd, "<!--", 4))
+		{
+			if (!SkipTo("-->"))
+				return SetError("unclosed comment");
+		}
+		else if (StartsWith(mCurr, mEnd, "<![CDATA[", 9))
+		{
+			mCurr += 9;
+			const char* start = mCurr;
+			if (!SkipTo("]]>"))
+				return SetError("unclosed CDATA");
+
+			mText.ptr = start;
+			mText.len = static_cast<size_t>(mCurr - 3 - start);
+			mDepth = static_cast<int>(mStack.size());
+			mEvent = eXmlEventText;
+			return mEvent;
+		}
+		else if (StartsWith(mCurr, mEnd, "<!", 2))
+		{
+			// doctype, an internal subset is not supported
+			if (!SkipTo(">"))
+				return SetError("unclosed doctype");
+		}
+		else if (StartsWith(mCurr, mEnd, "</", 2))
+		{
+			return ReadEndElement();
+		}
+		else
+		{
+			return ReadStartElement();
+		}
+	}
+
+	if (!mStack.empty())
+		return SetError("unexpected end of a document");
+
+	mDepth = 0;
+	mEvent = eXmlEventEndDocument;
+	return mEvent;
+}
+
+XmlPullParser::EEvent XmlPullParser::ReadText()
+{
+	const char* start = mCurr;
+	const char* end = static_cast<const char*>(memchr(mCurr, '<', static_cast<size_t>(mEnd - mCurr)));
+	if (nullptr == end)
+		end = mEnd;
+
+	mCurr = end;
+
+	// whitespaces between elements and a text outside of a root are skipped
+	if (mStack.empty() || std::all_of(start, end, IsSpace))
+		return eXmlEventNone;
+
+	mText.ptr = start;
+	mText.len = static_cast<size_t>(end - start);
+
+	if (nullptr != memchr(mText.ptr, '&', mText.len) && !DecodeEntities(mText))
+		return SetError("failed to decode a text");
+
+	mDepth = static_cast<int>(mStack.size());
+	mEvent = eXmlEventText;
+	return mEvent;
+}
+
+XmlPullParser::EEvent XmlPullParser::ReadStartElement()
+{
+	++mCurr;
+	if (!ReadName(mName))
+		return SetError("failed to read an element name");
+
+	for (;;)
+	{
+		while (mCurr < mEnd && IsSpace(*mCurr))
+			++mCurr;
+
+		if (mCurr >= mEnd)
+			return SetError("unclosed element");
+
+		if ('/' == *mCurr)
+		{
+			if (!StartsWith(mCurr, mEnd, "/>", 2))
+				return SetError("unexpected char in an element");
+
+			mCurr += 2;
+			mPendingEnd = true;
+			break;
+		}
+		else if ('>' == *mCurr)
+		{
+			++mCurr;
+			break;
+		}
+
+		XmlStringView name, value;
+		if (!ReadName(name))
+			return SetError("failed to read an attribute name");
+
+		while (mCurr < mEnd && IsSpace(*mCurr))
+			++mCurr;
+		if (mCurr >= mEnd || '=' != *mCurr)
+			return SetError("attribute has no value");
+		++mCurr;
+		while (mCurr < mEnd && IsSpace(*mCurr))
+			++mCurr;
+
+		if (mCurr >= mEnd || ('"' != *mCurr && '\'' != *mCurr))
+			return SetError("attribute value is not quoted");
+
+		const char quote = *mCurr++;
+		const char* end = static_cast<const char*>(memchr(mCurr, quote, static_cast<size_t>(mEnd - mCurr)));
+		if (nullptr == end)
+			return SetError("unclosed attribute value");
+
+		value.ptr = mCurr;
+		value.len = static_cast<size_t>(end - mCurr);
+		mCurr = end + 1;
+
+		if (nullptr != memchr(value.ptr, '&', value.len) && !DecodeEntities(value))
+			return SetError("failed to decode an attribute value");
+
+		if (!PushAttribute(name, value))
+			return SetError("failed to allocate attributes");
+	}
+
+	mStack.push_back(mName);
+	mDepth = static_cast<int>(mStack.size());
+	mEvent = eXmlEventStartElement;
+	return mEvent;
+}
+
+XmlPullParser::EEvent XmlPullParser::ReadEndElement()
+{
+	mCurr += 2;
+
+	XmlStringView name;
+	if (!ReadName(name))
+		return SetError("failed to read an end element name");
+
+	while (mCurr < mEnd && IsSpace(*mCurr))
+		++mCurr;
+	if (mCurr >= mEnd || '>' != *mCurr)
+		return SetError("unclosed end element");
+	++mCurr;
+
+	if (mStack.empty() || mStack.back().len != name.len || 0 != memcmp(mStack.back().ptr, name.ptr, name.len))
+		return SetError("mismatched end element");
+
+	mDepth = static_cast<int>(mStack.size());
+	mName = mStack.back();
+	mStack.pop_back();
+	mEvent = eXmlEventEndElement;
+	return mEvent;
+}
+
+bool XmlPullParser::PushAttribute(const XmlStringView& name, const XmlStringView& value)
+{
+	if (mNumberOfAttributes >= mAttributesCapacity)
+	{
+		const int capacity = std::max(8, mAttributesCapacity * 2);
+		XmlAttributeView* attributes = static_cast<XmlAttributeView*>(mArena.Alloc(sizeof(XmlAttributeView) * capacity));
+		if (nullptr == attributes)
+			return false;
+
+		// a previous array stays in the arena until the next event
+		if (mNumberOfAttributes > 0)
+			memcpy(attributes, mAttributes, sizeof(XmlAttributeView) * mNumberOfAttributes);
+
+		mAttributes = attributes;
+		mAttributesCapacity = capacity;
+	}
+
+	mAttributes[mNumberOfAttributes].name = name;
+	mAttributes[mNumberOfAttributes].value = value;
+	mNumberOfAttributes += 1;
+	return true;
+}
+
+bool XmlPullParser::DecodeEntities(XmlStringView& value)
+{
+	// a decoded string is never longer than an encoded one
+	char* buffer = static_cast<char*>(mArena.Alloc(value.len + 1, 1));
+	if (nullptr == buffer)
+		return false;
+
+	char* dst = buffer;
+	const char* src = value.ptr;
+	const char* end = value.ptr + value.len;
+
+	while (src < end)
+	{
+		if ('&' != *src)
+		{
+			*dst++ = *src++;
+			continue;
+		}
+
+		const char* semicolon = static_cast<const char*>(memchr(src, ';', static_cast<size_t>(end - src)));
+		const size_t len = (semicolon) ? static_cast<size_t>(semicolon - src) + 1 : 0;
+
+		if (StartsWith(src, end, "&lt;", 4)) { *dst++ = '<'; src += 4; }
+		else if (StartsWith(src, end, "&gt;", 4)) { *dst++ = '>'; src += 4; }
+		else if (StartsWith(src, end, "&amp;", 5)) { *dst++ = '&'; src += 5; }
+		else if (StartsWith(src, end, "&quot;", 6)) { *dst++ = '"'; src += 6; }
+		else if (StartsWith(src, end, "&apos;", 6)) { *dst++ = '\''; src += 6; }
+		else if (len > 3 && '#' == src[1] && len <= 12)
+		{
+			char number[12] = { 0 };
+			const bool isHex = ('x' == src[2] || 'X' == src[2]);
+			const char* digits = src + ((isHex) ? 3 : 2);
+			memcpy(number, digits, semicolon - digits);
+
+			char* numberEnd = nullptr;
+			const unsigned long code = strtoul(number, &numberEnd, (isHex) ? 16 : 10);
+
+			if (numberEnd == number || 0 != *numberEnd || 0 == code || code > 0x10FFFF)
+			{
+				*dst++ = *src++;
+			}
+			else
+			{
+				dst = EncodeCodePoint(dst, code);
+				src = semicolon + 1;
+			}
+		}
+		else
+		{
+			// unknown entity is kept as it is
+			*dst++ = *src++;
+		}
+	}
+
+	*dst = 0;
+	value.ptr = buffer;
+	value.len = static_cast<size_t>(dst - buffer);
+	return true;
+}
+
+bool XmlPullParser::NextChildElement(const int parentDepth)
+{
+	for (;;)
+	{
+		switch (Next())
+		{
+		case eXmlEventStartElement:
+			if (mDepth == parentDepth + 1)
+				return true;
+			break;
+		case eXmlEventEndElement:
+			if (mDepth <= parentDepth)
+				return false;
+			break;
+		case eXmlEventText:
+			break;
+		default:
+			return false;
+		}
+	}
+}
+
+bool XmlPullParser::NextChildElement(const int parentDepth, const char* name)
+{
+	while (NextChildElement(parentDepth))
+	{
+		if (mName.Equals(name))
+			return true;
+	}
+	return false;
+}
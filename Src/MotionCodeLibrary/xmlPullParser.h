@@ -0,0 +1,168 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/OpenMoBu
+//
+// Author Sergei Solokhin (Neill3d) 2014-2024
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+///
+/// not owned piece of a text, it's not null terminated
+///
+struct XmlStringView
+{
+	const char*		ptr{ nullptr };
+	size_t			len{ 0 };
+
+	bool IsEmpty() const { return 0 == len; }
+	bool Equals(const char* str) const { return (0 == len) ? 0 == *str : (0 == strncmp(ptr, str, len) && 0 == str[len]); }
+
+	int ToInt(const int defValue = 0) const;
+	double ToDouble(const double defValue = 0.0) const;
+	std::string ToString() const { return std::string(ptr, len); }
+};
+
+struct XmlAttributeView
+{
+	XmlStringView	name;
+	XmlStringView	value;	//!< entities are already decoded
+};
+
+///
+/// grows by blocks and rewinds without freeing, so a steady parsing doesn't touch a heap
+///
+class XmlArena
+{
+public:
+
+	XmlArena(const size_t blockSize = 64 * 1024);
+
+	void* Alloc(const size_t size, const size_t align = sizeof(void*));
+
+	/// every allocation is invalid after a rewind, blocks are kept for reuse
+	void Rewind();
+	void Free();
+
+	size_t GetReservedBytes() const { return mBlocks.size() * mBlockSize + mLargeBytes; }
+	size_t GetPeakBytes() const { return mPeakBytes; }
+
+private:
+
+	size_t									mBlockSize;
+	std::vector<std::unique_ptr<char[]>>	mBlocks;
+	std::vector<std::unique_ptr<char[]>>	mLargeBlocks;	//!< allocations bigger than a block, freed on rewind
+	size_t									mLargeBytes{ 0 };
+
+	size_t			mCurrBlock{ 0 };
+	size_t			mOffset{ 0 };
+	size_t			mUsedBytes{ 0 };
+	size_t			mPeakBytes{ 0 };
+};
+
+///
+/// streaming (pull) xml reader over a memory-mapped file
+///  there is no document tree, names and values point into a mapped file and stay valid while the parser is open,
+///  attributes and decoded entities live in an arena and stay valid until the next Next() call
+///  it covers xml written by TinyXML - elements, attributes, text, comments, declarations and CDATA
+///
+class XmlPullParser
+{
+public:
+
+	enum EEvent
+	{
+		eXmlEventNone,
+		eXmlEventStartElement,
+		eXmlEventEndElement,		//!< sent for <elem/> as well, right after a start element event
+		eXmlEventText,
+		eXmlEventEndDocument,
+		eXmlEventError
+	};
+
+	//! a destructor
+	~XmlPullParser();
+
+	bool Open(const char* filename);
+	/// parse a buffer which is owned by a caller
+	bool OpenBuffer(const char* data, const size_t size);
+	void Close();
+
+	EEvent Next();
+
+	/// read up to a next child start element of an element at parentDepth (0 for a root), a deeper content is skipped
+	/// returns false when a parent element is closed
+	bool NextChildElement(const int parentDepth);
+	bool NextChildElement(const int parentDepth, const char* name);
+
+	EEvent GetEvent() const { return mEvent; }
+	/// element depth for start and end events (root is 1), a parent depth for a text event
+	int GetDepth() const { return mDepth; }
+
+	/// element name for start and end events
+	const XmlStringView& GetName() const { return mName; }
+	/// text or CDATA content for a text event
+	const XmlStringView& GetText() const { return mText; }
+
+	int GetNumberOfAttributes() const { return mNumberOfAttributes; }
+	const XmlAttributeView& GetAttribute(const int index) const { return mAttributes[index]; }
+	const XmlAttributeView* FindAttribute(const char* name) const;
+
+	const char* GetErrorText() const { return mErrorText; }
+	int GetErrorLine() const;
+
+	size_t GetSize() const { return mSize; }
+	const XmlArena& GetArena() const { return mArena; }
+
+private:
+
+	void*					mFile{ nullptr };		//!< file and mapping handles on windows, not used with mmap
+	void*					mMapping{ nullptr };
+	const char*				mMappedData{ nullptr };
+
+	const char*				mData{ nullptr };
+	size_t					mSize{ 0 };
+	const char*				mCurr{ nullptr };
+	const char*				mEnd{ nullptr };
+
+	EEvent					mEvent{ eXmlEventNone };
+	int						mDepth{ 0 };
+	bool					mPendingEnd{ false };	//!< <elem/> was read, end event goes next
+
+	XmlStringView			mName;
+	XmlStringView			mText;
+
+	XmlAttributeView*		mAttributes{ nullptr };
+	int						mNumberOfAttributes{ 0 };
+	int						mAttributesCapacity{ 0 };
+
+	std::vector<XmlStringView>	mStack;		//!< names of open elements
+	XmlArena				mArena;
+
+	const char*				mErrorText{ nullptr };
+	const char*				mErrorPos{ nullptr };
+
+	void Reset();
+
+	EEvent SetError(const char* text);
+
+	bool SkipTo(const char* pattern);
+	bool ReadName(XmlStringView& name);
+	EEvent ReadStartElement();
+	EEvent ReadEndElement();
+	EEvent ReadText();
+
+	bool PushAttribute(const XmlStringView& name, const XmlStringView& value);
+	bool DecodeEntities(XmlStringView& value);
+};
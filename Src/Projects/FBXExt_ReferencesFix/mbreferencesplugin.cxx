@@ -17,12 +17,96 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 
 #include <vector>
 #include <filesystem>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 #include <fbxsdk/fbxsdk_nsbegin.h>
 
 static FbxManager* gFbxManager = nullptr;
 static bool        gProcessedOnce = false;
 
+///////////////////////////////////////////////////////////////////////////////////////////
+// reference path status of one import, layouts reference the same files many times
+//  and they could be on a slow network share
+
+struct PathStatusCache
+{
+	std::unordered_map<std::string, bool>	status;	// path -> exists
+
+	int		numberOfLookups{ 0 };
+	int		numberOfFileSystemHits{ 0 };
+};
+
+static PathStatusCache	gPathCache;
+
+static bool PathExists(const char *path)
+{
+	std::error_code ec;
+	return std::filesystem::exists(path, ec);
+}
+
+// check every unique path of loaded references, paths are checked in parallel
+//  unloaded references are never looked up in ImportTranslated, so they are skipped here
+static void FillPathStatusCache(FbxScene *pFbxScene)
+{
+	std::vector<std::string> paths;
+
+	for (int i = 0, count = pFbxScene->GetSrcObjectCount<FbxSceneReference>(); i < count; ++i)
+	{
+		FbxSceneReference *pref = pFbxScene->GetSrcObject<FbxSceneReference>(i);
+		if (false == pref->IsLoaded.Get())
+			continue;
+
+		const FbxString path = pref->ReferenceFilePath.Get();
+
+		if (gPathCache.status.emplace(path.Buffer(), false).second)
+			paths.push_back(path.Buffer());
+	}
+
+	if (paths.empty())
+		return;
+
+	std::vector<char> results(paths.size(), 0);
+	std::atomic<size_t> nextIndex(0);
+
+	auto fn = [&paths, &results, &nextIndex]() {
+		for (size_t i = nextIndex++; i < paths.size(); i = nextIndex++)
+			results[i] = PathExists(paths[i].c_str()) ? 1 : 0;
+	};
+
+	const size_t numberOfThreads = (std::min)(paths.size(), static_cast<size_t>((std::max)(1U, std::thread::hardware_concurrency())));
+	std::vector<std::thread> threads;
+
+	for (size_t i = 1; i < numberOfThreads; ++i)
+		threads.emplace_back(fn);
+	fn();
+
+	for (auto &t : threads)
+		t.join();
+
+	for (size_t i = 0; i < paths.size(); ++i)
+		gPathCache.status[paths[i]] = (results[i] != 0);
+
+	gPathCache.numberOfFileSystemHits += static_cast<int>(paths.size());
+}
+
+static bool CachedPathExists(const char *path)
+{
+	gPathCache.numberOfLookups += 1;
+
+	auto iter = gPathCache.status.find(path);
+	if (iter != end(gPathCache.status))
+		return iter->second;
+
+	// a reference which was not in a scene at import begin
+	const bool exists = PathExists(path);
+	gPathCache.status.emplace(path, exists);
+	gPathCache.numberOfFileSystemHits += 1;
+	return exists;
+}
+
 
 class MyPlugin : public FbxPlugin
 {
@@ -139,11 +223,13 @@ bool MBExt_ImportHandled( FbxObject* pFbxObject )
 
 void MBExt_ImportBegin(FbxScene* pFbxScene)
 {
-    // In this example we have nothing to do before we translate the FBX scene into
-    // MB data.
-
 	//XmlBeginExport();
 
+	gPathCache = PathStatusCache();
+
+	if (nullptr != pFbxScene)
+		FillPathStatusCache(pFbxScene);
+
 }
 
 bool MBExt_ImportProcess( FBComponent*& pOutputObject, FbxObject* pInputFbxObject, bool pIsAnInstance, bool pMerge)
@@ -184,7 +270,7 @@ void MBExt_ImportTranslated( FbxObject* pFbxObject, FBComponent* pFBComponent )
 				int value = 0;
 				if (isLoaded)
 				{
-					if (std::filesystem::exists(path.Buffer()))
+					if (CachedPathExists(path.Buffer()))
 					{
 						value = 1;
 					}
@@ -207,9 +293,13 @@ void MBExt_ImportTranslated( FbxObject* pFbxObject, FBComponent* pFBComponent )
 
 void MBExt_ImportEnd(FbxScene* pFbxScene)
 {
-    // In this example, this doesn't interest us either. Every thing has been processed in
-    // the MBExt_ImportProcess callback.
-	
+	if (gPathCache.numberOfLookups > 0)
+	{
+		FBTrace("[ReferencesFix] %d reference path lookups, %d file system hits\n", 
+			gPathCache.numberOfLookups, gPathCache.numberOfFileSystemHits);
+	}
+
+	gPathCache = PathStatusCache();
 }
 
 
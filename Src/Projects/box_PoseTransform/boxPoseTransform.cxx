@@ -138,87 +138,42 @@ bool CBoxPoseTransform::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FB
 	if (!model)
 		return false;
 
-    const char* modelName = model->Name;
-
 	for (int i = 0; i < NUMBER_OF_POSES; ++i)
 	{
 		FBObjectPose* pose = (m_Poses[i].GetCount() > 0) ? (FBObjectPose*)m_Poses[i].GetAt(0) : nullptr;
 
-        if (pose == nullptr)
-            continue;
+		PoseEntry& entry = m_PoseEntries[i];
+
+		if (entry.pose != pose || entry.model != model)
+			UpdatePoseEntry(entry, pose, model);
+
+		if (!entry.isValid)
+			continue;
 
-		FBStringList storedNames;
-#if(PRODUCT_VERSION > 2018)
-		storedNames = pose->GetStoredObjectNames();
-#endif
-        int nameIndex = -1;
-
-        for (int j = 0, storedNamesCount = storedNames.GetCount(); j < storedNamesCount; ++j)
-        {
-            const char* name{ storedNames.GetAt(j) };
-            char* lastDelim = strrchr((char*)name, ':');
-
-            if (lastDelim != nullptr)
-            {
-                name = lastDelim + 1;    
-            }
-            
-            if (strcmpi(name, modelName) == 0)
-            {
-                nameIndex = j;
-                break;
-            }
-        }
-
-        if (nameIndex < 0)
-            continue;
-
-        const char* name{ storedNames.GetAt(nameIndex) };
 		double factor{ 0.0f };
 		m_Factor[i]->ReadData(&factor, pEvaluateInfo);
 
 		factor *= 0.01;
 
-		FBMatrix tm, scl;
-		FBTVector t;
-		FBRVector r;
-		FBQuaternion q;
+		FBTVector& t = entry.translation;
+		FBQuaternion& q = entry.rotation;
 
-		bool is_valid = false;
-
-		if (pose->GetTransform(t, tm, scl, name, FBPoseTransformType::kFBPoseTransformLocal))
+		if (factor >= 1.0)
 		{
-			FBMatrixToQuaternion(q, tm);
-			is_valid = true;
+			translation = FBVector3d(t);
+			FBQuaternionToRotation(rotation, q);
 		}
-		else if (pose->IsPropertyStored(name, "Lcl Translation") && pose->IsPropertyStored(name, "Lcl Rotation"))
+		else
 		{
-			pose->GetPropertyValue(t, sizeof(double) * 3, name, "Lcl Translation");
-			pose->GetPropertyValue(r, sizeof(double) * 3, name, "Lcl Rotation");
+			FBQuaternion p;
+			FBRotationToQuaternion(p, rotation);
 
-			FBRotationToQuaternion(q, r);
-			is_valid = true;
-		}
+			FBQuaternion result;
+			FBInterpolateRotation(result, p, q, factor);
+			FBQuaternionToRotation(rotation, result);
 
-		if (is_valid)
-		{
-			if (factor >= 1.0)
-			{
-				translation = FBVector3d(t);
-				FBQuaternionToRotation(rotation, q);
-			}
-			else
-			{
-				FBQuaternion p;
-				FBRotationToQuaternion(p, rotation);
-
-				FBQuaternion result;
-				FBInterpolateRotation(result, p, q, factor);
-				FBQuaternionToRotation(rotation, result);
-
-				for (int j = 0; j < 3; ++j)
-					translation[j] = factor * (t[j] - translation[j]) + translation[j];
-			}
+			for (int j = 0; j < 3; ++j)
+				translation[j] = factor * (t[j] - translation[j]) + translation[j];
 		}
 	}
 
@@ -230,6 +185,63 @@ bool CBoxPoseTransform::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FB
 }
 
 
+void CBoxPoseTransform::UpdatePoseEntry(PoseEntry& entry, FBObjectPose* pose, FBModel* model)
+{
+	entry.pose = pose;
+	entry.model = model;
+	entry.isValid = false;
+
+	if (pose == nullptr || model == nullptr)
+		return;
+
+	const char* modelName = model->Name;
+
+	FBStringList storedNames;
+#if(PRODUCT_VERSION > 2018)
+	storedNames = pose->GetStoredObjectNames();
+#endif
+	int nameIndex = -1;
+
+	for (int j = 0, storedNamesCount = storedNames.GetCount(); j < storedNamesCount; ++j)
+	{
+		const char* name{ storedNames.GetAt(j) };
+		char* lastDelim = strrchr((char*)name, ':');
+
+		if (lastDelim != nullptr)
+		{
+			name = lastDelim + 1;
+		}
+
+		if (strcmpi(name, modelName) == 0)
+		{
+			nameIndex = j;
+			break;
+		}
+	}
+
+	if (nameIndex < 0)
+		return;
+
+	const char* name{ storedNames.GetAt(nameIndex) };
+
+	FBMatrix tm, scl;
+	FBRVector r;
+
+	if (pose->GetTransform(entry.translation, tm, scl, name, FBPoseTransformType::kFBPoseTransformLocal))
+	{
+		FBMatrixToQuaternion(entry.rotation, tm);
+		entry.isValid = true;
+	}
+	else if (pose->IsPropertyStored(name, "Lcl Translation") && pose->IsPropertyStored(name, "Lcl Rotation"))
+	{
+		pose->GetPropertyValue(entry.translation, sizeof(double) * 3, name, "Lcl Translation");
+		pose->GetPropertyValue(r, sizeof(double) * 3, name, "Lcl Rotation");
+
+		FBRotationToQuaternion(entry.rotation, r);
+		entry.isValid = true;
+	}
+}
+
 /************************************************
  *	FBX Storage.
  ************************************************/
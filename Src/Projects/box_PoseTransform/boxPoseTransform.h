@@ -67,4 +67,20 @@ private:
 	// retrieve
 	FBString	m_ModelName;
 	FBString	m_PoseNames[NUMBER_OF_POSES];
+
+	//! resolved pose transform of the object, so evaluation doesn't search stored names every time
+	struct PoseEntry
+	{
+		FBObjectPose	*pose{ nullptr };
+		FBModel			*model{ nullptr };
+
+		bool			isValid{ false };	//!< model is stored in the pose
+		FBTVector		translation;
+		FBQuaternion	rotation;
+	};
+
+	PoseEntry		m_PoseEntries[NUMBER_OF_POSES];
+
+	//! resolve an entry again when the pose or the model has been changed
+	static void UpdatePoseEntry(PoseEntry &entry, FBObjectPose *pose, FBModel *model);
 };
@@ -220,6 +220,7 @@ void Box_RayIntersect::FBDestroy()
 	/*
 	*	Free any user memory associated to box.
 	*/
+	mBVHCache.clear();
 //	FBBox::Destroy();
 }
 
@@ -473,6 +474,45 @@ bool RayIntersector::intersectModel(FBModel *pModel)
 	return false;
 }
 
+bool RayIntersector::intersectModel(FBModel *pModel, const MeshRayBVH &bvh)
+{
+	info.finded = false;
+	if (!pModel || bvh.IsEmpty()) 
+		return false;
+
+	FBMatrix m, invm;
+	pModel->GetMatrix(m, kModelTransformation_Geometry);
+	pModel->GetMatrix(invm, kModelInverse_Transformation_Geometry);
+
+	FBVector3d R0, R1;
+	VectorTransform(mPos, invm, R0);
+	VectorTransform(mDir, invm, R1);
+
+	const float r0[3] = { static_cast<float>(R0[0]), static_cast<float>(R0[1]), static_cast<float>(R0[2]) };
+	const float r1[3] = { static_cast<float>(R1[0]), static_cast<float>(R1[1]), static_cast<float>(R1[2]) };
+
+	RayBVH::Hit hit;
+	if (!bvh.Intersect(r0, r1, hit))
+		return false;
+
+	FBVector3d P(R0[0] + (R1[0] - R0[0]) * hit.t, 
+		R0[1] + (R1[1] - R0[1]) * hit.t, 
+		R0[2] + (R1[2] - R0[2]) * hit.t);
+
+	info.finded = true;
+	info.facet = hit.facet;
+	info.u = hit.u;
+	info.v = hit.v;
+	VectorTransform(P, m, info.point);
+	
+	FBVector3d normal;
+	bvh.GetTriangleNormal(hit.triangle, normal.mValue);
+	VectorTransform33(normal, m, info.normal);
+	VectorNormalize(info.normal);
+
+	return true;
+}
+
 double RayIntersector::calcIntersection( FBVector3d R0, FBVector3d R1, FBVector3d a, FBVector3d b, FBVector3d c )
 {
 	FBVector4d plane;
@@ -560,6 +600,47 @@ int RayIntersector::intersect_triangle( FBVector3d orig, FBVector3d dir, FBVecto
 }
 
 
+const MeshRayBVH *Box_RayIntersect::PrepareBVH(FBModel *pModel)
+{
+	MeshRayBVH &bvh = mBVHCache[pModel];
+
+	// refit when only positions are deformed, rebuild on a new topology
+	if (!bvh.Update(pModel))
+	{
+		if (!bvh.Build(pModel))
+		{
+			mBVHCache.erase(pModel);
+			return nullptr;
+		}
+	}
+	return &bvh;
+}
+
+void Box_RayIntersect::PruneBVHCache()
+{
+	if (mBVHCache.empty())
+		return;
+
+	const int count = mNodeMesh->GetSrcCount();
+	for (auto iter = begin(mBVHCache); iter != end(mBVHCache); )
+	{
+		bool connected = false;
+		for (int i=0; i<count && !connected; ++i)
+		{
+			FBPlug *pPlug = mNodeMesh->GetSrc(i);
+			pPlug = (pPlug) ? pPlug->GetOwner() : nullptr;
+
+			connected = (pPlug && pPlug->Is( FBModelPlaceHolder::TypeInfo ) 
+				&& static_cast<FBModelPlaceHolder*>(pPlug)->Model == iter->first);
+		}
+
+		if (connected)
+			++iter;
+		else
+			iter = mBVHCache.erase(iter);
+	}
+}
+
 /************************************************
  *	Real-time engine evaluation
  ************************************************/
@@ -583,6 +664,9 @@ bool Box_RayIntersect::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FBE
 	if (!mRayDirection->ReadData( lDir, pEvaluateInfo ) ) 
 		return false;
 
+	// a model pointer could be reused after a model is deleted, keep trees of connected models only
+	PruneBVHCache();
+
 	// If the read was not from a dead node.
 	const int count = mNodeMesh->GetSrcCount();
 	for (int i=0; i<count; ++i)
@@ -598,7 +682,21 @@ bool Box_RayIntersect::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FBE
 			if (!pModel)
 				continue;
 
-			// let's use a native mobu method for a ray casting
+			// per-model tree, fallback to a native mobu method when mesh is not tessellated
+			if (const MeshRayBVH *pBVH = PrepareBVH(pModel))
+			{
+				RayIntersector ray(lPos, lDir);
+				if (ray.intersectModel(pModel, *pBVH))
+				{
+					mIntersectPoint->WriteData(ray.info.point, pEvaluateInfo);
+					mIntersectNormal->WriteData(ray.info.normal, pEvaluateInfo);
+					mUVCoords[0]->WriteData(&ray.info.u, pEvaluateInfo);
+					mUVCoords[1]->WriteData(&ray.info.v, pEvaluateInfo);
+					return true;
+				}
+				continue;
+			}
+
 			FBTVector pos4(lPos[0], lPos[1], lPos[2]);
 			FBTVector dir4(lDir[0], lDir[1], lDir[2]);
 			FBTVector intersectPos, intersectNormal;
@@ -624,17 +722,6 @@ bool Box_RayIntersect::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FBE
 				mIntersectNormal->WriteData(intersectNormal, pEvaluateInfo);
 				return true;
 			}
-
-			/*
-			FBGeometry *pGeom = pModel->Geometry;
-
-			RayIntersector ray(lPos, lDir);
-			if (ray.intersectModel(pModel) )
-			{
-				mIntersectPoint->WriteData( ray.info.point, pEvaluateInfo );
-				return true;
-			}
-			*/
 		}
 	}
 	
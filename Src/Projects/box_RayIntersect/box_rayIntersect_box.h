@@ -17,6 +17,9 @@
 //--- SDK include
 #include <fbsdk/fbsdk.h>
 
+#include <map>
+#include "box_rayIntersect_meshbvh.h"
+
 //--- Registration defines
 #define	BOXRAYINTERSECT__CLASSNAME		Box_RayIntersect
 #define BOXRAYINTERSECT__CLASSSTR		"Box_RayIntersect"
@@ -35,7 +38,10 @@ public:
 		mMesh = nullptr;
 	}
 
+	//! brute-force test of every tessellated mesh polygon
 	bool intersectModel( FBModel *pModel ); 
+	//! use a prebuilt per-model tree, fills facet, point, u,v and a world space normal
+	bool intersectModel( FBModel *pModel, const MeshRayBVH &bvh );
 
 	struct IntersectionInfo
 	{
@@ -44,6 +50,7 @@ public:
 		FBVector3d	point;	// ray intersection point
 		double		u;		// facet u coord
 		double		v;		// facet v coord
+		FBVector3d	normal;	// facet world normal (filled by a bvh test)
 	} info;
 
 public:
@@ -95,6 +102,12 @@ private:
 	FBAnimationNode		*mIntersectPoint;	//!> output - mesh intersection world point
 	FBAnimationNode		*mIntersectNormal;	//!> output - mesh intersection normal
 	FBAnimationNode		*mUVCoords[2];		//!> output - intersection u,v points		
+
+	std::map<FBModel*, MeshRayBVH>	mBVHCache;	//!> per-model acceleration tree, rebuilt on topology change, refitted on deformation
+
+	const MeshRayBVH *PrepareBVH(FBModel *pModel);
+	//! drop trees of models which are not connected to the mesh node anymore (removed or deleted models)
+	void PruneBVHCache();
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,566 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_rayIntersect_bvh.cxx
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "box_rayIntersect_bvh.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#define BVH_SAH_BINS			12
+#define BVH_TRAVERSAL_COST		1.0f
+#define BVH_INTERSECT_COST		1.0f
+#define BVH_STACK_SIZE			128		//!> a traversal keeps at most one pending sibling per level, RayBVH::mDepth + 2 entries
+#define BVH_EPSILON				0.0000001f
+
+namespace
+{
+	struct BuildTask
+	{
+		int		node;
+		int		begin;
+		int		end;
+		int		depth;
+	};
+
+	struct Bounds
+	{
+		float	bmin[3]{ FLT_MAX, FLT_MAX, FLT_MAX };
+		float	bmax[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const float *p)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				bmin[k] = std::min(bmin[k], p[k]);
+				bmax[k] = std::max(bmax[k], p[k]);
+			}
+		}
+		void Grow(const Bounds &b)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				bmin[k] = std::min(bmin[k], b.bmin[k]);
+				bmax[k] = std::max(bmax[k], b.bmax[k]);
+			}
+		}
+		float Area() const
+		{
+			const float dx = bmax[0] - bmin[0];
+			const float dy = bmax[1] - bmin[1];
+			const float dz = bmax[2] - bmin[2];
+			return (dx < 0.0f) ? 0.0f : 2.0f * (dx*dy + dy*dz + dz*dx);
+		}
+	};
+
+	// slab test, returns entry distance or FLT_MAX when missed
+	inline float RayBoxDistance(const float *bmin, const float *bmax, const float *orig, const float *invDir, const float tmax)
+	{
+		float t0 = 0.0f;
+		float t1 = tmax;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			float tnear = (bmin[k] - orig[k]) * invDir[k];
+			float tfar = (bmax[k] - orig[k]) * invDir[k];
+			if (tnear > tfar)
+				std::swap(tnear, tfar);
+
+			t0 = (tnear > t0) ? tnear : t0;
+			t1 = (tfar < t1) ? tfar : t1;
+		}
+		return (t0 <= t1) ? t0 : FLT_MAX;
+	}
+
+	inline float SafeInverse(const float value)
+	{
+		return (fabsf(value) > BVH_EPSILON) ? 1.0f / value : ((value < 0.0f) ? -FLT_MAX : FLT_MAX);
+	}
+};
+
+void RayBVH::Clear()
+{
+	mPositions.clear();
+	mTriIndices.clear();
+	mTriFacets.clear();
+	mNodes.clear();
+	mPackets.clear();
+	mDepth = 0;
+}
+
+bool RayBVH::Build(const float *positions, const int vertexCount, const int *triIndices, const int *triFacets, const int triCount)
+{
+	Clear();
+
+	if (!positions || !triIndices || vertexCount <= 0 || triCount <= 0)
+		return false;
+
+	mPositions.assign(positions, positions + 3 * vertexCount);
+	mTriIndices.reserve(3 * triCount);
+	mTriFacets.reserve(triCount);
+
+	for (int i = 0; i < triCount; ++i)
+	{
+		const int i0 = triIndices[3 * i];
+		const int i1 = triIndices[3 * i + 1];
+		const int i2 = triIndices[3 * i + 2];
+
+		if (i0 < 0 || i1 < 0 || i2 < 0 || i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount)
+			continue;
+
+		mTriIndices.push_back(i0);
+		mTriIndices.push_back(i1);
+		mTriIndices.push_back(i2);
+		mTriFacets.push_back((triFacets) ? triFacets[i] : i);
+	}
+
+	if (mTriFacets.empty())
+	{
+		Clear();
+		return false;
+	}
+
+	BuildTree();
+	return true;
+}
+
+bool RayBVH::UpdatePositions(const float *positions, const int vertexCount)
+{
+	if (IsEmpty() || !positions || 3 * vertexCount != static_cast<int>(mPositions.size()))
+		return false;
+
+	if (memcmp(mPositions.data(), positions, sizeof(float) * mPositions.size()) != 0)
+	{
+		memcpy(mPositions.data(), positions, sizeof(float) * mPositions.size());
+		Refit();
+	}
+	return true;
+}
+
+void RayBVH::BuildTree()
+{
+	const int triCount = static_cast<int>(mTriFacets.size());
+
+	std::vector<Bounds>	triBounds(triCount);
+	std::vector<float>	centroids(3 * triCount);
+	std::vector<int>	order(triCount);
+
+	for (int i = 0; i < triCount; ++i)
+	{
+		Bounds &b = triBounds[i];
+		for (int j = 0; j < 3; ++j)
+			b.Grow(&mPositions[3 * mTriIndices[3 * i + j]]);
+
+		for (int k = 0; k < 3; ++k)
+			centroids[3 * i + k] = 0.5f * (b.bmin[k] + b.bmax[k]);
+		order[i] = i;
+	}
+
+	mNodes.clear();
+	mPackets.clear();
+	mNodes.reserve(2 * (triCount / RAYBVH_PACKET_SIZE + 1));
+	mPackets.reserve(triCount / RAYBVH_PACKET_SIZE + 1);
+
+	mNodes.push_back(Node());
+	mDepth = 0;
+
+	std::vector<BuildTask> tasks;
+	tasks.push_back({ 0, 0, triCount, 0 });
+
+	while (!tasks.empty())
+	{
+		const BuildTask task = tasks.back();
+		tasks.pop_back();
+
+		const int count = task.end - task.begin;
+		mDepth = std::max(mDepth, task.depth);
+
+		Bounds centroidBounds;
+		for (int i = task.begin; i < task.end; ++i)
+			centroidBounds.Grow(&centroids[3 * order[i]]);
+
+		if (count <= RAYBVH_PACKET_SIZE)
+		{
+			Node &leaf = mNodes[task.node];
+			leaf.first = static_cast<int>(mPackets.size());
+			leaf.count = count;
+
+			TriPacket packet;
+			for (int i = 0; i < RAYBVH_PACKET_SIZE; ++i)
+				packet.triangle[i] = (i < count) ? order[task.begin + i] : -1;
+
+			mPackets.push_back(packet);
+			continue;
+		}
+
+		// binned SAH along the widest centroid axis
+
+		int axis = 0;
+		float extent[3];
+		for (int k = 0; k < 3; ++k)
+			extent[k] = centroidBounds.bmax[k] - centroidBounds.bmin[k];
+		if (extent[1] > extent[axis]) axis = 1;
+		if (extent[2] > extent[axis]) axis = 2;
+
+		// no SAH split leaves mid at the begin, then a median split is used
+		int mid = task.begin;
+
+		// SAH could peel a few triangles per level on a skewed mesh, deep levels use a balanced split
+		if (extent[axis] > 0.0f && task.depth < RAYBVH_SAH_MAX_DEPTH)
+		{
+			Bounds binBounds[BVH_SAH_BINS];
+			int binCount[BVH_SAH_BINS] = { 0 };
+
+			const float scale = BVH_SAH_BINS / extent[axis];
+			auto binOf = [&](const int tri) {
+				const int bin = static_cast<int>((centroids[3 * tri + axis] - centroidBounds.bmin[axis]) * scale);
+				return std::min(bin, BVH_SAH_BINS - 1);
+			};
+
+			for (int i = task.begin; i < task.end; ++i)
+			{
+				const int bin = binOf(order[i]);
+				binCount[bin] += 1;
+				binBounds[bin].Grow(triBounds[order[i]]);
+			}
+
+			// sweep from the right to get area and count for every right partition
+			float rightArea[BVH_SAH_BINS];
+			int rightCount[BVH_SAH_BINS];
+			Bounds accum;
+			int accumCount = 0;
+			for (int i = BVH_SAH_BINS - 1; i > 0; --i)
+			{
+				accum.Grow(binBounds[i]);
+				accumCount += binCount[i];
+				rightArea[i] = accum.Area();
+				rightCount[i] = accumCount;
+			}
+
+			float bestCost = FLT_MAX;
+			int bestSplit = -1;
+			accum = Bounds();
+			accumCount = 0;
+			for (int i = 0; i < BVH_SAH_BINS - 1; ++i)
+			{
+				accum.Grow(binBounds[i]);
+				accumCount += binCount[i];
+
+				if (accumCount == 0 || rightCount[i + 1] == 0)
+					continue;
+
+				const float cost = BVH_TRAVERSAL_COST
+					+ BVH_INTERSECT_COST * (accum.Area() * accumCount + rightArea[i + 1] * rightCount[i + 1]);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = i;
+				}
+			}
+
+			if (bestSplit >= 0)
+			{
+				int *splitPtr = std::partition(order.data() + task.begin, order.data() + task.end,
+					[&](const int tri) { return binOf(tri) <= bestSplit; });
+				mid = static_cast<int>(splitPtr - order.data());
+			}
+		}
+
+		if (mid <= task.begin || mid >= task.end)
+		{
+			// all centroids in one bin or a depth limit, fallback to a median split
+			mid = task.begin + count / 2;
+			std::nth_element(order.data() + task.begin, order.data() + mid, order.data() + task.end,
+				[&](const int a, const int b) { return centroids[3 * a + axis] < centroids[3 * b + axis]; });
+		}
+
+		const int left = static_cast<int>(mNodes.size());
+		mNodes[task.node].first = left;
+		mNodes[task.node].count = 0;
+		mNodes.push_back(Node());
+		mNodes.push_back(Node());
+
+		tasks.push_back({ left + 1, mid, task.end, task.depth + 1 });
+		tasks.push_back({ left, task.begin, mid, task.depth + 1 });
+	}
+
+	Refit();
+}
+
+void RayBVH::FillPacket(TriPacket &packet) const
+{
+	for (int i = 0; i < RAYBVH_PACKET_SIZE; ++i)
+	{
+		const int tri = packet.triangle[i];
+		if (tri < 0)
+		{
+			// degenerate slot, determinant is zero and it never passes the test
+			for (int k = 0; k < 3; ++k)
+			{
+				packet.v0[k][i] = 0.0f;
+				packet.e1[k][i] = 0.0f;
+				packet.e2[k][i] = 0.0f;
+			}
+			continue;
+		}
+
+		const float *a = &mPositions[3 * mTriIndices[3 * tri]];
+		const float *b = &mPositions[3 * mTriIndices[3 * tri + 1]];
+		const float *c = &mPositions[3 * mTriIndices[3 * tri + 2]];
+
+		for (int k = 0; k < 3; ++k)
+		{
+			packet.v0[k][i] = a[k];
+			packet.e1[k][i] = b[k] - a[k];
+			packet.e2[k][i] = c[k] - a[k];
+		}
+	}
+}
+
+void RayBVH::Refit()
+{
+	for (auto &packet : mPackets)
+		FillPacket(packet);
+
+	// children are always stored after the parent, so a reverse walk is a bottom-up pass
+	for (int i = static_cast<int>(mNodes.size()) - 1; i >= 0; --i)
+	{
+		Node &node = mNodes[i];
+		Bounds b;
+
+		if (node.count > 0)
+		{
+			const TriPacket &packet = mPackets[node.first];
+			for (int j = 0; j < node.count; ++j)
+			{
+				const int tri = packet.triangle[j];
+				for (int n = 0; n < 3; ++n)
+					b.Grow(&mPositions[3 * mTriIndices[3 * tri + n]]);
+			}
+		}
+		else
+		{
+			const Node &left = mNodes[node.first];
+			const Node &right = mNodes[node.first + 1];
+			for (int k = 0; k < 3; ++k)
+			{
+				b.bmin[k] = std::min(left.bmin[k], right.bmin[k]);
+				b.bmax[k] = std::max(left.bmax[k], right.bmax[k]);
+			}
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			node.bmin[k] = b.bmin[k];
+			node.bmax[k] = b.bmax[k];
+		}
+	}
+}
+
+bool RayBVH::Intersect(const float *R0, const float *R1, Hit &hit) const
+{
+	if (IsEmpty())
+		return false;
+
+	const float orig[3] = { R0[0], R0[1], R0[2] };
+	const float dir[3] = { R1[0] - R0[0], R1[1] - R0[1], R1[2] - R0[2] };
+	const float invDir[3] = { SafeInverse(dir[0]), SafeInverse(dir[1]), SafeInverse(dir[2]) };
+
+	const __m128 ox = _mm_set1_ps(orig[0]);
+	const __m128 oy = _mm_set1_ps(orig[1]);
+	const __m128 oz = _mm_set1_ps(orig[2]);
+	const __m128 dx = _mm_set1_ps(dir[0]);
+	const __m128 dy = _mm_set1_ps(dir[1]);
+	const __m128 dz = _mm_set1_ps(dir[2]);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 eps = _mm_set1_ps(BVH_EPSILON);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	float tbest = FLT_MAX;
+	hit.triangle = -1;
+
+	int stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	if (RayBoxDistance(mNodes[0].bmin, mNodes[0].bmax, orig, invDir, tbest) == FLT_MAX)
+		return false;
+
+	while (stackSize > 0)
+	{
+		const Node &node = mNodes[stack[--stackSize]];
+
+		if (node.count > 0)
+		{
+			// 4-wide Moller-Trumbore
+			const TriPacket &packet = mPackets[node.first];
+
+			const __m128 e1x = _mm_load_ps(packet.e1[0]);
+			const __m128 e1y = _mm_load_ps(packet.e1[1]);
+			const __m128 e1z = _mm_load_ps(packet.e1[2]);
+			const __m128 e2x = _mm_load_ps(packet.e2[0]);
+			const __m128 e2y = _mm_load_ps(packet.e2[1]);
+			const __m128 e2z = _mm_load_ps(packet.e2[2]);
+
+			// pvec = dir x e2
+			const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+			const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+			const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+			const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 mask = _mm_cmpgt_ps(_mm_andnot_ps(signMask, det), eps);
+			if (_mm_movemask_ps(mask) == 0)
+				continue;
+
+			const __m128 invDet = _mm_div_ps(one, det);
+
+			const __m128 tx = _mm_sub_ps(ox, _mm_load_ps(packet.v0[0]));
+			const __m128 ty = _mm_sub_ps(oy, _mm_load_ps(packet.v0[1]));
+			const __m128 tz = _mm_sub_ps(oz, _mm_load_ps(packet.v0[2]));
+
+			const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+
+			// qvec = tvec x e1
+			const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+			const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+			const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+			const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+
+			const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(t, eps), _mm_cmplt_ps(t, _mm_set1_ps(tbest))));
+
+			const int bits = _mm_movemask_ps(mask);
+			if (bits == 0)
+				continue;
+
+			alignas(16) float tv[RAYBVH_PACKET_SIZE], uv[RAYBVH_PACKET_SIZE], vv[RAYBVH_PACKET_SIZE];
+			_mm_store_ps(tv, t);
+			_mm_store_ps(uv, u);
+			_mm_store_ps(vv, v);
+
+			for (int i = 0; i < RAYBVH_PACKET_SIZE; ++i)
+			{
+				if ((bits & (1 << i)) && tv[i] < tbest)
+				{
+					tbest = tv[i];
+					hit.triangle = packet.triangle[i];
+					hit.t = tv[i];
+					hit.u = uv[i];
+					hit.v = vv[i];
+				}
+			}
+		}
+		else
+		{
+			// push far child first, so near one is popped next
+			const int left = node.first;
+			const int right = node.first + 1;
+			const float tl = RayBoxDistance(mNodes[left].bmin, mNodes[left].bmax, orig, invDir, tbest);
+			const float tr = RayBoxDistance(mNodes[right].bmin, mNodes[right].bmax, orig, invDir, tbest);
+
+			// a bounded depth keeps the stack small, a full test is a guard for a tree out of the limit
+			if (stackSize + 2 > BVH_STACK_SIZE)
+				return IntersectBruteForce(R0, R1, hit);
+
+			if (tl <= tr)
+			{
+				if (tr != FLT_MAX) stack[stackSize++] = right;
+				if (tl != FLT_MAX) stack[stackSize++] = left;
+			}
+			else
+			{
+				if (tl != FLT_MAX) stack[stackSize++] = left;
+				if (tr != FLT_MAX) stack[stackSize++] = right;
+			}
+		}
+	}
+
+	if (hit.triangle >= 0)
+	{
+		hit.facet = mTriFacets[hit.triangle];
+		return true;
+	}
+	return false;
+}
+
+bool RayBVH::IntersectBruteForce(const float *R0, const float *R1, Hit &hit) const
+{
+	const float orig[3] = { R0[0], R0[1], R0[2] };
+	const float dir[3] = { R1[0] - R0[0], R1[1] - R0[1], R1[2] - R0[2] };
+
+	float tbest = FLT_MAX;
+	hit.triangle = -1;
+
+	const int triCount = GetTriangleCount();
+	for (int i = 0; i < triCount; ++i)
+	{
+		const float *a = &mPositions[3 * mTriIndices[3 * i]];
+		const float *b = &mPositions[3 * mTriIndices[3 * i + 1]];
+		const float *c = &mPositions[3 * mTriIndices[3 * i + 2]];
+
+		const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		const float p[3] = { dir[1] * e2[2] - dir[2] * e2[1], dir[2] * e2[0] - dir[0] * e2[2], dir[0] * e2[1] - dir[1] * e2[0] };
+
+		const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+		if (fabsf(det) <= BVH_EPSILON)
+			continue;
+
+		const float invDet = 1.0f / det;
+		const float tv[3] = { orig[0] - a[0], orig[1] - a[1], orig[2] - a[2] };
+		const float u = (tv[0] * p[0] + tv[1] * p[1] + tv[2] * p[2]) * invDet;
+		if (u < 0.0f || u > 1.0f)
+			continue;
+
+		const float q[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+		const float v = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * invDet;
+		if (v < 0.0f || u + v > 1.0f)
+			continue;
+
+		const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+		if (t > BVH_EPSILON && t < tbest)
+		{
+			tbest = t;
+			hit.triangle = i;
+			hit.t = t;
+			hit.u = u;
+			hit.v = v;
+		}
+	}
+
+	if (hit.triangle >= 0)
+	{
+		hit.facet = mTriFacets[hit.triangle];
+		return true;
+	}
+	return false;
+}
+
+void RayBVH::GetTriangleNormal(const int triangle, double *normal) const
+{
+	const float *a = &mPositions[3 * mTriIndices[3 * triangle]];
+	const float *b = &mPositions[3 * mTriIndices[3 * triangle + 1]];
+	const float *c = &mPositions[3 * mTriIndices[3 * triangle + 2]];
+
+	const double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	const double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
@@ -0,0 +1,93 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_rayIntersect_bvh.h
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// tree has no sdk dependencies, mesh reading is in MeshRayBVH (box_rayIntersect_meshbvh.h)
+
+#include <vector>
+#include <stdint.h>
+
+#define RAYBVH_PACKET_SIZE		4	//!> triangles tested together in one SSE Moller-Trumbore packet
+#define RAYBVH_SAH_MAX_DEPTH	48	//!> deeper nodes are split by a median, so a tree depth stays bounded for a traversal stack
+
+/**	RayBVH
+*	bounding volume hierarchy over a flat triangle array of one tessellated mesh
+*	tree is built once with a binned SAH, then refitted in place when vertex positions are deformed
+*	every leaf holds one packet of up to 4 triangles in SoA layout for a 4-wide ray-triangle test
+*	after RAYBVH_SAH_MAX_DEPTH levels nodes are split by a median, the depth is below RAYBVH_SAH_MAX_DEPTH + 32
+*/
+class RayBVH
+{
+public:
+
+	struct Hit
+	{
+		int		triangle;	//!> index in a flat triangle array
+		int		facet;		//!> source mesh polygon index
+		float	t;			//!> ray parameter, ray is (R0 + t * (R1 - R0))
+		float	u;			//!> barycentric u coord
+		float	v;			//!> barycentric v coord
+	};
+
+	//! clear all tree data
+	void Clear();
+
+	//! build a tree over xyz positions and 3 vertex indices per triangle, facets are source polygon indices (optional)
+	//!  triangles with out of range indices are skipped, returns false when there is nothing to build
+	bool Build(const float *positions, const int vertexCount, const int *triIndices, const int *triFacets, const int triCount);
+
+	//! copy new xyz positions and refit the tree when they are changed, returns false on a different vertex count
+	bool UpdatePositions(const float *positions, const int vertexCount);
+
+	bool IsEmpty() const { return mNodes.empty(); }
+	int GetTriangleCount() const { return static_cast<int>(mTriFacets.size()); }
+	int GetDepth() const { return mDepth; }
+
+	// ray is given by two xyz points in mesh space
+	bool Intersect(const float *R0, const float *R1, Hit &hit) const;
+	// reference implementation, test every triangle of a flat array
+	bool IntersectBruteForce(const float *R0, const float *R1, Hit &hit) const;
+
+	//! geometric normal of a triangle in mesh space (not normalized)
+	void GetTriangleNormal(const int triangle, double *normal) const;
+
+protected:
+
+	struct Node
+	{
+		float	bmin[3];
+		float	bmax[3];
+		int		first;		//!> leaf - packet index, interior node - index of a left child (right is first+1)
+		int		count;		//!> number of triangles in a leaf packet, 0 for an interior node
+	};
+
+	struct alignas(16) TriPacket
+	{
+		float	v0[3][RAYBVH_PACKET_SIZE];
+		float	e1[3][RAYBVH_PACKET_SIZE];
+		float	e2[3][RAYBVH_PACKET_SIZE];
+		int		triangle[RAYBVH_PACKET_SIZE];	//!> -1 for an empty slot
+	};
+
+	std::vector<float>		mPositions;		//!> xyz vertex positions, copy of a last read mesh state
+	std::vector<int>		mTriIndices;	//!> 3 vertex indices per triangle
+	std::vector<int>		mTriFacets;		//!> source polygon index per triangle
+
+	std::vector<Node>		mNodes;
+	std::vector<TriPacket>	mPackets;
+	int						mDepth{ 0 };
+
+	void BuildTree();
+	void FillPacket(TriPacket &packet) const;
+	void Refit();
+};
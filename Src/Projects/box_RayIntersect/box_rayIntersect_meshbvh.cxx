@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_rayIntersect_meshbvh.cxx
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "box_rayIntersect_meshbvh.h"
+
+uint64_t MeshRayBVH::ComputeTopologyHash(FBMesh *pMesh, const int vertexCount)
+{
+	// FNV-1a over vertex count and polygon vertex indices
+	uint64_t hash = 14695981039346656037ULL;
+	auto combine = [&hash](const int value) {
+		hash ^= static_cast<uint64_t>(static_cast<uint32_t>(value));
+		hash *= 1099511628211ULL;
+	};
+
+	combine(vertexCount);
+	combine(pMesh->PolygonCount());
+
+	int polyVertexCount = 0;
+	const int *polyVertexIndices = pMesh->PolygonVertexArrayGet(polyVertexCount);
+	combine(polyVertexCount);
+
+	if (polyVertexIndices)
+	{
+		for (int i = 0; i < polyVertexCount; ++i)
+			combine(polyVertexIndices[i]);
+	}
+	return hash;
+}
+
+bool MeshRayBVH::ReadPositions(FBModel *pModel, bool &changed)
+{
+	FBMesh *pMesh = pModel->TessellatedMesh;
+	if (!pMesh)
+		return false;
+
+	int vertexCount = 0;
+	const FBVertex *pVertices = pMesh->GetPositionsArray(vertexCount);
+	if (!pVertices || vertexCount <= 0)
+		return false;
+
+	changed = (static_cast<int>(mPositions.size()) != 3 * vertexCount);
+	mPositions.resize(3 * vertexCount);
+
+	float *dst = mPositions.data();
+	for (int i = 0; i < vertexCount; ++i, dst += 3)
+	{
+		const float x = pVertices[i][0];
+		const float y = pVertices[i][1];
+		const float z = pVertices[i][2];
+
+		if (!changed && (dst[0] != x || dst[1] != y || dst[2] != z))
+			changed = true;
+
+		dst[0] = x;
+		dst[1] = y;
+		dst[2] = z;
+	}
+	return true;
+}
+
+bool MeshRayBVH::Build(FBModel *pModel)
+{
+	Clear();
+	mTopologyHash = 0;
+
+	if (!pModel)
+		return false;
+
+	FBMesh *pMesh = pModel->TessellatedMesh;
+	if (!pMesh)
+		return false;
+
+	bool changed = false;
+	if (!ReadPositions(pModel, changed))
+		return false;
+
+	const int vertexCount = static_cast<int>(mPositions.size()) / 3;
+	// RayBVH::Build starts from a clear tree, keep a copy of read positions
+	const std::vector<float> positions(mPositions);
+
+	// flat triangle array, polygons are triangulated as a fan
+	const int polyCount = pMesh->PolygonCount();
+
+	std::vector<int>	triIndices;
+	std::vector<int>	triFacets;
+	triIndices.reserve(polyCount * 6);
+	triFacets.reserve(polyCount * 2);
+
+	for (int i = 0; i < polyCount; ++i)
+	{
+		const int count = pMesh->PolygonVertexCount(i);
+		if (count < 3)
+			continue;
+
+		const int i0 = pMesh->PolygonVertexIndex(i, 0);
+		for (int j = 1; j < count - 1; ++j)
+		{
+			triIndices.push_back(i0);
+			triIndices.push_back(pMesh->PolygonVertexIndex(i, j));
+			triIndices.push_back(pMesh->PolygonVertexIndex(i, j + 1));
+			triFacets.push_back(i);
+		}
+	}
+
+	if (!RayBVH::Build(positions.data(), vertexCount, triIndices.data(), triFacets.data(), static_cast<int>(triFacets.size())))
+		return false;
+
+	mTopologyHash = ComputeTopologyHash(pMesh, vertexCount);
+	return true;
+}
+
+bool MeshRayBVH::Update(FBModel *pModel)
+{
+	if (!pModel || IsEmpty())
+		return false;
+
+	FBMesh *pMesh = pModel->TessellatedMesh;
+	if (!pMesh)
+		return false;
+
+	bool changed = false;
+	const int oldPositionsSize = static_cast<int>(mPositions.size());
+
+	if (!ReadPositions(pModel, changed))
+		return false;
+
+	if (oldPositionsSize != static_cast<int>(mPositions.size()))
+		return false;
+
+	if (changed)
+	{
+		// deformed vertices with the same vertex count, topology could be changed as well
+		if (ComputeTopologyHash(pMesh, oldPositionsSize / 3) != mTopologyHash)
+			return false;
+
+		Refit();
+	}
+	return true;
+}
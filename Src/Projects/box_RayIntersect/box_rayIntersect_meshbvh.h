@@ -0,0 +1,40 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_rayIntersect_meshbvh.h
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//--- SDK include
+#include <fbsdk/fbsdk.h>
+
+#include "box_rayIntersect_bvh.h"
+
+/**	MeshRayBVH
+*	RayBVH over a tessellated mesh of a model
+*/
+class MeshRayBVH : public RayBVH
+{
+public:
+
+	//! grab triangles from a tessellated mesh (fan triangulation) and build a tree, returns false for an empty mesh
+	bool Build(FBModel *pModel);
+
+	//! read new mesh positions, refit the tree when they are changed since last build/refit
+	//!  returns false when topology is different and the tree has to be rebuilt
+	bool Update(FBModel *pModel);
+
+protected:
+
+	uint64_t				mTopologyHash{ 0 };
+
+	bool ReadPositions(FBModel *pModel, bool &changed);
+	static uint64_t ComputeTopologyHash(FBMesh *pMesh, const int vertexCount);
+};
@@ -16,6 +16,7 @@
 //--- Class declaration
 #include <math.h>
 #include "boxSpring_box.h"
+#include "boxSpring_system.h"
 
 //--- Registration defines
 #define BOXSPRING__CLASS		BOXSPRING__CLASSNAME
@@ -39,18 +40,15 @@ FBRegisterBox		(	BOXSPRING__NAME,			// Unique name to register box.
 bool CBoxSpring::FBCreate()
 {
 	lastLocalTimeDouble = lastSystemTimeDouble = 0.0;
-	mOldPos[0] = mOldPos[1] = mOldPos[2] = 0.0;
-	mCurrentPos[0] = mCurrentPos[1] = mCurrentPos[2] = 0.0;
-	mVel[0] = mVel[1] = mVel[2] = 0.0;
-
-	mDeltaTimeDouble = 0.0;
-	
-	mReset = false;
+	mSlot = CSpringSystem::TheOne().Register();
 
 	//printf( "spring box here!\n" );
 
 	if( FBBox::FBCreate() )
 	{
+		FBPropertyPublish(this, Batched, "Batched", nullptr, nullptr);
+		Batched = false;
+
 		// Input Nodes
 		mStiffnessNode	= AnimationNodeInCreate	( 0, "Stiff",		ANIMATIONNODE_TYPE_NUMBER );
 		mDampingNode	= AnimationNodeInCreate	( 1, "Damp",		ANIMATIONNODE_TYPE_NUMBER );
@@ -78,6 +76,7 @@ bool CBoxSpring::FBCreate()
  ************************************************/
 void CBoxSpring::FBDestroy()
 {
+	CSpringSystem::TheOne().Unregister(mSlot);
 	FBBox::FBDestroy();
 }
 
@@ -92,146 +91,13 @@ void VectorSet( float a, float b, float c, FBVector3d &v )
 	v[2] = c;
 }
 
-void VectorAdd( const FBVector3d &a, const FBVector3d &b, FBVector3d &c )
-{
-	c[0] = a[0] + b[0];
-	c[1] = a[1] + b[1];
-	c[2] = a[2] + b[2];
-}
-
-void VectorSub( const FBVector3d &a, const FBVector3d &b, FBVector3d &c )
-{
-	c[0] = a[0] - b[0];
-	c[1] = a[1] - b[1];
-	c[2] = a[2] - b[2];
-}
-
-void VectorMul( const FBVector3d &a, const FBVector3d &b, FBVector3d &c )
-{
-	c[0] = a[0] * b[0];
-	c[1] = a[1] * b[1];
-	c[2] = a[2] * b[2];
-}
-
-void VectorMul( const FBVector3d &a, float scale, FBVector3d &c )
-{
-	c[0] = a[0] * scale;
-	c[1] = a[1] * scale;
-	c[2] = a[2] * scale;
-}
-
-void VectorDiv( const FBVector3d &a, float scale, FBVector3d &c )
-{
-	c[0] = a[0] / scale;
-	c[1] = a[1] / scale;
-	c[2] = a[2] / scale;
-}
-
-float VectorLength( const FBVector3d &a )
-{
-	return sqrt( a[0]*a[0] + a[1]*a[1] + a[2]*a[2] );
-}
-
-void VectorNorm( FBVector3d &v )
-{
-	float len = VectorLength( v );
-
-	if (len > 0)
-	{
-		v[0] /= len;
-		v[1] /= len;
-		v[2] /= len;
-	}
-}
-
-float VectorDot( const FBVector3d &a, FBVector3d &b )
-{
-	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
-}
-
-struct SpringSettings
-{
-	double length; 
-	double friction;
-	double mass; 
-	double stiffness;
-	double damping;
-
-	SpringSettings(const double _length, const double _friction, const double _mass, const double _stiffness, const double _damping)
-		: length(_length)
-		, friction(_friction)
-		, mass(_mass)
-		, stiffness(_stiffness)
-		, damping(_damping)
-	{}
-};
-
-
-bool CalculateSpring( const double dt, const FBVector3d &lV, const FBVector3d &mPos, const FBVector3d &mOldPos, const SpringSettings &settings, FBVector3d &mVel, FBVector3d &outPos )
-{
-	FBVector3d	lForce, lR;
-	FBVector3d	px1, px2, pv1, pv2, dx, dv;			// position & velocity
-	double		m, r, value;						// vector length
-
-	// position
-	px1 = lV;
-	px2 = mOldPos;
-	VectorSub( px1, px2, dx );
-
-	// velocity
-	VectorSub( lV, mOldPos, pv1 );
-	pv2 = mVel;
-	VectorSub( pv1, pv2, dv );
-		
-	// force
-	r = settings.length;
-	m = VectorLength( dx );
-	if (m == 0.0) m = 0.0001;
-
-	lForce = dx;
-	VectorNorm( lForce );
-	value = (settings.stiffness*(m-r)+settings.damping*(VectorDot(dv, dx)/m));
-	//value = lS*(m-r);
-	VectorMul( lForce, value, lForce );
-	VectorDiv( lForce, settings.mass, lForce );
-
-	// add friction
-	lR = mVel;
-	if (m > 1.0f)
-		VectorMul( lR, -settings.friction, lR );
-	else
-		VectorMul( lR, -settings.friction, lR );
-	VectorAdd( lForce, lR, lForce );
-
-	VectorAdd( mVel, lForce, mVel );			// Change in velocity is added to the velocity.
-												// The change is proportinal with the acceleration (force / m) and change in time
-	
-	VectorMul( mVel, dt, lR );					// Change in position is added to the position.
-	VectorAdd( mOldPos, mVel, outPos );				// Change in position is velocity times the change in time
-		
-/*
-	//
-	//	damping
-	//
-	VectorSub( lV, mPos, lR );
-	VectorMul( lR, 0.5, lR );
-	double dt = (lTime - lastTimeDouble) * 10;
-	VectorMul( lR, dt, lR );
-
-	VectorAdd( mPos, lR, mPos );
-	lR = mPos;
-*/
-
-	return true;
-}
-
 bool CBoxSpring::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FBEvaluateInfo *pEvaluateInfo )
 {
 	double		lS, lD, lM, lFriction, lLength, lTimeDt, lZeroFrame, lRealTime;
-	FBVector3d	lInputPos, lR, lVel, lHold, lForce;
+	FBVector3d	lInputPos, lR;
 	bool		lStatus[9];
 	
-	FBTime		lEvaluationTime, lLocalTime;
+	FBTime		lEvaluationTime, lLocalTime, lSystemTime;
 
 	
 	// Read connector in values
@@ -277,107 +143,87 @@ bool CBoxSpring::AnimationNodeNotify( FBAnimationNode *pAnimationNode, FBEvaluat
 	
 	const double resetLimit = 20.0;
 
-	// Get the current evaluation time, indicating if recording.
 #ifdef OLD_FBEVALUATE_LOCALTIME
-	
-	// Get the current evaluation time, indicating if recording.
-    if( lRealTime > 0.0 )
-    {
-		lEvaluationTime = FBSystem().SystemTime;
-		mDeltaTimeDouble += lEvaluationTime.GetSecondDouble() - lastSystemTimeDouble;
+	lSystemTime = FBSystem().SystemTime;
+	lLocalTime = pEvaluateInfo->GetLocalStart();
+#else
+	lSystemTime = pEvaluateInfo->GetSystemTime();
+	lLocalTime = pEvaluateInfo->GetLocalTime();
+#endif
 
-		if (mDeltaTimeDouble > resetLimit)
-		{
-			lastSystemTimeDouble = lEvaluationTime.GetSecondDouble();
-			mDeltaTimeDouble = 0.0;
-			mReset = true;
-		}
-    }
-    else
-    {
-        lEvaluationTime = pEvaluateInfo->GetLocalStart();
+	// batched springs are integrated together once per evaluation tick
+	CSpringSystem &lSystem = CSpringSystem::TheOne();
+	const bool lBatched = Batched;
 
-		mDeltaTimeDouble += lEvaluationTime.GetSecondDouble() - lastLocalTimeDouble;
+	if (lBatched)
+		lSystem.BeginTick( lSystemTime.Get() * 31 + lLocalTime.Get() );
 
-		if (mDeltaTimeDouble > resetLimit || lEvaluationTime.GetFrame() == (int)lZeroFrame)
-		{
-			lastLocalTimeDouble = lEvaluationTime.GetSecondDouble();
-			mDeltaTimeDouble = 0.0;
-			mReset = true;
-		}
-    }
-	lLocalTime = pEvaluateInfo->GetLocalStart();
-
-#else
+	bool lReset = false;
+	double lDeltaTime = 0.0;
 
 	// Get the current evaluation time, indicating if recording.
     if( lRealTime > 0.0 )
     {
-        lEvaluationTime = pEvaluateInfo->GetSystemTime();
-		mDeltaTimeDouble += lEvaluationTime.GetSecondDouble() - lastSystemTimeDouble;
+        lEvaluationTime = lSystemTime;
+		lDeltaTime = lEvaluationTime.GetSecondDouble() - lastSystemTimeDouble;
 
-		if (mDeltaTimeDouble > resetLimit)
-		{
-			lastSystemTimeDouble = lEvaluationTime.GetSecondDouble();
-			mDeltaTimeDouble = 0.0;
-			mReset = true;
-		}
+		if (lDeltaTime > resetLimit)
+			lReset = true;
     }
     else
     {
-        lEvaluationTime = pEvaluateInfo->GetLocalTime();
+        lEvaluationTime = lLocalTime;
+		lDeltaTime = lEvaluationTime.GetSecondDouble() - lastLocalTimeDouble;
 
-		mDeltaTimeDouble += lEvaluationTime.GetSecondDouble() - lastLocalTimeDouble;
+		const int lFrame = lEvaluationTime.GetFrame();
 
-		if (mDeltaTimeDouble > resetLimit || lEvaluationTime.GetFrame() == (int)lZeroFrame)
+		if (lDeltaTime > resetLimit || lFrame == (int)lZeroFrame)
+		{
+			lReset = true;
+			lSystem.CacheClear(mSlot);
+		}
+		else if (lDeltaTime < 0.0)
 		{
-			lastLocalTimeDouble = lEvaluationTime.GetSecondDouble();
-			mDeltaTimeDouble = 0.0;
-			mReset = true;
+			// scrubbing backward, use a simulated state of that frame
+			lReset = !lSystem.CacheRestore(mSlot, lFrame);
+			lDeltaTime = 0.0;
 		}
     }
-	lLocalTime = pEvaluateInfo->GetLocalTime();
 
-#endif
-
-
-	if ( mReset )
+	if ( lReset )
 	{
-		VectorSet( 0.0, 0.0, 0.0, mVel );
-		mCurrentPos = lInputPos;	// at start mass pos and input pos is equal
-
-		lR = lInputPos;
-		mOldPos = lInputPos;
-
-		mReset = false;
+		// at start mass pos and input pos is equal
+		lSystem.Reset(mSlot, lInputPos);
+		lDeltaTime = 0.0;
 	}
+
+	if (lTimeDt == 0.0) lTimeDt = 30.0;
 	else
-	{	
-		
-		if (lTimeDt == 0.0) lTimeDt = 30.0;
-		else
-		if (lTimeDt < 0.0) lTimeDt = fabsl(lTimeDt);
+	if (lTimeDt < 0.0) lTimeDt = fabsl(lTimeDt);
 
-		if (lTimeDt > 200.0) lTimeDt = 200.0;
+	if (lTimeDt > 200.0) lTimeDt = 200.0;
 
-		const double dt = 1.0 / lTimeDt;
+	CSpringSystem::Settings settings;
+	settings.length = static_cast<float>(lLength);
+	settings.friction = static_cast<float>(lFriction);
+	settings.mass = static_cast<float>(lM);
+	settings.stiffness = static_cast<float>(lS);
+	settings.damping = static_cast<float>(lD);
+	settings.stepTime = static_cast<float>(1.0 / lTimeDt);
 
-		SpringSettings settings(lLength, lFriction, lM, lS, lD);
-		lHold = lInputPos;
+	// a batched spring is stepped on a next tick, otherwise it moves toward the current input right away
+	if (false == lBatched)
+		lSystem.Evaluate(mSlot, lInputPos, settings, lDeltaTime);
 
-		//printf( "delta time double - %.2f\n", (float) mDeltaTimeDouble );
-		while( mDeltaTimeDouble > dt )
-		{
-			//printf( "vel length - %.2f\n", (float)FBLength( FBTVector(mVel[0], mVel[1], mVel[2], 0.0) ) );
-			
-			CalculateSpring( dt, lInputPos, mCurrentPos, mOldPos, settings, mVel, mCurrentPos );
-			mDeltaTimeDouble -= dt;
-		}
+	lSystem.GetPosition(mSlot, lR);
 
-		lR = mCurrentPos;
-		mOldPos = mCurrentPos;
+	if (lRealTime <= 0.0)
+	{
+		lSystem.CacheStore(mSlot, lEvaluationTime.GetFrame());
 	}
 
+	if (lBatched)
+		lSystem.Submit(mSlot, lInputPos, settings, lDeltaTime);
 	
 	if( lRealTime > 0.0 )
     {
@@ -46,6 +46,10 @@ public:
 	//! FBX Retrieval function
 	virtual bool FbxRetrieve(FBFbxObject *pFbxObject, kFbxObjectStore pStoreWhat );
 
+public:
+
+	FBPropertyBool		Batched;			//!< step together with other springs, a target of a previous tick is used
+
 private:
 
 	FBAnimationNode	*mStiffnessNode;		//!< Input node: Stiffness.
@@ -66,13 +70,8 @@ private:
 
 	double				lastLocalTimeDouble;
 	double				lastSystemTimeDouble;
-	FBVector3d			mOldPos;			// motion old pos (for force calculation)
-	FBVector3d			mCurrentPos;				// mass pos
-	FBVector3d			mVel;				// mass velocity
-
-	double				mDeltaTimeDouble;
 
-	bool				mReset;
+	int					mSlot;				// spring index in a shared spring system (mass pos, velocity)
 };
 
 
@@ -0,0 +1,282 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// boxSpring_system.cxx
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**	\file	boxSpring_system.cxx
+*/
+
+#include "boxSpring_system.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <limits.h>
+
+#define SPRING_MIN_DISTANCE		0.0001f
+#define SPRING_MAX_STEPS		4000		// 20 seconds (reset limit) with 200 steps per second
+#define SPRING_CACHE_FRAMES		2048		// ring buffer size per spring, power of two
+
+namespace
+{
+	inline __m128 Select(const __m128 mask, const __m128 a, const __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+};
+
+CSpringSystem &CSpringSystem::TheOne()
+{
+	static CSpringSystem	gSpringSystem;
+	return gSpringSystem;
+}
+
+void CSpringSystem::Resize(const int count)
+{
+	const size_t size = static_cast<size_t>((count + 3) & ~3);
+
+	for (std::vector<float> *pArray : { &mPosX, &mPosY, &mPosZ, &mVelX, &mVelY, &mVelZ, &mTargetX, &mTargetY, &mTargetZ,
+		&mLength, &mFriction, &mStiffness, &mDamping, &mAccumTime })
+	{
+		pArray->resize(size, 0.0f);
+	}
+	// keep padding lanes valid for a division
+	mInvMass.resize(size, 1.0f);
+	mStepTime.resize(size, 1.0f);
+
+	mCache.resize(count);
+}
+
+int CSpringSystem::Register()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	int slot;
+	if (!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		slot = mCount++;
+		Resize(mCount);
+	}
+
+	mPosX[slot] = mPosY[slot] = mPosZ[slot] = 0.0f;
+	mVelX[slot] = mVelY[slot] = mVelZ[slot] = 0.0f;
+	mTargetX[slot] = mTargetY[slot] = mTargetZ[slot] = 0.0f;
+	mAccumTime[slot] = 0.0f;
+	mCache[slot].clear();
+
+	return slot;
+}
+
+void CSpringSystem::Unregister(const int slot)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (slot < 0 || slot >= mCount)
+		return;
+
+	mAccumTime[slot] = 0.0f;
+	mCache[slot].clear();
+	mFreeSlots.push_back(slot);
+}
+
+void CSpringSystem::BeginTick(const long long tickKey)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (tickKey == mLastTickKey)
+		return;
+
+	mLastTickKey = tickKey;
+	Step();
+}
+
+void CSpringSystem::Reset(const int slot, const double *pos)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mPosX[slot] = mTargetX[slot] = static_cast<float>(pos[0]);
+	mPosY[slot] = mTargetY[slot] = static_cast<float>(pos[1]);
+	mPosZ[slot] = mTargetZ[slot] = static_cast<float>(pos[2]);
+	mVelX[slot] = mVelY[slot] = mVelZ[slot] = 0.0f;
+	mAccumTime[slot] = 0.0f;
+}
+
+void CSpringSystem::Evaluate(const int slot, const double *target, const Settings &settings, const double deltaTime)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	SetTarget(slot, target, settings, deltaTime);
+
+	const int lane = slot & 3;
+	const __m128 laneMask = _mm_castsi128_ps(_mm_set_epi32((lane == 3) ? -1 : 0, (lane == 2) ? -1 : 0, (lane == 1) ? -1 : 0, (lane == 0) ? -1 : 0));
+	StepLanes(slot & ~3, laneMask);
+}
+
+void CSpringSystem::Submit(const int slot, const double *target, const Settings &settings, const double deltaTime)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	SetTarget(slot, target, settings, deltaTime);
+}
+
+void CSpringSystem::SetTarget(const int slot, const double *target, const Settings &settings, const double deltaTime)
+{
+	mTargetX[slot] = static_cast<float>(target[0]);
+	mTargetY[slot] = static_cast<float>(target[1]);
+	mTargetZ[slot] = static_cast<float>(target[2]);
+
+	mLength[slot] = settings.length;
+	mFriction[slot] = settings.friction;
+	mInvMass[slot] = (settings.mass != 0.0f) ? 1.0f / settings.mass : 1.0f;
+	mStiffness[slot] = settings.stiffness;
+	mDamping[slot] = settings.damping;
+	mStepTime[slot] = settings.stepTime;
+
+	const float accum = mAccumTime[slot] + static_cast<float>(std::max(0.0, deltaTime));
+	mAccumTime[slot] = std::min(accum, SPRING_MAX_STEPS * settings.stepTime);
+}
+
+void CSpringSystem::GetPosition(const int slot, double *pos) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	pos[0] = static_cast<double>(mPosX[slot]);
+	pos[1] = static_cast<double>(mPosY[slot]);
+	pos[2] = static_cast<double>(mPosZ[slot]);
+}
+
+void CSpringSystem::CacheStore(const int slot, const int frame)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::vector<CachedState> &cache = mCache[slot];
+	if (cache.empty())
+	{
+		CachedState empty;
+		empty.frame = INT_MIN;
+		cache.resize(SPRING_CACHE_FRAMES, empty);
+	}
+
+	CachedState &state = cache[frame & (SPRING_CACHE_FRAMES - 1)];
+	state.frame = frame;
+	state.pos[0] = mPosX[slot];
+	state.pos[1] = mPosY[slot];
+	state.pos[2] = mPosZ[slot];
+	state.vel[0] = mVelX[slot];
+	state.vel[1] = mVelY[slot];
+	state.vel[2] = mVelZ[slot];
+}
+
+bool CSpringSystem::CacheRestore(const int slot, const int frame)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	const std::vector<CachedState> &cache = mCache[slot];
+	if (cache.empty() || cache[frame & (SPRING_CACHE_FRAMES - 1)].frame != frame)
+		return false;
+
+	const CachedState &state = cache[frame & (SPRING_CACHE_FRAMES - 1)];
+	mPosX[slot] = state.pos[0];
+	mPosY[slot] = state.pos[1];
+	mPosZ[slot] = state.pos[2];
+	mVelX[slot] = state.vel[0];
+	mVelY[slot] = state.vel[1];
+	mVelZ[slot] = state.vel[2];
+	mAccumTime[slot] = 0.0f;
+	return true;
+}
+
+void CSpringSystem::CacheClear(const int slot)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCache[slot].clear();
+}
+
+void CSpringSystem::Step()
+{
+	const int size = static_cast<int>(mAccumTime.size());
+	const __m128 allLanes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (int i = 0; i < size; i += 4)
+		StepLanes(i, allLanes);
+}
+
+void CSpringSystem::StepLanes(const int i, const __m128 laneMask)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 minDistance = _mm_set1_ps(SPRING_MIN_DISTANCE);
+
+	__m128 accum = _mm_loadu_ps(&mAccumTime[i]);
+	const __m128 stepTime = _mm_loadu_ps(&mStepTime[i]);
+
+	// a step is made while there is more time left than a step time
+	__m128 mask = _mm_and_ps(laneMask, _mm_cmpgt_ps(accum, stepTime));
+	if (_mm_movemask_ps(mask) == 0)
+		return;
+
+	const __m128 stepped = mask;
+
+	// position of a previous evaluation, forces are computed against it on every sub-step
+	const __m128 px = _mm_loadu_ps(&mPosX[i]);
+	const __m128 py = _mm_loadu_ps(&mPosY[i]);
+	const __m128 pz = _mm_loadu_ps(&mPosZ[i]);
+
+	__m128 vx = _mm_loadu_ps(&mVelX[i]);
+	__m128 vy = _mm_loadu_ps(&mVelY[i]);
+	__m128 vz = _mm_loadu_ps(&mVelZ[i]);
+
+	const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&mTargetX[i]), px);
+	const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&mTargetY[i]), py);
+	const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&mTargetZ[i]), pz);
+
+	const __m128 length = _mm_loadu_ps(&mLength[i]);
+	const __m128 friction = _mm_loadu_ps(&mFriction[i]);
+	const __m128 invMass = _mm_loadu_ps(&mInvMass[i]);
+	const __m128 stiffness = _mm_loadu_ps(&mStiffness[i]);
+	const __m128 damping = _mm_loadu_ps(&mDamping[i]);
+
+	const __m128 m = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))), minDistance);
+	const __m128 invM = _mm_div_ps(_mm_set1_ps(1.0f), m);
+	const __m128 spring = _mm_mul_ps(stiffness, _mm_sub_ps(m, length));
+
+	do
+	{
+		// relative velocity
+		const __m128 dvx = _mm_sub_ps(dx, vx);
+		const __m128 dvy = _mm_sub_ps(dy, vy);
+		const __m128 dvz = _mm_sub_ps(dz, vz);
+		const __m128 dvdx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dvx, dx), _mm_mul_ps(dvy, dy)), _mm_mul_ps(dvz, dz));
+
+		// stiffness * (m - length) + damping * dot(dv, dx) / m, along the normalized dx and divided by mass
+		const __m128 value = _mm_add_ps(spring, _mm_mul_ps(damping, _mm_mul_ps(dvdx, invM)));
+		const __m128 scale = _mm_mul_ps(_mm_mul_ps(value, invM), invMass);
+
+		// velocity with a friction
+		vx = Select(mask, _mm_add_ps(vx, _mm_sub_ps(_mm_mul_ps(dx, scale), _mm_mul_ps(friction, vx))), vx);
+		vy = Select(mask, _mm_add_ps(vy, _mm_sub_ps(_mm_mul_ps(dy, scale), _mm_mul_ps(friction, vy))), vy);
+		vz = Select(mask, _mm_add_ps(vz, _mm_sub_ps(_mm_mul_ps(dz, scale), _mm_mul_ps(friction, vz))), vz);
+
+		accum = _mm_sub_ps(accum, _mm_and_ps(mask, stepTime));
+		mask = _mm_and_ps(mask, _mm_cmpgt_ps(accum, stepTime));
+
+	} while (_mm_movemask_ps(mask) != 0);
+
+	// position is moved once by the resulting velocity
+	_mm_storeu_ps(&mPosX[i], Select(stepped, _mm_add_ps(px, vx), px));
+	_mm_storeu_ps(&mPosY[i], Select(stepped, _mm_add_ps(py, vy), py));
+	_mm_storeu_ps(&mPosZ[i], Select(stepped, _mm_add_ps(pz, vz), pz));
+	_mm_storeu_ps(&mVelX[i], vx);
+	_mm_storeu_ps(&mVelY[i], vy);
+	_mm_storeu_ps(&mVelZ[i], vz);
+	_mm_storeu_ps(&mAccumTime[i], _mm_max_ps(accum, zero));
+}
@@ -0,0 +1,115 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// boxSpring_system.h
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __BOX_SPRING_SYSTEM_H__
+#define __BOX_SPRING_SYSTEM_H__
+
+/**	\file	boxSpring_system.h
+*	shared spring engine, all spring boxes of a scene are integrated together
+*/
+
+#include <xmmintrin.h>
+#include <vector>
+#include <mutex>
+
+/**	CSpringSystem
+*	keeps state of every registered spring in SoA arrays and integrates them with a fixed time step
+*	per spring, 4 springs per SSE lane set. Velocity is integrated on every sub-step and the position
+*	 is moved once per evaluation, like the spring box did before.
+*
+*	Evaluate steps one spring right away toward a target of the current tick.
+*	Batched springs are submitted instead and all of them are stepped together when the first box
+*	 of a new tick is evaluated, so a batched spring moves toward a target of a previous tick.
+*/
+class CSpringSystem
+{
+public:
+
+	struct Settings
+	{
+		float	length;
+		float	friction;
+		float	mass;
+		float	stiffness;
+		float	damping;
+		float	stepTime;		//!< fixed integration step in seconds
+	};
+
+	static CSpringSystem &TheOne();
+
+	int		Register();
+	void	Unregister(const int slot);
+
+	//! integrate all springs once per evaluation tick, tickKey is any value that changes every tick
+	void	BeginTick(const long long tickKey);
+
+	//! put spring into a rest state at a given position
+	void	Reset(const int slot, const double *pos);
+
+	//! step a spring toward a target right away
+	void	Evaluate(const int slot, const double *target, const Settings &settings, const double deltaTime);
+
+	//! new target and time to simulate on a next tick, for batched springs
+	void	Submit(const int slot, const double *target, const Settings &settings, const double deltaTime);
+
+	void	GetPosition(const int slot, double *pos) const;
+
+	//
+	// deterministic cache for a scene local time, so scrubbing backward restores a simulated state,
+	//  a ring buffer per spring keeps the last SPRING_CACHE_FRAMES frames
+
+	void	CacheStore(const int slot, const int frame);
+	//! returns false when there is no cached state for a frame
+	bool	CacheRestore(const int slot, const int frame);
+	void	CacheClear(const int slot);
+
+protected:
+
+	struct CachedState
+	{
+		int		frame;
+		float	pos[3];
+		float	vel[3];
+	};
+
+	mutable std::mutex		mMutex;
+
+	long long				mLastTickKey{ 0 };
+	int						mCount{ 0 };		//!< number of allocated slots, including free ones
+
+	std::vector<int>		mFreeSlots;
+
+	// SoA spring state, arrays are padded up to a multiple of 4
+
+	std::vector<float>		mPosX, mPosY, mPosZ;
+	std::vector<float>		mVelX, mVelY, mVelZ;
+	std::vector<float>		mTargetX, mTargetY, mTargetZ;
+
+	std::vector<float>		mLength;
+	std::vector<float>		mFriction;
+	std::vector<float>		mInvMass;
+	std::vector<float>		mStiffness;
+	std::vector<float>		mDamping;
+	std::vector<float>		mStepTime;
+	std::vector<float>		mAccumTime;		//!< time left to simulate, 0 for free slots
+
+	std::vector<std::vector<CachedState>>	mCache;
+
+	void	Resize(const int count);
+	void	SetTarget(const int slot, const double *target, const Settings &settings, const double deltaTime);
+	void	Step();
+	//! integrate a set of 4 springs starting at index, only lanes in a mask are stepped
+	void	StepLanes(const int index, const __m128 laneMask);
+};
+
+
+#endif /* __BOX_SPRING_SYSTEM_H__ */
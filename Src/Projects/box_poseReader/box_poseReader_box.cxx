@@ -18,7 +18,6 @@
 
 //--- Class declaration
 #include "box_poseReader_box.h"
-#include <math.h>
 
 //--- Registration defines
 #define ORBOXTEMPLATE__CLASS		ORBOXTEMPLATE__CLASSNAME
@@ -36,12 +35,6 @@ FBRegisterBox		(	ORBOXTEMPLATE__NAME,			// Unique name to register box.
 						ORBOXTEMPLATE__DESC,			// Box long description.
 						FB_DEFAULT_SDK_ICON			);	// Icon filename (default=Open Reality icon)
 
-#define VRADTODEG 57.295828
-#define VDEGTORAD 0.0174533
-
-typedef enum { eInterpLinear, eInterpSmoothStep, eInterpGaussian, eInterpCurve } EINTERPMODE ;
-
-
 /************************************************
  *	Creation
  ************************************************/
@@ -118,70 +111,14 @@ void Box_PoseReader::FBDestroy()
 /************************************************
  *	Real-time engine evaluation
  ************************************************/
-void VectorNormalize(FBTVector &vector)
+bool IsEqual(const double *a, const double *b, const int count)
 {
-	double len = FBLength(vector);
-	if (len != 0.0)
+	for (int i = 0; i < count; ++i)
 	{
-		FBMult( vector, vector, 1.0/len);
+		if (a[i] != b[i])
+			return false;
 	}
-}
-
-// --------------------------------------------------------------------------
-
-
-/*
- * poseReader::calcWtFromAngle() - Calcs weight based on a 0-180 angle.
- */
-double calcWtFromAngle(const double& dAngle, const double& dMinAngle, const double& dMaxAngle)
-{
-	double dWt ;
-
-	if (dAngle >= dMaxAngle)
-		dWt = 0.0 ;
-	else if (dAngle <= dMinAngle)
-		dWt = 1.0 ;
-	else
-		{
-		double dDelta = dMaxAngle - dMinAngle ;
-		if (dDelta > 0)
-			dWt = 1.0 - ((dAngle - dMinAngle) / dDelta) ;
-		else
-			dWt = 0.0 ;
-		}
-
-	return dWt ;
-}
-
-// ---------------------------------------------------------------------------
-
-
-/*
- * poseReader::smoothStep() - Take a value from 0-1 and instead of having it be linear,
- *			make it ease out and then in from the 0 and 1 locations.
- */
-double smoothStep(const double &dVal)
-{
-	// x^2*(3-2x)
-	double dRet = dVal * dVal * (3.0 - (2.0 * dVal) );
-	return dRet ;
-}
-
-// ---------------------------------------------------------------------------
-
-/*
- * poseReader::smoothGaussian() - Take a value from 0-1 and instead of having it be linear,
- *			make it ease out and then in from the 0 and 1 locations.  This has more of a longer
- *			ease than a smoothstep and so a faster falloff in the middle.
- */
-double smoothGaussian(const double &dVal)
-{
-	// 1.0 - exp( (-1 * x^2 ) / (2*sigma^2) )
-	
-	double dSigma = 1.0 ;		// Must be >0.   As drops to zero, higher value one lasts longer.
-
-	double dRet = (1.0 - exp( -1.0 * (dVal*dVal) * 10.0  / (2.0 * dSigma*dSigma)  ) );	// RBF
-	return dRet ;
+	return true;
 }
 
 bool Box_PoseReader::AnimationNodeNotify( FBAnimationNode* pAnimationNode, FBEvaluateInfo* pEvaluateInfo )
@@ -192,7 +129,7 @@ bool Box_PoseReader::AnimationNodeNotify( FBAnimationNode* pAnimationNode, FBEva
 	*	3. Write the data to the out connector
 	*	4. Return the status of the connection
 	*/
-	FBMatrix	matLive, invmatLive, matPose, invmatPose;
+	FBMatrix	matLive, matPose;
 
 	FBTVector	tLive, tPose;
 	FBRVector	rLive, rPose;
@@ -200,223 +137,60 @@ bool Box_PoseReader::AnimationNodeNotify( FBAnimationNode* pAnimationNode, FBEva
 	FBSVector	s(1.0, 1.0, 1.0);
 
 	double		value;
-    int			lReadAxis;
-	int			lInterpMode;
-	double		lAllowRotate;
-	double		lMinAngle, lMaxAngle;
-	double		lAllowTwist;
-	double		lMinTwist, lMaxTwist;
-	double		lAllowTranslate;
-	double		lMinTranslate, lMaxTranslate; 
+	PoseReaderSettings	settings;
 
 	// Read connector in values (set default values if no connection)
 	mWorldMatrixLiveIn[0]->ReadData( tLive, pEvaluateInfo );
 	mWorldMatrixLiveIn[1]->ReadData( rLive, pEvaluateInfo );
 	
 	FBTRSToMatrix(matLive, tLive, rLive, s );
-#ifdef OLD_FBMATH
-	FBMatrixInverse( invmatLive, matLive );
-#else
-	invmatLive = matLive;
-	invmatLive.Inverse();
-#endif
-	mWorldMatrixPoseIn[0]->ReadData( tPose, pEvaluateInfo );
-	mWorldMatrixPoseIn[1]->ReadData( rPose, pEvaluateInfo );
-
-	FBTRSToMatrix(matPose, tPose, rPose, s );
-#ifdef OLD_FBMATH
-	FBMatrixInverse( invmatPose, matPose );
-#else
-	invmatPose = matPose;
-	invmatPose.Inverse();
-#endif
-	if (mReadAxis->ReadData( &value, pEvaluateInfo ) ) lReadAxis = (int) value;
-	else lReadAxis = 1;
-	if (mInterpMode->ReadData( &value, pEvaluateInfo ) ) lInterpMode = (int) value;
-	else lInterpMode = 1;
-
-
-	if (!mAllowRotate->ReadData( &lAllowRotate, pEvaluateInfo ) ) lAllowRotate = 0.0;
-	if (!mMinAngle->ReadData( &lMinAngle, pEvaluateInfo ) ) lMinAngle = 0.0;
-	if (!mMaxAngle->ReadData( &lMaxAngle, pEvaluateInfo ) ) lMaxAngle = 180.0;
-	
-	if (lMinAngle >= lMaxAngle)
-			lMinAngle = lMaxAngle-0.001 ;
 
-	if (!mAllowTwist->ReadData( &lAllowTwist, pEvaluateInfo ) ) lAllowTwist = 1.0;
-	if (!mMinTwist->ReadData( &lMinTwist, pEvaluateInfo ) ) lMinTwist = 0.0;
-	if (!mMaxTwist->ReadData( &lMaxTwist, pEvaluateInfo ) ) lMaxTwist = 180.0;
+	RigidMatrix	live;
+	live.FromMatrix(matLive);
 
-	if (lMinTwist >= lMaxTwist)
-			lMinTwist = lMaxTwist-0.001 ;
+	mWorldMatrixPoseIn[0]->ReadData( tPose, pEvaluateInfo );
+	mWorldMatrixPoseIn[1]->ReadData( rPose, pEvaluateInfo );
 
-	if (!mAllowTranslate->ReadData( &lAllowTranslate, pEvaluateInfo ) ) lAllowTranslate = 1.0;
-	if (!mMinTranslate->ReadData( &lMinTranslate, pEvaluateInfo ) ) lMinTranslate = 0.0;
-	if (!mMaxTranslate->ReadData( &lMaxTranslate, pEvaluateInfo ) ) lMaxTranslate = 1.0;
+	// there is no scaling, so an inverse is a transposed rotation, and it's kept while a pose is not moving
+	if (!mHasPoseInverse || !IsEqual(tPose, mLastPoseTranslation, 3) || !IsEqual(rPose, mLastPoseRotation, 3))
+	{
+		FBTRSToMatrix(matPose, tPose, rPose, s );
 
-	if (lMinTranslate >= lMaxTranslate)
-			lMinTranslate = lMaxTranslate-0.001 ;
+		RigidMatrix pose;
+		pose.FromMatrix(matPose);
+		RigidInverse(mInvPose, pose);
 
-	// ==========================================
-	// Now do real calc
+		mLastPoseTranslation = tPose;
+		mLastPoseRotation = rPose;
+		mHasPoseInverse = true;
+	}
 
-	double dWt = 1.0 ;			// output weight
+	if (mReadAxis->ReadData( &value, pEvaluateInfo ) ) settings.readAxis = (int) value;
+	else settings.readAxis = 1;
+	if (mInterpMode->ReadData( &value, pEvaluateInfo ) ) settings.interpMode = (int) value;
+	else settings.interpMode = 1;
 
-	double dDot = -1.0 ;
-	double dAngle = 180.0;
-	double dWtTwist = 1.0 ;
-	double dWtTranslate = 1.0 ;
+	if (!mAllowRotate->ReadData( &settings.allowRotate, pEvaluateInfo ) ) settings.allowRotate = 0.0;
+	if (!mMinAngle->ReadData( &settings.minAngle, pEvaluateInfo ) ) settings.minAngle = 0.0;
+	if (!mMaxAngle->ReadData( &settings.maxAngle, pEvaluateInfo ) ) settings.maxAngle = 180.0;
 
-	FBMatrix matRelPose;
-	FBMatrixMult( matRelPose, invmatPose, matLive );	// where is joint relative to pose node?
-	//matRelPose = invmatPose * matLive;
+	if (!mAllowTwist->ReadData( &settings.allowTwist, pEvaluateInfo ) ) settings.allowTwist = 1.0;
+	if (!mMinTwist->ReadData( &settings.minTwist, pEvaluateInfo ) ) settings.minTwist = 0.0;
+	if (!mMaxTwist->ReadData( &settings.maxTwist, pEvaluateInfo ) ) settings.maxTwist = 180.0;
 
-	FBVector4d xAxis(1.0, 0.0, 0.0, 1.0);
-	FBVector4d yAxis(0.0, 1.0, 0.0, 1.0);
-	FBVector4d zAxis(0.0, 0.0, 1.0, 1.0);
+	if (!mAllowTranslate->ReadData( &settings.allowTranslate, pEvaluateInfo ) ) settings.allowTranslate = 1.0;
+	if (!mMinTranslate->ReadData( &settings.minTranslate, pEvaluateInfo ) ) settings.minTranslate = 0.0;
+	if (!mMaxTranslate->ReadData( &settings.maxTranslate, pEvaluateInfo ) ) settings.maxTranslate = 1.0;
 
-	if (lReadAxis == 0)		// X-Axis
-	{
-		// Get X axis of live joint in relative space of the pose node.
-		FBVector4d vAxis;
-		
-		FBVectorMatrixMult( vAxis, matRelPose, xAxis );
-		VectorNormalize( vAxis );
+	settings.Validate();
 
-		dDot = FBDot( vAxis, xAxis ); // Now in pose space, compare it's X axis to the joint
-		
-		if (dDot >= 1.0)		// Have to do this to handle precision errors in acos returning -1.#IND
-			dAngle = 0.0 ;
-		else if (dDot <= -1.0)
-			dAngle = 180.0 ;
-		else
-			dAngle = acos(dDot) * VRADTODEG;	// Now what is actual angle in degress?
-
-		dWt = calcWtFromAngle(dAngle, lMinAngle, lMaxAngle) ;
-		dWt = ((1.0- lAllowRotate) * dWt) + (lAllowRotate * 1.0) ;
-
-		if ( lAllowTwist != 1.0)
-		{
-			FBTVector vAxisTwist;
-			FBVectorMatrixMult( vAxisTwist, matRelPose, yAxis );
-			VectorNormalize( vAxisTwist );
-
-			double dDotTwist = FBDot( vAxisTwist, yAxis ); 
-			double dAngleTwist ;			
-			if (dDotTwist >= 1.0)
-				dAngleTwist = 0.0 ;
-			else if (dDotTwist <= -1.0)
-				dAngleTwist = 180.0 ;
-			else
-				dAngleTwist = acos(dDotTwist) * VRADTODEG;	// Now what is actual angle in degress?
-			
-			dWtTwist = calcWtFromAngle(dAngleTwist, lMinTwist, lMaxTwist) ;
-
-			dWt = ((1.0-lAllowTwist)*(dWt * dWtTwist)) + (lAllowTwist * dWt) ;
-		}
-	}
-	else if (lReadAxis == 1)		// Y-Axis
-	{
-		// Get X axis of live joint in relative space of the pose node.
-		FBTVector vAxis;
-		FBVectorMatrixMult( vAxis, matRelPose, yAxis );
-		VectorNormalize( vAxis );
-
-		dDot = FBDot( vAxis, yAxis ); // Now in pose space, compare it's X axis to the joint
-		
-		if (dDot >= 1.0)		// Have to do this to handle precision errors in acos returning -1.#IND
-			dAngle = 0.0 ;
-		else if (dDot <= -1.0)
-			dAngle = 180.0 ;
-		else
-			dAngle = acos(dDot) * VRADTODEG;	// Now what is actual angle in degress?
-
-		dWt = calcWtFromAngle(dAngle, lMinAngle, lMaxAngle) ;
-		dWt = ((1.0-lAllowRotate) * dWt) + (lAllowRotate * 1.0) ;
-
-		if ( lAllowTwist != 1.0)
-		{
-			FBTVector vAxisTwist;
-			FBVectorMatrixMult( vAxisTwist, matRelPose, xAxis );
-			VectorNormalize( vAxisTwist );
-
-			double dDotTwist = FBDot( vAxisTwist, xAxis ); 
-			double dAngleTwist ;			
-			if (dDotTwist >= 1.0)
-				dAngleTwist = 0.0 ;
-			else if (dDotTwist <= -1.0)
-				dAngleTwist = 180.0 ;
-			else
-				dAngleTwist = acos(dDotTwist) * VRADTODEG;	// Now what is actual angle in degress?
-			
-			dWtTwist = calcWtFromAngle(dAngleTwist, lMinTwist, lMaxTwist) ;
-
-			dWt = ((1.0-lAllowTwist)*(dWt * dWtTwist)) + (lAllowTwist * dWt) ;
-		}
-	}
-	else if (lReadAxis == 2)		// Z-Axis
-	{
-		// Get X axis of live joint in relative space of the pose node.
-		FBTVector vAxis;
-		FBVectorMatrixMult( vAxis, matRelPose, zAxis );
-		VectorNormalize( vAxis );
-
-		dDot = FBDot( vAxis, zAxis ); // Now in pose space, compare it's X axis to the joint
-		
-		if (dDot >= 1.0)		// Have to do this to handle precision errors in acos returning -1.#IND
-			dAngle = 0.0 ;
-		else if (dDot <= -1.0)
-			dAngle = 180.0 ;
-		else
-			dAngle = acos(dDot) * VRADTODEG;	// Now what is actual angle in degress?
-
-		dWt = calcWtFromAngle(dAngle, lMinAngle, lMaxAngle) ;
-		dWt = ((1.0-lAllowRotate) * dWt) + (lAllowRotate * 1.0) ;
-
-		if ( lAllowTwist != 1.0)
-		{
-			FBTVector vAxisTwist;
-			FBVectorMatrixMult( vAxisTwist, matRelPose, xAxis );
-			VectorNormalize( vAxisTwist );
-
-			double dDotTwist = FBDot( vAxisTwist, xAxis ); 
-			double dAngleTwist ;			
-			if (dDotTwist >= 1.0)
-				dAngleTwist = 0.0 ;
-			else if (dDotTwist <= -1.0)
-				dAngleTwist = 180.0 ;
-			else
-				dAngleTwist = acos(dDotTwist) * VRADTODEG;	// Now what is actual angle in degress?
-			
-			dWtTwist = calcWtFromAngle(dAngleTwist, lMinTwist, lMaxTwist) ;
-
-			dWt = ((1.0-lAllowTwist)*(dWt * dWtTwist)) + (lAllowTwist * dWt) ;
-		}
-	}
+	// ==========================================
+	// Now do real calc
 
-	if (lAllowTranslate != 1.0)
-	{
-		FBTVector vTrans( matRelPose[3*4], matRelPose[3*4+1], matRelPose[3*4+2], 1.0 ) ;
-		double dDist = FBLength( vTrans );
-		if (dDist <= lMinTranslate)
-			dWtTranslate = 1.0 ;
-		else if (dDist >= lMaxTranslate)
-			dWtTranslate = 0.0 ;
-		else
-		{
-			dWtTranslate = 1.0 - ((dDist - lMinTranslate) / (lMaxTranslate - lMinTranslate)) ;
-		}
-
-		dWt = ((1.0-lAllowTranslate)*(dWt * dWtTranslate)) + (lAllowTranslate * dWt) ;
-	}
+	RigidMatrix matRelPose;
+	RigidMult( matRelPose, mInvPose, live );	// where is joint relative to pose node?
 
-	// Adjust actual output a bit if desired.
-	if (lInterpMode == eInterpLinear)
-		;
-	else if (lInterpMode == eInterpSmoothStep)
-		dWt = smoothStep(dWt) ;
-	else if (lInterpMode == eInterpGaussian)
-		dWt = smoothGaussian(dWt) ;
+	double dWt = PoseReaderWeight( matRelPose, settings );
 
 	// Write result out to connector.
 	mOutWeight->WriteData( &dWt, pEvaluateInfo );
@@ -21,6 +21,7 @@
 
 //--- SDK include
 #include <fbsdk/fbsdk.h>
+#include "box_poseReader_math.h"
 
 //--- Registration defines
 #define	ORBOXTEMPLATE__CLASSNAME	Box_PoseReader
@@ -66,6 +67,12 @@ private:
 	FBAnimationNode		*mMaxTranslate;				//!< Input data: Max Translate allowed
 	
 	FBAnimationNode		*mOutWeight;				//!< Output data: output array of weight
+
+	// pose side inverse is computed again only when pose input is changed
+	bool				mHasPoseInverse{ false };
+	FBTVector			mLastPoseTranslation;
+	FBRVector			mLastPoseRotation;
+	RigidMatrix			mInvPose;
 };
 
 #endif /* __BOX_POSE_READER_BOX_H__ */
@@ -0,0 +1,208 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_poseReader_math.cxx
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**	\file	box_poseReader_math.cxx
+
+ This plugin is based on the Comet's PoseReader plugin for Maya
+
+*/
+
+#include "box_poseReader_math.h"
+#include <math.h>
+
+#define VRADTODEG 57.295828
+
+// --------------------------------------------------------------------------
+
+
+/*
+ * poseReader::calcWtFromAngle() - Calcs weight based on a 0-180 angle.
+ */
+double calcWtFromAngle(const double& dAngle, const double& dMinAngle, const double& dMaxAngle)
+{
+	double dWt ;
+
+	if (dAngle >= dMaxAngle)
+		dWt = 0.0 ;
+	else if (dAngle <= dMinAngle)
+		dWt = 1.0 ;
+	else
+		{
+		double dDelta = dMaxAngle - dMinAngle ;
+		if (dDelta > 0)
+			dWt = 1.0 - ((dAngle - dMinAngle) / dDelta) ;
+		else
+			dWt = 0.0 ;
+		}
+
+	return dWt ;
+}
+
+// ---------------------------------------------------------------------------
+
+
+/*
+ * poseReader::smoothStep() - Take a value from 0-1 and instead of having it be linear,
+ *			make it ease out and then in from the 0 and 1 locations.
+ */
+double smoothStep(const double &dVal)
+{
+	// x^2*(3-2x)
+	double dRet = dVal * dVal * (3.0 - (2.0 * dVal) );
+	return dRet ;
+}
+
+// ---------------------------------------------------------------------------
+
+/*
+ * poseReader::smoothGaussian() - Take a value from 0-1 and instead of having it be linear,
+ *			make it ease out and then in from the 0 and 1 locations.  This has more of a longer
+ *			ease than a smoothstep and so a faster falloff in the middle.
+ */
+double smoothGaussian(const double &dVal)
+{
+	// 1.0 - exp( (-1 * x^2 ) / (2*sigma^2) )
+
+	double dSigma = 1.0 ;		// Must be >0.   As drops to zero, higher value one lasts longer.
+
+	double dRet = (1.0 - exp( -1.0 * (dVal*dVal) * 10.0  / (2.0 * dSigma*dSigma)  ) );	// RBF
+	return dRet ;
+}
+
+// ---------------------------------------------------------------------------
+
+/*
+ * angle between a pose axis and the same joint axis in pose space,
+ *  an axis is transformed as a point (w = 1) like FBVectorMatrixMult does for the box
+ */
+double calcAxisAngle(const RigidMatrix &relPose, const int axis)
+{
+	const double *m = relPose.m;
+
+	const double x = m[axis * 3] + m[9];
+	const double y = m[axis * 3 + 1] + m[10];
+	const double z = m[axis * 3 + 2] + m[11];
+
+	const double len = sqrt(x*x + y*y + z*z);
+	const double dDot = (len != 0.0) ? (m[axis * 3 + axis] + m[9 + axis]) / len : 0.0;
+
+	if (dDot >= 1.0)		// Have to do this to handle precision errors in acos returning -1.#IND
+		return 0.0 ;
+	else if (dDot <= -1.0)
+		return 180.0 ;
+
+	return acos(dDot) * VRADTODEG;	// Now what is actual angle in degress?
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// PoseReaderSettings
+
+void PoseReaderSettings::Validate()
+{
+	if (minAngle >= maxAngle)
+		minAngle = maxAngle - 0.001;
+	if (minTwist >= maxTwist)
+		minTwist = maxTwist - 0.001;
+	if (minTranslate >= maxTranslate)
+		minTranslate = maxTranslate - 0.001;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// RigidMatrix
+
+void RigidMatrix::FromMatrix(const double *matrix)
+{
+	for (int c = 0; c < 3; ++c)
+		for (int r = 0; r < 3; ++r)
+			m[c * 3 + r] = matrix[c * 4 + r];
+
+	m[9] = matrix[12];
+	m[10] = matrix[13];
+	m[11] = matrix[14];
+}
+
+void RigidInverse(RigidMatrix &result, const RigidMatrix &m)
+{
+	const double *s = m.m;
+	double *d = result.m;
+
+	for (int c = 0; c < 3; ++c)
+		for (int r = 0; r < 3; ++r)
+			d[c * 3 + r] = s[r * 3 + c];
+
+	for (int r = 0; r < 3; ++r)
+		d[9 + r] = -(s[r * 3] * s[9] + s[r * 3 + 1] * s[10] + s[r * 3 + 2] * s[11]);
+}
+
+void RigidMult(RigidMatrix &result, const RigidMatrix &a, const RigidMatrix &b)
+{
+	const double *ma = a.m;
+	const double *mb = b.m;
+	double *d = result.m;
+
+	// columns 3 is a translation, it's transformed as a point
+	for (int c = 0; c < 4; ++c)
+	{
+		for (int r = 0; r < 3; ++r)
+		{
+			d[c * 3 + r] = ma[r] * mb[c * 3] + ma[3 + r] * mb[c * 3 + 1] + ma[6 + r] * mb[c * 3 + 2];
+		}
+	}
+
+	d[9] += ma[9];
+	d[10] += ma[10];
+	d[11] += ma[11];
+}
+
+double PoseReaderWeight(const RigidMatrix &relPose, const PoseReaderSettings &settings)
+{
+	double dWt = 1.0 ;			// output weight
+
+	if (settings.readAxis >= 0 && settings.readAxis <= 2)
+	{
+		// twist is read around X axis, for X-Axis reader it's Y axis
+		const int twistAxis = (settings.readAxis == 0) ? 1 : 0;
+
+		dWt = calcWtFromAngle(calcAxisAngle(relPose, settings.readAxis), settings.minAngle, settings.maxAngle) ;
+		dWt = ((1.0 - settings.allowRotate) * dWt) + (settings.allowRotate * 1.0) ;
+
+		if (settings.allowTwist != 1.0)
+		{
+			const double dWtTwist = calcWtFromAngle(calcAxisAngle(relPose, twistAxis), settings.minTwist, settings.maxTwist) ;
+			dWt = ((1.0 - settings.allowTwist)*(dWt * dWtTwist)) + (settings.allowTwist * dWt) ;
+		}
+	}
+
+	if (settings.allowTranslate != 1.0)
+	{
+		const double *t = relPose.m + 9;
+		const double dDist = sqrt(t[0]*t[0] + t[1]*t[1] + t[2]*t[2]);
+		double dWtTranslate;
+
+		if (dDist <= settings.minTranslate)
+			dWtTranslate = 1.0 ;
+		else if (dDist >= settings.maxTranslate)
+			dWtTranslate = 0.0 ;
+		else
+			dWtTranslate = 1.0 - ((dDist - settings.minTranslate) / (settings.maxTranslate - settings.minTranslate)) ;
+
+		dWt = ((1.0 - settings.allowTranslate)*(dWt * dWtTranslate)) + (settings.allowTranslate * dWt) ;
+	}
+
+	// Adjust actual output a bit if desired.
+	if (settings.interpMode == eInterpSmoothStep)
+		dWt = smoothStep(dWt) ;
+	else if (settings.interpMode == eInterpGaussian)
+		dWt = smoothGaussian(dWt) ;
+
+	return dWt;
+}
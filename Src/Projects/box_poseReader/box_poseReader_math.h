@@ -0,0 +1,62 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// box_poseReader_math.h
+//
+// Sergei <Neill3d> Solokhin 2014-2018
+//
+// GitHub page - https://github.com/Neill3d/OpenMoBu
+// Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __BOX_POSE_READER_MATH_H__
+#define __BOX_POSE_READER_MATH_H__
+
+/**	\file	box_poseReader_math.h
+
+ pose reader math without sdk dependencies
+
+*/
+
+typedef enum { eInterpLinear, eInterpSmoothStep, eInterpGaussian, eInterpCurve } EINTERPMODE ;
+
+//! connectors values of a pose reader
+struct PoseReaderSettings
+{
+	int		readAxis{ 1 };
+	int		interpMode{ 1 };
+
+	double	allowRotate{ 0.0 };
+	double	minAngle{ 0.0 };
+	double	maxAngle{ 180.0 };
+
+	double	allowTwist{ 1.0 };
+	double	minTwist{ 0.0 };
+	double	maxTwist{ 180.0 };
+
+	double	allowTranslate{ 1.0 };
+	double	minTranslate{ 0.0 };
+	double	maxTranslate{ 1.0 };
+
+	//! keep min values below max values
+	void Validate();
+};
+
+//! transform without scaling, rotation columns in m[0..8] and translation in m[9..11]
+struct RigidMatrix
+{
+	double	m[12];
+
+	//! take rotation and translation from a column-major 4x4 matrix (FBMatrix layout)
+	void FromMatrix(const double *matrix);
+};
+
+//! inverse of a rigid transform is a transposed rotation and a rotated back translation
+void RigidInverse(RigidMatrix &result, const RigidMatrix &m);
+void RigidMult(RigidMatrix &result, const RigidMatrix &a, const RigidMatrix &b);
+
+//! weight of a live joint transform relative to a pose (inverse pose * live)
+double PoseReaderWeight(const RigidMatrix &relPose, const PoseReaderSettings &settings);
+
+#endif /* __BOX_POSE_READER_MATH_H__ */
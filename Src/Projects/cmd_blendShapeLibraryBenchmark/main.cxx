@@ -0,0 +1,440 @@
+
+// main.cxx
+//
+// BlendShape Library Benchmark
+//
+// Compare load times of a blendshape library in the xml and binary formats
+//  - xml streamed with a pull parser (the way Blendshapes_LoadXML reads it)
+//  - binary library with float deltas
+//  - binary library with half deltas and zlib compressed blocks
+//  loaded shapes are compared with the source data, and damaged binary libraries have to be rejected
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "BlendShapeToolkit_library.h"
+#include "xmlPullParser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#define NUMBER_OF_MODELS	10
+#define NUMBER_OF_SHAPES	50
+#define NUMBER_OF_DIFFS		2000
+#define NUMBER_OF_VERTICES	20000
+#define NUMBER_OF_REPEATS	3
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// test data
+
+// positions and normals are 4 floats per diff, like in a library
+struct TestShape
+{
+	std::string			name;
+	std::vector<int>	indices;
+	std::vector<float>	positions;
+	std::vector<float>	normals;
+};
+
+struct TestModel
+{
+	std::string				name;
+	std::vector<TestShape>	shapes;
+};
+
+float RandomRange(const float minValue, const float maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+void GenerateModels(std::vector<TestModel> &models, const int numberOfModels, const int numberOfShapes, const int numberOfDiffs, const int numberOfVertices)
+{
+	models.resize(numberOfModels);
+
+	for (int i = 0; i < numberOfModels; ++i)
+	{
+		TestModel &model = models[i];
+		model.name = "Model " + std::to_string(i);
+		model.shapes.resize(numberOfShapes);
+
+		for (int j = 0; j < numberOfShapes; ++j)
+		{
+			TestShape &shape = model.shapes[j];
+			shape.name = "Shape " + std::to_string(j);
+
+			// sorted sparse indices, like a diff list of a sculpted region
+			int index = rand() % (numberOfVertices / 4);
+			for (int k = 0; k < numberOfDiffs && index < numberOfVertices; ++k)
+			{
+				shape.indices.push_back(index);
+				index += 1 + rand() % 3;
+			}
+
+			const size_t count = shape.indices.size();
+			shape.positions.resize(4 * count, 0.0f);
+			shape.normals.resize(4 * count, 0.0f);
+
+			for (size_t k = 0; k < count; ++k)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					shape.positions[4 * k + c] = RandomRange(-2.0f, 2.0f);
+					shape.normals[4 * k + c] = RandomRange(-0.5f, 0.5f);
+				}
+			}
+		}
+	}
+}
+
+// same layout as Blendshapes_SaveXML writes with tinyxml
+bool WriteXml(const char *fname, const std::vector<TestModel> &models)
+{
+	FILE *fp = fopen(fname, "w");
+	if (nullptr == fp)
+		return false;
+
+	fprintf(fp, "<Header numberOfModels=\"%d\" version=\"1\">\n", static_cast<int>(models.size()));
+
+	for (const TestModel &model : models)
+	{
+		fprintf(fp, "    <Model name=\"%s\" numberOfShapes=\"%d\">\n", model.name.c_str(), static_cast<int>(model.shapes.size()));
+
+		for (const TestShape &shape : model.shapes)
+		{
+			fprintf(fp, "        <Shape name=\"%s\" numberOfDiffs=\"%d\">\n", shape.name.c_str(), static_cast<int>(shape.indices.size()));
+
+			for (size_t k = 0; k < shape.indices.size(); ++k)
+			{
+				const float *p = &shape.positions[4 * k];
+				const float *n = &shape.normals[4 * k];
+				fprintf(fp, "            <Diff OriIndex=\"%d\" PosX=\"%f\" PosY=\"%f\" PosZ=\"%f\" NorX=\"%f\" NorY=\"%f\" NorZ=\"%f\" />\n",
+					shape.indices[k], p[0], p[1], p[2], n[0], n[1], n[2]);
+			}
+			fprintf(fp, "        </Shape>\n");
+		}
+		fprintf(fp, "    </Model>\n");
+	}
+
+	fprintf(fp, "</Header>\n");
+	fclose(fp);
+	return true;
+}
+
+bool WriteBinary(const char *fname, const std::vector<TestModel> &models, const EBlendShapeDeltaFormat deltaFormat, const bool compress)
+{
+	BlendShapeLibraryWriter writer(deltaFormat, compress);
+
+	for (const TestModel &model : models)
+	{
+		writer.AddModel(model.name.c_str());
+
+		for (const TestShape &shape : model.shapes)
+		{
+			writer.AddShape(shape.name.c_str(), static_cast<int>(shape.indices.size()), shape.indices.data(),
+				shape.positions.data(), shape.normals.data());
+		}
+	}
+
+	return writer.Save(fname);
+}
+
+long GetFileSize(const char *fname)
+{
+	FILE *fp = fopen(fname, "rb");
+	if (nullptr == fp)
+		return 0;
+
+	fseek(fp, 0, SEEK_END);
+	const long size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// loaders
+
+bool LoadXml(const char *fname, std::vector<TestModel> &models)
+{
+	models.clear();
+
+	XmlPullParser parser;
+	if (parser.Open(fname) == false)
+		return false;
+
+	if (parser.NextChildElement(0) == false || parser.GetName().Equals("Header") == false)
+		return false;
+
+	while (parser.NextChildElement(1, "Model"))
+	{
+		models.emplace_back();
+		TestModel &model = models.back();
+
+		const XmlAttributeView *attrib = parser.FindAttribute("name");
+		if (attrib)
+			model.name = attrib->value.ToString();
+
+		while (parser.NextChildElement(2, "Shape"))
+		{
+			model.shapes.emplace_back();
+			TestShape &shape = model.shapes.back();
+
+			int numberOfDiffs = 0;
+			for (int i = 0; i < parser.GetNumberOfAttributes(); ++i)
+			{
+				const XmlAttributeView &shapeAttrib = parser.GetAttribute(i);
+				if (shapeAttrib.name.Equals("name"))
+					shape.name = shapeAttrib.value.ToString();
+				else if (shapeAttrib.name.Equals("numberOfDiffs"))
+					numberOfDiffs = shapeAttrib.value.ToInt();
+			}
+
+			shape.indices.reserve(numberOfDiffs);
+			shape.positions.reserve(4 * numberOfDiffs);
+			shape.normals.reserve(4 * numberOfDiffs);
+
+			for (int j = 0; j < numberOfDiffs && parser.NextChildElement(3, "Diff"); ++j)
+			{
+				int index = 0;
+				float pos[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				float nor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+				for (int i = 0; i < parser.GetNumberOfAttributes(); ++i)
+				{
+					const XmlAttributeView &diffAttrib = parser.GetAttribute(i);
+					if (diffAttrib.name.Equals("OriIndex"))
+						index = diffAttrib.value.ToInt();
+					else if (diffAttrib.name.Equals("PosX"))
+						pos[0] = static_cast<float>(diffAttrib.value.ToDouble());
+					else if (diffAttrib.name.Equals("PosY"))
+						pos[1] = static_cast<float>(diffAttrib.value.ToDouble());
+					else if (diffAttrib.name.Equals("PosZ"))
+						pos[2] = static_cast<float>(diffAttrib.value.ToDouble());
+					else if (diffAttrib.name.Equals("NorX"))
+						nor[0] = static_cast<float>(diffAttrib.value.ToDouble());
+					else if (diffAttrib.name.Equals("NorY"))
+						nor[1] = static_cast<float>(diffAttrib.value.ToDouble());
+					else if (diffAttrib.name.Equals("NorZ"))
+						nor[2] = static_cast<float>(diffAttrib.value.ToDouble());
+				}
+
+				shape.indices.push_back(index);
+				shape.positions.insert(end(shape.positions), pos, pos + 4);
+				shape.normals.insert(end(shape.normals), nor, nor + 4);
+			}
+		}
+	}
+
+	return parser.GetEvent() != XmlPullParser::eXmlEventError;
+}
+
+bool LoadBinary(const char *fname, const int numberOfVertices, std::vector<TestModel> &models)
+{
+	models.clear();
+
+	BlendShapeLibrary library;
+	if (library.Open(fname) == false)
+		return false;
+
+	models.resize(library.GetNumberOfModels());
+
+	for (int i = 0; i < library.GetNumberOfModels(); ++i)
+	{
+		TestModel &model = models[i];
+		model.name = library.GetModelName(i);
+		model.shapes.resize(library.GetNumberOfShapes(i));
+
+		for (int j = 0; j < library.GetNumberOfShapes(i); ++j)
+		{
+			TestShape &shape = model.shapes[j];
+			shape.name = library.GetShapeName(i, j);
+
+			if (library.DecodeShape(i, j, numberOfVertices, shape.indices, shape.positions, shape.normals) == false)
+				return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// checks
+
+// max difference of loaded deltas to the source, -1 when names or indices are different
+double CompareModels(const std::vector<TestModel> &source, const std::vector<TestModel> &loaded)
+{
+	if (source.size() != loaded.size())
+		return -1.0;
+
+	double maxError = 0.0;
+
+	for (size_t i = 0; i < source.size(); ++i)
+	{
+		const TestModel &a = source[i];
+		const TestModel &b = loaded[i];
+
+		if (a.name != b.name || a.shapes.size() != b.shapes.size())
+			return -1.0;
+
+		for (size_t j = 0; j < a.shapes.size(); ++j)
+		{
+			const TestShape &sa = a.shapes[j];
+			const TestShape &sb = b.shapes[j];
+
+			if (sa.name != sb.name || sa.indices != sb.indices
+				|| sa.positions.size() != sb.positions.size() || sa.normals.size() != sb.normals.size())
+				return -1.0;
+
+			for (size_t k = 0; k < sa.positions.size(); ++k)
+			{
+				maxError = (std::max)(maxError, fabs(static_cast<double>(sa.positions[k]) - sb.positions[k]));
+				maxError = (std::max)(maxError, fabs(static_cast<double>(sa.normals[k]) - sb.normals[k]));
+			}
+		}
+	}
+	return maxError;
+}
+
+// put a value into a copy of the file, it's a way to make a damaged library
+bool PatchFile(const char *srcName, const char *dstName, const long offset, const void *data, const size_t size)
+{
+	FILE *fp = fopen(srcName, "rb");
+	if (nullptr == fp)
+		return false;
+
+	std::vector<unsigned char> bytes(static_cast<size_t>(GetFileSize(srcName)));
+	const bool isRead = bytes.empty() || (1 == fread(bytes.data(), bytes.size(), 1, fp));
+	fclose(fp);
+
+	if (false == isRead || offset < 0 || static_cast<size_t>(offset) + size > bytes.size())
+		return false;
+
+	memcpy(bytes.data() + offset, data, size);
+
+	fp = fopen(dstName, "wb");
+	if (nullptr == fp)
+		return false;
+
+	const bool isWritten = (1 == fwrite(bytes.data(), bytes.size(), 1, fp));
+	fclose(fp);
+	return isWritten;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	const int numberOfModels = (argc > 1) ? atoi(argv[1]) : NUMBER_OF_MODELS;
+	const int numberOfShapes = (argc > 2) ? atoi(argv[2]) : NUMBER_OF_SHAPES;
+	const int numberOfDiffs = (argc > 3) ? atoi(argv[3]) : NUMBER_OF_DIFFS;
+	const int numberOfVertices = NUMBER_OF_VERTICES;
+
+	if (numberOfModels <= 0 || numberOfShapes <= 0 || numberOfDiffs <= 0)
+	{
+		printf("usage: blendShapeLibrary_benchmark [numberOfModels] [numberOfShapes] [numberOfDiffs]\n");
+		return 1;
+	}
+
+	srand(1234);
+
+	std::vector<TestModel> source;
+	GenerateModels(source, numberOfModels, numberOfShapes, numberOfDiffs, numberOfVertices);
+
+	const char *xmlName = "bslBenchmark.xml";
+	const char *floatName = "bslBenchmark_float.bsl";
+	const char *halfName = "bslBenchmark_half.bsl";
+	const char *damagedName = "bslBenchmark_damaged.bsl";
+
+	if (false == WriteXml(xmlName, source)
+		|| false == WriteBinary(floatName, source, eBlendShapeDeltaFloat, false)
+		|| false == WriteBinary(halfName, source, eBlendShapeDeltaHalf, true))
+	{
+		printf("ERROR: failed to write test files\n");
+		return 1;
+	}
+
+	printf("[BlendShape Library Benchmark] %d models x %d shapes x %d diffs, %d repeats\n", numberOfModels, numberOfShapes, numberOfDiffs, NUMBER_OF_REPEATS);
+
+	bool isOk = true;
+
+	const char *names[3] = { "xml            ", "binary float   ", "binary half zip" };
+	const char *files[3] = { xmlName, floatName, halfName };
+	// xml keeps 6 decimals, half keeps 11 bits of mantissa
+	const double tolerances[3] = { 1e-6, 0.0, 2e-3 };
+
+	for (int mode = 0; mode < 3; ++mode)
+	{
+		std::vector<TestModel> loaded;
+		double seconds = 0.0;
+
+		for (int repeat = 0; repeat < NUMBER_OF_REPEATS; ++repeat)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			const bool isLoaded = (0 == mode) ? LoadXml(files[mode], loaded) : LoadBinary(files[mode], numberOfVertices, loaded);
+
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (false == isLoaded)
+			{
+				printf("ERROR: failed to load %s\n", files[mode]);
+				isOk = false;
+				break;
+			}
+		}
+
+		const double maxError = CompareModels(source, loaded);
+		printf("  %s - %8.2f ms, %8.2f MB on disk, max delta error %g\n", names[mode], 1000.0 * seconds / NUMBER_OF_REPEATS,
+			static_cast<double>(GetFileSize(files[mode])) / (1024.0 * 1024.0), maxError);
+
+		if (maxError < 0.0 || maxError > tolerances[mode])
+		{
+			printf("ERROR: %s loaded data differs from the source\n", files[mode]);
+			isOk = false;
+		}
+	}
+
+	// a library made for a denser mesh has indices outside of a model
+
+	{
+		std::vector<TestModel> loaded;
+		if (LoadBinary(floatName, source[0].shapes[0].indices.back(), loaded))
+		{
+			printf("ERROR: out of range vertex index is not rejected\n");
+			isOk = false;
+		}
+	}
+
+	// shape block which goes over the end of a file, offset + size wraps around zero
+
+	{
+		const long shapeOffset = 48 + 16 * numberOfModels;		// header and model table
+		const uint64_t dataOffset = 0xFFFFFFFFFFFFFFF0ULL;
+
+		BlendShapeLibrary library;
+		if (false == PatchFile(floatName, damagedName, shapeOffset + 16, &dataOffset, sizeof(uint64_t)))
+		{
+			printf("ERROR: failed to write a damaged library\n");
+			isOk = false;
+		}
+		else if (library.Open(damagedName))
+		{
+			printf("ERROR: wrapped shape block offset is not rejected\n");
+			isOk = false;
+		}
+	}
+
+	printf("  %s\n", (isOk) ? "passed" : "failed");
+
+	remove(xmlName);
+	remove(floatName);
+	remove(halfName);
+	remove(damagedName);
+
+	return (isOk) ? 0 : 1;
+}
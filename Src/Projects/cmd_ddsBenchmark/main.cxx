@@ -0,0 +1,300 @@
+
+// main.cxx
+//
+// DDS Loading Benchmark
+//
+// Compare ways to get block compressed levels of 4K textures ready for an upload
+//  - stdio reads of every level into fresh allocations, no flip
+//  - stdio read of a file, levels are flipped on one thread (the way readDDS did it before)
+//  - memory-mapped file, levels are flipped on one thread
+//  - memory-mapped file, mips / faces / layers are flipped in parallel
+//  - memory-mapped file, the file origin is kept and there is no flip at all
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "nvImage.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#define TEXTURE_SIZE		4096
+#define NUMBER_OF_REPEATS	5
+#define NUMBER_OF_MODES		5
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// test files
+
+struct TestFormat
+{
+	const char	*name;
+	char		fourCC[4];
+	int			blockSize;
+};
+
+const TestFormat gTestFormats[] = {
+	{ "DXT1", { 'D', 'X', 'T', '1' }, 8 },
+	{ "DXT5", { 'D', 'X', 'T', '5' }, 16 },
+	{ "BC4", { 'A', 'T', 'I', '1' }, 8 },
+	{ "BC5", { 'A', 'T', 'I', '2' }, 16 }
+};
+
+int GetNumberOfLevels(const int size)
+{
+	int levels = 1;
+	for (int s = size; s > 1; s >>= 1)
+		++levels;
+	return levels;
+}
+
+size_t GetLevelSize(const int size, const int level, const int blockSize)
+{
+	const int s = (std::max)(1, size >> level);
+	const size_t blocks = static_cast<size_t>((s + 3) / 4);
+	return blocks * blocks * blockSize;
+}
+
+// square texture with a full mip chain and random blocks
+bool WriteTestFile(const char *fname, const TestFormat &format, const int size)
+{
+	FILE *fp = fopen(fname, "wb");
+	if (nullptr == fp)
+		return false;
+
+	const int levels = GetNumberOfLevels(size);
+
+	// DDS_HEADER, 31 dwords
+	uint32_t header[31];
+	memset(header, 0, sizeof(header));
+	header[0] = 124;							// dwSize
+	header[1] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;	// caps, height, width, pixel format, mip count, linear size
+	header[2] = size;
+	header[3] = size;
+	header[4] = static_cast<uint32_t>(GetLevelSize(size, 0, format.blockSize));
+	header[6] = levels;
+	header[18] = 32;							// ddspf.dwSize
+	header[19] = 0x4;							// ddspf.dwFlags, fourCC
+	memcpy(&header[20], format.fourCC, 4);
+	header[26] = 0x1000 | 0x8 | 0x400000;		// dwCaps1, texture, complex, mipmap
+
+	fwrite("DDS ", 1, 4, fp);
+	fwrite(header, sizeof(header), 1, fp);
+
+	std::vector<unsigned char> data(GetLevelSize(size, 0, format.blockSize));
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<unsigned char>(rand() & 0xFF);
+
+	for (int level = 0; level < levels; ++level)
+		fwrite(data.data(), GetLevelSize(size, level, format.blockSize), 1, fp);
+
+	fclose(fp);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// loaders
+
+struct LoadResult
+{
+	double		seconds{ 0.0 };
+	size_t		bytes{ 0 };
+};
+
+// copy level data the way a driver does on a texture upload
+void Consume(std::vector<unsigned char> &staging, const void *data, const size_t size, size_t &bytes)
+{
+	if (staging.size() < size)
+		staging.resize(size);
+	memcpy(staging.data(), data, size);
+	bytes += size;
+}
+
+// read with stdio into allocations per level, the header is taken from an already loaded image
+bool LoadStdio(const char *fname, const nv::Image &info, std::vector<unsigned char> &staging, size_t &bytes)
+{
+	FILE *fp = fopen(fname, "rb");
+	if (nullptr == fp)
+		return false;
+
+	fseek(fp, 4 + 124, SEEK_SET);
+
+	for (int level = 0; level < info.getMipLevels(); ++level)
+	{
+		const size_t size = info.getImageSize(level);
+		unsigned char *data = new unsigned char[size];
+		const bool isOk = (1 == fread(data, size, 1, fp));
+
+		if (isOk)
+			Consume(staging, data, size, bytes);
+
+		delete[] data;
+
+		if (false == isOk)
+		{
+			fclose(fp);
+			return false;
+		}
+	}
+
+	fclose(fp);
+	return true;
+}
+
+bool LoadImage(const char *fname, const bool keepFileOrigin, std::vector<unsigned char> &staging, size_t &bytes)
+{
+	nv::Image image;
+	image.setKeepFileOrigin(keepFileOrigin);
+
+	if (false == image.loadImageFromFile(fname))
+		return false;
+
+	for (int level = 0; level < image.getMipLevels(); ++level)
+		Consume(staging, image.getLevel(level), image.getImageSize(level), bytes);
+
+	return true;
+}
+
+bool SameLevels(const nv::Image &a, const nv::Image &b)
+{
+	if (a.getMipLevels() != b.getMipLevels())
+		return false;
+
+	for (int level = 0; level < a.getMipLevels(); ++level)
+	{
+		if (0 != memcmp(a.getLevel(level), b.getLevel(level), a.getImageSize(level)))
+			return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	// dds files from a command line, or a generated set of 4K block compressed textures
+	std::vector<std::string>	files;
+	bool generated = false;
+
+	for (int i = 1; i < argc; ++i)
+		files.push_back(argv[i]);
+
+	if (files.empty())
+	{
+		srand(1234);
+
+		for (const TestFormat &format : gTestFormats)
+		{
+			const std::string fname = std::string("ddsBenchmark_") + format.name + ".dds";
+			if (false == WriteTestFile(fname.c_str(), format, TEXTURE_SIZE))
+			{
+				printf("ERROR: failed to write a test file %s\n", fname.c_str());
+				return 1;
+			}
+			files.push_back(fname);
+		}
+		generated = true;
+	}
+
+	printf("[DDS Loading Benchmark] %d files x %d repeats\n", static_cast<int>(files.size()), NUMBER_OF_REPEATS);
+
+	bool isOk = true;
+
+	// parallel flip of a mapped file has to give the same data as a flip on one thread of a file read with stdio
+	for (const std::string &fname : files)
+	{
+		nv::Image serial, parallel;
+
+		nv::Image::FileMapping(false);
+		nv::Image::FlipThreads(1);
+		const bool serialOk = serial.loadImageFromFile(fname.c_str());
+		nv::Image::FileMapping(true);
+		nv::Image::FlipThreads(0);
+		const bool parallelOk = parallel.loadImageFromFile(fname.c_str());
+
+		if (false == serialOk || false == parallelOk)
+		{
+			printf("ERROR: failed to load %s\n", fname.c_str());
+			isOk = false;
+		}
+		else if (false == parallel.isCompressed())
+		{
+			printf("  %s is not block compressed\n", fname.c_str());
+		}
+		else if (false == SameLevels(serial, parallel))
+		{
+			printf("ERROR: parallel flip differs from a serial flip in %s\n", fname.c_str());
+			isOk = false;
+		}
+	}
+
+	if (false == isOk)
+		return 1;
+
+	std::vector<unsigned char>	staging;
+	const char *names[NUMBER_OF_MODES] = { "stdio, no flip       ", "stdio, serial flip   ", "mapped, serial flip  ", "mapped, parallel flip", "mapped, file origin  " };
+	LoadResult results[NUMBER_OF_MODES];
+
+	for (int repeat = 0; repeat < NUMBER_OF_REPEATS; ++repeat)
+	{
+		for (const std::string &fname : files)
+		{
+			const char *f = fname.c_str();
+
+			nv::Image info;
+			info.setKeepFileOrigin(true);
+			if (false == info.loadImageFromFile(f) || info.getLayers() != 1 || info.isVolume())
+				continue;
+
+			for (int mode = 0; mode < NUMBER_OF_MODES; ++mode)
+			{
+				auto start = std::chrono::steady_clock::now();
+
+				switch (mode)
+				{
+				case 0:
+					isOk &= LoadStdio(f, info, staging, results[mode].bytes);
+					break;
+				case 1:
+					nv::Image::FileMapping(false);
+					nv::Image::FlipThreads(1);
+					isOk &= LoadImage(f, false, staging, results[mode].bytes);
+					nv::Image::FileMapping(true);
+					break;
+				case 2:
+					nv::Image::FlipThreads(1);
+					isOk &= LoadImage(f, false, staging, results[mode].bytes);
+					break;
+				case 3:
+					nv::Image::FlipThreads(0);
+					isOk &= LoadImage(f, false, staging, results[mode].bytes);
+					break;
+				case 4:
+					isOk &= LoadImage(f, true, staging, results[mode].bytes);
+					break;
+				}
+
+				results[mode].seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+		}
+	}
+
+	for (int mode = 0; mode < NUMBER_OF_MODES; ++mode)
+	{
+		const double megabytes = static_cast<double>(results[mode].bytes) / (1024.0 * 1024.0);
+		printf("  %s - %8.2f MB/s\n", names[mode], (results[mode].seconds > 0.0) ? megabytes / results[mode].seconds : 0.0);
+	}
+
+	if (generated)
+	{
+		for (const std::string &fname : files)
+			remove(fname.c_str());
+	}
+
+	return (isOk) ? 0 : 1;
+}
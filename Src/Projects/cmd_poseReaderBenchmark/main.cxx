@@ -0,0 +1,230 @@
+
+// main.cxx
+//
+// Pose Reader Benchmark
+//
+// Compare pose reader evaluation paths over many readers
+//  - general 4x4 inverse of a pose matrix every evaluation (the way box did it before)
+//  - rigid inverse every evaluation
+//  - rigid inverse cached per pose, only the live side changes (the way box does it now)
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "box_poseReader_math.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#define NUMBER_OF_READERS	10000
+#define NUMBER_OF_FRAMES	100
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// matrix helpers
+
+struct Matrix4
+{
+	double	m[16];
+};
+
+// column-major TRS matrix with Euler XYZ rotation in degrees and unit scaling
+void MakeMatrix(Matrix4 &result, const double *t, const double *r)
+{
+	const double deg = 3.14159265358979323846 / 180.0;
+	const double cx = cos(r[0] * deg), sx = sin(r[0] * deg);
+	const double cy = cos(r[1] * deg), sy = sin(r[1] * deg);
+	const double cz = cos(r[2] * deg), sz = sin(r[2] * deg);
+
+	// R = Rz * Ry * Rx
+	double *m = result.m;
+	m[0] = cy * cz;					m[4] = sx * sy * cz - cx * sz;	m[8] = cx * sy * cz + sx * sz;	m[12] = t[0];
+	m[1] = cy * sz;					m[5] = sx * sy * sz + cx * cz;	m[9] = cx * sy * sz - sx * cz;	m[13] = t[1];
+	m[2] = -sy;						m[6] = sx * cy;					m[10] = cx * cy;				m[14] = t[2];
+	m[3] = 0.0;						m[7] = 0.0;						m[11] = 0.0;					m[15] = 1.0;
+}
+
+// general inverse with cofactors
+bool InverseGeneral(Matrix4 &result, const Matrix4 &matrix)
+{
+	const double *m = matrix.m;
+	double inv[16];
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	double det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if (det == 0.0)
+		return false;
+
+	det = 1.0 / det;
+	for (int i = 0; i < 16; ++i)
+		result.m[i] = inv[i] * det;
+	return true;
+}
+
+void Mult(Matrix4 &result, const Matrix4 &a, const Matrix4 &b)
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		for (int r = 0; r < 4; ++r)
+		{
+			result.m[c * 4 + r] = a.m[r] * b.m[c * 4] + a.m[4 + r] * b.m[c * 4 + 1] + a.m[8 + r] * b.m[c * 4 + 2] + a.m[12 + r] * b.m[c * 4 + 3];
+		}
+	}
+}
+
+double RandomRange(const double minValue, const double maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / static_cast<double>(RAND_MAX));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	const int numberOfReaders = (argc > 1) ? atoi(argv[1]) : NUMBER_OF_READERS;
+	const int numberOfFrames = (argc > 2) ? atoi(argv[2]) : NUMBER_OF_FRAMES;
+
+	if (numberOfReaders <= 0 || numberOfFrames <= 0)
+	{
+		printf("usage: poseReader_benchmark [numberOfReaders] [numberOfFrames]\n");
+		return 1;
+	}
+
+	srand(1234);
+
+	std::vector<PoseReaderSettings>	settings(numberOfReaders);
+	std::vector<Matrix4>			poses(numberOfReaders);
+	std::vector<Matrix4>			lives(numberOfReaders * numberOfFrames);
+	std::vector<RigidMatrix>		invPoses(numberOfReaders);
+
+	for (int i = 0; i < numberOfReaders; ++i)
+	{
+		PoseReaderSettings &s = settings[i];
+		s.readAxis = i % 3;
+		s.interpMode = i % 3;
+		s.allowRotate = 0.0;
+		s.minAngle = 0.0;
+		s.maxAngle = RandomRange(30.0, 180.0);
+		s.allowTwist = (i % 2) ? 0.5 : 1.0;
+		s.maxTwist = 90.0;
+		s.allowTranslate = (i % 4) ? 1.0 : 0.0;
+		s.maxTranslate = 20.0;
+
+		const double t[3] = { RandomRange(-10.0, 10.0), RandomRange(-10.0, 10.0), RandomRange(-10.0, 10.0) };
+		const double r[3] = { RandomRange(-180.0, 180.0), RandomRange(-90.0, 90.0), RandomRange(-180.0, 180.0) };
+		MakeMatrix(poses[i], t, r);
+
+		RigidMatrix pose;
+		pose.FromMatrix(poses[i].m);
+		RigidInverse(invPoses[i], pose);
+		settings[i].Validate();
+
+		for (int f = 0; f < numberOfFrames; ++f)
+		{
+			const double lt[3] = { t[0] + RandomRange(-5.0, 5.0), t[1] + RandomRange(-5.0, 5.0), t[2] + RandomRange(-5.0, 5.0) };
+			const double lr[3] = { r[0] + RandomRange(-60.0, 60.0), r[1] + RandomRange(-60.0, 60.0), r[2] + RandomRange(-60.0, 60.0) };
+			MakeMatrix(lives[f * numberOfReaders + i], lt, lr);
+		}
+	}
+
+	std::vector<double>	weightsGeneral(numberOfReaders);
+	std::vector<double>	weightsRigid(numberOfReaders);
+	std::vector<double>	weightsCached(numberOfReaders);
+
+	double generalSeconds = 0.0;
+	double rigidSeconds = 0.0;
+	double cachedSeconds = 0.0;
+	double maxRigidError = 0.0;
+	double maxCachedError = 0.0;
+	double checksum = 0.0;
+
+	for (int f = 0; f < numberOfFrames; ++f)
+	{
+		const Matrix4 *frameLives = &lives[f * numberOfReaders];
+
+		// 1 - general inverse of a pose every evaluation
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < numberOfReaders; ++i)
+		{
+			Matrix4 invPose, relPose;
+			InverseGeneral(invPose, poses[i]);
+			Mult(relPose, invPose, frameLives[i]);
+
+			RigidMatrix rel;
+			rel.FromMatrix(relPose.m);
+			weightsGeneral[i] = PoseReaderWeight(rel, settings[i]);
+		}
+
+		generalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// 2 - rigid inverse every evaluation
+
+		start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < numberOfReaders; ++i)
+		{
+			RigidMatrix pose, live, invPose, rel;
+			pose.FromMatrix(poses[i].m);
+			live.FromMatrix(frameLives[i].m);
+
+			RigidInverse(invPose, pose);
+			RigidMult(rel, invPose, live);
+			weightsRigid[i] = PoseReaderWeight(rel, settings[i]);
+		}
+
+		rigidSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// 3 - cached pose inverses, only live transforms are updated
+
+		start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < numberOfReaders; ++i)
+		{
+			RigidMatrix live, rel;
+			live.FromMatrix(frameLives[i].m);
+
+			RigidMult(rel, invPoses[i], live);
+			weightsCached[i] = PoseReaderWeight(rel, settings[i]);
+		}
+
+		cachedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (int i = 0; i < numberOfReaders; ++i)
+		{
+			maxRigidError = std::max(maxRigidError, fabs(weightsRigid[i] - weightsGeneral[i]));
+			maxCachedError = std::max(maxCachedError, fabs(weightsCached[i] - weightsGeneral[i]));
+			checksum += weightsCached[i];
+		}
+	}
+
+	const double evaluations = static_cast<double>(numberOfReaders) * numberOfFrames;
+
+	printf("[Pose Reader Benchmark] %d readers x %d frames\n", numberOfReaders, numberOfFrames);
+	printf("  general inverse - %8.2f ns per reader\n", 1e9 * generalSeconds / evaluations);
+	printf("  rigid inverse   - %8.2f ns per reader, max weight error %g\n", 1e9 * rigidSeconds / evaluations, maxRigidError);
+	printf("  cached inverse  - %8.2f ns per reader, max weight error %g\n", 1e9 * cachedSeconds / evaluations, maxCachedError);
+	printf("  checksum %f\n", checksum);
+
+	return (maxRigidError < 1e-6 && maxCachedError < 1e-6) ? 0 : 1;
+}
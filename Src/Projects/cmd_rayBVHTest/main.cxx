@@ -0,0 +1,212 @@
+// main.cxx
+//
+// Ray BVH Test
+//
+// Compare RayBVH hits with a brute-force test of every triangle
+//  - random triangle soup
+//  - skewed mesh, triangles are spread with a geometric step and SAH splits are unbalanced,
+//     a tree depth has to stay below RAYBVH_SAH_MAX_DEPTH + 32 for a traversal stack
+//  - the same meshes after deformed positions are refitted
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "box_rayIntersect_bvh.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <string>
+
+#define NUMBER_OF_TRIANGLES		20000
+#define NUMBER_OF_RAYS			20000
+#define NUMBER_OF_SKEWED		1200	//!> float range limits a geometric step
+#define SKEWED_STEP_SCALE		1.05f
+#define HIT_EPSILON				0.00001f
+
+float RandomRange(const float minValue, const float maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+struct Mesh
+{
+	std::vector<float>	positions;
+	std::vector<int>	indices;
+};
+
+void MakeSoup(Mesh &mesh, const int triCount)
+{
+	mesh.positions.resize(9 * triCount);
+	mesh.indices.resize(3 * triCount);
+
+	for (int i = 0; i < triCount; ++i)
+	{
+		const float center[3] = { RandomRange(-50.0f, 50.0f), RandomRange(-50.0f, 50.0f), RandomRange(-50.0f, 50.0f) };
+		for (int j = 0; j < 3; ++j)
+		{
+			for (int k = 0; k < 3; ++k)
+				mesh.positions[9 * i + 3 * j + k] = center[k] + RandomRange(-2.0f, 2.0f);
+			mesh.indices[3 * i + j] = 3 * i + j;
+		}
+	}
+}
+
+void MakeSkewed(Mesh &mesh, const int triCount)
+{
+	mesh.positions.resize(9 * triCount);
+	mesh.indices.resize(3 * triCount);
+
+	// triangles facing x axis, every next one is further by a growing step
+	float x = 0.0f;
+	float step = 0.001f;
+
+	for (int i = 0; i < triCount; ++i)
+	{
+		const float size = RandomRange(0.5f, 1.0f);
+		const float tri[9] = { x, -size, -size, x, size, -size, x, -size, size };
+
+		for (int j = 0; j < 9; ++j)
+			mesh.positions[9 * i + j] = tri[j];
+		for (int j = 0; j < 3; ++j)
+			mesh.indices[3 * i + j] = 3 * i + j;
+
+		x += step;
+		step *= SKEWED_STEP_SCALE;
+	}
+}
+
+void Deform(Mesh &mesh)
+{
+	for (size_t i = 0; i < mesh.positions.size(); i += 3)
+	{
+		const float y = mesh.positions[i + 1];
+		mesh.positions[i] += 0.5f * sinf(0.1f * y);
+		mesh.positions[i + 2] *= 1.1f;
+	}
+}
+
+// rays from a box around a mesh to random points in its center area
+int CompareHits(const RayBVH &bvh, const char *name, const float *bmin, const float *bmax)
+{
+	int numberOfHits = 0;
+	int numberOfMismatches = 0;
+
+	double bvhMs = 0.0;
+	double bruteMs = 0.0;
+
+	for (int i = 0; i < NUMBER_OF_RAYS; ++i)
+	{
+		float R0[3], R1[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const float size = bmax[k] - bmin[k];
+			R0[k] = RandomRange(bmin[k] - size, bmax[k] + size);
+			R1[k] = RandomRange(bmin[k] + 0.25f * size, bmax[k] - 0.25f * size);
+		}
+
+		RayBVH::Hit hit, refHit;
+
+		auto start = std::chrono::steady_clock::now();
+		const bool isHit = bvh.Intersect(R0, R1, hit);
+		bvhMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		const bool isRefHit = bvh.IntersectBruteForce(R0, R1, refHit);
+		bruteMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// the same distance is enough when a ray goes through a shared edge
+		const bool match = (isHit == isRefHit) && (!isHit || hit.triangle == refHit.triangle || fabsf(hit.t - refHit.t) < HIT_EPSILON);
+
+		if (!match)
+		{
+			if (numberOfMismatches < 5)
+				printf("    mismatch ray %d - bvh %d (t %f), brute-force %d (t %f)\n", i, (isHit) ? hit.triangle : -1, (isHit) ? hit.t : 0.0f,
+					(isRefHit) ? refHit.triangle : -1, (isRefHit) ? refHit.t : 0.0f);
+			numberOfMismatches += 1;
+		}
+		if (isRefHit)
+			numberOfHits += 1;
+	}
+
+	printf("  %-16s - %d triangles, depth %d, %d hits of %d rays, bvh %.2f ms, brute-force %.2f ms, %d mismatches\n",
+		name, bvh.GetTriangleCount(), bvh.GetDepth(), numberOfHits, NUMBER_OF_RAYS, bvhMs, bruteMs, numberOfMismatches);
+
+	return numberOfMismatches;
+}
+
+int TestMesh(Mesh &mesh, const char *name)
+{
+	RayBVH bvh;
+	const int vertexCount = static_cast<int>(mesh.positions.size()) / 3;
+	const int triCount = static_cast<int>(mesh.indices.size()) / 3;
+
+	if (!bvh.Build(mesh.positions.data(), vertexCount, mesh.indices.data(), nullptr, triCount))
+	{
+		printf("  %s - failed to build a tree\n", name);
+		return 1;
+	}
+
+	float bmin[3] = { 1e30f, 1e30f, 1e30f };
+	float bmax[3] = { -1e30f, -1e30f, -1e30f };
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			bmin[k] = fminf(bmin[k], mesh.positions[3 * i + k]);
+			bmax[k] = fmaxf(bmax[k], mesh.positions[3 * i + k]);
+		}
+	}
+
+	int numberOfFailed = 0;
+	if (bvh.GetDepth() >= RAYBVH_SAH_MAX_DEPTH + 32)
+	{
+		printf("  %s - tree depth %d is out of the limit\n", name, bvh.GetDepth());
+		numberOfFailed += 1;
+	}
+
+	numberOfFailed += CompareHits(bvh, name, bmin, bmax);
+
+	Deform(mesh);
+	if (!bvh.UpdatePositions(mesh.positions.data(), vertexCount))
+	{
+		printf("  %s - failed to refit a tree\n", name);
+		return numberOfFailed + 1;
+	}
+
+	const std::string refitName = std::string(name) + " refit";
+	numberOfFailed += CompareHits(bvh, refitName.c_str(), bmin, bmax);
+
+	return numberOfFailed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	const int numberOfTriangles = (argc > 1) ? atoi(argv[1]) : NUMBER_OF_TRIANGLES;
+
+	if (numberOfTriangles <= 0)
+	{
+		printf("usage: rayBVH_test [numberOfTriangles]\n");
+		return 1;
+	}
+
+	srand(1234);
+
+	printf("[Ray BVH Test]\n");
+
+	int numberOfFailed = 0;
+	Mesh mesh;
+
+	MakeSoup(mesh, numberOfTriangles);
+	numberOfFailed += TestMesh(mesh, "soup");
+
+	MakeSkewed(mesh, NUMBER_OF_SKEWED);
+	numberOfFailed += TestMesh(mesh, "skewed");
+
+	printf("  %s\n", (numberOfFailed == 0) ? "passed" : "failed");
+	return (numberOfFailed == 0) ? 0 : 1;
+}
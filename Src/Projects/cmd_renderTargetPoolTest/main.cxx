@@ -0,0 +1,205 @@
+// main.cxx
+//
+// Render Target Pool Test
+//
+// Check lease, reuse and eviction accounting of RenderTargetPool in a real gl context
+//  - released objects are served again for the same size and format
+//  - different keys make new objects
+//  - objects over a memory budget are deleted, the oldest release first
+//  - Trim and Clear empty the buckets
+//  - other gl context gets its own pool
+//
+// a hidden window with a default pixel format is used for a context, put Mesa opengl32.dll next to an executable
+//  to run it headless with llvmpipe
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include <windows.h>
+#include "RenderTargetPool.h"
+
+#include <stdio.h>
+#include <vector>
+
+#define TEST_SIZE		64
+#define TEST_BYTES		(TEST_SIZE * TEST_SIZE * 4)
+
+int gNumberOfFailed = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { printf("  FAILED line %d: %s\n", __LINE__, #condition); gNumberOfFailed += 1; }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// gl context
+
+struct GLContext
+{
+	HWND	hWnd{ nullptr };
+	HDC		hDC{ nullptr };
+	HGLRC	hRC{ nullptr };
+
+	bool Create()
+	{
+		WNDCLASSA wc = { 0 };
+		wc.lpfnWndProc = DefWindowProcA;
+		wc.hInstance = GetModuleHandleA(nullptr);
+		wc.lpszClassName = "RenderTargetPoolTest";
+		RegisterClassA(&wc);
+
+		hWnd = CreateWindowA(wc.lpszClassName, "", WS_OVERLAPPEDWINDOW, 0, 0, 64, 64, nullptr, nullptr, wc.hInstance, nullptr);
+		if (nullptr == hWnd)
+			return false;
+
+		hDC = GetDC(hWnd);
+
+		PIXELFORMATDESCRIPTOR pfd = { 0 };
+		pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
+		pfd.nVersion = 1;
+		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+		pfd.iPixelType = PFD_TYPE_RGBA;
+		pfd.cColorBits = 32;
+		pfd.cDepthBits = 24;
+
+		const int format = ChoosePixelFormat(hDC, &pfd);
+		if (0 == format || !SetPixelFormat(hDC, format, &pfd))
+			return false;
+
+		hRC = wglCreateContext(hDC);
+		if (nullptr == hRC || !wglMakeCurrent(hDC, hRC))
+			return false;
+
+		return (GLEW_OK == glewInit());
+	}
+
+	~GLContext()
+	{
+		wglMakeCurrent(nullptr, nullptr);
+		if (hRC)
+			wglDeleteContext(hRC);
+		if (hDC)
+			ReleaseDC(hWnd, hDC);
+		if (hWnd)
+			DestroyWindow(hWnd);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// helpers
+
+GLuint LeaseColor(const int width, const int height)
+{
+	return RenderTargetPool::TheOne().LeaseTexture2D(width, height, GL_RGBA, GL_RGBA8, GL_UNSIGNED_BYTE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	GLContext context;
+	if (!context.Create())
+	{
+		printf("failed to create a gl context\n");
+		return 1;
+	}
+
+	RenderTargetPool& pool = RenderTargetPool::TheOne();
+	pool.SetBudget(3 * TEST_BYTES);
+	pool.ResetStats();
+
+	printf("[Render Target Pool Test] budget %d bytes\n", 3 * TEST_BYTES);
+
+	// 1 - lease and reuse
+
+	const GLuint color = LeaseColor(TEST_SIZE, TEST_SIZE);
+	const GLuint depth = pool.LeaseRenderbuffer(TEST_SIZE, TEST_SIZE, GL_DEPTH_COMPONENT24);
+
+	CHECK(color > 0 && glIsTexture(color));
+	CHECK(depth > 0);
+	CHECK(pool.GetStats().numberOfAllocations == 2);
+	CHECK(pool.GetStats().leasedBytes == 2 * TEST_BYTES);
+
+	// an object goes back only to its own kind
+	CHECK(false == pool.ReleaseRenderbuffer(color));
+	CHECK(pool.ReleaseTexture(color));
+	CHECK(pool.ReleaseRenderbuffer(depth));
+	CHECK(false == pool.ReleaseTexture(color));
+
+	CHECK(pool.GetNumberOfFreeObjects() == 2);
+	CHECK(pool.GetStats().freeBytes == 2 * TEST_BYTES);
+	CHECK(pool.GetStats().leasedBytes == 0);
+
+	const GLuint colorAgain = LeaseColor(TEST_SIZE, TEST_SIZE);
+	CHECK(colorAgain == color);
+	CHECK(pool.GetStats().numberOfReuses == 1);
+	CHECK(pool.GetStats().numberOfAllocations == 2);
+
+	// other size is a new object
+	const GLuint colorBig = LeaseColor(2 * TEST_SIZE, TEST_SIZE);
+	CHECK(colorBig != color);
+	CHECK(pool.GetStats().numberOfAllocations == 3);
+
+	pool.ReleaseTexture(colorAgain);
+	pool.ReleaseTexture(colorBig);
+
+	// 2 - eviction over a budget, the oldest release goes first
+
+	CHECK(pool.GetStats().freeBytes <= pool.GetBudget());
+	CHECK(pool.GetStats().numberOfEvictions == 1);
+	CHECK(false == glIsRenderbuffer(depth));
+
+	std::vector<GLuint> textures;
+	for (int i = 0; i < 4; ++i)
+		textures.push_back(LeaseColor(TEST_SIZE + i + 1, TEST_SIZE));
+	for (GLuint id : textures)
+		pool.ReleaseTexture(id);
+
+	CHECK(pool.GetStats().freeBytes <= pool.GetBudget());
+	CHECK(pool.GetNumberOfFreeObjects() <= 3);
+	CHECK(glIsTexture(textures.back()));
+	CHECK(false == glIsTexture(color));
+
+	// 3 - trim and clear
+
+	pool.Trim();
+	CHECK(pool.GetNumberOfFreeObjects() == 0);
+	CHECK(pool.GetStats().freeBytes == 0);
+	CHECK(false == glIsTexture(textures.back()));
+
+	const GLuint leased = LeaseColor(TEST_SIZE, TEST_SIZE);
+	const GLuint released = LeaseColor(TEST_SIZE, TEST_SIZE);
+	pool.ReleaseTexture(released);
+
+	pool.Clear();
+	CHECK(pool.GetNumberOfFreeObjects() == 0);
+	CHECK(pool.GetStats().leasedBytes == 0 && pool.GetStats().freeBytes == 0);
+	CHECK(false == glIsTexture(released));
+	// a leased object is forgotten, its owner deletes it
+	CHECK(false == pool.ReleaseTexture(leased));
+	glDeleteTextures(1, &leased);
+
+	// 4 - pool per gl context
+
+	pool.ReleaseTexture(LeaseColor(TEST_SIZE, TEST_SIZE));
+	{
+		GLContext otherContext;
+		CHECK(otherContext.Create());
+
+		RenderTargetPool& otherPool = RenderTargetPool::TheOne();
+		CHECK(&otherPool != &pool);
+		CHECK(otherPool.GetNumberOfFreeObjects() == 0);
+
+		RenderTargetPool::ForgetContext(otherContext.hRC);
+	}
+
+	wglMakeCurrent(context.hDC, context.hRC);
+	CHECK(&RenderTargetPool::TheOne() == &pool);
+	CHECK(pool.GetNumberOfFreeObjects() == 1);
+
+	const RenderTargetPool::Stats& stats = pool.GetStats();
+	printf("  leases %u, reuses %u, allocations %u, releases %u, evictions %u, peak %u bytes\n",
+		stats.numberOfLeases, stats.numberOfReuses, stats.numberOfAllocations, stats.numberOfReleases, stats.numberOfEvictions,
+		static_cast<unsigned int>(stats.peakBytes));
+	printf("  %s\n", (gNumberOfFailed == 0) ? "passed" : "failed");
+
+	return (gNumberOfFailed == 0) ? 0 : 1;
+}
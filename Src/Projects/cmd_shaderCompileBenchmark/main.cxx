@@ -0,0 +1,348 @@
+
+// main.cxx
+//
+// Shader Compile Benchmark
+//
+// Compare ways to get composite blend variants (25 blend modes, with and without a mask) ready
+//  - compile and link every variant synchronously on a first use (the way CompositeShaderManager did it before)
+//  - start every variant up front and poll GL_COMPLETION_STATUS_KHR (GL_KHR_parallel_shader_compile)
+//
+// on Windows a hidden window with a default pixel format is used for a context, put Mesa opengl32.dll next to an executable
+//  to run it headless with llvmpipe. Elsewhere it's an EGL pbuffer context on a surfaceless Mesa display,
+//  LIBGL_ALWAYS_SOFTWARE=1 picks llvmpipe when there is a gpu
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "glslShader.h"
+#include "glslProgramCache.h"
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#define NUMBER_OF_REPEATS	3
+
+bool gVerbose = false;
+
+void LOGI(const char* pFormatString, ...)
+{
+	if (!gVerbose)
+		return;
+
+	va_list args;
+	va_start(args, pFormatString);
+	vprintf(pFormatString, args);
+	va_end(args);
+}
+
+void LOGE(const char* pFormatString, ...)
+{
+	va_list args;
+	va_start(args, pFormatString);
+	vprintf(pFormatString, args);
+	va_end(args);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// gl context
+
+#ifdef _WIN32
+
+struct GLContext
+{
+	HWND	hWnd{ nullptr };
+	HDC		hDC{ nullptr };
+	HGLRC	hRC{ nullptr };
+
+	bool Create()
+	{
+		WNDCLASSA wc = { 0 };
+		wc.lpfnWndProc = DefWindowProcA;
+		wc.hInstance = GetModuleHandleA(nullptr);
+		wc.lpszClassName = "ShaderCompileBenchmark";
+		RegisterClassA(&wc);
+
+		hWnd = CreateWindowA(wc.lpszClassName, "", WS_OVERLAPPEDWINDOW, 0, 0, 64, 64, nullptr, nullptr, wc.hInstance, nullptr);
+		if (nullptr == hWnd)
+			return false;
+
+		hDC = GetDC(hWnd);
+
+		PIXELFORMATDESCRIPTOR pfd = { 0 };
+		pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
+		pfd.nVersion = 1;
+		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+		pfd.iPixelType = PFD_TYPE_RGBA;
+		pfd.cColorBits = 32;
+		pfd.cDepthBits = 24;
+
+		const int format = ChoosePixelFormat(hDC, &pfd);
+		if (0 == format || !SetPixelFormat(hDC, format, &pfd))
+			return false;
+
+		hRC = wglCreateContext(hDC);
+		if (nullptr == hRC || !wglMakeCurrent(hDC, hRC))
+			return false;
+
+		return (GLEW_OK == glewInit());
+	}
+
+	~GLContext()
+	{
+		wglMakeCurrent(nullptr, nullptr);
+		if (hRC)
+			wglDeleteContext(hRC);
+		if (hDC)
+			ReleaseDC(hWnd, hDC);
+		if (hWnd)
+			DestroyWindow(hWnd);
+	}
+};
+
+#else
+
+struct GLContext
+{
+	EGLDisplay	display{ EGL_NO_DISPLAY };
+	EGLSurface	surface{ EGL_NO_SURFACE };
+	EGLContext	context{ EGL_NO_CONTEXT };
+
+	bool Create()
+	{
+		// surfaceless platform needs no window system, a default display is a fallback
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		if (getPlatformDisplay)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+		if (EGL_NO_DISPLAY == display || !eglInitialize(display, nullptr, nullptr))
+		{
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			if (EGL_NO_DISPLAY == display || !eglInitialize(display, nullptr, nullptr))
+				return false;
+		}
+
+		const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		const EGLint surfaceAttribs[] = { EGL_WIDTH, 64, EGL_HEIGHT, 64, EGL_NONE };
+
+		EGLConfig config = nullptr;
+		EGLint numberOfConfigs = 0;
+		if (!eglChooseConfig(display, configAttribs, &config, 1, &numberOfConfigs) || 0 == numberOfConfigs)
+			return false;
+
+		surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+		if (EGL_NO_SURFACE == surface || !eglBindAPI(EGL_OPENGL_API))
+			return false;
+
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+		if (EGL_NO_CONTEXT == context || !eglMakeCurrent(display, surface, surface, context))
+			return false;
+
+		// glew has to be built with GLEW_EGL to take entry points from egl
+		return (GLEW_OK == glewInit());
+	}
+
+	~GLContext()
+	{
+		if (EGL_NO_DISPLAY == display)
+			return;
+
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (EGL_NO_CONTEXT != context)
+			eglDestroyContext(display, context);
+		if (EGL_NO_SURFACE != surface)
+			eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+};
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// variants
+
+const char* gBlendNames[] = {
+	"Normal", "Lighten", "Darken", "Multiply", "Average", "Add", "Substract", "Difference", "Negation",
+	"Exclusion", "Screen", "Overlay", "SoftLight", "HardLight", "ColorDodge", "ColorBurn", "LinearDodge",
+	"LinearBurn", "LinearLight", "VividLight", "PinLight", "HardMix", "Reflect", "Glow", "Phoenix"
+};
+
+// a run index makes every source unique, so a driver doesn't take a program from its own cache
+std::string MakeHeader(const int blendIndex, const bool useMask, const int runIndex)
+{
+	char buffer[256] = { 0 };
+	snprintf(buffer, 256, "#version 120\n#define BENCHMARK_RUN %d\n#define BlendOperation(base,blend) Blend%s(base,blend)\n%s",
+		runIndex, gBlendNames[blendIndex], (useMask) ? "#define USE_MASK\n" : "");
+	return buffer;
+}
+
+struct BenchResult
+{
+	double	totalMs{ 0.0 };		//!< from a first request to all variants are linked
+	double	submitMs{ 0.0 };	//!< time spent in calls which start variants
+	double	maxStallMs{ 0.0 };	//!< the longest single call, a frame hitch
+	int		numberOfFailed{ 0 };
+};
+
+BenchResult BenchSync(const std::string& vertexFile, const std::string& fragmentFile, const int runIndex)
+{
+	BenchResult result;
+	const int numberOfVariants = 2 * static_cast<int>(sizeof(gBlendNames) / sizeof(gBlendNames[0]));
+
+	std::vector<std::unique_ptr<GLSLShader>> shaders(numberOfVariants);
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numberOfVariants; ++i)
+	{
+		const auto callStart = std::chrono::steady_clock::now();
+
+		shaders[i].reset(new GLSLShader());
+		shaders[i]->SetHeaderText(MakeHeader(i / 2, (i % 2) != 0, runIndex).c_str());
+		if (!shaders[i]->LoadShaders(vertexFile.c_str(), fragmentFile.c_str()))
+			result.numberOfFailed += 1;
+
+		const double callMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - callStart).count();
+		result.maxStallMs = (std::max)(result.maxStallMs, callMs);
+	}
+
+	result.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.submitMs = result.totalMs;
+	return result;
+}
+
+BenchResult BenchParallel(const std::string& vertexFile, const std::string& fragmentFile, const int runIndex)
+{
+	BenchResult result;
+	const int numberOfVariants = 2 * static_cast<int>(sizeof(gBlendNames) / sizeof(gBlendNames[0]));
+
+	std::vector<std::unique_ptr<GLSLShader>> shaders(numberOfVariants);
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numberOfVariants; ++i)
+	{
+		const auto callStart = std::chrono::steady_clock::now();
+
+		shaders[i].reset(new GLSLShader());
+		shaders[i]->SetHeaderText(MakeHeader(i / 2, (i % 2) != 0, runIndex).c_str());
+		if (!shaders[i]->BeginLoadShaders(vertexFile.c_str(), fragmentFile.c_str()))
+			result.numberOfFailed += 1;
+
+		const double callMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - callStart).count();
+		result.submitMs += callMs;
+		result.maxStallMs = (std::max)(result.maxStallMs, callMs);
+	}
+
+	// a render loop polls variants every frame and finishes only completed ones
+	int numberOfPending = numberOfVariants;
+	while (numberOfPending > 0)
+	{
+		numberOfPending = 0;
+		for (int i = 0; i < numberOfVariants; ++i)
+		{
+			if (!shaders[i]->IsLinkPending())
+				continue;
+
+			if (!shaders[i]->IsLinkCompleted())
+			{
+				numberOfPending += 1;
+				continue;
+			}
+
+			const auto callStart = std::chrono::steady_clock::now();
+
+			if (!shaders[i]->FinishLink(fragmentFile.c_str()))
+				result.numberOfFailed += 1;
+
+			const double callMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - callStart).count();
+			result.maxStallMs = (std::max)(result.maxStallMs, callMs);
+		}
+
+		if (numberOfPending > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	result.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: shaderCompile_benchmark <GLSL folder with simple.vsh and compositeBlend.fsh> [numberOfRepeats] [-v]\n");
+		return 1;
+	}
+
+	const std::string folder(argv[1]);
+	const int numberOfRepeats = (argc > 2 && atoi(argv[2]) > 0) ? atoi(argv[2]) : NUMBER_OF_REPEATS;
+	gVerbose = (argc > 3 && 0 == strcmp(argv[3], "-v"));
+
+	const std::string vertexFile = folder + "/simple.vsh";
+	const std::string fragmentFile = folder + "/compositeBlend.fsh";
+
+	// measure a compiler, not a cache
+#ifdef _WIN32
+	_putenv_s("MESA_SHADER_CACHE_DISABLE", "true");
+#else
+	setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+#endif
+	GLSLProgramCache::ENABLED = false;
+
+	GLContext context;
+	if (!context.Create())
+	{
+		printf("ERROR: failed to create a gl context\n");
+		return 1;
+	}
+
+	const bool isParallel = GLSLShader::IsParallelCompileSupported();
+
+	printf("[Shader Compile Benchmark] %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	printf("  parallel shader compile is %s\n", (isParallel) ? "supported" : "not supported, BeginLoadShaders links synchronously");
+
+	BenchResult syncBest, parallelBest;
+	syncBest.totalMs = parallelBest.totalMs = 1e30;
+	int numberOfFailed = 0;
+
+	for (int r = 0; r < numberOfRepeats; ++r)
+	{
+		const BenchResult syncResult = BenchSync(vertexFile, fragmentFile, 2 * r);
+		const BenchResult parallelResult = BenchParallel(vertexFile, fragmentFile, 2 * r + 1);
+
+		numberOfFailed += syncResult.numberOfFailed + parallelResult.numberOfFailed;
+
+		if (syncResult.totalMs < syncBest.totalMs)
+			syncBest = syncResult;
+		if (parallelResult.totalMs < parallelBest.totalMs)
+			parallelBest = parallelResult;
+	}
+
+	const int numberOfVariants = 2 * static_cast<int>(sizeof(gBlendNames) / sizeof(gBlendNames[0]));
+
+	printf("  %d variants, best of %d runs\n", numberOfVariants, numberOfRepeats);
+	printf("  synchronous - total %8.2f ms, longest call %8.2f ms\n", syncBest.totalMs, syncBest.maxStallMs);
+	printf("  parallel    - total %8.2f ms, submit %8.2f ms, longest call %8.2f ms\n", parallelBest.totalMs, parallelBest.submitMs, parallelBest.maxStallMs);
+
+	if (numberOfFailed > 0)
+	{
+		printf("ERROR: %d variants failed to compile\n", numberOfFailed);
+		return 1;
+	}
+	return 0;
+}
@@ -28,4 +28,9 @@ void XmlEndExport(const char *filename = "D:\\shadersGraph.xml");
 // baking
 
 //bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, TiXmlElement *pFirstElem);
-bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set<FbxObject*> &fbxShaders, std::vector<FbxObject*> &fbxShadersLibrary);
\ No newline at end of file
+bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set<FbxObject*> &fbxShaders, std::vector<FbxObject*> &fbxShadersLibrary);
+
+//
+// benchmark
+
+bool XmlBenchmark(const char *fname, const int repeats);
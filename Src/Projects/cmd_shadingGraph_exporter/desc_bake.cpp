@@ -3,10 +3,12 @@
 // Sergei <Neill3d> Solokhin 2018
 
 #include "desc.h"
-#include "tinyxml.h"
+#include "xmlPullParser.h"
 
 #include <vector>
 #include <set>
+#include <string>
+#include <unordered_map>
 
 ///////////////////////////////////////////////////// 
 
@@ -15,6 +17,76 @@
 /////////////////////////////////////////////////////
 
 
+struct ParsingProperty
+{
+	std::string		name;
+	std::string		value;
+	double			x, y, z, w;
+
+	int							connCount;
+	std::vector<std::string>	sources;	//!< long names of connected models
+
+	//! a constructor
+	ParsingProperty()
+	{
+		x = y = z = w = 0.0;
+		connCount = 0;
+	}
+
+	void Prep(XmlPullParser &parser)
+	{
+		const int depth = parser.GetDepth();
+
+		for (int i = 0; i < parser.GetNumberOfAttributes(); ++i)
+		{
+			const XmlAttributeView &attrib = parser.GetAttribute(i);
+
+			if (attrib.name.Equals("Name"))
+			{
+				name = attrib.value.ToString();
+			}
+			else if (attrib.name.Equals("Value"))
+			{
+				value = attrib.value.ToString();
+			}
+			else if (attrib.name.Equals("X"))
+			{
+				value = attrib.value.ToString();
+				x = attrib.value.ToDouble();
+			}
+			else if (attrib.name.Equals("Y"))
+			{
+				value = attrib.value.ToString();
+				y = attrib.value.ToDouble();
+			}
+			else if (attrib.name.Equals("Z"))
+			{
+				value = attrib.value.ToString();
+				z = attrib.value.ToDouble();
+			}
+			else if (attrib.name.Equals("W"))
+			{
+				value = attrib.value.ToString();
+				w = attrib.value.ToDouble();
+			}
+		}
+
+		if (parser.NextChildElement(depth, "Connections"))
+		{
+			const XmlAttributeView *pCount = parser.FindAttribute("Count");
+			if (nullptr != pCount)
+				connCount = pCount->value.ToInt();
+
+			while (parser.NextChildElement(depth + 1, "Source"))
+			{
+				const XmlAttributeView *pLongName = parser.FindAttribute("LongName");
+				if (nullptr != pLongName)
+					sources.push_back(pLongName->value.ToString());
+			}
+		}
+	}
+};
+
 struct ParsingShader
 {
 	std::string		classname;
@@ -22,13 +94,11 @@ struct ParsingShader
 	std::string		longname;
 	std::string		type;
 
-	TiXmlElement	*pElem;
-
 	int propCount;
-	TiXmlElement	*pFirstProp;
+	std::vector<ParsingProperty>	props;
 
 	int attCount;
-	TiXmlElement	*pFirstAttachment;
+	std::vector<std::string>		attachments;	//!< long names of models
 
 	bool			isValid;
 
@@ -36,18 +106,10 @@ struct ParsingShader
 	ParsingShader()
 	{
 		isValid = false;
-		pElem = nullptr;
+		propCount = 0;
 		attCount = 0;
-		pFirstAttachment = nullptr;
 	}
 
-	//! an alternative constructor
-	ParsingShader(TiXmlElement *_pElem)
-	{
-		Prep(_pElem);
-	}
-
-
 	const char *GetLongName() const
 	{
 		return longname.c_str();
@@ -62,45 +124,24 @@ struct ParsingShader
 		return isValid;
 	}
 
-	TiXmlElement *GetFirstPropertyElem()
-	{
-		return pFirstProp;
-	}
-	TiXmlElement *GetFirstAttachmentElem()
-	{
-		return pFirstAttachment;
-	}
-
-	bool Prep(TiXmlElement *_pElem)
+	// parser is on a shader start element, the whole shader element is read
+	bool Prep(XmlPullParser &parser)
 	{
 		isValid = false;
-		pElem = _pElem;
-		int founded = 0;
+		const int depth = parser.GetDepth();
 
-		for (TiXmlAttribute *pAttrib = pElem->FirstAttribute();
-			nullptr != pAttrib;
-			pAttrib = pAttrib->Next())
+		for (int i = 0; i < parser.GetNumberOfAttributes(); ++i)
 		{
-			if (0 == strcmp("ClassName", pAttrib->Name()))
-			{
-				classname = pAttrib->ValueStr();
-				founded += 1;
-			}
-			else if (0 == strcmp("Name", pAttrib->Name()))
-			{
-				name = pAttrib->ValueStr();
-				founded += 1;
-			}
-			else if (0 == strcmp("LongName", pAttrib->Name()))
-			{
-				longname = pAttrib->ValueStr();
-				founded += 1;
-			}
-			else if (0 == strcmp("Type", pAttrib->Name()))
-			{
-				type = pAttrib->ValueStr();
-				founded += 1;
-			}
+			const XmlAttributeView &attrib = parser.GetAttribute(i);
+
+			if (attrib.name.Equals("ClassName"))
+				classname = attrib.value.ToString();
+			else if (attrib.name.Equals("Name"))
+				name = attrib.value.ToString();
+			else if (attrib.name.Equals("LongName"))
+				longname = attrib.value.ToString();
+			else if (attrib.name.Equals("Type"))
+				type = attrib.value.ToString();
 		}
 
 		if (0 == classname.size() || 0 == longname.size())
@@ -108,56 +149,53 @@ struct ParsingShader
 			return false;
 		}
 
-		// look for properties
-		founded = 0;
+		bool hasPropCount = false;
+		bool hasAttCount = false;
 		propCount = 0;
+		attCount = 0;
 
-		TiXmlElement *pPropElem = pElem->FirstChildElement("Properties");
-		if (nullptr != pPropElem)
+		while (parser.NextChildElement(depth))
 		{
-			for (TiXmlAttribute *pAttrib = pPropElem->FirstAttribute();
-				nullptr != pAttrib;
-				pAttrib = pAttrib->Next())
+			if (parser.GetName().Equals("Properties"))
 			{
-				if (0 == strcmp("Count", pAttrib->Name()))
+				const XmlAttributeView *pCount = parser.FindAttribute("Count");
+				if (nullptr != pCount)
+				{
+					propCount = pCount->value.ToInt();
+					hasPropCount = true;
+				}
+
+				props.reserve(propCount);
+				while (parser.NextChildElement(depth + 1, "Property"))
 				{
-					propCount = pAttrib->IntValue();
-					founded += 1;
+					props.emplace_back();
+					props.back().Prep(parser);
 				}
 			}
+			else if (parser.GetName().Equals("Attachments"))
+			{
+				const XmlAttributeView *pCount = parser.FindAttribute("Count");
+				if (nullptr != pCount)
+				{
+					attCount = pCount->value.ToInt();
+					hasAttCount = true;
+				}
 
-			pFirstProp = pPropElem->FirstChildElement("Property");
+				while (parser.NextChildElement(depth + 1, "Dst"))
+				{
+					const XmlAttributeView *pLongName = parser.FindAttribute("LongName");
+					attachments.push_back((nullptr != pLongName) ? pLongName->value.ToString() : std::string());
+				}
+			}
 		}
 
-		if (nullptr == pFirstProp || 0 == founded)
+		if (props.empty() || false == hasPropCount)
 		{
 			printf("> skipping one xml shader property\n");
 			return false;
 		}
 
-		// look for attachments
-
-		founded = 0;
-		attCount = 0;
-
-		pPropElem = pElem->FirstChildElement("Attachments");
-		if (nullptr != pPropElem)
-		{
-			for (TiXmlAttribute *pAttrib = pPropElem->FirstAttribute();
-				nullptr != pAttrib;
-				pAttrib = pAttrib->Next())
-			{
-				if (0 == strcmp("Count", pAttrib->Name()))
-				{
-					attCount = pAttrib->IntValue();
-					founded += 1;
-				}
-			}
-
-			pFirstAttachment = pPropElem->FirstChildElement("Dst");
-		}
-
-		if (nullptr == pFirstAttachment || 0 == founded)
+		if (attachments.empty() || false == hasAttCount)
 		{
 			printf("> skipping one xml shader attachment\n");
 			return false;
@@ -181,8 +219,62 @@ void FreeParsingShadersVector(std::vector<ParsingShader*> &shaders)
 	}
 }
 
+/////////////////////////////////////////////////////
+// fbx shaders index
+
+// (long name, subtype) key, subtype could not contain a zero char, so it's a safe separator
+std::string MakeShaderKey(const char *longname, const char *subtype)
+{
+	std::string key(longname);
+	key.push_back('\0');
+	key.append(subtype);
+	return key;
+}
+
+// returns nullptr when an object has no MoBu subtype
+const char *GetShaderSubType(FbxObject *pObject, FbxString &subTypeStr)
+{
+	FbxProperty subTypeProp = pObject->FindProperty("MoBuSubTypeName");
+	if (false == subTypeProp.IsValid())
+		return nullptr;
+
+	subTypeStr = subTypeProp.Get<FbxString>();
+	return subTypeStr.Buffer();
+}
+
+typedef std::unordered_map<std::string, FbxObject*>	ShadersIndex;
+
+// one pass over scene shaders, a first shader wins for a duplicated key
+void BuildShadersIndex(const std::set<FbxObject*> &fbxShaders, ShadersIndex &index)
+{
+	index.clear();
+	index.reserve(fbxShaders.size());
+
+	FbxString subTypeStr;
+	for (FbxObject *pObject : fbxShaders)
+	{
+		const char *subtype = GetShaderSubType(pObject, subTypeStr);
+		if (nullptr != subtype)
+			index.emplace(MakeShaderKey(pObject->GetName(), subtype), pObject);
+	}
+}
+
+// subtype -> shader library object to clone
+void BuildLibraryIndex(const std::vector<FbxObject*> &fbxShadersLibrary, std::unordered_map<std::string, FbxObject*> &index)
+{
+	index.clear();
+
+	FbxString subTypeStr;
+	for (FbxObject *pShaderBase : fbxShadersLibrary)
+	{
+		const char *subtype = GetShaderSubType(pShaderBase, subTypeStr);
+		if (nullptr != subtype && pShaderBase->IsRuntimePlug())
+			index.emplace(subtype, pShaderBase);
+	}
+}
+
 // return true if fbx shaders differ from xml shaders
-bool CheckForShadersGraphChanges(FbxScene *pScene, std::vector<ParsingShader*> &shaders, std::set<FbxObject*> &fbxShaders)
+bool CheckForShadersGraphChanges(FbxScene *pScene, std::vector<ParsingShader*> &shaders, std::set<FbxObject*> &fbxShaders, const ShadersIndex &fbxIndex)
 {
 	// check for number of shaders, longname and classname, number of connections, connection longname
 
@@ -194,42 +286,23 @@ bool CheckForShadersGraphChanges(FbxScene *pScene, std::vector<ParsingShader*> &
 
 	for (auto xmlshaderIter = begin(shaders); xmlshaderIter != end(shaders); ++xmlshaderIter)
 	{
-		bool founded = false;
-
-		for (auto fbxshaderIter = begin(fbxShaders); fbxshaderIter != end(fbxShaders); ++fbxshaderIter)
-		{
-			const char *fbxshaderName = (*fbxshaderIter)->GetName();
-			FbxProperty subTypeProp = (*fbxshaderIter)->FindProperty("MoBuSubTypeName");
-			if (false == subTypeProp.IsValid())
-				break;
-			FbxString subTypeStr(subTypeProp.Get<FbxString>());
-
-			// DONE: check type (classname)
-			if (0 == strcmp(fbxshaderName, (*xmlshaderIter)->GetLongName())
-				&& 0 == strcmp(subTypeStr.Buffer(), (*xmlshaderIter)->classname.c_str()))
-			{
-				founded = true;
+		// DONE: check type (classname)
+		auto fbxshaderIter = fbxIndex.find(MakeShaderKey((*xmlshaderIter)->GetLongName(), (*xmlshaderIter)->classname.c_str()));
 
-				// check number of connections
-				const int fbxDstCount = (*fbxshaderIter)->GetDstObjectCount() - 1; // -1 I'm removing FbxScene connection
-				const int xmlDstCount = (*xmlshaderIter)->GetDstObjectCount();
+		if (fbxshaderIter == end(fbxIndex))
+			return true;
 
-				// TODO: check each dst longname and type !!
-				if (fbxDstCount != xmlDstCount)
-				{
-					return true;
-				}
+		// check number of connections
+		const int fbxDstCount = fbxshaderIter->second->GetDstObjectCount() - 1; // -1 I'm removing FbxScene connection
+		const int xmlDstCount = (*xmlshaderIter)->GetDstObjectCount();
 
-				break;
-			}
-		}
-
-		if (false == founded)
+		// TODO: check each dst longname and type !!
+		if (fbxDstCount != xmlDstCount)
+		{
 			return true;
+		}
 	}
 
-	
-
 	return false;
 }
 
@@ -245,20 +318,8 @@ bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, ParsingShader *pXmlS
 	{
 		// TODO:
 
-		for (TiXmlElement *pElem = pXmlShader->GetFirstAttachmentElem();
-			nullptr != pElem;
-			pElem = pElem->NextSiblingElement("Dst"))
+		for (const std::string &modelname : pXmlShader->attachments)
 		{
-			std::string modelname;
-
-			for (TiXmlAttribute *pAttrib = pElem->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
-			{
-				if (0 == strcmp("LongName", pAttrib->Name()))
-				{
-					modelname = pAttrib->ValueStr();
-				}
-			}
-
 			if (modelname.size() > 0)
 			{
 				FbxNode *pnode = pScene->FindNodeByName(FbxString(modelname.c_str()));
@@ -271,45 +332,14 @@ bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, ParsingShader *pXmlS
 
 	// props
 
-	for (TiXmlElement *pElem = pXmlShader->GetFirstPropertyElem(); 
-			nullptr != pElem; 
-			pElem = pElem->NextSiblingElement("Property"))
+	for (const ParsingProperty &xmlProp : pXmlShader->props)
 	{
-		std::string name, value;
-		double x, y, z, w;
-		x = y = z = w = 0.0;
-
-		for (TiXmlAttribute *pAttrib = pElem->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
-		{
-			if (0 == strcmp("Name", pAttrib->Name()))
-			{
-				name = pAttrib->ValueStr();
-			}
-			else if (0 == strcmp("Value", pAttrib->Name()))
-			{
-				value = pAttrib->ValueStr();
-			}
-			else if (0 == strcmp("X", pAttrib->Name()))
-			{
-				value = pAttrib->ValueStr();
-				sscanf_s( value.c_str(), "%lf", &x );
-			}
-			else if (0 == strcmp("Y", pAttrib->Name()))
-			{
-				value = pAttrib->ValueStr();
-				sscanf_s(value.c_str(), "%lf", &y);
-			}
-			else if (0 == strcmp("Z", pAttrib->Name()))
-			{
-				value = pAttrib->ValueStr();
-				sscanf_s(value.c_str(), "%lf", &z);
-			}
-			else if (0 == strcmp("W", pAttrib->Name()))
-			{
-				value = pAttrib->ValueStr();
-				sscanf_s(value.c_str(), "%lf", &w);
-			}
-		}
+		const std::string &name = xmlProp.name;
+		const std::string &value = xmlProp.value;
+		const double x = xmlProp.x;
+		const double y = xmlProp.y;
+		const double z = xmlProp.z;
+		const double w = xmlProp.w;
 
 		if (0 == name.size() || 0 == value.size())
 		{
@@ -407,36 +437,15 @@ bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, ParsingShader *pXmlS
 			// TODO: check connections
 
 			int numberOfFbxConnections = prop.GetSrcObjectCount();
-			int numberOfXmlConnections = 0;
+			const int numberOfXmlConnections = xmlProp.connCount;
 
-			TiXmlElement *pAllConn = pElem->FirstChildElement("Connections");
-			if (nullptr != pAllConn)
-			{
-				for (TiXmlAttribute *pAttrib = pAllConn->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
-				{
-					if (0 == strcmp("Count", pAttrib->Name()))
-						numberOfXmlConnections = pAttrib->IntValue();
-				}
-			}
-			
 			prop.DisconnectAllSrcObject();
 			
 			if (numberOfXmlConnections > 0)
 			{
 				// assign connection from xml
-				TiXmlElement *pConnElem = pAllConn->FirstChildElement("Source");
-
-				for (; nullptr != pConnElem; pConnElem = pConnElem->NextSiblingElement("Source"))
+				for (const std::string &longname : xmlProp.sources)
 				{
-					
-					std::string longname;
-
-					for (TiXmlAttribute *pAttrib = pConnElem->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
-					{
-						if (0 == strcmp("LongName", pAttrib->Name()))
-							longname = pAttrib->ValueStr();
-					}
-					
 					if (longname.size() > 0)
 					{
 						FbxNode *pNode = pScene->FindNodeByName(longname.c_str());
@@ -446,7 +455,6 @@ bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, ParsingShader *pXmlS
 							prop.ConnectSrcObject(pNode);
 						}
 					}
-					
 				}
 
 				anyConnChanges = true;
@@ -477,74 +485,56 @@ bool ReadXmlShader(FbxScene *pScene, FbxObject *pFbxShader, ParsingShader *pXmlS
 	return true;
 }
 
-FbxObject *CloneShaderFromLibrary(FbxManager *pManager, FbxScene *pScene, const char *type, std::vector<FbxObject*> &fbxShadersLibrary)
+FbxObject *CloneShaderFromLibrary(FbxManager *pManager, FbxScene *pScene, const char *type, const std::unordered_map<std::string, FbxObject*> &libraryIndex)
 {
-	for (auto iter = begin(fbxShadersLibrary); iter != end(fbxShadersLibrary); ++iter)
-	{
-		FbxObject *pShaderBase = *iter;
+	auto iter = libraryIndex.find(type);
+	if (iter == end(libraryIndex))
+		return nullptr;
 
-		FbxProperty subTypeProp = pShaderBase->FindProperty("MoBuSubTypeName");
-		if (false == subTypeProp.IsValid())
-			break;
-		FbxString subTypeStr(subTypeProp.Get<FbxString>());
+	FbxObject *pShaderBase = iter->second;
+	FbxClassId classid = pShaderBase->GetRuntimeClassId();
 
-		if (pShaderBase->IsRuntimePlug()
-			&& 0 == strcmp(type, subTypeStr.Buffer()) )
-		{
-			FbxClassId classid = pShaderBase->GetRuntimeClassId();
+	// adding two new clones
+	FbxObject *newObj = classid.Create(*pManager, "New Shader\0", pShaderBase);
+	newObj->SetName("New Shader\0");
+	pScene->ConnectSrcObject(newObj);
 
-			// adding two new clones
-			FbxObject *newObj = classid.Create(*pManager, "New Shader\0", pShaderBase);
-			newObj->SetName("New Shader\0");
-			pScene->ConnectSrcObject(newObj);
-
-			return newObj;
-		}
-	}
-
-	return nullptr;
+	return newObj;
 }
 
 bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set<FbxObject*> &fbxShaders, std::vector<FbxObject*> &fbxShadersLibrary)
 {
 	bool lStatus = true;
-	TiXmlDocument	*pDoc = nullptr;
+	XmlPullParser	parser;
 	std::vector<ParsingShader*>		xmlShaders;
 
 	try
 	{
-		pDoc = new TiXmlDocument();
-		if (nullptr == pDoc)
-			throw std::exception("failed to allocate memory");
-
-		if (false == pDoc->LoadFile(fname))
+		// stream a file, shader description is read into parsing structs without a document tree
+		if (false == parser.Open(fname))
 			throw std::exception("failed to load a xml file");
 
-		TiXmlElement *pElem = pDoc->FirstChildElement("ShadersGraph");
-
-		if (nullptr == pElem)
+		if (false == parser.NextChildElement(0) || false == parser.GetName().Equals("ShadersGraph"))
 			throw std::exception(FAILED_STRUCT_TEXT);
 
-		pElem = pElem->FirstChildElement("Shaders");
-		if (nullptr == pElem)
+		if (false == parser.NextChildElement(1, "Shaders"))
 			throw std::exception(FAILED_STRUCT_TEXT);
 
 		int numberOfShaders = 0;
 
-		for (TiXmlAttribute *pAttrib = pElem->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
+		const XmlAttributeView *pCount = parser.FindAttribute("Count");
+		if (nullptr != pCount)
 		{
-			if (0 == strcmp("Count", pAttrib->Name()))
-			{
-				numberOfShaders = pAttrib->IntValue();
-			}
+			numberOfShaders = pCount->value.ToInt();
 		}
 		
-		pElem = pElem->FirstChildElement("Shader");
-		for (; nullptr != pElem; pElem = pElem->NextSiblingElement("Shader"))
+		xmlShaders.reserve(numberOfShaders);
+
+		while (parser.NextChildElement(2, "Shader"))
 		{
-			ParsingShader	*newParsing = new ParsingShader(pElem);
+			ParsingShader	*newParsing = new ParsingShader();
 
-			if (false == newParsing->IsValid())
+			if (false == newParsing->Prep(parser))
 			{
 				delete newParsing;
 				newParsing = nullptr;
@@ -554,8 +544,18 @@ bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set
 			xmlShaders.push_back(newParsing);
 		}
 
+		if (XmlPullParser::eXmlEventError == parser.GetEvent())
+		{
+			printf("> %s at line %d\n", parser.GetErrorText(), parser.GetErrorLine());
+			throw std::exception("failed to parse a xml file");
+		}
+
+		// index fbx shaders once, instead of a scan for every xml shader
+		ShadersIndex	fbxIndex;
+		BuildShadersIndex(fbxShaders, fbxIndex);
+
 		// check if there are any changes in the scene
-		bool anyChanges = CheckForShadersGraphChanges(pScene, xmlShaders, fbxShaders);
+		bool anyChanges = CheckForShadersGraphChanges(pScene, xmlShaders, fbxShaders, fbxIndex);
 
 		if (true == anyChanges)
 		{
@@ -565,13 +565,17 @@ bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set
 			{
 				(*iter)->Destroy();
 			}
+			fbxIndex.clear();
+
+			std::unordered_map<std::string, FbxObject*>	libraryIndex;
+			BuildLibraryIndex(fbxShadersLibrary, libraryIndex);
 
 			for (auto parseIter = begin(xmlShaders); parseIter != end(xmlShaders); ++parseIter)
 			{
 				FbxObject *pNewShader = nullptr;
 
 				// Clone a library shader with a specified type
-				pNewShader = CloneShaderFromLibrary(pManager, pScene, (*parseIter)->classname.c_str(), fbxShadersLibrary);
+				pNewShader = CloneShaderFromLibrary(pManager, pScene, (*parseIter)->classname.c_str(), libraryIndex);
 
 				if (nullptr != pNewShader)
 				{
@@ -587,21 +591,12 @@ bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set
 			for (auto parseIter = begin(xmlShaders); parseIter != end(xmlShaders); ++parseIter)
 			{
 				// DONE: try to find that shader in the fbx scene
-				for (auto iter = begin(fbxShaders); iter != end(fbxShaders); ++iter)
-				{
-					FbxObject *pObject = *iter;
+				auto iter = fbxIndex.find(MakeShaderKey((*parseIter)->GetLongName(), (*parseIter)->classname.c_str()));
 
-					FbxProperty subTypeProp = pObject->FindProperty("MoBuSubTypeName");
-					if (false == subTypeProp.IsValid())
-						break;
-					FbxString subTypeStr(subTypeProp.Get<FbxString>());
-
-					if (0 == strcmp(pObject->GetName(), (*parseIter)->GetLongName()))
-						// && 0 == strcmp(subTypeStr.Buffer(), type.c_str()) )
-					{
-						// find a shader, let's find an xml value
-						ReadXmlShader(pScene, pObject, *parseIter);
-					}
+				if (iter != end(fbxIndex))
+				{
+					// find a shader, let's find an xml value
+					ReadXmlShader(pScene, iter->second, *parseIter);
 				}
 			}
 		}
@@ -618,12 +613,7 @@ bool ReadXml(const char *fname, FbxManager *pManager, FbxScene *pScene, std::set
 	// free mem
 
 	FreeParsingShadersVector(xmlShaders);
-
-	if (pDoc)
-	{
-		delete pDoc;
-		pDoc = nullptr;
-	}
+	parser.Close();
 	
 	return lStatus;
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+
+// desc_bench.cpp
+// Sergei <Neill3d> Solokhin 2018
+
+#include "desc.h"
+#include "tinyxml.h"
+#include "xmlPullParser.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// compare a TinyXML document with a pull parser on the same xml file
+
+struct BenchCounters
+{
+	size_t		numberOfElements{ 0 };
+	size_t		numberOfAttributes{ 0 };
+};
+
+// peak private bytes of the process, a mapped file is not counted there
+size_t GetPeakPrivateBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(PROCESS_MEMORY_COUNTERS)))
+		return 0;
+	return counters.PeakPagefileUsage;
+#else
+	// peak resident size in kilobytes, it includes touched pages of a mapped file
+	struct rusage usage;
+	if (0 != getrusage(RUSAGE_SELF, &usage))
+		return 0;
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void WalkDocument(const TiXmlNode *pNode, BenchCounters &counters)
+{
+	for (const TiXmlNode *pChild = pNode->FirstChild(); nullptr != pChild; pChild = pChild->NextSibling())
+	{
+		const TiXmlElement *pElem = pChild->ToElement();
+		if (nullptr == pElem)
+			continue;
+
+		counters.numberOfElements += 1;
+		for (const TiXmlAttribute *pAttrib = pElem->FirstAttribute(); nullptr != pAttrib; pAttrib = pAttrib->Next())
+			counters.numberOfAttributes += 1;
+
+		WalkDocument(pElem, counters);
+	}
+}
+
+bool BenchDocument(const char *fname, BenchCounters &counters)
+{
+	TiXmlDocument doc;
+	if (false == doc.LoadFile(fname))
+		return false;
+
+	WalkDocument(&doc, counters);
+	return true;
+}
+
+bool BenchPullParser(const char *fname, BenchCounters &counters, size_t &arenaPeak)
+{
+	XmlPullParser parser;
+	if (false == parser.Open(fname))
+		return false;
+
+	for (XmlPullParser::EEvent ev = parser.Next(); XmlPullParser::eXmlEventEndDocument != ev; ev = parser.Next())
+	{
+		if (XmlPullParser::eXmlEventError == ev)
+		{
+			printf("> %s at line %d\n", parser.GetErrorText(), parser.GetErrorLine());
+			return false;
+		}
+		else if (XmlPullParser::eXmlEventStartElement == ev)
+		{
+			counters.numberOfElements += 1;
+			counters.numberOfAttributes += parser.GetNumberOfAttributes();
+		}
+	}
+
+	arenaPeak = parser.GetArena().GetPeakBytes();
+	return true;
+}
+
+bool XmlBenchmark(const char *fname, const int repeats)
+{
+	__int64	fileSize = 0;
+	TCHAR buffer[256] = { 0 };
+	FileSizeAndDate(fname, fileSize, buffer, 256);
+
+	const int numberOfRuns = (repeats > 0) ? repeats : 1;
+	const double megabytes = static_cast<double>(fileSize) * numberOfRuns / (1024.0 * 1024.0);
+
+	printf("[Shading Graph Exporter] xml benchmark - %s, %.2f MB x %d\n", fname, static_cast<double>(fileSize) / (1024.0 * 1024.0), numberOfRuns);
+
+	// pull parser goes first, a peak value only grows during a process life
+	BenchCounters pullCounters;
+	size_t arenaPeak = 0;
+	size_t peakBefore = GetPeakPrivateBytes();
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numberOfRuns; ++i)
+	{
+		pullCounters = BenchCounters();
+		if (false == BenchPullParser(fname, pullCounters, arenaPeak))
+		{
+			printf("ERROR: pull parser failed to read a file\n");
+			return false;
+		}
+	}
+
+	const double pullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const size_t pullPeak = GetPeakPrivateBytes() - peakBefore;
+
+	BenchCounters domCounters;
+	peakBefore = GetPeakPrivateBytes();
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numberOfRuns; ++i)
+	{
+		domCounters = BenchCounters();
+		if (false == BenchDocument(fname, domCounters))
+		{
+			printf("ERROR: TinyXML failed to read a file\n");
+			return false;
+		}
+	}
+
+	const double domSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const size_t domPeak = GetPeakPrivateBytes() - peakBefore;
+
+	printf("  pull parser - %8.2f MB/s, peak private %zd KB (arena %zd KB), %zd elements, %zd attributes\n",
+		megabytes / pullSeconds, pullPeak / 1024, arenaPeak / 1024, pullCounters.numberOfElements, pullCounters.numberOfAttributes);
+	printf("  TinyXML dom - %8.2f MB/s, peak private %zd KB, %zd elements, %zd attributes\n",
+		megabytes / domSeconds, domPeak / 1024, domCounters.numberOfElements, domCounters.numberOfAttributes);
+
+	if (pullCounters.numberOfElements != domCounters.numberOfElements
+		|| pullCounters.numberOfAttributes != domCounters.numberOfAttributes)
+	{
+		printf("WARNING: parsers disagree on a file content\n");
+		return false;
+	}
+	return true;
+}
@@ -15,9 +15,25 @@
 
 #include <set>
 #include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char **environ;
+#endif
 
 //
 // run in two possible modes - extract xml and bake xml
+//  or in a batch mode - every manifest line is processed by a worker process with a mode and arguments from that line
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // mainExtract
@@ -71,7 +87,7 @@ bool mainExtract(const FbxString &lFilePath, const FbxString &strOutput)
 	if (false == outOfDate)
 	{
 		printf("No need to update a fbx file\n");
-		return false;
+		return true;
 	}
 
 	// Prepare the FBX SDK.
@@ -159,7 +175,7 @@ bool mainExtract(const FbxString &lFilePath, const FbxString &strOutput)
 	// are automatically destroyed at the same time.
 	DestroySdkObjects(lSdkManager, lResult);
 
-	return true;
+	return lResult;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -438,9 +454,256 @@ bool mainBake(const FbxString &lFilePath, const FbxString &lXmlPath, const FbxSt
 	// are automatically destroyed at the same time.
 	DestroySdkObjects(lSdkManager, lResult);
 
+	return lResult;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// mainBatch
+
+struct BatchEntry
+{
+	std::vector<std::string>	args;
+	std::string					line;
+
+	int			exitCode{ -1 };
+	double		seconds{ 0.0 };
+};
+
+// split a manifest line into arguments, a path with spaces could be put in double quotes
+void SplitManifestLine(const std::string &line, std::vector<std::string> &args)
+{
+	args.clear();
+
+	std::string curr;
+	bool quoted = false;
+	bool hasArg = false;
+
+	for (const char c : line)
+	{
+		if ('"' == c)
+		{
+			quoted = !quoted;
+			hasArg = true;
+		}
+		else if (!quoted && (' ' == c || '\t' == c || '\r' == c))
+		{
+			if (hasArg)
+				args.push_back(curr);
+			curr.clear();
+			hasArg = false;
+		}
+		else
+		{
+			curr.push_back(c);
+			hasArg = true;
+		}
+	}
+
+	if (hasArg)
+		args.push_back(curr);
+}
+
+bool ReadManifest(const char *filename, std::vector<BatchEntry> &entries)
+{
+	std::ifstream f(filename);
+	if (!f.is_open())
+		return false;
+
+	std::string line;
+	while (std::getline(f, line))
+	{
+		BatchEntry entry;
+		SplitManifestLine(line, entry.args);
+
+		// skip empty lines and comments
+		if (entry.args.empty() || '#' == entry.args[0][0])
+			continue;
+
+		// a line without a mode is a fbx file to extract
+		if ('-' != entry.args[0][0])
+			entry.args.insert(begin(entry.args), "-e");
+
+		entry.line = line;
+		entries.push_back(std::move(entry));
+	}
 	return true;
 }
 
+#ifdef _WIN32
+// quote an argument the way CommandLineToArgvW splits it back, backslashes are doubled only in front of a quote
+void AppendQuotedArgument(std::string &cmd, const std::string &arg)
+{
+	cmd.push_back('"');
+
+	size_t numberOfBackslashes = 0;
+	for (const char c : arg)
+	{
+		if ('\\' == c)
+		{
+			numberOfBackslashes += 1;
+			continue;
+		}
+
+		// backslashes in front of a quote are escaped and the quote itself too
+		if ('"' == c)
+			cmd.append(numberOfBackslashes * 2 + 1, '\\');
+		else
+			cmd.append(numberOfBackslashes, '\\');
+
+		numberOfBackslashes = 0;
+		cmd.push_back(c);
+	}
+
+	cmd.append(numberOfBackslashes * 2, '\\');
+	cmd.push_back('"');
+}
+#endif
+
+// argv[0] is not a path when the tool is started through PATH, ask the system where the executable is
+std::string GetExecutablePath(const char *argv0)
+{
+#ifdef _WIN32
+	std::vector<char> buffer(MAX_PATH);
+
+	for (;;)
+	{
+		const DWORD length = GetModuleFileNameA(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
+		if (0 == length)
+			break;
+		if (length < buffer.size())
+			return std::string(buffer.data(), length);
+
+		// path is truncated
+		buffer.resize(buffer.size() * 2);
+	}
+#else
+	std::vector<char> buffer(4096);
+	const ssize_t length = readlink("/proc/self/exe", buffer.data(), buffer.size());
+
+	if (length > 0 && static_cast<size_t>(length) < buffer.size())
+		return std::string(buffer.data(), static_cast<size_t>(length));
+#endif
+	return argv0;
+}
+
+// every entry is processed in a separate process, fbx sdk objects and xml writer globals are not shared between files
+//  the process is started directly with an argument vector, no shell is involved
+int RunBatchEntry(const char *exePath, const BatchEntry &entry)
+{
+#ifdef _WIN32
+	std::string cmd;
+	AppendQuotedArgument(cmd, exePath);
+
+	for (const std::string &arg : entry.args)
+	{
+		cmd.push_back(' ');
+		AppendQuotedArgument(cmd, arg);
+	}
+
+	STARTUPINFOA si = {};
+	PROCESS_INFORMATION pi = {};
+	si.cb = sizeof(si);
+
+	// command line buffer has to be writable
+	std::vector<char> cmdLine(begin(cmd), end(cmd));
+	cmdLine.push_back(0);
+
+	if (FALSE == CreateProcessA(exePath, cmdLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi))
+	{
+		printf("ERROR: failed to start a worker process - %s (error %lu)\n", exePath, GetLastError());
+		return -1;
+	}
+
+	WaitForSingleObject(pi.hProcess, INFINITE);
+
+	DWORD exitCode = 0;
+	if (FALSE == GetExitCodeProcess(pi.hProcess, &exitCode))
+		exitCode = static_cast<DWORD>(-1);
+
+	CloseHandle(pi.hThread);
+	CloseHandle(pi.hProcess);
+
+	return static_cast<int>(exitCode);
+#else
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(exePath));
+
+	for (const std::string &arg : entry.args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	pid_t pid;
+	// spawnp finds the executable in PATH too when it's a fallback argv[0] without a directory
+	if (0 != posix_spawnp(&pid, exePath, nullptr, nullptr, argv.data(), environ))
+	{
+		printf("ERROR: failed to start a worker process - %s\n", exePath);
+		return -1;
+	}
+
+	int status = 0;
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+
+	return WEXITSTATUS(status);
+#endif
+}
+
+bool mainBatch(const char *exePath, const FbxString &lManifestPath, const int numberOfWorkers)
+{
+	std::vector<BatchEntry>	entries;
+
+	if (!ReadManifest(lManifestPath.Buffer(), entries))
+	{
+		printf("ERROR: failed to open a manifest file - %s\n", lManifestPath.Buffer());
+		return false;
+	}
+
+	const int workersCount = (std::max)(1, (std::min)(numberOfWorkers, static_cast<int>(entries.size())));
+	printf("[Shading Graph Exporter] Batch of %zd files with %d workers\n", entries.size(), workersCount);
+
+	const auto batchStart = std::chrono::steady_clock::now();
+
+	std::atomic<size_t>		nextEntry{ 0 };
+	std::vector<std::thread>	workers;
+
+	for (int i = 0; i < workersCount; ++i)
+	{
+		workers.emplace_back([&]() {
+
+			for (size_t ndx = nextEntry++; ndx < entries.size(); ndx = nextEntry++)
+			{
+				BatchEntry &entry = entries[ndx];
+
+				const auto start = std::chrono::steady_clock::now();
+				entry.exitCode = RunBatchEntry(exePath, entry);
+				entry.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+		});
+	}
+
+	for (auto &worker : workers)
+		worker.join();
+
+	const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+
+	// report in a manifest order
+	int numberOfFailed = 0;
+	printf("\n[Shading Graph Exporter] Batch report\n");
+
+	for (const BatchEntry &entry : entries)
+	{
+		const bool isOk = (0 == entry.exitCode);
+		if (!isOk)
+			numberOfFailed += 1;
+
+		printf("%s %8.3fs  %s\n", (isOk) ? "[ OK ]" : "[FAIL]", entry.seconds, entry.line.c_str());
+	}
+
+	printf("> %zd files, %d failed, total time %.3fs\n", entries.size(), numberOfFailed, totalSeconds);
+
+	return 0 == numberOfFailed;
+}
+
 ////////////////////////////////////////////////////////////////////
 // main
 
@@ -450,7 +713,9 @@ int main(int argc, char** argv)
 	{
 		MODE_OPEN_NONE,
 		MODE_OPEN_EXTRACT,
-		MODE_OPEN_BAKE
+		MODE_OPEN_BAKE,
+		MODE_OPEN_BATCH,
+		MODE_OPEN_BENCH
 	};
 
 	int currMode = MODE_OPEN_NONE;
@@ -459,12 +724,29 @@ int main(int argc, char** argv)
 	FbxString lXmlPath("");
 	FbxString lOutPath("");
 
+	int numberOfWorkers = static_cast<int>(std::thread::hardware_concurrency());
+
 	for( int i = 1, c = argc; i < c; ++i )
 	{
 		FbxString arg(argv[i]);
 		const char *buf = arg.Buffer();
 
-		if (0 == strcmp("-e", buf) || 0 == strcmp("-extract", arg) || 0 == strcmp("-f", arg))
+		if (0 == strcmp("-batch", buf) || 0 == strcmp("-m", buf))
+		{
+			currMode = MODE_OPEN_BATCH;
+			lFilePath.Clear();
+		}
+		else if (0 == strcmp("-bench", buf))
+		{
+			currMode = MODE_OPEN_BENCH;
+			lFilePath.Clear();
+			lXmlPath.Clear();
+		}
+		else if (0 == strcmp("-j", buf) && i + 1 < c)
+		{
+			numberOfWorkers = atoi(argv[++i]);
+		}
+		else if (0 == strcmp("-e", buf) || 0 == strcmp("-extract", arg) || 0 == strcmp("-f", arg))
 		{
 			currMode = MODE_OPEN_EXTRACT;
 			lFilePath.Clear();
@@ -493,16 +775,31 @@ int main(int argc, char** argv)
 	
 	//
 
+	bool lResult = true;
+	const auto start = std::chrono::steady_clock::now();
+
 	switch (currMode)
 	{
 	case MODE_OPEN_EXTRACT:
-		mainExtract(lFilePath, lXmlPath);
+		lResult = mainExtract(lFilePath, lXmlPath);
 		break;
 	case MODE_OPEN_BAKE:
-		mainBake(lFilePath, lXmlPath, lOutPath);
+		lResult = mainBake(lFilePath, lXmlPath, lOutPath);
 		break;
+	case MODE_OPEN_BATCH:
+		// file path is a manifest path in that mode
+		return (mainBatch(GetExecutablePath(argv[0]).c_str(), lFilePath, numberOfWorkers)) ? 0 : 1;
+	case MODE_OPEN_BENCH:
+		// file path is a xml path, a second argument is a number of runs
+		return (XmlBenchmark(lFilePath.Buffer(), (lXmlPath.IsEmpty()) ? 5 : atoi(lXmlPath.Buffer()))) ? 0 : 1;
 	}
 	
-    return 0;
+	if (MODE_OPEN_NONE != currMode)
+	{
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("[Shading Graph Exporter] %s - %.3fs\n", lFilePath.Buffer(), seconds);
+	}
+
+    return (lResult) ? 0 : 1;
 }
 
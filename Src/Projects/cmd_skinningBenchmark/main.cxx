@@ -0,0 +1,265 @@
+// main.cxx
+//
+// Skinning Benchmark
+//
+// Linear blend skinning kernel on a synthetic mesh (100k vertices, 150 bones by default)
+//  - reference path in double precision, rest positions are transformed by the blended matrix
+//  - round trip, kernel output is inverted back to rest with a general 4x4 inverse
+//     (the way LinkedVertex::CalculateDeformedPosition does)
+//  - SkinningDeform on a single thread and on all hardware threads
+//
+// Sergei <Neill3d> Solokhin 2018
+
+#include "SkinningKernel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#define NUMBER_OF_VERTICES	100000
+#define NUMBER_OF_BONES		150
+#define NUMBER_OF_RUNS		20
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// matrix helpers
+
+struct Matrix4
+{
+	double	m[16];
+};
+
+// column-major TRS matrix with Euler XYZ rotation in degrees and uniform scaling
+void MakeMatrix(Matrix4 &result, const double *t, const double *r, const double s)
+{
+	const double deg = 3.14159265358979323846 / 180.0;
+	const double cx = cos(r[0] * deg), sx = sin(r[0] * deg);
+	const double cy = cos(r[1] * deg), sy = sin(r[1] * deg);
+	const double cz = cos(r[2] * deg), sz = sin(r[2] * deg);
+
+	// R = Rz * Ry * Rx
+	double *m = result.m;
+	m[0] = s * cy * cz;				m[4] = s * (sx * sy * cz - cx * sz);	m[8] = s * (cx * sy * cz + sx * sz);	m[12] = t[0];
+	m[1] = s * cy * sz;				m[5] = s * (sx * sy * sz + cx * cz);	m[9] = s * (cx * sy * sz - sx * cz);	m[13] = t[1];
+	m[2] = -s * sy;					m[6] = s * sx * cy;						m[10] = s * cx * cy;					m[14] = t[2];
+	m[3] = 0.0;						m[7] = 0.0;								m[11] = 0.0;							m[15] = 1.0;
+}
+
+// general inverse with cofactors
+bool InverseGeneral(Matrix4 &result, const Matrix4 &matrix)
+{
+	const double *m = matrix.m;
+	double inv[16];
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	double det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if (det == 0.0)
+		return false;
+
+	det = 1.0 / det;
+	for (int i = 0; i < 16; ++i)
+		result.m[i] = inv[i] * det;
+	return true;
+}
+
+double RandomRange(const double minValue, const double maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / static_cast<double>(RAND_MAX));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char** argv)
+{
+	const int numberOfVertices = (argc > 1) ? atoi(argv[1]) : NUMBER_OF_VERTICES;
+	const int numberOfBones = (argc > 2) ? atoi(argv[2]) : NUMBER_OF_BONES;
+
+	if (numberOfVertices <= 0 || numberOfBones <= 0)
+	{
+		printf("usage: skinning_benchmark [numberOfVertices] [numberOfBones]\n");
+		return 1;
+	}
+
+	srand(1234);
+
+	// bone palette, the last matrix is an identity for unweighted vertices
+
+	std::vector<Matrix4>	bones(numberOfBones + 1);
+	std::vector<float>		palette((numberOfBones + 1) * 16);
+
+	for (int n = 0; n <= numberOfBones; ++n)
+	{
+		const double t[3] = { RandomRange(-50.0, 50.0), RandomRange(-50.0, 50.0), RandomRange(-50.0, 50.0) };
+		const double r[3] = { RandomRange(-30.0, 30.0), RandomRange(-30.0, 30.0), RandomRange(-30.0, 30.0) };
+		const double zero[3] = { 0.0, 0.0, 0.0 };
+
+		if (n < numberOfBones)
+			MakeMatrix(bones[n], t, r, RandomRange(0.9, 1.1));
+		else
+			MakeMatrix(bones[n], zero, zero, 1.0);
+
+		for (int k = 0; k < 16; ++k)
+			palette[n * 16 + k] = static_cast<float>(bones[n].m[k]);
+	}
+
+	// vertices with sorted and normalized influences, every 100th vertex is unweighted
+
+	std::vector<int>		boneIndices(numberOfVertices * SKINNING_MAX_INFLUENCES);
+	std::vector<float>		weights(numberOfVertices * SKINNING_MAX_INFLUENCES);
+	std::vector<float>		restPositions(numberOfVertices * 4);
+	std::vector<float>		restNormals(numberOfVertices * 4);
+
+	for (int i = 0; i < numberOfVertices; ++i)
+	{
+		int *indices = &boneIndices[i * SKINNING_MAX_INFLUENCES];
+		float *w = &weights[i * SKINNING_MAX_INFLUENCES];
+
+		const int numberOfInfluences = (i % 100 == 0) ? 0 : 1 + i % SKINNING_MAX_INFLUENCES;
+		const int firstBone = rand() % numberOfBones;
+
+		float total = 0.0f;
+		for (int j = 0; j < SKINNING_MAX_INFLUENCES; ++j)
+		{
+			indices[j] = (j < numberOfInfluences) ? (firstBone + j) % numberOfBones : numberOfBones;
+			w[j] = (j < numberOfInfluences) ? static_cast<float>(RandomRange(0.1, 1.0)) : 0.0f;
+			total += w[j];
+		}
+
+		std::sort(w, w + numberOfInfluences, [](const float a, const float b) { return a > b; });
+
+		for (int j = 0; j < SKINNING_MAX_INFLUENCES; ++j)
+			w[j] = (total > 0.0f) ? w[j] / total : 0.0f;
+
+		if (numberOfInfluences == 0)
+		{
+			indices[0] = numberOfBones;
+			w[0] = 1.0f;
+		}
+
+		float *p = &restPositions[i * 4];
+		p[0] = static_cast<float>(RandomRange(-100.0, 100.0));
+		p[1] = static_cast<float>(RandomRange(-100.0, 100.0));
+		p[2] = static_cast<float>(RandomRange(-100.0, 100.0));
+		p[3] = 1.0f;
+
+		float *nor = &restNormals[i * 4];
+		nor[0] = static_cast<float>(RandomRange(-1.0, 1.0));
+		nor[1] = static_cast<float>(RandomRange(-1.0, 1.0));
+		nor[2] = static_cast<float>(RandomRange(-1.0, 1.0)) + 0.01f;
+		nor[3] = 0.0f;
+	}
+
+	SkinningData data;
+	data.palette = palette.data();
+	data.boneIndices = boneIndices.data();
+	data.weights = weights.data();
+	data.vertexCount = numberOfVertices;
+
+	std::vector<float>	positions(numberOfVertices * 4);
+	std::vector<float>	normals(numberOfVertices * 4);
+
+	// 1 - double precision reference
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<double>	reference(numberOfVertices * 3);
+	std::vector<double>	referenceNormals(numberOfVertices * 3);
+	std::vector<Matrix4>	inverses(numberOfVertices);
+
+	for (int i = 0; i < numberOfVertices; ++i)
+	{
+		Matrix4 blend = {};
+		for (int j = 0; j < SKINNING_MAX_INFLUENCES; ++j)
+		{
+			const double w = weights[i * SKINNING_MAX_INFLUENCES + j];
+			const Matrix4 &bone = bones[boneIndices[i * SKINNING_MAX_INFLUENCES + j]];
+
+			for (int k = 0; k < 16; ++k)
+				blend.m[k] += w * bone.m[k];
+		}
+
+		Matrix4 &inv = inverses[i];
+		InverseGeneral(inv, blend);
+
+		const float *p = &restPositions[i * 4];
+		const float *nor = &restNormals[i * 4];
+		double n[3];
+
+		for (int k = 0; k < 3; ++k)
+		{
+			reference[i * 3 + k] = blend.m[k] * p[0] + blend.m[4 + k] * p[1] + blend.m[8 + k] * p[2] + blend.m[12 + k];
+			// inverse transpose for normals
+			n[k] = inv.m[k * 4] * nor[0] + inv.m[k * 4 + 1] * nor[1] + inv.m[k * 4 + 2] * nor[2];
+		}
+
+		const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (int k = 0; k < 3; ++k)
+			referenceNormals[i * 3 + k] = n[k] / len;
+	}
+
+	const double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// 2 - kernel on one thread and on all threads
+
+	double singleMs = 0.0;
+	double threadedMs = 0.0;
+
+	for (int run = 0; run < NUMBER_OF_RUNS; ++run)
+	{
+		singleMs += SkinningDeform(data, restPositions.data(), restNormals.data(), positions.data(), normals.data(), 1);
+		threadedMs += SkinningDeform(data, restPositions.data(), restNormals.data(), positions.data(), normals.data());
+	}
+
+	singleMs /= NUMBER_OF_RUNS;
+	threadedMs /= NUMBER_OF_RUNS;
+
+	double maxError = 0.0;
+	double maxNormalError = 0.0;
+	double maxRoundTripError = 0.0;
+
+	for (int i = 0; i < numberOfVertices; ++i)
+	{
+		const Matrix4 &inv = inverses[i];
+		const float *p = &positions[i * 4];
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const double scale = std::max(1.0, fabs(reference[i * 3 + k]));
+			maxError = std::max(maxError, fabs(p[k] - reference[i * 3 + k]) / scale);
+			maxNormalError = std::max(maxNormalError, fabs(normals[i * 4 + k] - referenceNormals[i * 3 + k]));
+
+			// un-deform like LinkedVertex::CalculateDeformedPosition, it has to give the rest position back
+			const double rest = inv.m[k] * p[0] + inv.m[4 + k] * p[1] + inv.m[8 + k] * p[2] + inv.m[12 + k];
+			maxRoundTripError = std::max(maxRoundTripError, fabs(rest - restPositions[i * 4 + k]) / std::max(1.0, fabs(rest)));
+		}
+	}
+
+	printf("[Skinning Benchmark] %d vertices, %d bones, %d influences\n", numberOfVertices, numberOfBones, SKINNING_MAX_INFLUENCES);
+	printf("  reference (double)              - %8.3f ms\n", referenceMs);
+	printf("  kernel, 1 thread                - %8.3f ms\n", singleMs);
+	printf("  kernel, all threads             - %8.3f ms\n", threadedMs);
+	printf("  max relative position error %g\n", maxError);
+	printf("  max normal error %g\n", maxNormalError);
+	printf("  max round trip error %g\n", maxRoundTripError);
+
+	return (maxError < 1e-4 && maxNormalError < 1e-3 && maxRoundTripError < 1e-3) ? 0 : 1;
+}
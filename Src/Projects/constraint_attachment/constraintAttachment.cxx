@@ -13,7 +13,9 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include "constraintAttachment.h"
 
 #include <vector>
-#include "pointTriangle.h"
+#include <algorithm>
+#include <thread>
+#include <float.h>
 
 //--- Registration defines
 #define	CCONSTRAINTATTACHMENT__CLASS	CCONSTRAINTATTACHMENT__CLASSNAME
@@ -605,47 +607,84 @@ bool CConstraintAttachment::CalculateClosestPoints3(FBModel *srcModel, FBModel *
 	srcModel->GetMatrix(matrixA);
 	dstModel->GetMatrix(matrixB);
 
-	// 1 - get source list of triangles
+	// 1 - get source list of triangles and update a search tree
 	std::vector<DistancePointTriangleExact::Triangle>	triangles;
 	PrepareTriangleList(triangles, modelScaling, matrixA, srcModel->ModelVertexData);
+	mSurfaceTree.Update(triangles);
+
+	if (mSurfaceTree.IsEmpty())
+		return false;
 
 	// 2 - get constrain list of vertices
 	std::vector<vec3>	vertices;
 	PrepareVerticesList(vertices, modelScaling, matrixB, dstModel->ModelVertexData);
 
 	// 3 - find closest distance to triangle
-	//	brute force - for each point find closest triangle, then sort and find pair point-triangle
+	//	for each point query the tree (best-first), points are split into ranges between threads
 
-	vec3 holdContactA(0.0f, 0.0f, 0.0f);
-	vec3 holdContactB(0.0f, 0.0f, 0.0f);
+	struct ClosestPair
+	{
+		float	sqrDistance{ FLT_MAX };
+		int		triangle{ -1 };
+		int		vertex{ -1 };
+		DistancePointTriangleExact::Result	result;
+	};
 
-	bool firstPoint = true;
-	float minDistance = 0.0f;
+	const int numVertices = static_cast<int>(vertices.size());
+	const int numThreads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), numVertices / 64));
 
-	DistancePointTriangleExact	distOp;
+	std::vector<ClosestPair>	threadResults(numThreads);
+	std::vector<std::thread>	threads;
 
-	for (vec3& point : vertices)
+	auto computeRange = [this, &vertices, &threadResults, numVertices, numThreads](const int threadIndex)
 	{
-		for (DistancePointTriangleExact::Triangle& tri : triangles)
-		{
-			auto result = distOp(point, tri);
+		ClosestPair &pair = threadResults[threadIndex];
+		const int begin = numVertices * threadIndex / numThreads;
+		const int end = numVertices * (threadIndex + 1) / numThreads;
 
-			if ( result.sqrDistance > 0.0f &&  (firstPoint || minDistance > result.sqrDistance) )
+		DistancePointTriangleExact::Result result;
+		for (int i = begin; i < end; ++i)
+		{
+			// use current best distance as a search radius, that cuts most of the tree for the next points
+			const int tri = mSurfaceTree.FindClosest(vertices[i], pair.sqrDistance, result);
+			if (tri >= 0)
 			{
-				firstPoint = false;
-				minDistance = result.sqrDistance;
-				outBaryCoords = FBVector3d(result.parameter[0], result.parameter[1], result.parameter[2]);
-
-				outVertA = tri.index[0];
-				outVertB = tri.index[1];
-				outVertC = tri.index[2];
-
-				holdContactA = result.closest;
-				holdContactB = point;
+				pair.sqrDistance = result.sqrDistance;
+				pair.triangle = tri;
+				pair.vertex = i;
+				pair.result = result;
 			}
 		}
+	};
+
+	for (int i = 1; i < numThreads; ++i)
+		threads.emplace_back(computeRange, i);
+	computeRange(0);
+
+	for (auto &thread : threads)
+		thread.join();
+
+	// ranges are in vertex order, so the first minimum wins the same way as in a sequential search
+	const ClosestPair *pBest = nullptr;
+	for (const ClosestPair &pair : threadResults)
+	{
+		if (pair.triangle >= 0 && (nullptr == pBest || pair.sqrDistance < pBest->sqrDistance))
+			pBest = &pair;
 	}
 
+	if (nullptr == pBest)
+		return false;
+
+	const DistancePointTriangleExact::Triangle &tri = mSurfaceTree.GetTriangles()[pBest->triangle];
+
+	outBaryCoords = FBVector3d(pBest->result.parameter[0], pBest->result.parameter[1], pBest->result.parameter[2]);
+	outVertA = tri.index[0];
+	outVertB = tri.index[1];
+	outVertC = tri.index[2];
+
+	const vec3 holdContactA(pBest->result.closest);
+	const vec3 holdContactB(vertices[pBest->vertex]);
+
 	//
 	// move constraint model to the contact point A
 
@@ -14,6 +14,8 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 //--- SDK include
 #include <fbsdk/fbsdk.h>
 
+#include "triangleTree.h"
+
 #define CCONSTRAINTATTACHMENT__CLASSNAME	CConstraintAttachment
 #define CCONSTRAINTATTACHMENT__CLASSSTR		"CConstraintAttachment"
 
@@ -94,6 +96,9 @@ protected:
 	FBVertex			mDebugC;
 	FBVector3d			mDebugNormal;
 
+	// source surface triangles, kept between snaps and refitted when the surface is deformed
+	TriangleAABBTree	mSurfaceTree;
+
 	bool		CalculateClosestPoints3(FBModel *srcModel, FBModel *dstModel, FBVector3d &srcContactPoint, FBVector3d &dstContactPoint, int &outVertA, int &outVertB, int &outVertC, FBVector3d &outBaryCoords );
 	
 	bool		BaryCoordsToTM( FBMatrix &modelMatrix, FBMatrix &normalMatrix, int numVerts, const FBVertex *vertices, const FBNormal *normals, 
@@ -36,7 +36,7 @@ protected:
 };
 
 
-DistancePointTriangleExact::Result DistancePointTriangleExact::operator()(
+inline DistancePointTriangleExact::Result DistancePointTriangleExact::operator()(
     nv::vec3 const& point, DistancePointTriangleExact::Triangle const& triangle)
 {
     using namespace nv;
@@ -0,0 +1,254 @@
+
+
+/**	\file	triangleTree.cxx
+
+Sergei <Neill3d> Solokhin 2018
+
+GitHub page - https://github.com/Neill3d/OpenMoBu
+Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+
+*/
+
+#include "triangleTree.h"
+
+#include <algorithm>
+#include <queue>
+#include <float.h>
+
+#define TRIANGLE_TREE_LEAF_SIZE		4
+
+namespace
+{
+	struct QueueItem
+	{
+		float	sqrDistance;
+		int		node;
+
+		bool operator < (const QueueItem &other) const
+		{
+			// std::priority_queue is a max heap, we need a nearest node on top
+			return sqrDistance > other.sqrDistance;
+		}
+	};
+
+	float SqrDistanceToBox(const nv::vec3 &p, const nv::vec3 &bmin, const nv::vec3 &bmax)
+	{
+		float result = 0.0f;
+		for (int k = 0; k < 3; ++k)
+		{
+			const float d = (p[k] < bmin[k]) ? bmin[k] - p[k] : ((p[k] > bmax[k]) ? p[k] - bmax[k] : 0.0f);
+			result += d * d;
+		}
+		return result;
+	}
+};
+
+void TriangleAABBTree::Clear()
+{
+	mTriangles.clear();
+	mOrder.clear();
+	mNodes.clear();
+}
+
+bool TriangleAABBTree::IsSameTopology(const std::vector<Triangle> &triangles) const
+{
+	if (IsEmpty() || triangles.size() != mTriangles.size())
+		return false;
+
+	for (size_t i = 0, count = triangles.size(); i < count; ++i)
+	{
+		const Triangle &a = triangles[i];
+		const Triangle &b = mTriangles[i];
+		if (a.index[0] != b.index[0] || a.index[1] != b.index[1] || a.index[2] != b.index[2])
+			return false;
+	}
+	return true;
+}
+
+void TriangleAABBTree::Update(const std::vector<Triangle> &triangles)
+{
+	const bool refit = IsSameTopology(triangles);
+	mTriangles = triangles;
+
+	if (mTriangles.empty())
+	{
+		Clear();
+		return;
+	}
+
+	if (refit)
+		Refit();
+	else
+		Build();
+}
+
+void TriangleAABBTree::Build()
+{
+	using namespace nv;
+
+	const int triCount = static_cast<int>(mTriangles.size());
+
+	std::vector<vec3> centroids(triCount);
+	mOrder.resize(triCount);
+
+	for (int i = 0; i < triCount; ++i)
+	{
+		const Triangle &tri = mTriangles[i];
+		centroids[i] = (1.0f / 3.0f) * (tri.v[0] + tri.v[1] + tri.v[2]);
+		mOrder[i] = i;
+	}
+
+	struct BuildTask
+	{
+		int		node;
+		int		begin;
+		int		end;
+	};
+
+	mNodes.clear();
+	mNodes.reserve(2 * (triCount / TRIANGLE_TREE_LEAF_SIZE + 1));
+	mNodes.push_back(Node());
+
+	std::vector<BuildTask> tasks;
+	tasks.push_back({ 0, 0, triCount });
+
+	while (!tasks.empty())
+	{
+		const BuildTask task = tasks.back();
+		tasks.pop_back();
+
+		const int count = task.end - task.begin;
+		if (count <= TRIANGLE_TREE_LEAF_SIZE)
+		{
+			mNodes[task.node].first = task.begin;
+			mNodes[task.node].count = count;
+			continue;
+		}
+
+		// median split along the longest axis of centroids
+
+		vec3 cmin(FLT_MAX, FLT_MAX, FLT_MAX);
+		vec3 cmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = task.begin; i < task.end; ++i)
+		{
+			const vec3 &c = centroids[mOrder[i]];
+			for (int k = 0; k < 3; ++k)
+			{
+				cmin[k] = std::min(cmin[k], c[k]);
+				cmax[k] = std::max(cmax[k], c[k]);
+			}
+		}
+
+		int axis = 0;
+		const vec3 extent = cmax - cmin;
+		if (extent[1] > extent[axis]) axis = 1;
+		if (extent[2] > extent[axis]) axis = 2;
+
+		const int mid = task.begin + count / 2;
+		std::nth_element(mOrder.begin() + task.begin, mOrder.begin() + mid, mOrder.begin() + task.end,
+			[&centroids, axis](const int a, const int b) { return centroids[a][axis] < centroids[b][axis]; });
+
+		const int left = static_cast<int>(mNodes.size());
+		mNodes[task.node].first = left;
+		mNodes[task.node].count = 0;
+		mNodes.push_back(Node());
+		mNodes.push_back(Node());
+
+		tasks.push_back({ left + 1, mid, task.end });
+		tasks.push_back({ left, task.begin, mid });
+	}
+
+	Refit();
+}
+
+void TriangleAABBTree::Refit()
+{
+	using namespace nv;
+
+	// children are stored after the parent, so a reverse walk is a bottom-up pass
+	for (int i = static_cast<int>(mNodes.size()) - 1; i >= 0; --i)
+	{
+		Node &node = mNodes[i];
+		node.bmin = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		node.bmax = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		if (node.count > 0)
+		{
+			for (int j = node.first; j < node.first + node.count; ++j)
+			{
+				const Triangle &tri = mTriangles[mOrder[j]];
+				for (int n = 0; n < 3; ++n)
+				{
+					for (int k = 0; k < 3; ++k)
+					{
+						node.bmin[k] = std::min(node.bmin[k], tri.v[n][k]);
+						node.bmax[k] = std::max(node.bmax[k], tri.v[n][k]);
+					}
+				}
+			}
+		}
+		else
+		{
+			const Node &left = mNodes[node.first];
+			const Node &right = mNodes[node.first + 1];
+			for (int k = 0; k < 3; ++k)
+			{
+				node.bmin[k] = std::min(left.bmin[k], right.bmin[k]);
+				node.bmax[k] = std::max(left.bmax[k], right.bmax[k]);
+			}
+		}
+	}
+}
+
+int TriangleAABBTree::FindClosest(const nv::vec3 &point, const float maxSqrDistance, Result &result) const
+{
+	if (IsEmpty())
+		return -1;
+
+	DistancePointTriangleExact	distOp;
+
+	float bestDistance = maxSqrDistance;
+	int bestTriangle = -1;
+
+	std::priority_queue<QueueItem> queue;
+	queue.push({ SqrDistanceToBox(point, mNodes[0].bmin, mNodes[0].bmax), 0 });
+
+	while (!queue.empty())
+	{
+		const QueueItem item = queue.top();
+		queue.pop();
+
+		// every node left in the queue is further away
+		if (item.sqrDistance >= bestDistance)
+			break;
+
+		const Node &node = mNodes[item.node];
+
+		if (node.count > 0)
+		{
+			for (int j = node.first; j < node.first + node.count; ++j)
+			{
+				const int index = mOrder[j];
+				const Result r = distOp(point, mTriangles[index]);
+
+				if (r.sqrDistance > 0.0f && r.sqrDistance < bestDistance)
+				{
+					bestDistance = r.sqrDistance;
+					bestTriangle = index;
+					result = r;
+				}
+			}
+		}
+		else
+		{
+			for (int child = node.first; child <= node.first + 1; ++child)
+			{
+				const float d = SqrDistanceToBox(point, mNodes[child].bmin, mNodes[child].bmax);
+				if (d < bestDistance)
+					queue.push({ d, child });
+			}
+		}
+	}
+
+	return bestTriangle;
+}
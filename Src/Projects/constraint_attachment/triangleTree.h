@@ -0,0 +1,55 @@
+
+#pragma once
+
+/**	\file	triangleTree.h
+
+Sergei <Neill3d> Solokhin 2018
+
+GitHub page - https://github.com/Neill3d/OpenMoBu
+Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+
+*/
+
+#include <vector>
+#include "pointTriangle.h"
+
+//////////////////////////////////////////////////////////////////////////////////
+//! AABB tree over a triangle list with a best-first closest point query.
+//!  Tree is kept between snaps, when only triangle positions are changed it's refitted instead of rebuilt.
+class TriangleAABBTree
+{
+public:
+
+	typedef DistancePointTriangleExact::Triangle	Triangle;
+	typedef DistancePointTriangleExact::Result		Result;
+
+	//! build a new tree or refit an existing one when triangle list has the same topology
+	void Update(const std::vector<Triangle> &triangles);
+
+	void Clear();
+	bool IsEmpty() const { return mNodes.empty(); }
+
+	const std::vector<Triangle> &GetTriangles() const { return mTriangles; }
+
+	//! closest triangle to a point, skips exact contacts (zero distance) the same way as the brute force search
+	//! \return triangle index or -1 when nothing is closer than maxSqrDistance
+	int FindClosest(const nv::vec3 &point, const float maxSqrDistance, Result &result) const;
+
+protected:
+
+	struct Node
+	{
+		nv::vec3	bmin;
+		nv::vec3	bmax;
+		int			first;		//!< leaf - first triangle in mOrder, interior - left child index (right is first+1)
+		int			count;		//!< number of triangles in a leaf, 0 for an interior node
+	};
+
+	std::vector<Triangle>	mTriangles;
+	std::vector<int>		mOrder;		//!< triangle indices grouped by leaves
+	std::vector<Node>		mNodes;
+
+	bool IsSameTopology(const std::vector<Triangle> &triangles) const;
+	void Build();
+	void Refit();
+};
@@ -69,6 +69,14 @@ bool Manager_CameraLinkVis::Open()
 
 bool Manager_CameraLinkVis::Clear()
 {
+	mLastCamera = nullptr;
+	mGroupsByName.clear();
+	mCamerasByGroup.clear();
+	mGroupsDirty = true;
+	mCamerasDirty = true;
+	mHideAllLinked = true;
+	mShownGroup.clear();
+
     return true;
 }
 
@@ -105,14 +113,22 @@ void Manager_CameraLinkVis::EventUIIdle(HISender pSender, HKEvent pEvent)
 
 	if (pCamera != mLastCamera)
 	{
-		// leave all cameras groups
-		FBScene *pScene = mSystem.Scene;
-		for (int i=0; i<pScene->Cameras.GetCount(); ++i)
+		if (mHideAllLinked || mCamerasDirty)
+		{
+			// leave all cameras groups, only after cameras are added or removed
+			RebuildCameras();
+
+			for (auto& iter : mCamerasByGroup)
+				GroupVis(iter.first.c_str(), false);
+
+			mHideAllLinked = false;
+		}
+		else if (!mShownGroup.empty())
 		{
-			FBCamera *iCam = FBCast<FBCamera>(pScene->Cameras[i]);
-			if (iCam->SystemCamera == false)
-				LeaveCamera(iCam);
+			// leave the group of a previous camera
+			GroupVis(mShownGroup.c_str(), false);
 		}
+		mShownGroup.clear();
 
 		// enter one current
 		EnterCamera(pCamera);
@@ -121,31 +137,81 @@ void Manager_CameraLinkVis::EventUIIdle(HISender pSender, HKEvent pEvent)
 	mLastCamera = pCamera;
 }
 
-bool Manager_CameraLinkVis::GroupVis(const char *groupName, const bool show)
+void Manager_CameraLinkVis::RebuildGroups()
 {
-	FBScene *pScene = FBSystem::TheOne().Scene;
+	mGroupsByName.clear();
 
-	for (int i=0; i<pScene->Groups.GetCount(); ++i)
+	FBScene *pScene = mSystem.Scene;
+	for (int i=0, count=pScene->Groups.GetCount(); i<count; ++i)
 	{
-		if ( strcmp( pScene->Groups[i]->Name, groupName ) == 0 )
-		{
-			pScene->Groups[i]->Show = show;
+		FBGroup *pGroup = pScene->Groups[i];
+		
+		// the first group wins for duplicated names, like a linear search did
+		mGroupsByName.emplace(pGroup->Name.AsString(), pGroup);
+	}
+
+	mGroupsDirty = false;
+}
 
-			FBGroup *pGroup = pScene->Groups[i];
-			for (int j=0, count=pGroup->Items.GetCount(); j<count; ++j)
+void Manager_CameraLinkVis::RebuildCameras()
+{
+	mCamerasByGroup.clear();
+
+	FBScene *pScene = mSystem.Scene;
+	for (int i=0, count=pScene->Cameras.GetCount(); i<count; ++i)
+	{
+		FBCamera *pCamera = FBCast<FBCamera>(pScene->Cameras[i]);
+
+		if (pCamera->SystemCamera == false)
+		{
+			FBProperty *lProp = pCamera->PropertyList.Find(NLinkVis_Internal::GROUP_NAME);
+			if (lProp)
 			{
-				FBComponent *pcomp = pGroup->Items[j];
-				if (FBIS(pcomp, FBModel))
-				{
-					( FBCast<FBModel>(pcomp) )->Show = show;
-				}
+				mCamerasByGroup.emplace(lProp->AsString(), pCamera);
 			}
+		}
+	}
+
+	mCamerasDirty = false;
+}
+
+FBGroup* Manager_CameraLinkVis::FindGroup(const char* groupName)
+{
+	if (mGroupsDirty)
+		RebuildGroups();
+
+	auto iter = mGroupsByName.find(groupName);
+	if (iter != end(mGroupsByName) && strcmp(iter->second->Name, groupName) == 0)
+		return iter->second;
+
+	// a name could be changed without a scene event, verify with one full scan
+	RebuildGroups();
+
+	iter = mGroupsByName.find(groupName);
+	return (iter != end(mGroupsByName)) ? iter->second : nullptr;
+}
 
-			return true;
+bool Manager_CameraLinkVis::GroupVis(const char *groupName, const bool show)
+{
+	if (groupName == nullptr || groupName[0] == 0)
+		return false;
+
+	FBGroup *pGroup = FindGroup(groupName);
+	if (pGroup == nullptr)
+		return false;
+
+	pGroup->Show = show;
+
+	for (int j=0, count=pGroup->Items.GetCount(); j<count; ++j)
+	{
+		FBComponent *pcomp = pGroup->Items[j];
+		if (FBIS(pcomp, FBModel))
+		{
+			( FBCast<FBModel>(pcomp) )->Show = show;
 		}
 	}
 
-	return false;
+	return true;
 }
 
 void Manager_CameraLinkVis::LeaveCamera(FBCamera *pCamera)
@@ -168,56 +234,124 @@ void Manager_CameraLinkVis::EnterCamera(FBCamera *pCamera)
 	if (pProp)
 	{
 		const char *groupName = pProp->AsString();
-		GroupVis( groupName, true );
+		if (GroupVis( groupName, true ))
+			mShownGroup = groupName;
 	}
 }
 
 FBCamera* Manager_CameraLinkVis::FindCameraByGroup(const char *groupName)
 {
-	FBScene *pScene = FBSystem::TheOne().Scene;
+	if (mCamerasDirty)
+		RebuildCameras();
 
-	for (int i=0; i<pScene->Cameras.GetCount(); ++i)
+	auto iter = mCamerasByGroup.find(groupName);
+	if (iter != end(mCamerasByGroup))
 	{
-		FBCamera *pCamera = FBCast<FBCamera>(pScene->Cameras[i]);
-
-		if (pCamera->SystemCamera == false)
-		{
-			FBProperty *lProp = pCamera->PropertyList.Find(NLinkVis_Internal::GROUP_NAME);
-			if (lProp)
-			{
-				const char *lname = lProp->AsString();
-				if ( strcmp( lname, groupName ) == 0 )
-				{
-					return pCamera;
-				}
-			}
-		}
+		FBProperty *lProp = iter->second->PropertyList.Find(NLinkVis_Internal::GROUP_NAME);
+		if (lProp && strcmp(lProp->AsString(), groupName) == 0)
+			return iter->second;
 	}
 
-	return nullptr;
+	// the property value could be edited by user, verify with one full scan
+	RebuildCameras();
+
+	iter = mCamerasByGroup.find(groupName);
+	return (iter != end(mCamerasByGroup)) ? iter->second : nullptr;
 }
 
 void Manager_CameraLinkVis::EventSceneChange(HISender pSender, HKEvent pEvent)
 {
 	FBEventSceneChange sceneEvent(pEvent);
+	const int type = sceneEvent.Type.AsInt();
 
-	if (sceneEvent.Type.AsInt() == kFBSceneChangeRename)
+	if (type == kFBSceneChangeAttach)
+	{
+		FBComponent *pComponent = sceneEvent.ChildComponent;
+
+		if ( FBIS(pComponent, FBGroup) )
+		{
+			if (!mGroupsDirty)
+				mGroupsByName.emplace(pComponent->Name.AsString(), FBCast<FBGroup>(pComponent));
+		}
+		else if ( FBIS(pComponent, FBCamera) )
+		{
+			// a link property is usually added after a camera is created
+			mCamerasDirty = true;
+		}
+	}
+	else if (type == kFBSceneChangeDetach)
+	{
+		FBComponent *pComponent = sceneEvent.ChildComponent;
+
+		if ( FBIS(pComponent, FBGroup) )
+		{
+			for (auto iter = begin(mGroupsByName); iter != end(mGroupsByName); )
+			{
+				if (iter->second == pComponent)
+					iter = mGroupsByName.erase(iter);
+				else
+					++iter;
+			}
+			// other group with the same name is found by a full scan on a next miss
+		}
+		else if ( FBIS(pComponent, FBCamera) )
+		{
+			for (auto iter = begin(mCamerasByGroup); iter != end(mCamerasByGroup); )
+			{
+				if (iter->second == pComponent)
+					iter = mCamerasByGroup.erase(iter);
+				else
+					++iter;
+			}
+
+			if (mLastCamera == pComponent)
+				mLastCamera = nullptr;
+			if (gCamera == pComponent)
+				gCamera = nullptr;
+		}
+	}
+	else if (type == kFBSceneChangeRename)
 	{
 		if ( FBIS(sceneEvent.Component, FBGroup) )
 		{
 			gGroup = (FBGroup*) (FBComponent*) sceneEvent.Component;
 			gCamera = FindCameraByGroup(gGroup->Name);
+			mRenamedGroup = gGroup->Name.AsString();
 		}
 	}
-	else if (sceneEvent.Type.AsInt() == kFBSceneChangeRenamed)
+	else if (type == kFBSceneChangeRenamed)
 	{
-		if (gGroup != nullptr && gCamera != nullptr)
+		if (gGroup != nullptr)
 		{
-			FBProperty *lProp = gCamera->PropertyList.Find(NLinkVis_Internal::GROUP_NAME);
-			if (lProp)
+			const std::string newName(gGroup->Name.AsString());
+
+			if (!mGroupsDirty)
+			{
+				mGroupsByName.erase(mRenamedGroup);
+				mGroupsByName.emplace(newName, gGroup);
+			}
+
+			if (gCamera != nullptr)
 			{
-				lProp->SetString( gGroup->Name );
+				FBProperty *lProp = gCamera->PropertyList.Find(NLinkVis_Internal::GROUP_NAME);
+				if (lProp)
+				{
+					lProp->SetString( gGroup->Name );
+				}
+
+				if (!mCamerasDirty)
+				{
+					mCamerasByGroup.erase(mRenamedGroup);
+					mCamerasByGroup.emplace(newName, gCamera);
+				}
 			}
+
+			if (mShownGroup == mRenamedGroup)
+				mShownGroup = newName;
 		}
+
+		gGroup = nullptr;
+		gCamera = nullptr;
+		mRenamedGroup.clear();
 	}
-}
\ No newline at end of file
+}
@@ -16,6 +16,9 @@
 //--- SDK include
 #include <fbsdk/fbsdk.h>
 
+#include <string>
+#include <unordered_map>
+
 //--- Registration defines
 #define CAMERA_LINKVIS__CLASSNAME Manager_CameraLinkVis
 #define CAMERA_LINKVIS__CLASSSTR  "Manager_CameraLinkVis"
@@ -51,6 +54,24 @@ private:
 	static FBGroup* gGroup;
 	static FBCamera* gCamera;
 
+	//
+	// name keyed index, updated from scene change events
+
+	std::unordered_map<std::string, FBGroup*>		mGroupsByName;
+	std::unordered_map<std::string, FBCamera*>		mCamerasByGroup;	//!< linked group name -> camera
+
+	bool				mGroupsDirty{ true };
+	bool				mCamerasDirty{ true };
+	bool				mHideAllLinked{ true };		//!< hide every linked group on the next camera switch
+	
+	std::string			mShownGroup;				//!< group of the current camera
+	std::string			mRenamedGroup;				//!< name of a group before rename
+
+	void RebuildGroups();
+	void RebuildCameras();
+
+	FBGroup* FindGroup(const char* groupName);
+
 	void LeaveCamera(FBCamera *pCamera);
 	void EnterCamera(FBCamera *pCamera);
 
@@ -12,6 +12,8 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include "posteffectbase.h"
 #include "postpersistentdata.h"
 
+#include <algorithm>
+
 //
 extern void LOGE(const char* pFormatString, ...);
 
@@ -43,8 +45,84 @@ void PostEffectBase::FreeShaders()
 	mShaders.clear();
 }
 
+/////////////////////////////////////////////////////////////////////////
+// UniformValueCache
+
+bool UniformValueCache::IsChanged(const GLint loc, const float* values, const int count)
+{
+	auto iter = std::find_if(begin(mEntries), end(mEntries), [loc](const Entry& entry) { return entry.location == loc; });
+	
+	if (iter != end(mEntries) && iter->count == count 
+		&& 0 == memcmp(iter->values, values, sizeof(float) * count))
+	{
+		return false;
+	}
+
+	// values that don't fit into an entry are always sent
+	if (count > MAX_ENTRY_VALUES)
+		return true;
+
+	if (iter == end(mEntries))
+	{
+		mEntries.push_back(Entry());
+		iter = std::prev(end(mEntries));
+		iter->location = loc;
+	}
+
+	iter->count = count;
+	memcpy(iter->values, values, sizeof(float) * count);
+	return true;
+}
+
+void UniformValueCache::Uniform1i(const GLint loc, const GLint value)
+{
+	// compare bits of integer value
+	float bits;
+	memcpy(&bits, &value, sizeof(float));
+
+	if (loc >= 0 && IsChanged(loc, &bits, 1))
+		glUniform1i(loc, value);
+}
+
+void UniformValueCache::Uniform1f(const GLint loc, const float value)
+{
+	if (loc >= 0 && IsChanged(loc, &value, 1))
+		glUniform1f(loc, value);
+}
+
+void UniformValueCache::Uniform2f(const GLint loc, const float x, const float y)
+{
+	const float values[2]{ x, y };
+	if (loc >= 0 && IsChanged(loc, values, 2))
+		glUniform2f(loc, x, y);
+}
+
+void UniformValueCache::Uniform4f(const GLint loc, const float x, const float y, const float z, const float w)
+{
+	const float values[4]{ x, y, z, w };
+	if (loc >= 0 && IsChanged(loc, values, 4))
+		glUniform4f(loc, x, y, z, w);
+}
+
+void UniformValueCache::Uniform4fv(const GLint loc, const GLsizei count, const float* values)
+{
+	if (loc >= 0 && IsChanged(loc, values, 4 * count))
+		glUniform4fv(loc, count, values);
+}
+
+void UniformValueCache::UniformMatrix4fv(const GLint loc, const GLsizei count, const GLboolean transpose, const float* values)
+{
+	if (loc >= 0 && IsChanged(loc, values, 16 * count))
+		glUniformMatrix4fv(loc, count, transpose, values);
+}
+
+/////////////////////////////////////////////////////////////////////////
+// CommonEffectUniforms
+
 void CommonEffectUniforms::PrepareUniformLocations(GLSLShader* shader)
 {
+	mUniformCache.Clear();
+
 	const GLint loc = shader->findLocation("maskSampler");
 	if (loc >= 0)
 		glUniform1i(loc, GetMaskSamplerSlot());
@@ -61,16 +139,9 @@ void CommonEffectUniforms::UpdateUniforms(PostPersistentData* data)
 	const double _upperClip = data->UpperClip;
 	const double _lowerClip = data->LowerClip;
 
-	if (useMaskLoc >= 0)
-		glUniform1f(useMaskLoc, (useMasking) ? 1.0f : 0.0f);
-
-	if (upperClipLoc >= 0)
-	{
-		glUniform1f(upperClipLoc, 0.01f * (float)_upperClip);
-	}
-
-	if (lowerClipLoc >= 0)
-		glUniform1f(lowerClipLoc, 1.0f - 0.01f * (float)_lowerClip);
+	mUniformCache.Uniform1f(useMaskLoc, (useMasking) ? 1.0f : 0.0f);
+	mUniformCache.Uniform1f(upperClipLoc, 0.01f * (float)_upperClip);
+	mUniformCache.Uniform1f(lowerClipLoc, 1.0f - 0.01f * (float)_lowerClip);
 }
 
 bool PostEffectBase::Load(const int shaderIndex, const char *vname, const char *fname)
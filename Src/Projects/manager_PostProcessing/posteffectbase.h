@@ -18,6 +18,7 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 
 #include <memory>
 #include <bitset>
+#include <vector>
 
 // forward
 class PostEffectBuffers;
@@ -51,6 +52,47 @@ enum class CompositionMask : uint32_t
 	// TODO:
 };
 
+/// <summary>
+/// last values sent to uniforms of one glsl program
+///  a program keeps its uniform values between binds, so an unchanged UI value is not sent again every frame
+/// </summary>
+class UniformValueCache
+{
+public:
+
+	/// <summary>
+	/// forget sent values, must be called when a program is (re)loaded
+	/// </summary>
+	void Clear() { mEntries.clear(); }
+
+	// setters must be called inside the binded glsl shader, negative locations are skipped
+
+	void Uniform1i(const GLint loc, const GLint value);
+	void Uniform1f(const GLint loc, const float value);
+	void Uniform2f(const GLint loc, const float x, const float y);
+	void Uniform4f(const GLint loc, const float x, const float y, const float z, const float w);
+	void Uniform4fv(const GLint loc, const GLsizei count, const float* values);
+	void UniformMatrix4fv(const GLint loc, const GLsizei count, const GLboolean transpose, const float* values);
+
+protected:
+
+	enum { MAX_ENTRY_VALUES = 16 };
+
+	struct Entry
+	{
+		GLint		location;
+		int			count;
+		float		values[MAX_ENTRY_VALUES];
+	};
+
+	std::vector<Entry>	mEntries;
+
+	/// <summary>
+	/// remember values for a location, returns false when they are the same as the last sent ones
+	/// </summary>
+	bool IsChanged(const GLint loc, const float* values, const int count);
+};
+
 /// <summary>
 /// uniforms needed for a common effect functionality, masking, clipping, etc.
 /// </summary>
@@ -81,6 +123,9 @@ protected:
 	GLint lowerClipLoc{ -1 };
 	GLint upperClipLoc{ -1 };
 	GLint useMaskLoc{ -1 };
+
+	// values of the effect shader, cleared in PrepareUniformLocations
+	UniformValueCache	mUniformCache;
 };
 
 struct PostEffectContext
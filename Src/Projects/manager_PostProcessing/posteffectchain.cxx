@@ -497,9 +497,8 @@ void PostEffectChain::SendPreview(PostEffectBuffers* buffers, double systime)
 		buffers->GetBufferDownscalePtr()->Bind();
 		mShaderDownscale->Bind();
 
-		GLint loc = mShaderDownscale->findLocation("texelSize");
-		if (loc >= 0)
-			glUniform2f(loc, 1.0f / (float)buffers->GetWidth(), 1.0f / (float)buffers->GetHeight());
+		if (mLocDownscaleTexelSize >= 0)
+			glUniform2f(mLocDownscaleTexelSize, 1.0f / (float)buffers->GetWidth(), 1.0f / (float)buffers->GetHeight());
 
 		drawOrthoQuad2d(buffers->GetPreviewWidth(), buffers->GetPreviewHeight());
 
@@ -720,12 +719,22 @@ bool PostEffectChain::Process(PostEffectBuffers *buffers, double systime)
 		}
 	}
 
-	// 3. in case of SSAO active, render a linear depth texture
+	// 3. in case of SSAO or flare occlusion active, render a linear depth texture
 
-	if (mSettings->SSAO)
+	PostEffectLensFlare* lensFlare = (mSettings->LensFlare) ? static_cast<PostEffectLensFlare*>(mLensFlare.get()) : nullptr;
+	const bool isFlareOcclusion = (lensFlare && lensFlare->IsDepthOcclusionRequested() && mLastCamera);
+	const bool isLinearDepth = mSettings->SSAO || isFlareOcclusion;
+
+	if (isLinearDepth)
 	{
 		RenderLinearDepth(buffers);
 	}
+
+	if (isFlareOcclusion)
+	{
+		FrameBuffer* pBufferDepth = buffers->GetBufferDepthPtr();
+		lensFlare->RenderOcclusion(pBufferDepth->GetColorObject(), pBufferDepth->GetWidth(), pBufferDepth->GetHeight());
+	}
 	
 	// 4a. blur masks (if applied)
 
@@ -900,7 +909,7 @@ bool PostEffectChain::Process(PostEffectBuffers *buffers, double systime)
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, 0);
 	}
-	if (mSettings->SSAO)
+	if (isLinearDepth)
 	{
 		glActiveTexture(GL_TEXTURE2);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -1036,6 +1045,11 @@ bool PostEffectChain::LoadShaders()
 	mVignetting.reset(ShaderFactory(SHADER_TYPE_VIGNETTE, shadersPath));
 	mFilmGrain.reset(ShaderFactory(SHADER_TYPE_FILMGRAIN, shadersPath));
 	mLensFlare.reset(ShaderFactory(SHADER_TYPE_LENSFLARE, shadersPath));
+	if (mLensFlare.get())
+	{
+		// flare still works without an occlusion test
+		static_cast<PostEffectLensFlare*>(mLensFlare.get())->LoadOcclusionShader(shadersPath);
+	}
 	mSSAO.reset(ShaderFactory(SHADER_TYPE_SSAO, shadersPath));
 	mDOF.reset(ShaderFactory(SHADER_TYPE_DOF, shadersPath));
 	mDisplacement.reset(ShaderFactory(SHADER_TYPE_DISPLACEMENT, shadersPath));
@@ -1175,6 +1189,8 @@ bool PostEffectChain::LoadShaders()
 		if (loc >= 0)
 			glUniform1i(loc, 0);
 		
+		mLocDownscaleTexelSize = pNewShader->findLocation("texelSize");
+
 		pNewShader->UnBind();
 
 		mShaderDownscale.reset(pNewShader.release());
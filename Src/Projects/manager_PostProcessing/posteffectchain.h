@@ -98,6 +98,7 @@ protected:
 	GLint							mLocBlurSharpness{ -1 };
 	GLint							mLocBlurRes{ -1 };
 	GLint							mLocImageBlurScale{ -1 };
+	GLint							mLocDownscaleTexelSize{ -1 };
 
 	bool							mNeedReloadShaders{ true };
 	bool							mIsCompressedDataReady{ false };
@@ -120,7 +121,7 @@ private:
 	bool PrepareChainOrder(int& blurAndMix, int& blurAndMix2);
 
 	/// <summary>
-	/// render a linear depth (for SSAO)
+	/// render a linear depth (for SSAO and flare occlusion)
 	/// </summary>
 	void RenderLinearDepth(PostEffectBuffers* buffers);
 
@@ -96,21 +96,21 @@ bool PostEffectColor::CollectUIValues(PostPersistentData* pData, PostEffectConte
 
 	if (mResolution >= 0)
 	{
-		glUniform2f(mResolution, static_cast<float>(effectContext.w), static_cast<float>(effectContext.h));
+		mUniformCache.Uniform2f(mResolution, static_cast<float>(effectContext.w), static_cast<float>(effectContext.h));
 	}
 
 	if (mChromaticAberration >= 0)
 	{
-		glUniform4f(mChromaticAberration, static_cast<float>(ca_dir[0]), static_cast<float>(ca_dir[1]), 0.0f, chromatic_aberration);
+		mUniformCache.Uniform4f(mChromaticAberration, static_cast<float>(ca_dir[0]), static_cast<float>(ca_dir[1]), 0.0f, chromatic_aberration);
 	}
 
 	UpdateUniforms(pData);
 
 	if (mLocCSB >= 0)
-		glUniform4f(mLocCSB, (float)contrast, (float)saturation, (float)brightness, (float)gamma);
+		mUniformCache.Uniform4f(mLocCSB, (float)contrast, (float)saturation, (float)brightness, (float)gamma);
 
 	if (mLocHue >= 0)
-		glUniform4f(mLocHue, (float)hue, (float)hueSat, (float)lightness, inverse);
+		mUniformCache.Uniform4f(mLocHue, (float)hue, (float)hueSat, (float)lightness, inverse);
 
 	mShader->UnBind();
 	return true;
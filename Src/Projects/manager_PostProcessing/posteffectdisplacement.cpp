@@ -110,25 +110,25 @@ bool PostEffectDisplacement::CollectUIValues(PostPersistentData *pData, PostEffe
 
 		// iTime
 		if (mLoc.iTime >= 0)
-			glUniform1f(mLoc.iTime, (float)_timer);
+			mUniformCache.Uniform1f(mLoc.iTime, (float)_timer);
 
 		if (mLoc.iSpeed >= 0)
-			glUniform1f(mLoc.iSpeed, (float)timerMult);
+			mUniformCache.Uniform1f(mLoc.iSpeed, (float)timerMult);
 
 		if (mLoc.useQuakeEffect >= 0)
-			glUniform1f(mLoc.useQuakeEffect, (pData->UseQuakeWaterEffect) ? 1.0f : 0.0f);
+			mUniformCache.Uniform1f(mLoc.useQuakeEffect, (pData->UseQuakeWaterEffect) ? 1.0f : 0.0f);
 
 		if (mLoc.xDistMag >= 0)
-			glUniform1f(mLoc.xDistMag, 0.0001f * (float)xdist);
+			mUniformCache.Uniform1f(mLoc.xDistMag, 0.0001f * (float)xdist);
 
 		if (mLoc.yDistMag >= 0)
-			glUniform1f(mLoc.yDistMag, 0.0001f * (float)ydist);
+			mUniformCache.Uniform1f(mLoc.yDistMag, 0.0001f * (float)ydist);
 
 		if (mLoc.xSineCycles >= 0)
-			glUniform1f(mLoc.xSineCycles, (float) xcycles);
+			mUniformCache.Uniform1f(mLoc.xSineCycles, (float) xcycles);
 
 		if (mLoc.ySineCycles >= 0)
-			glUniform1f(mLoc.ySineCycles, (float)ycycles);
+			mUniformCache.Uniform1f(mLoc.ySineCycles, (float)ycycles);
 
 		GetShaderPtr()->UnBind();
 
@@ -199,51 +199,51 @@ bool PostEffectDOF::CollectUIValues(PostPersistentData *pData, PostEffectContext
 	UpdateUniforms(pData);
 
 	if (textureWidth >= 0)
-		glUniform1f(textureWidth, (float)effectContext.w);
+		mUniformCache.Uniform1f(textureWidth, (float)effectContext.w);
 	if (textureHeight >= 0)
-		glUniform1f(textureHeight, (float)effectContext.h);
+		mUniformCache.Uniform1f(textureHeight, (float)effectContext.h);
 
 	if (focalDistance >= 0)
-		glUniform1f(focalDistance, (float)_focalDistance);
+		mUniformCache.Uniform1f(focalDistance, (float)_focalDistance);
 	if (focalRange >= 0)
-		glUniform1f(focalRange, (float)_focalRange);
+		mUniformCache.Uniform1f(focalRange, (float)_focalRange);
 	if (fstop >= 0)
-		glUniform1f(fstop, (float)_fstop);
+		mUniformCache.Uniform1f(fstop, (float)_fstop);
 
 	if (zNear>= 0)
-		glUniform1f(zNear, (float)_znear);
+		mUniformCache.Uniform1f(zNear, (float)_znear);
 	if (zFar >= 0)
-		glUniform1f(zFar, (float)_zfar);
+		mUniformCache.Uniform1f(zFar, (float)_zfar);
 
 	if (samples >= 0)
-		glUniform1i(samples, _samples);
+		mUniformCache.Uniform1i(samples, _samples);
 	if (rings >= 0)
-		glUniform1i(rings, _rings);
+		mUniformCache.Uniform1i(rings, _rings);
 
 	if (blurForeground >= 0)
-		glUniform1f(blurForeground, (float)_blurForeground);
+		mUniformCache.Uniform1f(blurForeground, (float)_blurForeground);
 
 	if (CoC >= 0)
-		glUniform1f(CoC, 0.01f * (float)_CoC);
+		mUniformCache.Uniform1f(CoC, 0.01f * (float)_CoC);
 
 	if (blurForeground >= 0)
-		glUniform1f(blurForeground, (float)_blurForeground);
+		mUniformCache.Uniform1f(blurForeground, (float)_blurForeground);
 
 	if (threshold >= 0)
-		glUniform1f(threshold, 0.01f * (float)_threshold);
+		mUniformCache.Uniform1f(threshold, 0.01f * (float)_threshold);
 	if (bias >= 0)
-		glUniform1f(bias, 0.01f * (float)_bias);
+		mUniformCache.Uniform1f(bias, 0.01f * (float)_bias);
 
 	if (fringe>= 0)
-		glUniform1f(fringe, 0.01f * (float)_fringe);
+		mUniformCache.Uniform1f(fringe, 0.01f * (float)_fringe);
 	if (feather>= 0)
-		glUniform1f(feather, 0.01f * (float)_feather);
+		mUniformCache.Uniform1f(feather, 0.01f * (float)_feather);
 
 	if (debugBlurValue >= 0)
-		glUniform1f(debugBlurValue, (float)_debugBlurValue);
+		mUniformCache.Uniform1f(debugBlurValue, (float)_debugBlurValue);
 
 	if (focusPoint >= 0)
-		glUniform4f(focusPoint, 0.01f * (float)_focusPoint[0], 0.01f * (float)_focusPoint[1], 0.0f, _useFocusPoint);
+		mUniformCache.Uniform4f(focusPoint, 0.01f * (float)_focusPoint[0], 0.01f * (float)_focusPoint[1], 0.0f, _useFocusPoint);
 
 	mShader->UnBind();
 	return true;
@@ -95,22 +95,22 @@ bool PostEffectFilmGrain::CollectUIValues(PostPersistentData* pData, PostEffectC
 	UpdateUniforms(pData);
 
 	if (textureWidth >= 0)
-		glUniform1f(textureWidth, static_cast<float>(effectContext.w));
+		mUniformCache.Uniform1f(textureWidth, static_cast<float>(effectContext.w));
 	if (textureHeight >= 0)
-		glUniform1f(textureHeight, static_cast<float>(effectContext.h));
+		mUniformCache.Uniform1f(textureHeight, static_cast<float>(effectContext.h));
 
 	if (timer >= 0)
-		glUniform1f(timer, static_cast<float>(_timer));
+		mUniformCache.Uniform1f(timer, static_cast<float>(_timer));
 	if (grainamount >= 0)
-		glUniform1f(grainamount, 0.01f * static_cast<float>(_grainamount));
+		mUniformCache.Uniform1f(grainamount, 0.01f * static_cast<float>(_grainamount));
 	if (colored >= 0)
-		glUniform1f(colored, static_cast<float>(_colored));
+		mUniformCache.Uniform1f(colored, static_cast<float>(_colored));
 	if (coloramount >= 0)
-		glUniform1f(coloramount, 0.01f * static_cast<float>(_coloramount));
+		mUniformCache.Uniform1f(coloramount, 0.01f * static_cast<float>(_coloramount));
 	if (grainsize >= 0)
-		glUniform1f(grainsize, 0.01f * static_cast<float>(_grainsize));
+		mUniformCache.Uniform1f(grainsize, 0.01f * static_cast<float>(_grainsize));
 	if (lumamount >= 0)
-		glUniform1f(lumamount, 0.01f * static_cast<float>(_lumamount));
+		mUniformCache.Uniform1f(lumamount, 0.01f * static_cast<float>(_lumamount));
 
 	mShader->UnBind();
 	return true;
@@ -84,11 +84,11 @@ bool PostEffectFishEye::CollectUIValues(PostPersistentData* pData, PostEffectCon
 	UpdateUniforms(pData);
 
 	if (mLocAmount >= 0)
-		glUniform1f(mLocAmount, 0.01f * static_cast<float>(amount));
+		mUniformCache.Uniform1f(mLocAmount, 0.01f * static_cast<float>(amount));
 	if (mLocLensRadius >= 0)
-		glUniform1f(mLocLensRadius, static_cast<float>(lensradius));
+		mUniformCache.Uniform1f(mLocLensRadius, static_cast<float>(lensradius));
 	if (mLocSignCurvature >= 0)
-		glUniform1f(mLocSignCurvature, static_cast<float>(signcurvature));
+		mUniformCache.Uniform1f(mLocSignCurvature, static_cast<float>(signcurvature));
 
 	shader->UnBind();
 	return true;
@@ -12,6 +12,7 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
 #include "math3d.h"
 
 #include "postprocessing_helper.h"
@@ -21,6 +22,193 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #define SHADER_LENSFLARE_FRAGMENT		"\\GLSL\\lensFlare.fsh" 
 #define SHADER_LENSFLARE_BUBBLE_FRAGMENT			"\\GLSL\\lensFlareBubble.fsh"
 #define SHADER_LENSFLARE_ANAMORPHIC_FRAGMENT		"\\GLSL\\lensFlareAnamorphic.fsh"
+#define SHADER_LENSFLARE_OCCLUSION_FRAGMENT			"\\GLSL\\flareOcclusion.fsh"
+
+#define FLARE_OCCLUSION_RADIUS		0.01		// radius of depth taps relative to a viewport height
+
+//
+extern void LOGE(const char* pFormatString, ...);
+
+////////////////////////////////////////////////////////////////////////////////////
+// flare occlusion query
+
+FlareOcclusionQuery::~FlareOcclusionQuery()
+{
+	Free();
+}
+
+bool FlareOcclusionQuery::Load(const char* vname, const char* fname)
+{
+	Free();
+
+	std::unique_ptr<GLSLShader> pNewShader(new GLSLShader);
+
+	if (!pNewShader->LoadShaders(vname, fname))
+	{
+		LOGE("Post Effect Chain (%s, %s) ERROR: failed to load flare occlusion shader\n", vname, fname);
+		return false;
+	}
+
+	// samplers and locations
+	pNewShader->Bind();
+
+	const GLint loc = pNewShader->findLocation("linearDepthSampler");
+	if (loc >= 0)
+		glUniform1i(loc, 0);
+
+	mLocLights = pNewShader->findLocation("lights");
+	mLocTapScale = pNewShader->findLocation("tapScale");
+
+	pNewShader->UnBind();
+
+	mShader.reset(pNewShader.release());
+	return true;
+}
+
+void FlareOcclusionQuery::Free()
+{
+	mShader.reset(nullptr);
+	mBuffer.reset(nullptr);
+
+	if (mPBOs[0] > 0)
+	{
+		glDeleteBuffers(2, mPBOs);
+		mPBOs[0] = mPBOs[1] = 0;
+	}
+
+	for (int i = 0; i < 2; ++i)
+	{
+		if (mFences[i])
+		{
+			glDeleteSync(mFences[i]);
+			mFences[i] = nullptr;
+		}
+		mReadCount[i] = 0;
+	}
+
+	mNumberOfLights = 0;
+	mNumberOfResults = 0;
+}
+
+void FlareOcclusionQuery::BeginLights()
+{
+	mNumberOfLights = 0;
+}
+
+void FlareOcclusionQuery::AddLight(const double x, const double y, const double depth)
+{
+	if (mNumberOfLights >= MAX_NUMBER_OF_LIGHTS)
+		return;
+
+	float* light = mLights + 4 * mNumberOfLights;
+	light[0] = static_cast<float>(x);
+	light[1] = static_cast<float>(y);
+	light[2] = static_cast<float>(depth);
+	light[3] = 0.0f;
+
+	mNumberOfLights += 1;
+}
+
+void FlareOcclusionQuery::Render(const GLuint linearDepthId, const int w, const int h)
+{
+	if (!IsReady() || mNumberOfLights == 0 || w <= 0 || h <= 0)
+		return;
+
+	if (!mBuffer.get())
+	{
+		mBuffer.reset(new FrameBuffer(1, 1, FrameBuffer::eCreateColorTexture | FrameBuffer::eDeleteFramebufferOnCleanup | FrameBuffer::eSaveViewport));
+		mBuffer->SetColorFormat(0, GL_RED);
+		mBuffer->SetColorInternalFormat(0, GL_R32F);
+		mBuffer->SetColorType(0, GL_FLOAT);
+		mBuffer->SetFilter(0, FrameBuffer::filterNearest);
+		mBuffer->SetClamp(0, GL_CLAMP_TO_EDGE);
+
+		if (!mBuffer->ReSize(MAX_NUMBER_OF_LIGHTS, 1))
+		{
+			mBuffer.reset(nullptr);
+			return;
+		}
+	}
+
+	if (0 == mPBOs[0])
+	{
+		glGenBuffers(2, mPBOs);
+
+		for (int i = 0; i < 2; ++i)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBOs[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float) * MAX_NUMBER_OF_LIGHTS, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	// a pending readback in this slot is too old already, drop it
+	mCurPBO = 1 - mCurPBO;
+
+	if (mFences[mCurPBO])
+	{
+		glDeleteSync(mFences[mCurPBO]);
+		mFences[mCurPBO] = nullptr;
+	}
+
+	const float radius = static_cast<float>(FLARE_OCCLUSION_RADIUS);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, linearDepthId);
+
+	mBuffer->Bind();
+	mShader->Bind();
+
+	if (mLocLights >= 0)
+		glUniform4fv(mLocLights, mNumberOfLights, mLights);
+	if (mLocTapScale >= 0)
+		glUniform4f(mLocTapScale, radius * static_cast<float>(h) / static_cast<float>(w), radius, 0.0f, 0.0f);
+
+	drawOrthoQuad2d(mNumberOfLights, 1);
+
+	mShader->UnBind();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBOs[mCurPBO]);
+	glReadPixels(0, 0, mNumberOfLights, 1, GL_RED, GL_FLOAT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	mBuffer->UnBind();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	mFences[mCurPBO] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mReadCount[mCurPBO] = mNumberOfLights;
+}
+
+void FlareOcclusionQuery::FetchResults()
+{
+	// older readback first, so a newer finished one wins
+	for (int i = 1; i <= 2; ++i)
+	{
+		const int slot = (mCurPBO + i) % 2;
+
+		if (nullptr == mFences[slot])
+			continue;
+
+		const GLenum status = glClientWaitSync(mFences[slot], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBOs[slot]);
+		glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(float) * mReadCount[slot], mVisibility);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		mNumberOfResults = mReadCount[slot];
+
+		glDeleteSync(mFences[slot]);
+		mFences[slot] = nullptr;
+	}
+}
+
+float FlareOcclusionQuery::GetVisibility(const int index) const
+{
+	return (index >= 0 && index < mNumberOfResults) ? mVisibility[index] : 1.0f;
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -114,6 +302,24 @@ bool PostEffectLensFlare::SubShader::PrepUniforms(GLSLShader* mShader)
 	return lSuccess;
 }
 
+bool PostEffectLensFlare::LoadOcclusionShader(const char* shadersLocation)
+{
+	const FBString vertex_path(shadersLocation, SHADER_LENSFLARE_VERTEX);
+	const FBString fragment_path(shadersLocation, SHADER_LENSFLARE_OCCLUSION_FRAGMENT);
+
+	return mOcclusion.Load(vertex_path, fragment_path);
+}
+
+bool PostEffectLensFlare::IsDepthOcclusionRequested() const
+{
+	return mOcclusion.IsReady() && mOcclusion.GetNumberOfLights() > 0;
+}
+
+void PostEffectLensFlare::RenderOcclusion(const GLuint linearDepthId, const int w, const int h)
+{
+	mOcclusion.Render(linearDepthId, w, h);
+}
+
 bool PostEffectLensFlare::CollectUIValues(PostPersistentData *pData, PostEffectContext& effectContext)
 {
 	mCurrentShader = pData->FlareType.AsInt();
@@ -125,10 +331,15 @@ bool PostEffectLensFlare::CollectUIValues(PostPersistentData *pData, PostEffectC
 		pData->FlareType.SetData((void*) &newFlareType);
 	}
 	
-	return subShaders[mCurrentShader].CollectUIValues(mCurrentShader, GetShaderPtr(), pData, effectContext);
+	// results of a previous frame test and a new list of lights to test
+	mOcclusion.FetchResults();
+	mOcclusion.BeginLights();
+
+	FlareOcclusionQuery* occlusion = (mOcclusion.IsReady()) ? &mOcclusion : nullptr;
+	return subShaders[mCurrentShader].CollectUIValues(mCurrentShader, GetShaderPtr(), pData, effectContext, occlusion);
 }
 
-bool PostEffectLensFlare::SubShader::CollectUIValues(const int shaderIndex, GLSLShader* mShader, PostPersistentData *pData, PostEffectContext& effectContext)
+bool PostEffectLensFlare::SubShader::CollectUIValues(const int shaderIndex, GLSLShader* mShader, PostPersistentData *pData, PostEffectContext& effectContext, FlareOcclusionQuery* occlusion)
 {
 	m_NumberOfPasses = 1;
 	bool lSuccess = false;
@@ -159,7 +370,7 @@ bool PostEffectLensFlare::SubShader::CollectUIValues(const int shaderIndex, GLSL
 
 	if (pData->UseFlareLightObject && pData->FlareLight.GetCount() > 0)
 	{
-		ProcessLightObjects(pData, effectContext.camera, effectContext.w, effectContext.h, effectContext.sysTimeDT, systemTime, flarePos);
+		ProcessLightObjects(pData, effectContext.camera, effectContext.w, effectContext.h, effectContext.sysTimeDT, systemTime, flarePos, occlusion);
 	}
 	else
 	{
@@ -183,19 +394,20 @@ bool PostEffectLensFlare::SubShader::CollectUIValues(const int shaderIndex, GLSL
 	return lSuccess;
 }
 
-void PostEffectLensFlare::SubShader::ProcessLightObjects(PostPersistentData* pData, FBCamera* pCamera, int w, int h, double dt, FBTime systemTime, double* flarePos)
+void PostEffectLensFlare::SubShader::ProcessLightObjects(PostPersistentData* pData, FBCamera* pCamera, int w, int h, double dt, FBTime systemTime, double* flarePos, FlareOcclusionQuery* occlusion)
 {
 	m_NumberOfPasses = pData->FlareLight.GetCount();
 	m_LightPositions.resize(m_NumberOfPasses);
 	m_LightColors.resize(m_NumberOfPasses);
 	m_LightAlpha.resize(m_NumberOfPasses, 0.0f);
 
-	FBMatrix mvp;
+	FBMatrix mvp, mv;
 	pCamera->GetCameraMatrix(mvp, kFBModelViewProj);
+	pCamera->GetCameraMatrix(mv, kFBModelView);
 
 	for (int i = 0; i < m_NumberOfPasses; ++i)
 	{
-		ProcessSingleLight(pData, pCamera, mvp, i, w, h, dt, flarePos);
+		ProcessSingleLight(pData, pCamera, mvp, mv, i, w, h, dt, flarePos, occlusion);
 	}
 
 	// relative coords to a screen size
@@ -203,7 +415,7 @@ void PostEffectLensFlare::SubShader::ProcessLightObjects(PostPersistentData* pDa
 	pData->FlarePosY = 100.0 * flarePos[1];
 }
 
-void PostEffectLensFlare::SubShader::ProcessSingleLight(PostPersistentData* pData, FBCamera* pCamera, FBMatrix& mvp, int index, int w, int h, double dt, double* flarePos)
+void PostEffectLensFlare::SubShader::ProcessSingleLight(PostPersistentData* pData, FBCamera* pCamera, FBMatrix& mvp, FBMatrix& mv, int index, int w, int h, double dt, double* flarePos, FlareOcclusionQuery* occlusion)
 {
 	FBLight* pLight = static_cast<FBLight*>(pData->FlareLight.GetAt(index));
 
@@ -223,44 +435,26 @@ void PostEffectLensFlare::SubShader::ProcessSingleLight(PostPersistentData* pDat
 	m_LightPositions[index].Set(flarePos);
 	FBColor color(pLight->DiffuseColor);
 
-	bool isFading = false;
+	// visible fraction of the light from a scene depth test, the result comes on a next frame
+	float visibility = 1.0f;
 
-	if (pData->LensFlare_UseOcclusion && pData->FlareOcclusionObjects.GetCount() > 0)
+	if (occlusion && pData->LensFlare_UseOcclusion)
 	{
-		const int offsetX = pCamera->CameraViewportX;
-		const int offsetY = pCamera->CameraViewportY;
+		FBVector4d eyePos;
+		FBVectorMatrixMult(eyePos, mv, FBVector4d(lightPos[0], lightPos[1], lightPos[2], 1.0));
 
-		const int x = offsetX + static_cast<int>(v4[0]);
-		const int y = offsetY + (h - static_cast<int>(v4[1]));
-
-		FBVector3d camPosition;
-		pCamera->GetVector(camPosition);
-		double distToLight = VectorLength(VectorSubtract(lightPos, camPosition));
-
-		for (int i = 0, count = pData->FlareOcclusionObjects.GetCount(); i < count; ++i)
-		{
-			if (FBModel* model = FBCast<FBModel>(pData->FlareOcclusionObjects.GetAt(i)))
-			{
-				FBVector3d hitPosition, hitNormal;
-				if (model->RayCast(pCamera, x, y, hitPosition, hitNormal))
-				{
-					const double distToHit = VectorLength(VectorSubtract(hitPosition, camPosition));
-
-					if (distToHit < distToLight)
-					{
-						isFading = true;
-						break;
-					}
-				}
-			}
-
-		}
+		// lights are added in the same order, so query index is a light index
+		occlusion->AddLight(flarePos[0], flarePos[1], -eyePos[2]);
+		visibility = occlusion->GetVisibility(index);
 	}
 
 	float alpha = m_LightAlpha[index];
 	double occSpeed = 100.0;
 	pData->FlareOcclusionSpeed.GetData(&occSpeed, sizeof(double));
-	alpha += static_cast<float>(occSpeed) * ((isFading) ? -dt : dt);
+	
+	// fade toward the visible fraction
+	const float fadeStep = static_cast<float>(occSpeed * dt);
+	alpha = (alpha < visibility) ? std::min(alpha + fadeStep, visibility) : std::max(alpha - fadeStep, visibility);
 	alpha = clamp01(alpha);
 
 	const double f = smoothstep(0.0, 1.0, static_cast<double>(alpha));
@@ -278,18 +472,18 @@ void PostEffectLensFlare::SubShader::UpdateShaderUniforms(GLSLShader* mShader, P
 	FBColor& flareTint, double flareInner, double flareOuter, float fadeToBordersValue, double borderWidthValue, double featherValue)
 {
 	// Update all shader uniforms here
-	if (seed >= 0) glUniform1f(seed, static_cast<float>(seedValue));
-	if (amount >= 0) glUniform1f(amount, 0.01f * static_cast<float>(flareAmount));
-	if (textureWidth >= 0) glUniform1f(textureWidth, static_cast<float>(w));
-	if (textureHeight >= 0) glUniform1f(textureHeight, static_cast<float>(h));
-	if (timer >= 0) glUniform1f(timer, static_cast<float>(flareTimer));
-	if (light_pos >= 0) glUniform4f(light_pos, static_cast<float>(flarePos[0]), static_cast<float>(flarePos[1]), static_cast<float>(flarePos[2]), 0.0f);
-	if (tint >= 0) glUniform4f(tint, static_cast<float>(flareTint[0]), static_cast<float>(flareTint[1]), static_cast<float>(flareTint[2]), 1.0f);
-	if (inner >= 0) glUniform1f(inner, 0.01f * static_cast<float>(flareInner));
-	if (outer >= 0) glUniform1f(outer, 0.01f * static_cast<float>(flareOuter));
-	if (fadeToBorders >= 0) glUniform1f(fadeToBorders, fadeToBordersValue);
-	if (borderWidth >= 0) glUniform1f(borderWidth, static_cast<float>(borderWidthValue));
-	if (feather >= 0) glUniform1f(feather, 0.01f * static_cast<float>(featherValue));
+	if (seed >= 0) mUniformCache.Uniform1f(seed, static_cast<float>(seedValue));
+	if (amount >= 0) mUniformCache.Uniform1f(amount, 0.01f * static_cast<float>(flareAmount));
+	if (textureWidth >= 0) mUniformCache.Uniform1f(textureWidth, static_cast<float>(w));
+	if (textureHeight >= 0) mUniformCache.Uniform1f(textureHeight, static_cast<float>(h));
+	if (timer >= 0) mUniformCache.Uniform1f(timer, static_cast<float>(flareTimer));
+	if (light_pos >= 0) mUniformCache.Uniform4f(light_pos, static_cast<float>(flarePos[0]), static_cast<float>(flarePos[1]), static_cast<float>(flarePos[2]), 0.0f);
+	if (tint >= 0) mUniformCache.Uniform4f(tint, static_cast<float>(flareTint[0]), static_cast<float>(flareTint[1]), static_cast<float>(flareTint[2]), 1.0f);
+	if (inner >= 0) mUniformCache.Uniform1f(inner, 0.01f * static_cast<float>(flareInner));
+	if (outer >= 0) mUniformCache.Uniform1f(outer, 0.01f * static_cast<float>(flareOuter));
+	if (fadeToBorders >= 0) mUniformCache.Uniform1f(fadeToBorders, fadeToBordersValue);
+	if (borderWidth >= 0) mUniformCache.Uniform1f(borderWidth, static_cast<float>(borderWidthValue));
+	if (feather >= 0) mUniformCache.Uniform1f(feather, 0.01f * static_cast<float>(featherValue));
 
 }
 
@@ -309,10 +503,10 @@ bool PostEffectLensFlare::SubShader::PrepPass(GLSLShader* mShader, const int pas
 	if (light_pos >= 0 && pass < static_cast<int>(m_LightPositions.size()))
 	{
 		const FBVector3d pos(m_LightPositions[pass]);
-		glUniform4f(light_pos, static_cast<float>(pos[0]), static_cast<float>(pos[1]), static_cast<float>(pos[2]), m_DepthAttenuation);
+		mUniformCache.Uniform4f(light_pos, static_cast<float>(pos[0]), static_cast<float>(pos[1]), static_cast<float>(pos[2]), m_DepthAttenuation);
 
 		const FBColor _tint(m_LightColors[pass]);
-		glUniform4f(tint, (float)_tint[0], (float)_tint[1], (float)_tint[2], 1.0f);
+		mUniformCache.Uniform4f(tint, (float)_tint[0], (float)_tint[1], (float)_tint[2], 1.0f);
 		return true;
 	}
 	return false;
@@ -16,6 +16,58 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 // forward
 class PostPersistentData;
 
+/// <summary>
+/// visibility of flare lights against a scene depth
+///  a multi-tap test on a linear depth is rendered into a tiny buffer and read back asynchronously on a next frame
+/// </summary>
+class FlareOcclusionQuery
+{
+public:
+	static const int MAX_NUMBER_OF_LIGHTS{ 16 };
+
+	FlareOcclusionQuery() = default;
+	~FlareOcclusionQuery();
+
+	bool Load(const char* vname, const char* fname);
+	void Free();
+
+	bool IsReady() const { return nullptr != mShader.get(); }
+
+	/// start a new list of lights for the next query
+	void BeginLights();
+	/// x, y - relative window position, depth - linear depth of the light, light index is an order of adding
+	void AddLight(const double x, const double y, const double depth);
+	int GetNumberOfLights() const { return mNumberOfLights; }
+
+	/// render visibility of added lights from a linear depth texture and request a readback
+	void Render(const GLuint linearDepthId, const int w, const int h);
+
+	/// copy results of a finished readback, never waits for GPU
+	void FetchResults();
+
+	/// visibility fraction [0; 1] from the last fetched result, 1 when there is no result for the light yet
+	float GetVisibility(const int index) const;
+
+private:
+	std::unique_ptr<GLSLShader>		mShader;
+	std::unique_ptr<FrameBuffer>	mBuffer;	//!< one texel per light
+
+	GLint		mLocLights{ -1 };
+	GLint		mLocTapScale{ -1 };
+
+	int			mNumberOfLights{ 0 };
+	float		mLights[MAX_NUMBER_OF_LIGHTS * 4];
+
+	// double buffered readback
+	GLuint		mPBOs[2]{ 0, 0 };
+	GLsync		mFences[2]{ nullptr, nullptr };
+	int			mReadCount[2]{ 0, 0 };
+	int			mCurPBO{ 0 };
+
+	int			mNumberOfResults{ 0 };
+	float		mVisibility[MAX_NUMBER_OF_LIGHTS];
+};
+
 /// <summary>
 /// lens flare post processing effect
 /// </summary>
@@ -42,10 +94,21 @@ public:
 	virtual const int GetNumberOfPasses() const override;
 	virtual bool PrepPass(const int pass) override;
 
+	/// load a shader for the flare lights occlusion test
+	bool LoadOcclusionShader(const char* shadersLocation);
+
+	/// true when flare lights of a current frame wait for an occlusion test
+	bool IsDepthOcclusionRequested() const;
+
+	/// test flare lights against a linear depth, visibility is used by the flare on a next frame
+	void RenderOcclusion(const GLuint linearDepthId, const int w, const int h);
+
 protected:
 
 	//Louis
 	EFlareType		FlareType{ EFlareType::flare1 };
+
+	FlareOcclusionQuery		mOcclusion;
 	
 	// shader locations
 
@@ -97,13 +160,13 @@ protected:
 
 		void Init();
 		bool PrepUniforms(GLSLShader* mShader);
-		bool CollectUIValues(const int shaderIndex, GLSLShader* mShader, PostPersistentData *pData, PostEffectContext& effectContext);
+		bool CollectUIValues(const int shaderIndex, GLSLShader* mShader, PostPersistentData *pData, PostEffectContext& effectContext, FlareOcclusionQuery* occlusion);
 		bool PrepPass(GLSLShader* mShader, const int pass);
 
 	private:
-		void ProcessLightObjects(PostPersistentData* pData, FBCamera* pCamera, int w, int h, double dt, FBTime systemTime, double* flarePos);
+		void ProcessLightObjects(PostPersistentData* pData, FBCamera* pCamera, int w, int h, double dt, FBTime systemTime, double* flarePos, FlareOcclusionQuery* occlusion);
 
-		void ProcessSingleLight(PostPersistentData* pData, FBCamera* pCamera, FBMatrix& mvp, int index, int w, int h, double dt, double* flarePos);
+		void ProcessSingleLight(PostPersistentData* pData, FBCamera* pCamera, FBMatrix& mvp, FBMatrix& mv, int index, int w, int h, double dt, double* flarePos, FlareOcclusionQuery* occlusion);
 
 		void UpdateShaderUniforms(GLSLShader* mShader, PostPersistentData* pData, int w, int h, 
 			double seedValue, double flareAmount, double flareTimer, double* flarePos, 
@@ -188,32 +188,32 @@ bool PostEffectMotionBlur::CollectUIValues(PostPersistentData *pData, PostEffect
 		mShader->Bind();
 
 		if (mLoc.zNear >= 0)
-			glUniform1f(mLoc.zNear, znear);
+			mUniformCache.Uniform1f(mLoc.zNear, znear);
 		if (mLoc.zFar >= 0)
-			glUniform1f(mLoc.zFar, zfar);
+			mUniformCache.Uniform1f(mLoc.zFar, zfar);
 
 		UpdateUniforms(pData);
 
 		if (mLoc.clipInfo >= 0)
-			glUniform4fv(mLoc.clipInfo, 1, clipInfo);
+			mUniformCache.Uniform4fv(mLoc.clipInfo, 1, clipInfo);
 
 		// proj
 		if (mLoc.projInfo >= 0)
-			glUniform4fv(mLoc.projInfo, 1, projInfo);
+			mUniformCache.Uniform4fv(mLoc.projInfo, 1, projInfo);
 		if (mLoc.projOrtho >= 0)
-			glUniform1i(mLoc.projOrtho, projOrtho);
+			mUniformCache.Uniform1i(mLoc.projOrtho, projOrtho);
 
 		// matrices
 		if (mLoc.uInverseModelViewMat >= 0)
-			glUniformMatrix4fv(mLoc.uInverseModelViewMat, 1, GL_FALSE, fInvModelView);
+			mUniformCache.UniformMatrix4fv(mLoc.uInverseModelViewMat, 1, GL_FALSE, fInvModelView);
 		if (mLoc.uPrevModelViewProj >= 0)
-			glUniformMatrix4fv(mLoc.uPrevModelViewProj, 1, GL_FALSE, fprevModelViewProj);
+			mUniformCache.UniformMatrix4fv(mLoc.uPrevModelViewProj, 1, GL_FALSE, fprevModelViewProj);
 
 		// resolution
 		if (mLoc.InvQuarterResolution >= 0)
-			glUniform2f(mLoc.InvQuarterResolution, 1.0f / float(quarterWidth), 1.0f / float(quarterHeight));
+			mUniformCache.Uniform2f(mLoc.InvQuarterResolution, 1.0f / float(quarterWidth), 1.0f / float(quarterHeight));
 		if (mLoc.InvFullResolution >= 0)
-			glUniform2f(mLoc.InvFullResolution, 1.0f / float(effectContext.w), 1.0f / float(effectContext.h));
+			mUniformCache.Uniform2f(mLoc.InvFullResolution, 1.0f / float(effectContext.w), 1.0f / float(effectContext.h));
 
 		int localFrame = effectContext.localFrame; 
 		
@@ -226,7 +226,7 @@ bool PostEffectMotionBlur::CollectUIValues(PostPersistentData *pData, PostEffect
 			{
 				float dt = static_cast<float>(effectContext.localTimeDT);
 				dt *= 0.01f * (float)_amount;
-				glUniform1f(mLoc.dt, dt);
+				mUniformCache.Uniform1f(mLoc.dt, dt);
 			}
 
 			mLastLocalFrame = effectContext.localFrame;
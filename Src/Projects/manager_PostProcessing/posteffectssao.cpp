@@ -221,41 +221,41 @@ bool PostEffectSSAO::CollectUIValues(PostPersistentData *pData, PostEffectContex
 	UpdateUniforms(pData);
 
 	if (mLoc.clipInfo >= 0)
-		glUniform4fv(mLoc.clipInfo, 1, clipInfo);
+		mUniformCache.Uniform4fv(mLoc.clipInfo, 1, clipInfo);
 
 	if (mLoc.OnlyAO >= 0)
-		glUniform1f(mLoc.OnlyAO, (float)onlyAO);
+		mUniformCache.Uniform1f(mLoc.OnlyAO, (float)onlyAO);
 
 	// proj
 	if (mLoc.projInfo >= 0)
-		glUniform4fv(mLoc.projInfo, 1, projInfo);
+		mUniformCache.Uniform4fv(mLoc.projInfo, 1, projInfo);
 	if (mLoc.projOrtho >= 0)
-		glUniform1i(mLoc.projOrtho, projOrtho);
+		mUniformCache.Uniform1i(mLoc.projOrtho, projOrtho);
 
 	// pass radius
 	if (mLoc.RadiusToScreen >= 0)
-		glUniform1f(mLoc.RadiusToScreen, (float)RadiusToScreen);
+		mUniformCache.Uniform1f(mLoc.RadiusToScreen, (float)RadiusToScreen);
 	if (mLoc.R2 >= 0)
-		glUniform1f(mLoc.R2, (float)R2);
+		mUniformCache.Uniform1f(mLoc.R2, (float)R2);
 	if (mLoc.NegInvR2 >= 0)
-		glUniform1f(mLoc.NegInvR2, (float)negInvR2);
+		mUniformCache.Uniform1f(mLoc.NegInvR2, (float)negInvR2);
 
 	// ao
 	if (mLoc.PowExponent >= 0)
-		glUniform1f(mLoc.PowExponent, intensity);
+		mUniformCache.Uniform1f(mLoc.PowExponent, intensity);
 	if (mLoc.NDotVBias >= 0)
-		glUniform1f(mLoc.NDotVBias, bias);
+		mUniformCache.Uniform1f(mLoc.NDotVBias, bias);
 	if (mLoc.AOMultiplier >= 0)
-		glUniform1f(mLoc.AOMultiplier, aoMult);
+		mUniformCache.Uniform1f(mLoc.AOMultiplier, aoMult);
 
 	// resolution
 	if (mLoc.InvQuarterResolution >= 0)
-		glUniform2f(mLoc.InvQuarterResolution, 1.0f / float(quarterWidth), 1.0f / float(quarterHeight));
+		mUniformCache.Uniform2f(mLoc.InvQuarterResolution, 1.0f / float(quarterWidth), 1.0f / float(quarterHeight));
 	if (mLoc.InvFullResolution >= 0)
-		glUniform2f(mLoc.InvFullResolution, 1.0f / float(effectContext.w), 1.0f / float(effectContext.h));
+		mUniformCache.Uniform2f(mLoc.InvFullResolution, 1.0f / float(effectContext.w), 1.0f / float(effectContext.h));
 
 	if (mLoc.hbaoRandom >= 0)
-		glUniform4fv(mLoc.hbaoRandom, 1, mRandom);
+		mUniformCache.Uniform4fv(mLoc.hbaoRandom, 1, mRandom);
 
 	mShader->UnBind();
 	return true;
@@ -85,13 +85,13 @@ bool PostEffectVignetting::CollectUIValues(PostPersistentData* pData, PostEffect
 	UpdateUniforms(pData);
 
 	if (mLocAmount >= 0)
-		glUniform1f(mLocAmount, 0.01f * static_cast<float>(amount));
+		mUniformCache.Uniform1f(mLocAmount, 0.01f * static_cast<float>(amount));
 	if (mLocVignOut >= 0)
-		glUniform1f(mLocVignOut, 0.01f * static_cast<float>(vignout));
+		mUniformCache.Uniform1f(mLocVignOut, 0.01f * static_cast<float>(vignout));
 	if (mLocVignIn >= 0)
-		glUniform1f(mLocVignIn, 0.01f * static_cast<float>(vignin));
+		mUniformCache.Uniform1f(mLocVignIn, 0.01f * static_cast<float>(vignin));
 	if (mLocVignFade >= 0)
-		glUniform1f(mLocVignFade, static_cast<float>(vignfade));
+		mUniformCache.Uniform1f(mLocVignFade, static_cast<float>(vignfade));
 
 	mShader->UnBind();
 	return true;
@@ -393,7 +393,6 @@ void PostPersistentData::AddPropertiesToPropertyViewManager()
 	AddPropertyView("Flare Use Masking", "Lens Flare Setup");
 	AddPropertyView("Flare Masking Channel", "Lens Flare Setup");
 	AddPropertyView("Flare Use Occlusion", "Lens Flare Setup");
-	AddPropertyView("Flare Occlusion Objects", "Lens Flare Setup");
 	AddPropertyView("Flare Occlusion Speed", "Lens Flare Setup");
 
 	//Louis 
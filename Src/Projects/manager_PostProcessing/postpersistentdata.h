@@ -192,7 +192,7 @@ public: // PROPERTIES
 
 	FBPropertyBool				LensFlare_UseOcclusion; //!< fade out lens flare in case there is some geometry in front
 	FBPropertyAnimatableDouble		FlareOcclusionSpeed; //!< a multiplier to a time we spend to fade in or out the flare effect from geometry occlusion
-	FBPropertyListObject			FlareOcclusionObjects; //!< models that are taken part in occlusion culling process
+	FBPropertyListObject			FlareOcclusionObjects; //!< not used, kept for old scenes, flare occlusion is tested against a scene depth
 
 	//Louis
 	FBPropertyBaseEnum<EFlareType>	FlareType;
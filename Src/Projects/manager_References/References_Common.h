@@ -49,6 +49,9 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #define ACTION_CHANGEPATH		"\\MBFileRefAdvanced\\ActionChangePath.py"
 #define ACTION_CHANGEPATH_TEMP	"\\ActionChangePathTemp.py"
 
+// queued load / unload / reload actions of one idle tick
+#define ACTION_BATCH_TEMP		"\\ActionBatchTemp.py"
+
 /////////////////////////////////////////////////////////////
 
 const char *GetActionPath();
@@ -20,6 +20,8 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include <string.h>
 #include <sstream>
 #include <vector>
+#include <map>
+#include <sys/stat.h>
 
 //--- Registration defines
 #define REFERENCES_MANAGER__CLASS REFERENCES_MANAGER__CLASSNAME
@@ -36,44 +38,165 @@ static bool gSkipPlugData = false;
 
 /////////////////////////////////////////////////////
 
-bool ReplaceScriptNS(const char *scriptpath, const char *ns, const char *outpath, const char *arg1 = nullptr)
+////////////////////////////////////////////////////////////////////////////////////////
+// action scripts are kept in memory and re-read only when a file on disk is changed
+
+struct ActionScript
 {
-	const char *ctrlline = "lRefName = ''";
-	const char *argline = "lArg1 = ''";
+	std::vector<std::string>	lines;
+	time_t						modified{ 0 };
+};
+
+static std::map<std::string, ActionScript>	gActionScripts;
+
+const ActionScript *GetActionScript(const char *scriptpath)
+{
+	struct stat fileStat;
+	if (0 != stat(scriptpath, &fileStat))
+		return nullptr;
+
+	ActionScript &script = gActionScripts[scriptpath];
+	if (script.modified == fileStat.st_mtime && script.lines.size() > 0)
+		return &script;
 
-	// read
 	std::ifstream ifs(scriptpath, std::ifstream::in);
 
 	if (false == ifs.is_open())
-		return false;
+	{
+		gActionScripts.erase(scriptpath);
+		return nullptr;
+	}
 
-	std::ofstream ofs(outpath, std::ifstream::out);
-
-	if (false == ofs.is_open())
-		return false;
+	script.lines.clear();
+	script.modified = fileStat.st_mtime;
 
 	std::string readout;
 	while (std::getline(ifs, readout))
 	{
+		script.lines.push_back(readout);
+	}
+
+	ifs.close();
+	return &script;
+}
+
+// put a namespace (and an optional argument) into a script text
+bool SubstituteScriptNS(std::string &text, const char *scriptpath, const char *ns, const char *arg1 = nullptr)
+{
+	const char *ctrlline = "lRefName = ''";
+	const char *argline = "lArg1 = ''";
+
+	const ActionScript *script = GetActionScript(scriptpath);
+	if (nullptr == script)
+		return false;
+
+	for (auto iter = begin(script->lines); iter != end(script->lines); ++iter)
+	{
+		const std::string &readout = *iter;
+
 		if (nullptr != strstr(readout.c_str(), ctrlline))
 		{
-			readout = "lRefName = '" + std::string(ns) + "'";
+			text.append("lRefName = '" + std::string(ns) + "'");
 		}
 		else if (nullptr != arg1 && nullptr != strstr(readout.c_str(), argline))
 		{
-			readout = "lArg1 = '" + std::string(arg1) + "'";
+			text.append("lArg1 = '" + std::string(arg1) + "'");
+		}
+		else
+		{
+			text.append(readout);
 		}
+		text.append("\n");
+	}
+
+	return true;
+}
 
-		ofs.write(readout.c_str(), readout.size());
-		ofs << "\n";
+bool ReplaceScriptNS(const char *scriptpath, const char *ns, const char *outpath, const char *arg1 = nullptr)
+{
+	std::string text;
+	if (false == SubstituteScriptNS(text, scriptpath, ns, arg1))
+		return false;
+
+	std::ofstream ofs(outpath, std::ifstream::out);
+
+	if (false == ofs.is_open())
+		return false;
+
+	ofs.write(text.c_str(), text.size());
+	ofs.close();
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// ActionScriptBatch
+
+// quoted python string literal
+static void AppendPythonString(std::string &out, const char *text)
+{
+	out.push_back('\'');
+	for (const char *c = text; *c != 0; ++c)
+	{
+		switch (*c)
+		{
+		case '\\': out.append("\\\\"); break;
+		case '\'': out.append("\\'"); break;
+		case '\n': out.append("\\n"); break;
+		case '\r': break;
+		default: out.push_back(*c);
+		}
 	}
+	out.push_back('\'');
+}
 
-	ifs.close();
+bool ActionScriptBatch::Add(const char *scriptpath, const char *ns, const char *arg1)
+{
+	std::string text;
+	if (false == SubstituteScriptNS(text, scriptpath, ns, arg1))
+		return false;
+
+	// every action goes as a string literal, it's compiled and executed with own globals
+	//  so actions don't share variables the same way as separate script executions
+	mText.append("(");
+	AppendPythonString(mText, scriptpath);
+	mText.append(", ");
+	AppendPythonString(mText, text.c_str());
+	mText.append("),\n");
+
+	mCount += 1;
+	return true;
+}
+
+bool ActionScriptBatch::Write(const char *outpath) const
+{
+	std::ofstream ofs(outpath, std::ifstream::out);
+
+	if (false == ofs.is_open())
+		return false;
+
+	ofs << "# -*- coding: utf-8 -*-\n";
+	ofs << "# queued file reference actions, generated by ReferencesManager\n";
+	ofs << "import traceback\n";
+	ofs << "lActions = [\n";
+	ofs.write(mText.c_str(), mText.size());
+	ofs << "]\n";
+	ofs << "for lActionPath, lActionText in lActions:\n";
+	ofs << "    try:\n";
+	ofs << "        exec(compile(lActionText, lActionPath, 'exec'), {'__name__': '__main__', '__file__': lActionPath})\n";
+	ofs << "    except Exception:\n";
+	ofs << "        traceback.print_exc()\n";
 	ofs.close();
 
 	return true;
 }
 
+void ActionScriptBatch::Clear()
+{
+	mText.clear();
+	mCount = 0;
+}
+
 void EnterSkipPlugData()
 {
 	gSkipPlugData = true;
@@ -169,73 +292,55 @@ void ReferencesManager::OnUIIdle(HISender pSender, HKEvent pEvent)
 	{
 		EnterSkipPlugData();
 
-		if (mVectorReload.size() > 0)
-		{
-			for (auto iter = begin(mVectorReload); iter != end(mVectorReload); ++iter)
-			{
-				FBFileReference *pref = *iter;
-				
-				FBString scriptPath(GetActionPath(), ACTION_RELOAD);
-				FBString outPath(GetSystemTempPath(), ACTION_RELOAD_TEMP);
+		FBString reloadPath(GetActionPath(), ACTION_RELOAD);
+		FBString unloadPath(GetActionPath(), ACTION_UNLOAD);
+		FBString loadPath(GetActionPath(), ACTION_LOAD);
 
-				if (true == ReplaceScriptNS(scriptPath, pref->LongName, outPath))
-				{
-					mApp.ExecuteScript(outPath);
-				}
-			}
-
-			mVectorReload.clear();
+		for (auto iter = begin(mVectorReload); iter != end(mVectorReload); ++iter)
+		{
+			FBFileReference *pref = *iter;
+			mBatch.Add(reloadPath, pref->LongName);
 		}
 		
-		if (mVectorUnload.size() > 0)
+		for (auto iter = begin(mVectorUnload); iter != end(mVectorUnload); ++iter)
 		{
-			for (auto iter = begin(mVectorUnload); iter != end(mVectorUnload); ++iter)
-			{
-				FBFileReference *pref = *iter;
-				//pref->IsLoaded = false;
-
-				//
-				if (FileExists(pref->ReferenceFilePath) && pref->IsLoaded)
-				{
-					FBString path(pref->ReferenceFilePath);
-					FBFileMonitoringManager::TheOne().RemoveFileFromMonitor(path);
-				}
-
-				FBString scriptPath(GetActionPath(), ACTION_UNLOAD);
-				FBString outPath(GetSystemTempPath(), ACTION_UNLOAD_TEMP);
+			FBFileReference *pref = *iter;
+			//pref->IsLoaded = false;
 
-				if (true == ReplaceScriptNS(scriptPath, pref->LongName, outPath))
-				{
-					mApp.ExecuteScript(outPath);
-				}
+			//
+			if (FileExists(pref->ReferenceFilePath) && pref->IsLoaded)
+			{
+				FBString path(pref->ReferenceFilePath);
+				FBFileMonitoringManager::TheOne().RemoveFileFromMonitor(path);
 			}
-			mVectorUnload.clear();
+
+			mBatch.Add(unloadPath, pref->LongName);
 		}
 		
 		//
-		if (mVectorLoad.size() > 0)
+		for (auto iter = begin(mVectorLoad); iter != end(mVectorLoad); ++iter)
 		{
-			for (auto iter = begin(mVectorLoad); iter != end(mVectorLoad); ++iter)
-			{
-				FBFileReference *pref = *iter;
+			FBFileReference *pref = *iter;
+			mBatch.Add(loadPath, pref->LongName);
+		}
 
-				FBString scriptPath(GetActionPath(), ACTION_LOAD);
-				FBString outPath(GetSystemTempPath(), ACTION_LOAD_TEMP);
+		ExecuteBatch();
 
-				if (true == ReplaceScriptNS(scriptPath, pref->LongName, outPath))
-				{
-					mApp.ExecuteScript(outPath);
-				}
-				
-				// check file path and add to file monitor
-				if (FileExists(pref->ReferenceFilePath) && pref->IsLoaded)
-				{
-					FBString path(pref->ReferenceFilePath);
-					FBFileMonitoringManager::TheOne().AddFileToMonitor(path, kFBFileMonitoring_FILEREFERENCE);
-				}
+		// check file path and add to file monitor, when load actions are done
+		for (auto iter = begin(mVectorLoad); iter != end(mVectorLoad); ++iter)
+		{
+			FBFileReference *pref = *iter;
+
+			if (FileExists(pref->ReferenceFilePath) && pref->IsLoaded)
+			{
+				FBString path(pref->ReferenceFilePath);
+				FBFileMonitoringManager::TheOne().AddFileToMonitor(path, kFBFileMonitoring_FILEREFERENCE);
 			}
-			mVectorLoad.clear();
 		}
+
+		mVectorReload.clear();
+		mVectorUnload.clear();
+		mVectorLoad.clear();
 		
 		LeaveSkipPlugData();
 	}
@@ -532,7 +637,6 @@ void ReferencesManager::OnFileRefChange(HISender pSender, HKEvent pEvent)
 void ReferencesManager::ReferencesPostLoad()
 {
 	FBString scriptPath(GetActionPath(), ACTION_RELOAD);
-	FBString outPath(GetSystemTempPath(), ACTION_RELOAD_TEMP);
 
 	EnterSkipPlugData();
 
@@ -551,10 +655,7 @@ void ReferencesManager::ReferencesPostLoad()
 
 				if (needToLoad)
 				{
-					if (true == ReplaceScriptNS(scriptPath, pref->LongName, outPath))
-					{
-						mApp.ExecuteScript(outPath);
-					}
+					mBatch.Add(scriptPath, pref->LongName);
 				}
 
 				pref->PropertyRemove(prop);
@@ -562,5 +663,22 @@ void ReferencesManager::ReferencesPostLoad()
 		}
 	}
 
+	ExecuteBatch();
+
 	LeaveSkipPlugData();
+}
+
+void ReferencesManager::ExecuteBatch()
+{
+	if (mBatch.GetCount() > 0)
+	{
+		FBString outPath(GetSystemTempPath(), ACTION_BATCH_TEMP);
+
+		if (true == mBatch.Write(outPath))
+		{
+			mApp.ExecuteScript(outPath);
+		}
+
+		mBatch.Clear();
+	}
 }
\ No newline at end of file
@@ -14,6 +14,7 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include <fbsdk/fbsdk.h>
 
 #include <set>
+#include <string>
 
 //--- Registration defines
 #define REFERENCES_MANAGER__CLASSNAME	ReferencesManager
@@ -21,6 +22,28 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 
 ///////////////////////////////////////////////////////////////////////////////////
 
+/** Queued reference actions collected into one generated script.
+*	Toggling many references costs one interpreter round-trip instead of a temp file and an execution per reference
+*/
+class ActionScriptBatch
+{
+public:
+
+	//! add an action script with a namespace substitution, a template script is cached in memory
+	bool Add(const char *scriptpath, const char *ns, const char *arg1 = nullptr);
+	bool Write(const char *outpath) const;
+	void Clear();
+
+	int GetCount() const { return mCount; }
+
+protected:
+
+	std::string		mText;
+	int				mCount{ 0 };
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+
 /** References Manager Class.
 */
 class ReferencesManager : public FBCustomManager
@@ -69,6 +92,11 @@ protected:
 	std::set<FBFileReference*>	mVectorLoad;
 	std::set<FBFileReference*>	mVectorReload;
 
+	ActionScriptBatch			mBatch;
+
+	// run all collected actions with one script execution
+	void ExecuteBatch();
+
 	// on file delete, let's remove a holder
 	void RemoveHolder(FBFileReference *pRef); // FBString &refpath);
 
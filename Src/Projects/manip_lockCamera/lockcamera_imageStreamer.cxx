@@ -0,0 +1,246 @@
+
+/**	\file	lockcamera_imageStreamer.cxx
+
+Sergei <Neill3d> Solokhin 2018
+
+GitHub page - https://github.com/Neill3d/OpenMoBu
+Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+
+
+*/
+
+//--- Class declarations
+#include "lockcamera_imageStreamer.h"
+
+#include <fbsdk/fbsdk.h>
+#include <GL\glew.h>
+
+#include <algorithm>
+#include <string.h>
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// ImageStreamer
+
+ImageStreamer::ImageStreamer(const int numberOfWorkers)
+{
+	const int count = std::max(1, numberOfWorkers);
+
+	for (int i = 0; i < count; ++i)
+	{
+		mWorkers.emplace_back(&ImageStreamer::WorkerLoop, this);
+	}
+}
+
+ImageStreamer::~ImageStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+		mRequests.clear();
+	}
+	mCondition.notify_all();
+
+	for (auto &worker : mWorkers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+void ImageStreamer::Request(const char *filename, const unsigned int tag)
+{
+	// sdk calls stay on a calling thread
+	DecodeRequest request;
+	request.tag = tag;
+	Load(filename, request);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		mRequests.push_back(std::move(request));
+		mNumberOfInFlight += 1;
+	}
+	mCondition.notify_one();
+}
+
+bool ImageStreamer::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mNumberOfInFlight > 0;
+}
+
+void ImageStreamer::WorkerLoop()
+{
+	for (;;)
+	{
+		DecodeRequest request;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mStop || !mRequests.empty(); });
+
+			if (mStop)
+				return;
+
+			request = std::move(mRequests.front());
+			mRequests.pop_front();
+		}
+
+		// a copy with a flip is the slow part, it's done without a lock
+		DecodedImage image;
+		Decode(request, image);
+		image.image = std::move(request.image);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mReady.push_back(std::move(image));
+	}
+}
+
+void ImageStreamer::Load(const char *filename, DecodeRequest &request)
+{
+	if (nullptr == filename || 0 == filename[0])
+		return;
+
+	std::shared_ptr<FBImage> lImage = std::make_shared<FBImage>(filename);
+
+	if (lImage->Width <= 0 || lImage->Height <= 0)
+		return;
+
+	FBImageFormat imageFormat;
+	lImage->Format.GetData(&imageFormat, sizeof(FBImageFormat));
+
+	request.bytesPerPixel = 3;
+	request.internalFormat = GL_RGB8;
+	request.format = GL_RGB;
+
+	if (kFBImageFormatBGRA32 == imageFormat)
+	{
+		request.bytesPerPixel = 4;
+		request.internalFormat = GL_RGBA8;
+		request.format = GL_BGRA;
+	}
+	else if (kFBImageFormatRGBA32 == imageFormat)
+	{
+		request.bytesPerPixel = 4;
+		request.internalFormat = GL_RGBA8;
+		request.format = GL_RGBA;
+	}
+
+	request.width = lImage->Width;
+	request.height = lImage->Height;
+	request.source = lImage->GetBufferAddress();
+	request.image = lImage;
+}
+
+void ImageStreamer::Decode(const DecodeRequest &request, DecodedImage &image)
+{
+	image.tag = request.tag;
+
+	if (nullptr == request.source)
+		return;
+
+	image.width = request.width;
+	image.height = request.height;
+	image.internalFormat = request.internalFormat;
+	image.format = request.format;
+
+	// rows go in a reversed order, the same as FBImage::VerticalFlip before a copy
+	const size_t rowSize = static_cast<size_t>(image.width) * static_cast<size_t>(request.bytesPerPixel);
+	image.pixels.resize(rowSize * static_cast<size_t>(image.height));
+
+	for (int y = 0; y < image.height; ++y)
+	{
+		const unsigned char *src = request.source + rowSize * static_cast<size_t>(image.height - 1 - y);
+		memcpy(image.pixels.data() + rowSize * static_cast<size_t>(y), src, rowSize);
+	}
+}
+
+int ImageStreamer::UploadReady(const int maxUploads, std::function<void(unsigned int tag, unsigned int textureId)> onUploaded)
+{
+	int numberOfUploads = 0;
+
+	while (numberOfUploads < maxUploads)
+	{
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mReady.empty())
+				break;
+
+			image = std::move(mReady.front());
+			mReady.pop_front();
+			mNumberOfInFlight -= 1;
+		}
+
+		const unsigned int textureId = Upload(image);
+		if (onUploaded)
+			onUploaded(image.tag, textureId);
+
+		// FBImage goes away on this thread, the same one which has loaded it
+		image.image.reset();
+
+		numberOfUploads += 1;
+	}
+
+	return numberOfUploads;
+}
+
+unsigned int ImageStreamer::Upload(const DecodedImage &image)
+{
+	if (image.pixels.empty())
+		return 0;
+
+	const GLsizeiptr size = static_cast<GLsizeiptr>(image.pixels.size());
+	const void *pixels = image.pixels.data();
+
+	// copy into a pixel unpack buffer, so glTexImage2D returns without waiting for a transfer
+	const bool usePBO = (GLEW_ARB_pixel_buffer_object == GL_TRUE);
+	if (usePBO)
+	{
+		if (0 == mUnpackBuffer)
+			glGenBuffers(1, &mUnpackBuffer);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mUnpackBuffer);
+		// orphan a previous storage, a driver could still read it for a previous upload
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+		void *ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+		if (ptr)
+		{
+			memcpy(ptr, pixels, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			pixels = nullptr; // offset in the bound buffer
+		}
+		else
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+
+	GLuint id = 0;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);                         // set 1-byte alignment
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, image.internalFormat, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE, pixels);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (usePBO)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	return id;
+}
+
+void ImageStreamer::FreeBuffers()
+{
+	if (mUnpackBuffer > 0)
+	{
+		glDeleteBuffers(1, &mUnpackBuffer);
+		mUnpackBuffer = 0;
+	}
+}
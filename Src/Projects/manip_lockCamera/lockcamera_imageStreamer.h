@@ -0,0 +1,96 @@
+#ifndef __ORMANIP_LOCK_CAMERA_IMAGE_STREAMER_H__
+#define __ORMANIP_LOCK_CAMERA_IMAGE_STREAMER_H__
+
+/**	\file	lockcamera_imageStreamer.h
+
+Sergei <Neill3d> Solokhin 2018
+
+GitHub page - https://github.com/Neill3d/OpenMoBu
+Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/master/LICENSE
+
+*/
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+//! Prepare images on worker threads and upload them into textures on the render thread
+/*!
+	FBImage is an sdk object, so it's loaded on a thread which calls Request, a worker only
+	copies its pixels with a vertical flip into a staging block. A prepared image waits in a queue until
+	UploadReady is called with an active GL context (at frame start), pixels go through
+	a pixel unpack buffer when it's supported. A loaded FBImage is released in UploadReady
+*/
+class ImageStreamer
+{
+public:
+
+	//! a constructor, starts worker threads
+	ImageStreamer(const int numberOfWorkers = 2);
+
+	//! a destructor, waits for workers to finish a current decoding
+	~ImageStreamer();
+
+	//! load an image file and queue it for staging, tag is passed back with an uploaded texture
+	void Request(const char *filename, const unsigned int tag);
+
+	//! upload decoded images into textures, GL context must be active
+	//! onUploaded is called with texture 0 when an image failed to load
+	int UploadReady(const int maxUploads, std::function<void(unsigned int tag, unsigned int textureId)> onUploaded);
+
+	//! true when there are requests which are not uploaded yet
+	bool IsBusy() const;
+
+	//! release GL resources of the current context
+	void FreeBuffers();
+
+protected:
+
+	struct DecodeRequest
+	{
+		unsigned int			tag{ 0 };
+		int						width{ 0 };
+		int						height{ 0 };
+		int						bytesPerPixel{ 0 };
+		unsigned int			internalFormat{ 0 };
+		unsigned int			format{ 0 };
+		const unsigned char		*source{ nullptr };	//!< pixels of a loaded image
+		std::shared_ptr<void>	image;				//!< keeps a loaded FBImage alive until an upload
+	};
+
+	struct DecodedImage
+	{
+		unsigned int				tag{ 0 };
+		int							width{ 0 };
+		int							height{ 0 };
+		unsigned int				internalFormat{ 0 };
+		unsigned int				format{ 0 };
+		std::vector<unsigned char>	pixels;
+		std::shared_ptr<void>		image;	//!< loaded FBImage, released on a thread which uploads
+	};
+
+	std::vector<std::thread>		mWorkers;
+
+	mutable std::mutex				mMutex;
+	std::condition_variable			mCondition;
+	bool							mStop{ false };
+
+	std::deque<DecodeRequest>		mRequests;
+	std::deque<DecodedImage>		mReady;
+	int								mNumberOfInFlight{ 0 };	//!< requested but not yet uploaded
+
+	unsigned int					mUnpackBuffer{ 0 };
+
+	void WorkerLoop();
+	static void Load(const char *filename, DecodeRequest &request);
+	static void Decode(const DecodeRequest &request, DecodedImage &image);
+
+	unsigned int Upload(const DecodedImage &image);
+};
+
+#endif /* lock camera image streamer h */
@@ -13,6 +13,7 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 #include "lockcamera_manip.h"
 //#include <fbsdk/fbsdk-opengl.h>
 #include <Windows.h>
+#include <GL\glew.h>
 #include <GL\GL.h>
 
 //--- Registration defines
@@ -33,9 +34,8 @@ FBRegisterManipulator(			MANIP_LOCKCAMERA__CLASS,
 //
 HGLRC		gLastContext = 0;
 
-#define GL_BGR									GL_BGR_EXT
-#define GL_BGRA									GL_BGRA_EXT
-#define GL_CLAMP_TO_EDGE 0x812F
+// decoded image is small, but it's not needed to upload all of them in one frame
+#define MAX_TEXTURE_UPLOADS_PER_FRAME	1
 
 /************************************************
  *	FiLMBOX Constructor.
@@ -73,6 +73,9 @@ bool Manip_LockCamera::FBCreate()
 		mLockId = 0;
 		mUnLockId = 0;
 
+		mImageStreamer.reset(new ImageStreamer(2));
+		mTexturesRequested = false;
+
 		return true;
 	}
 	return false;
@@ -145,6 +148,9 @@ void Manip_LockCamera::FBDestroy()
 	//mApp.OnFileOpenCompleted.Remove(this, (FBCallback)&ORManip_Template::OnFileNew);
 	//mApp.OnFileNew.Remove(this, (FBCallback)&ORManip_Template::OnFileNew);
 
+	// wait for workers before the manipulator is gone
+	mImageStreamer.reset();
+
 	FBManipulator::FBDestroy();
 }
 
@@ -354,6 +360,13 @@ void Manip_LockCamera::OnPerFrameRenderingPipelineCallback(HISender pSender, HKE
 
 		mRenderPaneIndex = 0;
 
+		static bool glewFirstRun = true;
+		if (glewFirstRun)
+		{
+			glewInit();
+			glewFirstRun = false;
+		}
+
 		HGLRC currRc = wglGetCurrentContext();
 		if (0 == gLastContext || currRc != gLastContext)
 		{
@@ -361,12 +374,12 @@ void Manip_LockCamera::OnPerFrameRenderingPipelineCallback(HISender pSender, HKE
 			gLastContext = currRc;
 		}
 
-		static bool firstLoad = true;
-		if (true == firstLoad || 0 == mLockId)
+		// images are decoded in background, viewport is drawn without them for a few frames
+		if (false == mTexturesRequested)
 		{
 			LoadTextures();
-			firstLoad = false;
 		}
+		UploadTextures();
 				
 	} break;
 	case kFBGlobalEvalCallbackAfterRender:
@@ -474,7 +487,7 @@ void Manip_LockCamera::OnFileNew(HISender pSender, HKEvent pEvent)
 
 void Manip_LockCamera::LoadTextures()
 {
-	if (mLockId > 0)
+	if (mTexturesRequested || !mImageStreamer)
 		return;
 
 	FBString path(mSystem.ApplicationPath);
@@ -483,8 +496,27 @@ void Manip_LockCamera::LoadTextures()
 	FBString lockPath(path, mLockPath);
 	FBString unlockPath(path, mUnLockPath);
 
-	mLockId = UploadImageIntoTexture(lockPath, 0);
-	mUnLockId = UploadImageIntoTexture(unlockPath, 0);
+	mImageStreamer->Request(lockPath, TEXTURE_LOCK);
+	mImageStreamer->Request(unlockPath, TEXTURE_UNLOCK);
+
+	// a missing image is not requested again every frame
+	mTexturesRequested = true;
+}
+
+void Manip_LockCamera::UploadTextures()
+{
+	if (!mImageStreamer)
+		return;
+
+	mImageStreamer->UploadReady(MAX_TEXTURE_UPLOADS_PER_FRAME, [this](unsigned int tag, unsigned int textureId)
+	{
+		unsigned int &id = (TEXTURE_LOCK == tag) ? mLockId : mUnLockId;
+
+		// a request from a previous context could finish after a new one
+		if (id > 0)
+			glDeleteTextures(1, &id);
+		id = textureId;
+	});
 }
 
 void Manip_LockCamera::FreeTextures()
@@ -499,64 +531,9 @@ void Manip_LockCamera::FreeTextures()
 		glDeleteTextures(1, &mUnLockId);
 		mUnLockId = 0;
 	}
-}
-
-unsigned int Manip_LockCamera::UploadImageIntoTexture(const char *filename, const unsigned int useId)
-{
-	GLuint id = 0;
-	FBImage *pImage = new FBImage(filename);
-
-	if (pImage)
-	{
-		if (pImage->Width > 0)
-		{
-			pImage->VerticalFlip();
-			unsigned char *buffer = pImage->GetBufferAddress();
-
-			GLuint internalFormat = GL_RGB8;
-			GLuint format = GL_RGB;
-
-			int width = pImage->Width;
-			int height = pImage->Height;
-			FBImageFormat imageFormat;
-			pImage->Format.GetData(&imageFormat, sizeof(FBImageFormat));
-
-			if (kFBImageFormatBGRA32 == imageFormat)
-			{
-				internalFormat = GL_RGBA8;
-				format = GL_BGRA;
-			}
-			else if (kFBImageFormatRGBA32 == imageFormat)
-			{
-				internalFormat = GL_RGBA8;
-				format = GL_RGBA;
-			}
-			else if (kFBImageFormatRGB24 == imageFormat)
-			{
-				internalFormat = GL_RGB8;
-				format = GL_RGB;
-			}
 
-			id = useId;
-			if (0 == id)
-				glGenTextures(1, &id);
+	if (mImageStreamer)
+		mImageStreamer->FreeBuffers();
 
-			glBindTexture(GL_TEXTURE_2D, id);
-
-			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);                         // set 1-byte alignment
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, buffer);
-
-			glBindTexture(GL_TEXTURE_2D, 0);
-
-		}
-
-
-		delete pImage;
-	}
-	return id;
-}
\ No newline at end of file
+	mTexturesRequested = false;
+}
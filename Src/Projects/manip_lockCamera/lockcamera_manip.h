@@ -13,6 +13,9 @@ Licensed under The "New" BSD License - https://github.com/Neill3d/OpenMoBu/blob/
 //--- SDK include
 #include <fbsdk/fbsdk.h>
 
+#include <memory>
+#include "lockcamera_imageStreamer.h"
+
 //--- Registration defines
 #define MANIP_LOCKCAMERA__CLASSNAME		Manip_LockCamera
 #define MANIP_LOCKCAMERA__CLASSSTR		"Manip_LockCamera"
@@ -66,9 +69,18 @@ public:
 
 private:
 
+	enum
+	{
+		TEXTURE_LOCK,
+		TEXTURE_UNLOCK
+	};
+
 	unsigned int			mLockId;
 	unsigned int			mUnLockId;
 
+	std::unique_ptr<ImageStreamer>	mImageStreamer;
+	bool					mTexturesRequested;	// decoding is in progress or done for the current context
+
 	FBString				mLockPath;
 	FBString				mUnLockPath;
 
@@ -77,7 +89,8 @@ private:
 	void LoadTextures();
 	void FreeTextures();
 
-	unsigned int UploadImageIntoTexture(const char *filename, const unsigned int useId);
+	//! assign textures decoded in background, called at frame start
+	void UploadTextures();
 
 	void LoadConfig();
 };
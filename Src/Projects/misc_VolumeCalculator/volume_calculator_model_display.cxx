@@ -14,6 +14,8 @@
 //--- Class declaration
 #include "volume_calculator_model_display.h"
 #include <fbsdk\fbsdk-opengl.h>
+#include <algorithm>
+#include "math3d.h"
 
 FBClassImplementation( ModelVolumeCalculator );					//Register class
 FBStorableCustomModelImplementation( ModelVolumeCalculator, ORMODELCUSTOMDISPLAY__DESCSTR );	//Register to the store/retrieve system
@@ -179,12 +181,14 @@ void ModelVolumeCalculator::AddPropertiesToPropertyViewManager()
 	AddPropertyView("Zone Length", "");
 	AddPropertyView("Zone Width", "");
 	AddPropertyView("Show points", "");
+	AddPropertyView("Show Heat Map", "");
 	AddPropertyView("Step", "");
 	AddPropertyView("Min Coverage", "");
 	AddPropertyView("Marker", "");
 	AddPropertyView("Cameras", "");
 	AddPropertyView("Solve", "");
 	AddPropertyView("Marks", "");
+	AddPropertyView("Solve Time", "");
 
 	AddPropertyView("", "Display Settings", true);
 	AddPropertyView("Room Color", "Display Settings");
@@ -213,12 +217,14 @@ ModelVolumeCalculator::ModelVolumeCalculator( const char* pName, HIObject pObjec
 	FBPropertyPublish( this, ZoneLength, "Zone Length", NULL, NULL );
 	FBPropertyPublish( this, ZoneWidth, "Zone Width", NULL, NULL );
 	FBPropertyPublish( this, DisplayPoints, "Show points", NULL, NULL );
+	FBPropertyPublish( this, DisplayHeatMap, "Show Heat Map", NULL, NULL );
 	FBPropertyPublish( this, SolveStep, "Step", NULL, NULL );
 	FBPropertyPublish( this, CameraCoverage, "Min Coverage", NULL, NULL );
 	FBPropertyPublish( this, Marker, "Marker", NULL, NULL );
 	FBPropertyPublish( this, Cameras, "Cameras", NULL, NULL );
 	FBPropertyPublish( this, Solve, "Solve", NULL, Volume_Solve );
 	FBPropertyPublish( this, Marks, "Marks", NULL, NULL );
+	FBPropertyPublish( this, SolveTime, "Solve Time", NULL, NULL );
 
 	FBPropertyPublish(this, RoomColor, "Room Color", nullptr, nullptr);
 	FBPropertyPublish(this, ZoneColor, "Zone Color", nullptr, nullptr);
@@ -236,6 +242,7 @@ ModelVolumeCalculator::ModelVolumeCalculator( const char* pName, HIObject pObjec
 
 	DisplayRoom = true;
 	DisplayPoints = false;
+	DisplayHeatMap = false;
 	
 	DisplayZone = false;
 	IsZoneCircle = false;
@@ -247,6 +254,8 @@ ModelVolumeCalculator::ModelVolumeCalculator( const char* pName, HIObject pObjec
 	SolveStep = 50.0;
 	CameraCoverage = 3;
 	Marks = 0;
+	SolveTime = 0.0;
+	SolveTime.ModifyPropertyFlag(kFBPropertyFlagReadOnly, true);
 
 	RoomColor = FBColor(0.8, 0.8, 0.8);
 	ZoneColor = FBColor(0.9, 0.9, 0.9);
@@ -357,22 +366,92 @@ void ModelVolumeCalculator::DrawActiveZone(const bool is_pick)
 	}
 }
 
+void ModelVolumeCalculator::PrepareDrawArrays()
+{
+	const bool heatMap = DisplayHeatMap;
+	const int coverage = CameraCoverage;
+	const FBColor point_color = PointColor;
+
+	if (!mDrawArraysDirty && heatMap == mDrawHeatMap && coverage == mDrawCoverage 
+		&& point_color[0] == mDrawPointColor[0] && point_color[1] == mDrawPointColor[1] && point_color[2] == mDrawPointColor[2])
+	{
+		return;
+	}
+
+	mDrawArraysDirty = false;
+	mDrawHeatMap = heatMap;
+	mDrawCoverage = coverage;
+	mDrawPointColor = point_color;
+
+	mDrawPositions.clear();
+	mDrawColors.clear();
+
+	if (mGrid.IsEmpty())
+		return;
+
+	// heat map shows every visible point, blue for a single camera up to red for the most covered points
+	const int numCameras = std::max(1, Cameras.GetCount());
+	const int minCount = (heatMap) ? 1 : std::max(1, coverage);
+
+	const unsigned char flatColor[3] = {
+		static_cast<unsigned char>(255.0 * clamp01(point_color[0])),
+		static_cast<unsigned char>(255.0 * clamp01(point_color[1])),
+		static_cast<unsigned char>(255.0 * clamp01(point_color[2])) };
+
+	float pos[3];
+	for (int z = 0; z < mGrid.GetSizeZ(); ++z)
+		for (int y = 0; y < mGrid.GetSizeY(); ++y)
+			for (int x = 0; x < mGrid.GetSizeX(); ++x)
+			{
+				const int count = mGrid.GetCount(x, y, z);
+				if (count < minCount)
+					continue;
+
+				mGrid.GetLocalPosition(x, y, z, pos);
+				mDrawPositions.insert(mDrawPositions.end(), pos, pos + 3);
+
+				if (heatMap)
+				{
+					const double f = std::min(1.0, static_cast<double>(count) / static_cast<double>(numCameras));
+					const double r = clamp01(2.0 * f - 1.0);
+					const double g = 1.0 - fabs(2.0 * f - 1.0);
+					const double b = clamp01(1.0 - 2.0 * f);
+
+					mDrawColors.push_back(static_cast<unsigned char>(255.0 * r));
+					mDrawColors.push_back(static_cast<unsigned char>(255.0 * g));
+					mDrawColors.push_back(static_cast<unsigned char>(255.0 * b));
+				}
+				else
+				{
+					mDrawColors.insert(mDrawColors.end(), flatColor, flatColor + 3);
+				}
+			}
+}
+
 void ModelVolumeCalculator::DrawVolumePoints(const bool is_pick)
 {
-	if (!mPoints.size() ) return;
+	PrepareDrawArrays();
+
+	if (mDrawPositions.empty()) 
+		return;
 
 	glPointSize(3.0f);
 
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, mDrawPositions.data());
+
 	if (!is_pick)
 	{
-		const FBColor point_color = PointColor;
-		glColor3dv(point_color);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(3, GL_UNSIGNED_BYTE, 0, mDrawColors.data());
 	}
 	
-	glBegin(GL_POINTS);
-	for (size_t i=0; i<mPoints.size(); ++i)
-		glVertex3dv(mPoints[i]);
-	glEnd();
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mDrawPositions.size() / 3));
+	
+	if (!is_pick)
+		glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
 	glPointSize(1.0f);
 }
 
@@ -633,48 +712,29 @@ struct Camera
 
 void ModelVolumeCalculator::PrepareVolumePoints(double l, double w, double h, double step)
 {
-	const double hl = l * 0.5;
-	const double hw = w * 0.5;
-	
-	double sl = -hl;
-	double sw = -hw;
-	double sh = 0.0;
+	// room is drawn with a model translation, so test points in the same world space
+	const FBVector3d T = Translation;
+	mDrawArraysDirty = true;
 
-	std::vector<Camera>	cameras;
-	if (Cameras.GetCount() ) {
-		cameras.resize(Cameras.GetCount() );
+	if (!mGrid.Allocate(l, w, h, step, T[0], T[1], T[2]))
+		return;
 
-		for (int i=0; i<cameras.size(); ++i)
-			cameras[i].UpdateFrustum( (FBCamera*) Cameras.GetAt(i) );
-	}
-
-	// lets calculate the number of points in volume
-	long count = l * w * h / step;
-	if (!count) return;
-
-	long index = 0;
-	mPoints.resize(count);
-	FBVector3d v;
-
-	for( sl=-hl; sl < hl; sl+=step)
-		for (sw=-hw; sw<hw; sw+=step)
-			for (sh=0.0; sh<h; sh+=step)
-			{
-				if (index < count) {
-					v = FBVector3d(sw, sh, sl);
+	std::vector<CoverageFrustum>	frustums;
+	if (Cameras.GetCount() ) {
+		frustums.resize(Cameras.GetCount() );
 
-					int tests = 0;
-					for (size_t i=0; i<cameras.size(); ++i)
-						if (cameras[i].PointInFrustum(v) ) tests++;
+		Camera camera;
+		for (int i=0; i<frustums.size(); ++i)
+		{
+			camera.UpdateFrustum( (FBCamera*) Cameras.GetAt(i) );
 
-					if (tests >= CameraCoverage) {
-						mPoints[index] = v;
-						index++;
-					}
-				}
-			}
+			for (int j=0; j<6; ++j)
+				for (int k=0; k<4; ++k)
+					frustums[i].planes[j][k] = static_cast<float>(camera.m_Frustum[j][k]);
+		}
+	}
 
-	if (index < count) mPoints.resize(index);
+	mGrid.Solve(frustums);
 }
 
 void ModelVolumeCalculator::DrawMarkerRays(const bool is_pick)
@@ -717,5 +777,9 @@ void ModelVolumeCalculator::DrawMarkerRays(const bool is_pick)
 void ModelVolumeCalculator::DoVolumeSolve()
 {
 	PrepareVolumePoints(Length, Width, Height, SolveStep);
-	Marks = mPoints.size();
+	Marks = mGrid.CountCovered(CameraCoverage);
+	SolveTime = mGrid.GetSolveTime();
+
+	FBTrace("[Volume Calculator] solved %d x %d x %d points for %d cameras in %.2f ms\n", 
+		mGrid.GetSizeX(), mGrid.GetSizeY(), mGrid.GetSizeZ(), Cameras.GetCount(), mGrid.GetSolveTime());
 }
@@ -17,6 +17,8 @@
 #include <fbsdk/fbsdk.h>
 #include <vector>
 
+#include "volume_calculator_solver.h"
+
 enum kCECameraPresets
 {
 	kCECameraPreset_None,
@@ -111,7 +113,9 @@ public:
 
 	FBPropertyAction	Solve;				// compute active volume from given cameras
 	FBPropertyBool		DisplayPoints;		// display active points in volume
+	FBPropertyBool		DisplayHeatMap;		// display all covered points colored by number of cameras
 	FBPropertyInt		Marks;				// number of result points (with occolusion)
+	FBPropertyDouble	SolveTime;			// time of the last solve in ms
 
 	FBPropertyAction	SwitchToCamera;		// make selected camera current, and show it's frustum planes
 	FBPropertyAction	About;				// show information about me )
@@ -137,7 +141,18 @@ private:
 
 	void DrawRoom(double l, double w, double h, const bool is_pick);
 
-	std::vector<FBVector3d>		mPoints;	// volume points array
+	void	PrepareDrawArrays();
+
+	CoverageGrid				mGrid;		// number of cameras for every volume point
+
+	// vertex arrays to draw a grid in one call, rebuilt after solve or display settings change
+	std::vector<float>			mDrawPositions;
+	std::vector<unsigned char>	mDrawColors;
+
+	bool						mDrawArraysDirty{ true };
+	bool						mDrawHeatMap{ false };
+	int							mDrawCoverage{ 0 };
+	FBColor						mDrawPointColor;
 };
 
 
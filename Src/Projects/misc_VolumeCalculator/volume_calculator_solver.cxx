@@ -0,0 +1,172 @@
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/MoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/MoBu
+//
+// Author Sergey Solohin (Neill3d) 2014
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "volume_calculator_solver.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <math.h>
+
+#define COVERAGE_MAX_CAMERAS	255		// voxel counter is one byte
+
+namespace
+{
+	int SamplesCount(const double size, const double step)
+	{
+		// same as for (s = 0; s < size; s += step)
+		return (size > 0.0) ? static_cast<int>(ceil(size / step - 0.000001)) : 0;
+	}
+};
+
+void CoverageGrid::Clear()
+{
+	mCounts.clear();
+	mSize[0] = mSize[1] = mSize[2] = 0;
+}
+
+bool CoverageGrid::Allocate(const double length, const double width, const double height, const double step,
+	const double originX, const double originY, const double originZ)
+{
+	Clear();
+
+	if (step <= 0.0)
+		return false;
+
+	mSize[0] = SamplesCount(width, step);
+	mSize[1] = SamplesCount(height, step);
+	mSize[2] = SamplesCount(length, step);
+
+	if (mSize[0] == 0 || mSize[1] == 0 || mSize[2] == 0)
+	{
+		Clear();
+		return false;
+	}
+
+	mStep = static_cast<float>(step);
+	mStart[0] = static_cast<float>(-0.5 * width);
+	mStart[1] = 0.0f;
+	mStart[2] = static_cast<float>(-0.5 * length);
+
+	mOrigin[0] = static_cast<float>(originX);
+	mOrigin[1] = static_cast<float>(originY);
+	mOrigin[2] = static_cast<float>(originZ);
+
+	mCounts.resize(static_cast<size_t>(mSize[0]) * mSize[1] * mSize[2], 0);
+	return true;
+}
+
+void CoverageGrid::GetLocalPosition(const int x, const int y, const int z, float *pos) const
+{
+	pos[0] = mStart[0] + mStep * x;
+	pos[1] = mStart[1] + mStep * y;
+	pos[2] = mStart[2] + mStep * z;
+}
+
+int CoverageGrid::CountCovered(const int minCoverage) const
+{
+	int result = 0;
+	for (const unsigned char count : mCounts)
+	{
+		if (count >= minCoverage)
+			result += 1;
+	}
+	return result;
+}
+
+void CoverageGrid::Solve(const std::vector<CoverageFrustum> &frustums)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::fill(mCounts.begin(), mCounts.end(), static_cast<unsigned char>(0));
+
+	if (!mCounts.empty() && !frustums.empty())
+	{
+		const int numThreads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), mSize[2]));
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < numThreads; ++i)
+		{
+			threads.emplace_back(&CoverageGrid::SolveSlices, this, std::cref(frustums),
+				mSize[2] * i / numThreads, mSize[2] * (i + 1) / numThreads);
+		}
+		SolveSlices(frustums, 0, mSize[2] / numThreads);
+
+		for (auto &thread : threads)
+			thread.join();
+	}
+
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	mSolveTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+void CoverageGrid::SolveSlices(const std::vector<CoverageFrustum> &frustums, const int zBegin, const int zEnd)
+{
+	const int numCameras = std::min(static_cast<int>(frustums.size()), COVERAGE_MAX_CAMERAS);
+	const int sizeX = mSize[0];
+	const int sizeX4 = (sizeX + 3) & ~3;
+
+	// x coords of every sample in a row, padded up to 4
+	std::vector<float> rowX(sizeX4);
+	for (int x = 0; x < sizeX4; ++x)
+		rowX[x] = mOrigin[0] + mStart[0] + mStep * x;
+
+	std::vector<int> rowCounts(sizeX4);
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int z = zBegin; z < zEnd; ++z)
+	{
+		const float wz = mOrigin[2] + mStart[2] + mStep * z;
+
+		for (int y = 0; y < mSize[1]; ++y)
+		{
+			const float wy = mOrigin[1] + mStart[1] + mStep * y;
+
+			std::fill(rowCounts.begin(), rowCounts.end(), 0);
+
+			for (int c = 0; c < numCameras; ++c)
+			{
+				const CoverageFrustum &frustum = frustums[c];
+
+				// y and z part of a plane equation is constant along the row
+				__m128 a[6], bcd[6];
+				for (int p = 0; p < 6; ++p)
+				{
+					const float *plane = frustum.planes[p];
+					a[p] = _mm_set1_ps(plane[0]);
+					bcd[p] = _mm_set1_ps(plane[1] * wy + plane[2] * wz + plane[3]);
+				}
+
+				for (int x = 0; x < sizeX4; x += 4)
+				{
+					const __m128 px = _mm_loadu_ps(&rowX[x]);
+
+					__m128 inside = _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(a[0], px), bcd[0]), zero);
+					for (int p = 1; p < 6; ++p)
+						inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(a[p], px), bcd[p]), zero));
+
+					// mask lane is -1 when inside
+					__m128i counts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rowCounts[x]));
+					counts = _mm_sub_epi32(counts, _mm_castps_si128(inside));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(&rowCounts[x]), counts);
+				}
+			}
+
+			unsigned char *dst = &mCounts[(static_cast<size_t>(z) * mSize[1] + y) * sizeX];
+			for (int x = 0; x < sizeX; ++x)
+				dst[x] = static_cast<unsigned char>(rowCounts[x]);
+		}
+	}
+}
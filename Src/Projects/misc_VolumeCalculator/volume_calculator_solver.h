@@ -0,0 +1,73 @@
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Licensed under the "New" BSD License.
+//		License page - https://github.com/Neill3d/MoBu/blob/master/LICENSE
+//
+// GitHub repository - https://github.com/Neill3d/MoBu
+//
+// Author Sergey Solohin (Neill3d) 2014
+//  e-mail to: neill3d@gmail.com
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <stddef.h>
+
+/** Camera frustum as 6 normalized planes (a, b, c, d), point is inside when a*x + b*y + c*z + d > 0 for every plane
+*/
+struct CoverageFrustum
+{
+	float	planes[6][4];
+};
+
+/** Regular grid of sample points inside a room, every voxel holds the number of cameras that see it
+*	X axis is a width, Y is a height, Z axis is a length
+*/
+class CoverageGrid
+{
+public:
+
+	//! allocate a grid for a room centered at (originX, originZ) on the floor (y = originY)
+	//!  sample points are the same as the previous per-point solver, from -half size with a given step
+	bool Allocate(const double length, const double width, const double height, const double step,
+		const double originX, const double originY, const double originZ);
+
+	void Clear();
+
+	//! count cameras for every voxel, rows are solved in parallel with a 4-wide SSE plane test
+	void Solve(const std::vector<CoverageFrustum> &frustums);
+
+	//! number of voxels seen by at least minCoverage cameras
+	int CountCovered(const int minCoverage) const;
+
+	bool IsEmpty() const { return mCounts.empty(); }
+
+	int GetSizeX() const { return mSize[0]; }
+	int GetSizeY() const { return mSize[1]; }
+	int GetSizeZ() const { return mSize[2]; }
+
+	//! voxel sample position in room local space (without origin offset)
+	void GetLocalPosition(const int x, const int y, const int z, float *pos) const;
+
+	unsigned char GetCount(const int x, const int y, const int z) const {
+		return mCounts[(static_cast<size_t>(z) * mSize[1] + y) * mSize[0] + x];
+	}
+
+	//! time of the last solve in milliseconds
+	double GetSolveTime() const { return mSolveTime; }
+
+protected:
+
+	int							mSize[3]{ 0, 0, 0 };
+	float						mStart[3]{ 0.0f, 0.0f, 0.0f };		//!< local position of a first sample
+	float						mOrigin[3]{ 0.0f, 0.0f, 0.0f };		//!< room world offset
+	float						mStep{ 1.0f };
+
+	std::vector<unsigned char>	mCounts;
+	double						mSolveTime{ 0.0 };
+
+	void SolveSlices(const std::vector<CoverageFrustum> &frustums, const int zBegin, const int zEnd);
+};
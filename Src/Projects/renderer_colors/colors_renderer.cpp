@@ -64,11 +64,13 @@ bool ColorsRendererCallback::FBCreate()
     FBPropertyPublish(this, CustomLightingSetting,  "CustomLightingSetting",    nullptr, nullptr);
     FBPropertyPublish(this, NoFrustumculling,       "NoFrustumculling", nullptr, nullptr);
     FBPropertyPublish(this, CustomFrstumCulling,    "CustomFrustumCulling", nullptr, nullptr);
+    FBPropertyPublish(this, BatchedColorIds,        "BatchedColorIds", nullptr, nullptr);
     
     SupportIDBufferPicking  = true;
     CustomLightingSetting   = false;
     NoFrustumculling        = false;
     CustomFrstumCulling     = true;
+    BatchedColorIds         = true;
     
     // Init data members.
     mAttachCount            = 0;
@@ -175,6 +177,56 @@ void ColorsRendererCallback::FreeShader()
 	}
 }
 
+bool ColorsRendererCallback::LoadColorIdShader()
+{
+	mColorIdShader.reset();
+
+	const FBString fragment_filename( "\\GLSL\\renderer_colorId.fsh" );
+	const FBString vertex_filename( "\\GLSL\\renderer_colorId.vsh" );
+
+	char effectPath[256]{ 0 };
+	if (!FindEffectLocation( fragment_filename, effectPath, 256) )
+		return false;
+
+	mColorIdShader.reset(new GLSLShader());
+
+	if (!mColorIdShader->LoadShaders( FBString(effectPath, vertex_filename), FBString(effectPath, fragment_filename) ) )
+	{
+		mColorIdShader.reset();
+		return false;
+	}
+	return true;
+}
+
+void ColorsRendererCallback::FreeBatchBuffers()
+{
+	if (mDrawDataBuffer > 0)
+	{
+		glDeleteBuffers(1, &mDrawDataBuffer);
+		mDrawDataBuffer = 0;
+	}
+	if (mDrawIndexBuffer > 0)
+	{
+		glDeleteBuffers(1, &mDrawIndexBuffer);
+		mDrawIndexBuffer = 0;
+	}
+	if (mIndirectBuffer > 0)
+	{
+		glDeleteBuffers(1, &mIndirectBuffer);
+		mIndirectBuffer = 0;
+	}
+	mDrawIndexCapacity = 0;
+}
+
+bool ColorsRendererCallback::IsBatchingSupported() const
+{
+	return BatchedColorIds 
+		&& mColorIdShader != nullptr
+		&& GLEW_ARB_multi_draw_indirect 
+		&& GLEW_ARB_shader_storage_buffer_object
+		&& GLEW_ARB_base_instance;
+}
+
 void ColorsRendererCallback::Attach()
 {
     //
@@ -189,6 +241,10 @@ void ColorsRendererCallback::Attach()
     {
 		if ( !LoadShader() )
 			FBMessageBox( "Color Renderer", "Failed to load shaders!", "Ok" );
+
+		// optional, color ids are rendered model by model without it
+		if ( !LoadColorIdShader() )
+			FBTrace("ColorsRendererCallback - batched color id shader is not loaded\n");
     }
 
     // Increase attachment count.
@@ -211,6 +267,8 @@ void ColorsRendererCallback::Detach()
     if (mAttachCount == 0)
     {
 		FreeShader();
+		mColorIdShader.reset();
+		FreeBatchBuffers();
     }
 }
 
@@ -223,6 +281,8 @@ void ColorsRendererCallback::DetachDisplayContext(FBViewingOptions* pViewOption)
     //
 
     FBTrace("ColorsRendererCallback::DetachDisplayContext()\n");
+
+	FreeBatchBuffers();
 }
 
 void ColorsRendererCallback::Render(FBRenderOptions* pRenderOptions)
@@ -275,14 +335,21 @@ void ColorsRendererCallback::RenderColorIds(FBRenderOptions *pRenderOptions)
 	if (!lCamera)
 		return;
 
-    FBMatrix lCameraMVPMatrix;
-    lCamera->GetCameraMatrix(lCameraMVPMatrix, kFBModelViewProj);
-
     glDisable(GL_LIGHTING); 
        
 
     glMatrixMode(GL_MODELVIEW);
 
+	if (IsBatchingSupported())
+	{
+		CollectColorIdBatch(lCamera);
+		RenderColorIdsBatched();
+
+		for (FBModel* lModel : mFallbackModels)
+			RenderColorIdModel(lModel);
+		return;
+	}
+
     //
     // Loop though each model, and render accordingly.
     //
@@ -297,9 +364,6 @@ void ColorsRendererCallback::RenderColorIds(FBRenderOptions *pRenderOptions)
         if( !lModel->IsVisible() || !lModelVertexData->IsDrawable() )  
             continue;
 
-        FBMatrix lModelTransformMatrix;
-        lModel->GetMatrix(lModelTransformMatrix, kModelTransformation_Geometry);
-
         //
         // Early frustum culling is important for improving rendering performance. 
         // and provide hint to allow MotionBuilder core evaluation engine not 
@@ -314,37 +378,193 @@ void ColorsRendererCallback::RenderColorIds(FBRenderOptions *pRenderOptions)
            
         }
 
+		RenderColorIdModel(lModel);
+    }
 
-        //If IDBuffer rendering requested (for display or picking), set model color to be the Model's Unique Color ID.
+
+}
+
+void ColorsRendererCallback::RenderColorIdModel(FBModel *pModel)
+{
+	FBModelVertexData* lModelVertexData = pModel->ModelVertexData;
+
+	FBMatrix lModelTransformMatrix;
+	pModel->GetMatrix(lModelTransformMatrix, kModelTransformation_Geometry);
+
+	//If IDBuffer rendering requested (for display or picking), set model color to be the Model's Unique Color ID.
        
-        FBColor lUniqueColorId = lModel->UniqueColorId;
-		glColor3dv(lUniqueColorId);
+	FBColor lUniqueColorId = pModel->UniqueColorId;
+	glColor3dv(lUniqueColorId);
 
-        glPushMatrix();
-        glMultMatrixd(lModelTransformMatrix);
+	glPushMatrix();
+	glMultMatrixd(lModelTransformMatrix);
 
-        const int lSubRegionCount = lModelVertexData->GetSubRegionCount();
+	const int lSubRegionCount = lModelVertexData->GetSubRegionCount();
 
-        //Calling PushZDepthClipOverride() disables the OpenGL custom clip-plane (used for Z-Depth HideFront selection) if this model is selected using
-        //Z-Depth HideFront selection tool. This is so that the model is not clipped, i.e., remains visible.
-        lModelVertexData->PushZDepthClipOverride();
+	//Calling PushZDepthClipOverride() disables the OpenGL custom clip-plane (used for Z-Depth HideFront selection) if this model is selected using
+	//Z-Depth HideFront selection tool. This is so that the model is not clipped, i.e., remains visible.
+	lModelVertexData->PushZDepthClipOverride();
 
-        lModelVertexData->EnableOGLVertexData();        //Bind Vertex Array or Vertex Buffer Object.
+	lModelVertexData->EnableOGLVertexData();        //Bind Vertex Array or Vertex Buffer Object.
 
-        for(int lSubRegionIdx = 0; lSubRegionIdx < lSubRegionCount; ++lSubRegionIdx)
-        {
-           
-			// ID Buffer rendering, simply draw geometry. 
-			lModelVertexData->DrawSubRegion(lSubRegionIdx); // draw all the sub patches inside this sub regions.
-           
-        }
+	for(int lSubRegionIdx = 0; lSubRegionIdx < lSubRegionCount; ++lSubRegionIdx)
+	{
+		// ID Buffer rendering, simply draw geometry. 
+		lModelVertexData->DrawSubRegion(lSubRegionIdx); // draw all the sub patches inside this sub regions.
+	}
 
-        lModelVertexData->DisableOGLVertexData();   //Unbind Vertex Array or Vertex Buffer Object.
-        lModelVertexData->PopZDepthClipOverride();  //Re-enables Z-Depth HideFront clip-plane if it was previously disabled via PushZDepthClipOverride().
-        glPopMatrix();
-    }
+	lModelVertexData->DisableOGLVertexData();   //Unbind Vertex Array or Vertex Buffer Object.
+	lModelVertexData->PopZDepthClipOverride();  //Re-enables Z-Depth HideFront clip-plane if it was previously disabled via PushZDepthClipOverride().
+	glPopMatrix();
+}
+
+void ColorsRendererCallback::CollectColorIdBatch(FBCamera *pCamera)
+{
+	FBRenderer* lRenderer = FBSystem::TheOne().Renderer;
+
+	mDrawData.clear();
+	mCommands.clear();
+	mBatchItems.clear();
+	mFallbackModels.clear();
+
+	const int lDisplayGeometryCount = lRenderer->DisplayableGeometryCount;
+	mDrawData.reserve(lDisplayGeometryCount);
+	mBatchItems.reserve(lDisplayGeometryCount);
+
+	for (int i = lDisplayGeometryCount - 1; i >= 0; --i)
+	{
+		FBModel* lModel = lRenderer->GetDisplayableGeometry(i);
+		FBModelVertexData* lModelVertexData = lModel->ModelVertexData;
+
+		if( !lModel->IsVisible() || !lModelVertexData->IsDrawable() )  
+			continue;
+
+		if (NoFrustumculling == false && lRenderer->IsModelInsideCameraFrustum(lModel, pCamera) == false)
+			continue;
+
+		// indirect commands are only for indexed triangles inside vertex buffer objects
+		const int lSubPatchCount = lModelVertexData->GetSubPatchCount();
+		bool isBatchable = (lModelVertexData->GetVertexArrayVBOId(kFBGeometryArrayID_Point) > 0)
+			&& (lModelVertexData->GetIndexArrayVBOId() > 0);
+
+		for (int j = 0; isBatchable && j < lSubPatchCount; ++j)
+		{
+			bool isOptimized = false;
+			isBatchable = (lModelVertexData->GetSubPatchPrimitiveType(j, &isOptimized) == FBGeometryPrimitiveType::kFBGeometry_TRIANGLES);
+		}
+
+		if (!isBatchable)
+		{
+			mFallbackModels.push_back(lModel);
+			continue;
+		}
+
+		const GLuint drawIndex = static_cast<GLuint>(mDrawData.size());
+
+		FBMatrix lModelTransformMatrix;
+		lModel->GetMatrix(lModelTransformMatrix, kModelTransformation_Geometry);
+		const FBColor lUniqueColorId = lModel->UniqueColorId;
+
+		ColorIdDrawData data;
+		for (int k = 0; k < 16; ++k)
+			data.model[k] = static_cast<float>(lModelTransformMatrix[k]);
+		for (int k = 0; k < 3; ++k)
+			data.color[k] = static_cast<float>(lUniqueColorId[k]);
+		data.color[3] = 1.0f;
+		mDrawData.push_back(data);
+
+		ColorIdBatchItem item;
+		item.vertexData = lModelVertexData;
+		item.firstCommand = static_cast<int>(mCommands.size());
+		item.numberOfCommands = lSubPatchCount;
+		mBatchItems.push_back(item);
+
+		for (int j = 0; j < lSubPatchCount; ++j)
+		{
+			DrawElementsIndirectCommand command;
+			command.count = static_cast<GLuint>(lModelVertexData->GetSubPatchIndexSize(j));
+			command.instanceCount = 1;
+			command.firstIndex = static_cast<GLuint>(lModelVertexData->GetSubPatchIndexOffset(j));
+			command.baseVertex = 0;
+			command.baseInstance = drawIndex; // fetches a draw index from the instanced attribute
+			mCommands.push_back(command);
+		}
+	}
+}
+
+void ColorsRendererCallback::RenderColorIdsBatched()
+{
+	if (mBatchItems.empty() || mCommands.empty())
+		return;
+
+	if (mDrawDataBuffer == 0)
+		glGenBuffers(1, &mDrawDataBuffer);
+	if (mIndirectBuffer == 0)
+		glGenBuffers(1, &mIndirectBuffer);
+	if (mDrawIndexBuffer == 0)
+		glGenBuffers(1, &mDrawIndexBuffer);
+
+	// the whole frame goes in one upload for every buffer
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mDrawDataBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ColorIdDrawData) * mDrawData.size(), mDrawData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * mCommands.size(), mCommands.data(), GL_STREAM_DRAW);
+
+	// static sequence 0..N-1, grows only when there are more draws than ever before
+	if (mDrawData.size() > mDrawIndexCapacity)
+	{
+		mDrawIndexCapacity = mDrawData.size() * 2;
+		std::vector<GLuint> indices(mDrawIndexCapacity);
+		for (size_t i = 0; i < mDrawIndexCapacity; ++i)
+			indices[i] = static_cast<GLuint>(i);
+
+		glBindBuffer(GL_ARRAY_BUFFER, mDrawIndexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint) * mDrawIndexCapacity, indices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	mColorIdShader->Bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mDrawDataBuffer);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+
+	for (const ColorIdBatchItem& item : mBatchItems)
+	{
+		FBModelVertexData* lModelVertexData = item.vertexData;
+
+		lModelVertexData->PushZDepthClipOverride();
+		lModelVertexData->EnableOGLVertexData();
+
+		glBindBuffer(GL_ARRAY_BUFFER, lModelVertexData->GetVertexArrayVBOId(kFBGeometryArrayID_Point));
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, lModelVertexData->GetVertexArrayVBOOffset(kFBGeometryArrayID_Point));
+
+		glBindBuffer(GL_ARRAY_BUFFER, mDrawIndexBuffer);
+		glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, 0, nullptr);
+		glVertexAttribDivisor(1, 1);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lModelVertexData->GetIndexArrayVBOId());
+
+		// vertex and index buffers are owned by the model, so one call covers all sub patches of one model
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 
+			reinterpret_cast<const void*>(sizeof(DrawElementsIndirectCommand) * item.firstCommand), item.numberOfCommands, 0);
+
+		lModelVertexData->DisableOGLVertexData();
+		lModelVertexData->PopZDepthClipOverride();
+	}
+
+	glVertexAttribDivisor(1, 0);
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
 
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
 
+	mColorIdShader->UnBind();
 }
 
 /////////////////////////////
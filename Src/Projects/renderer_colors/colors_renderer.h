@@ -33,6 +33,23 @@
 /////////////////////////////////////////////////////////////////////////////
 // Unique color id render
 
+/// per draw data of a batched color id pass (std430 layout in the shader)
+struct ColorIdDrawData
+{
+	float		model[16];
+	float		color[4];
+};
+
+/// GL_DRAW_INDIRECT_BUFFER command layout
+struct DrawElementsIndirectCommand
+{
+	GLuint		count;
+	GLuint		instanceCount;
+	GLuint		firstIndex;
+	GLint		baseVertex;
+	GLuint		baseInstance;
+};
+
 
 #define ORColorsRendererCallback__CLASSNAME		ColorsRendererCallback
 #define ORColorsRendererCallback__CLASSSTR		"ColorsRendererCallback"
@@ -68,6 +85,7 @@ public:
     */
     FBPropertyBool      NoFrustumculling;       
     FBPropertyBool      CustomFrstumCulling;    //!< <b>Read/Write Property:</b> Demo how to perform naive frustum culling if true.
+    FBPropertyBool      BatchedColorIds;        //!< <b>Read/Write Property:</b> Render color ids with one storage buffer and indirect draws per frame.
     
 protected:
     unsigned int        mAttachCount;          //!< How many view panes use this renderer callback instance currently.
@@ -86,6 +104,37 @@ protected:
 	//
 	void RenderColorIds(FBRenderOptions *pRenderOptions);
 
+	//
+	// batched color id pass
+
+	struct ColorIdBatchItem
+	{
+		FBModelVertexData	*vertexData;
+		int					firstCommand;
+		int					numberOfCommands;
+	};
+
+	std::unique_ptr<GLSLShader>		mColorIdShader;
+
+	GLuint				mDrawDataBuffer{ 0 };
+	GLuint				mDrawIndexBuffer{ 0 };
+	GLuint				mIndirectBuffer{ 0 };
+	size_t				mDrawIndexCapacity{ 0 };
+
+	std::vector<ColorIdDrawData>				mDrawData;
+	std::vector<DrawElementsIndirectCommand>	mCommands;
+	std::vector<ColorIdBatchItem>				mBatchItems;
+	std::vector<FBModel*>						mFallbackModels;	//!< models with non triangle patches, drawn one by one
+
+	bool				IsBatchingSupported() const;
+	bool				LoadColorIdShader();
+	void				FreeBatchBuffers();
+
+	//! collect visible models into draw data and indirect commands once per frame
+	void CollectColorIdBatch(FBCamera *pCamera);
+	void RenderColorIdsBatched();
+	void RenderColorIdModel(FBModel *pModel);
+
 	//
 	void RenderNormalizedColors(FBRenderOptions *pRenderOptions);
 
@@ -152,6 +152,8 @@ ParticleSystem::ParticleSystem(unsigned int maxparticles)
 {
 	mTransformFeedback[0] = mTransformFeedback[1] = 0;
 	mParticleBuffer[0] = mParticleBuffer[1] = 0;
+	mInstanceVAO[0] = mInstanceVAO[1] = 0;
+	mInstanceVAOStream = TInstanceVertexStream::Zero();
 	
 #ifdef _DEBUG
 	glEnable(GL_DEBUG_OUTPUT);
@@ -197,6 +199,7 @@ void ParticleSystem::ClearParticleSystem()
 	mBufferSurface[1].Free();
 
 	FreeNoiseTexture();
+	FreeInstanceObjects();
 }
 
 void ParticleSystem::PrepNoiseTexture()
@@ -367,12 +367,29 @@ protected:
 
 	GLuint						mNoiseTexture{ 0 };	// 3d texture for the turbulence field
 
+	// instances are submitted with one multi draw indirect call, a draw per mesh patch
+	GLuint						mInstanceVAO[2];		//!< vertex arrays for each particle buffer
+	TInstanceVertexStream		mInstanceVAOStream;		//!< stream vertex arrays were made for
+
+	GLuint						mPatchTextureArray{ 0 };	//!< patch textures resampled into layers
+	std::vector<GLuint>			mPatchTextures;			//!< patch textures the array was made for
+	std::vector<int>			mPatchLayers;			//!< texture array layer per patch, -1 for no texture
+	CGPUBufferSSBO				mBufferPatchLayers;
+	bool						mPatchTexturesReady{ false };	//!< every patch texture could be sampled from the array
+
+	GLuint						mIndirectBuffer{ 0 };
+	std::vector<TDrawElementsIndirectCommand>	mIndirectCommands;
+
 
 	void RenderPoints();
 	void RenderQuads();
 	void RenderBillboards();
 	void RenderStretchedBillboards();
 	void RenderInstances(const int lighting);
+	void PrepareInstanceVAO(const TInstanceVertexStream &stream);
+	void PreparePatchTextureArray(const std::vector<TMeshPatch> &mesh);
+	void PrepareIndirectCommands(const std::vector<TMeshPatch> &mesh);
+	void FreeInstanceObjects();
 
 	void SwapBuffers();	// operation to switch update and render double-buffers
 	void SwapSurfaceBuffers();
@@ -12,7 +12,10 @@
 
 
 #include "ParticleSystem.h"
+#include "checkglerror.h"
 #include <vector>
+#include <algorithm>
+#include <math.h>
 
 using namespace GPUParticles;
 
@@ -256,8 +259,91 @@ void ParticleSystem::RenderInstances(const int lighting)
 	{
 		const TInstanceVertexStream &stream = mConnections->GetInstanceVertexStream();
 		std::vector<TMeshPatch> &mesh = mConnections->GetInstanceMeshVector();
-		//pModelVertexData->EnableOGLVertexData();
 		
+		if (0 == stream.indexId)
+			return;
+
+		// all patches in one multi draw call, the draw index is a patch index in the shader
+		bool useIndirect = (GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_draw_parameters);
+		if (useIndirect)
+		{
+			PreparePatchTextureArray(mesh);
+			useIndirect = mPatchTexturesReady;
+		}
+
+		const float usePatchTextures = (useIndirect && mPatchTextureArray > 0) ? 1.0f : 0.0f;
+		if (mRenderData.gUsePatchTextures != usePatchTextures)
+		{
+			mRenderData.gUsePatchTextures = usePatchTextures;
+			mShader->UploadRenderDataBlock(mRenderData);
+		}
+
+		PrepareInstanceVAO(stream);
+
+		mShader->BindRenderInstances(lighting);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindVertexArray(mInstanceVAO[mCurrTFB]);
+
+		if (useIndirect)
+		{
+			PrepareIndirectCommands(mesh);
+
+			if (mPatchTextureArray > 0)
+			{
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, mPatchTextureArray);
+				glActiveTexture(GL_TEXTURE0);
+
+				mBufferPatchLayers.Bind(3);
+			}
+
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mIndirectCommands.size()), 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			if (mPatchTextureArray > 0)
+			{
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+				glActiveTexture(GL_TEXTURE0);
+			}
+		}
+		else
+		{
+			// a draw per patch with a patch texture
+			for (auto iter=begin(mesh); iter!=end(mesh); ++iter)
+			{
+				if (iter->textureId > 0)
+				{
+					glBindTexture(GL_TEXTURE_2D, iter->textureId);
+				}
+
+				glDrawElementsInstanced(GL_TRIANGLES, iter->size, GL_UNSIGNED_INT, (void*) (sizeof(unsigned int) * iter->offset), mInstanceCount);
+			}
+		}
+
+		glBindVertexArray(0);
+		
+		mShader->UnBindRenderInstances();
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+void ParticleSystem::PrepareInstanceVAO(const TInstanceVertexStream &stream)
+{
+	// vertex arrays are made once per instance stream, particle attributes come from a current transform feedback buffer
+	if (mInstanceVAO[0] > 0 && TInstanceVertexStream::Equals(stream, mInstanceVAOStream))
+		return;
+
+	if (0 == mInstanceVAO[0])
+		glGenVertexArrays(2, mInstanceVAO);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		glBindVertexArray(mInstanceVAO[i]);
+
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
 		glEnableVertexAttribArray(2);
@@ -274,12 +360,9 @@ void ParticleSystem::RenderInstances(const int lighting)
 		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*) stream.normalOffset); // normals
 
 		glBindBuffer(GL_ARRAY_BUFFER, stream.uvId);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*) stream.uvOffset); // normals
-
-		mShader->BindRenderInstances(lighting);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*) stream.uvOffset); // uv
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindBuffer(GL_ARRAY_BUFFER, mParticleBuffer[mCurrTFB]);
+		glBindBuffer(GL_ARRAY_BUFFER, mParticleBuffer[i]);
 		
 		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)0);         // position, normalized lifetime
 		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)16);        // velocity, lifetime
@@ -291,46 +374,214 @@ void ParticleSystem::RenderInstances(const int lighting)
 		glVertexAttribDivisor(6, 1);
 		glVertexAttribDivisor(7, 1);
 
-		GLuint texId = 0;
-		unsigned int baseVertex = 0;
-		unsigned int indicesCount = 0;
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream.indexId);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	mInstanceVAOStream = stream;
+}
+
+void ParticleSystem::PreparePatchTextureArray(const std::vector<TMeshPatch> &mesh)
+{
+	// rebuild only when patch textures are changed
+	bool changed = (mesh.size() != mPatchTextures.size());
+	for (size_t i = 0; !changed && i < mesh.size(); ++i)
+	{
+		changed = (mesh[i].textureId != mPatchTextures[i]);
+	}
+
+	if (false == changed)
+		return;
+
+	mPatchTextures.resize(mesh.size());
+	for (size_t i = 0; i < mesh.size(); ++i)
+	{
+		mPatchTextures[i] = mesh[i].textureId;
+	}
+
+	if (mPatchTextureArray > 0)
+	{
+		glDeleteTextures(1, &mPatchTextureArray);
+		mPatchTextureArray = 0;
+	}
+
+	// unique textures and a common layer size
+
+	GLint lastTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+
+	std::vector<GLuint> layerTextures;
+	std::vector<GLint> layerSizes;
+	GLint width = 0;
+	GLint height = 0;
 
-		if (stream.indexId > 0)
+	mPatchLayers.assign(mesh.size(), -1);
+
+	for (size_t i = 0; i < mesh.size(); ++i)
+	{
+		const GLuint texId = mesh[i].textureId;
+		if (0 == texId)
+			continue;
+
+		auto iter = std::find(begin(layerTextures), end(layerTextures), texId);
+		if (iter != end(layerTextures))
 		{
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream.indexId);
+			mPatchLayers[i] = static_cast<int>(iter - begin(layerTextures));
+			continue;
+		}
 
-			for (auto iter=begin(mesh); iter!=end(mesh); ++iter)
-			{
-				texId = iter->textureId;
-				baseVertex = iter->offset;
-				indicesCount = iter->size;
+		GLint w = 0;
+		GLint h = 0;
+		glBindTexture(GL_TEXTURE_2D, texId);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
 
-				if (texId > 0)
-				{
-					glBindTexture(GL_TEXTURE_2D, texId);
-				}
+		if (w <= 0 || h <= 0)
+			continue;
 
-				glDrawElementsInstanced(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, (void*) (sizeof(unsigned int) * baseVertex), mInstanceCount);
-			}
+		width = (std::max)(width, w);
+		height = (std::max)(height, h);
+
+		mPatchLayers[i] = static_cast<int>(layerTextures.size());
+		layerTextures.push_back(texId);
+		layerSizes.push_back(w);
+		layerSizes.push_back(h);
+	}
 
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, lastTexture);
+
+	if (layerTextures.empty())
+	{
+		// nothing to sample, patches use a shader color map
+		mPatchTexturesReady = true;
+		return;
+	}
+
+	const GLsizei levels = 1 + static_cast<GLsizei>(floor(log2(static_cast<double>((std::max)(width, height)))));
+
+	glGenTextures(1, &mPatchTextureArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mPatchTextureArray);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, static_cast<GLsizei>(layerTextures.size()));
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// resample every texture into its layer, viewer framebuffers are restored after
+
+	GLint lastReadFramebuffer = 0;
+	GLint lastDrawFramebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastReadFramebuffer);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &lastDrawFramebuffer);
+
+	const GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+	glDisable(GL_SCISSOR_TEST);
+
+	GLuint framebuffers[2] = { 0, 0 };
+	glGenFramebuffers(2, framebuffers);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+	bool isOk = true;
+	for (size_t i = 0; isOk && i < layerTextures.size(); ++i)
+	{
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layerTextures[i], 0);
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mPatchTextureArray, 0, static_cast<GLint>(i));
+
+		// compressed textures are not color renderable
+		if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_READ_FRAMEBUFFER)
+			|| GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER))
+		{
+			isOk = false;
+			break;
 		}
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBlitFramebuffer(0, 0, layerSizes[i * 2], layerSizes[i * 2 + 1], 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	}
 
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(2);
-		glDisableVertexAttribArray(4);
-		glDisableVertexAttribArray(5);
-		glDisableVertexAttribArray(6);
-		glDisableVertexAttribArray(7);
-		
-		mShader->UnBindRenderInstances();
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, lastReadFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lastDrawFramebuffer);
+	glDeleteFramebuffers(2, framebuffers);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		//pModelVertexData->DisableOGLVertexData();
+	if (GL_TRUE == scissorTest)
+		glEnable(GL_SCISSOR_TEST);
+
+	if (isOk)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		mBufferPatchLayers.UpdateData(sizeof(int), mPatchLayers.size(), mPatchLayers.data());
+	}
+	else
+	{
+		glDeleteTextures(1, &mPatchTextureArray);
+		mPatchTextureArray = 0;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	mPatchTexturesReady = isOk;
+	CHECK_GL_ERROR();
+}
+
+void ParticleSystem::PrepareIndirectCommands(const std::vector<TMeshPatch> &mesh)
+{
+	// commands are uploaded only when patches or a number of displayed particles are changed
+	bool changed = (0 == mIndirectBuffer || mesh.size() != mIndirectCommands.size());
+	mIndirectCommands.resize(mesh.size());
+
+	for (size_t i = 0; i < mesh.size(); ++i)
+	{
+		TDrawElementsIndirectCommand &command = mIndirectCommands[i];
+
+		if (changed || command.count != mesh[i].size || command.instanceCount != mInstanceCount
+			|| command.firstIndex != mesh[i].offset)
+		{
+			command.count = mesh[i].size;
+			command.instanceCount = mInstanceCount;
+			command.firstIndex = mesh[i].offset;
+			command.baseVertex = 0;
+			command.baseInstance = 0;
+			changed = true;
+		}
+	}
+
+	if (false == changed)
+		return;
+
+	if (0 == mIndirectBuffer)
+		glGenBuffers(1, &mIndirectBuffer);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(TDrawElementsIndirectCommand) * mIndirectCommands.size(), mIndirectCommands.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ParticleSystem::FreeInstanceObjects()
+{
+	if (mInstanceVAO[0] > 0)
+	{
+		glDeleteVertexArrays(2, mInstanceVAO);
+		mInstanceVAO[0] = mInstanceVAO[1] = 0;
+	}
+	mInstanceVAOStream = TInstanceVertexStream::Zero();
+
+	if (mPatchTextureArray > 0)
+	{
+		glDeleteTextures(1, &mPatchTextureArray);
+		mPatchTextureArray = 0;
+	}
+	mPatchTextures.clear();
+	mPatchLayers.clear();
+	mPatchTexturesReady = false;
+	mBufferPatchLayers.Free();
+
+	if (mIndirectBuffer > 0)
+	{
+		glDeleteBuffers(1, &mIndirectBuffer);
+		mIndirectBuffer = 0;
 	}
+	mIndirectCommands.clear();
 }
 
 void ParticleSystem::SwapBuffers()
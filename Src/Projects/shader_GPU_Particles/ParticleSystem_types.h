@@ -152,6 +152,11 @@ struct	renderBlock
 	float		gMaxPointScale;
 	float		gPointScaleDistance;
 	float		gUseColorMap;
+
+	float		gUsePatchTextures;	// instance patches sample a texture array, layer per draw
+	float		gRenderTemp1;
+	float		gRenderTemp2;
+	float		gRenderTemp3;
 };
 
 //
@@ -219,6 +224,13 @@ struct TInstanceVertexStream
 		Set(zeroStream, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 		return zeroStream;
 	}
+
+	static bool Equals(const TInstanceVertexStream& a, const TInstanceVertexStream& b)
+	{
+		return a.vertexCount == b.vertexCount && a.positionId == b.positionId && a.normalId == b.normalId
+			&& a.uvId == b.uvId && a.indexId == b.indexId && a.positionOffset == b.positionOffset
+			&& a.normalOffset == b.normalOffset && a.uvOffset == b.uvOffset && a.indexOffset == b.indexOffset;
+	}
 };
 
 struct TMeshPatch
@@ -228,6 +240,16 @@ struct TMeshPatch
 	unsigned int	size;
 };
 
+// layout of a command in GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct TDrawElementsIndirectCommand
+{
+	GLuint			count;
+	GLuint			instanceCount;
+	GLuint			firstIndex;
+	GLuint			baseVertex;
+	GLuint			baseInstance;
+};
+
 // TODO: !! use rotation and rotation velocity to move particles !!
 // TODO: !! terrainAddress could be also a 3d texture of mesh voxels !!
 struct TCollision
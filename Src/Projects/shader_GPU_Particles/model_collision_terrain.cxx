@@ -19,6 +19,7 @@
 #include "math3d.h"
 #include "FBCommon.h"
 #include "FileUtils.h"
+#include "RenderTargetPool.h"
 
 #include "Shader_ParticleSystem.h"
 
@@ -803,6 +804,8 @@ void CollisionTerrain::OnRenderEvent(HISender pSender, HKEvent pEvent)
 			{
 				mShader->ChangeContext();
 				mBuffer.Cleanup();
+				// attachments of the previous context were deleted by the cleanup, drop its pool once
+				RenderTargetPool::ForgetContext(mLastContext);
 
 				mLastContext = currentContext;
 			}
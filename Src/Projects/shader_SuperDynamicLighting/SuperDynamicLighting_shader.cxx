@@ -93,6 +93,9 @@ bool SuperDynamicLighting::FBCreate()
 	FBPropertyPublish(this, ForceUpdateTextures, "Force Update Textures", nullptr, nullptr);
 	ForceUpdateTextures = false;
 
+	FBPropertyPublish(this, LogStateChanges, "Log State Changes", nullptr, nullptr);
+	LogStateChanges = false;
+
 	// rim lighting
 
 	FBPropertyPublish(this, UseRim, "Use Rim Lighting", nullptr, nullptr);
@@ -147,6 +150,8 @@ void SuperDynamicLighting::FBDestroy()
 			delete mSceneManager;
 			mSceneManager = nullptr;
 		}
+
+		SuperShaderModelInfo::FreeUnusedUVSetsBuffers();
 	}
 
     // Delete lighting shader
@@ -216,6 +221,7 @@ void SuperDynamicLighting::ShaderPassTypeBegin(FBRenderOptions* pRenderOptions,
 
 	StoreCullMode(mCullFaceInfo);
 	mLastCullingMode = kFBCullingOff;
+	mLastVertexFormat = 0xFFFFFFFF;
 
 	if (Transparency != kFBAlphaSourceNoAlpha)
 	{
@@ -226,6 +232,9 @@ void SuperDynamicLighting::ShaderPassTypeBegin(FBRenderOptions* pRenderOptions,
 	// global camera cache and scene lights
 	mSceneManager->BeginShading(pRenderOptions);
 
+	if (mpLightShader)
+		mpLightShader->ResetStateCounters();
+
 	// bind a shader here, prepare a global scene light set
 	if (!mpLightShader->BeginShading(pRenderOptions, nullptr))
 	{
@@ -263,6 +272,14 @@ void SuperDynamicLighting::ShaderPassTypeEnd(FBRenderOptions* pRenderOptions, FB
 	// global unbind
 	mpLightShader->EndShading();
 
+	if (LogStateChanges)
+	{
+		const Graphics::TStateCounters &counters = mpLightShader->GetStateCounters();
+		FBTrace("[SuperDynamicLighting] pass %d - models %d, cull changes %d, vertex format changes %d, material switches %d (uploads %d), texture binds %d (skipped %d)\n",
+			(int)pPass, counters.models, counters.cullChanges, counters.vertexFormatChanges,
+			counters.materialSwitches, counters.materialUploads, counters.textureBinds, counters.textureBindsSkipped);
+	}
+
 	FetchCullMode(mCullFaceInfo);
 
 	if (Shadows)
@@ -378,10 +395,13 @@ void SuperDynamicLighting::ShaderPassModelDraw(FBRenderOptions* pRenderOptions,
 			}
 
 			mLastCullingMode = cullMode;
+			mpLightShader->GetStateCounters().cullChanges += 1;
 			//((CRenderOptions&)options).SetLastCullingMode(cullMode);
 		}
 	}
 
+	mpLightShader->GetStateCounters().models += 1;
+
 	mpLightShader->ShaderPassModelDraw(pRenderOptions, pPass, pInfo, mNeedUpdateTextures);
 
 	// bind vertex buffers
@@ -390,6 +410,13 @@ void SuperDynamicLighting::ShaderPassModelDraw(FBRenderOptions* pRenderOptions,
 	if (nullptr != lInfo && false == pRenderOptions->IsIDBufferRendering())
 	{
 		lInfo->Bind();
+
+		const unsigned int vertexFormat = lInfo->GetVertexFormat();
+		if (vertexFormat != mLastVertexFormat)
+		{
+			mpLightShader->GetStateCounters().vertexFormatChanges += 1;
+			mLastVertexFormat = vertexFormat;
+		}
 	}
 
 }
@@ -156,6 +156,7 @@ public:
 	//
 	FBPropertyBool				SwitchAlbedoTosRGB;
 	FBPropertyBool				ForceUpdateTextures;
+	FBPropertyBool				LogStateChanges;		//!< print gl state changes of every shading pass
 
 	// Rim lighting
 	FBPropertyAnimatableDouble			UseRim;
@@ -200,6 +201,7 @@ protected:
 	
 	OGLCullFaceInfo			mCullFaceInfo;
 	FBModelCullingMode		mLastCullingMode;
+	unsigned int			mLastVertexFormat;
 
 	bool					mHasExclusiveLights;
 
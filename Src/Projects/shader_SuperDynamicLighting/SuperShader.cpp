@@ -12,6 +12,7 @@ Licensed under The "New" BSD License - https ://github.com/Neill3d/OpenMoBu/blob
 #include "CheckGLError.h"
 #include "mobu_logging.h"
 #include <map>
+#include <string.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include "glm_utils.h"
 
@@ -375,10 +376,33 @@ namespace Graphics {
 
 
 
+	void SuperShader::ResetLastBinds()
+	{
+		mHasLastMaterialBlock = false;
+		for (int i = 0; i < 8; ++i)
+			mLastSlotTexId[i] = 0;
+	}
+
+	void SuperShader::BindSamplerTexture(const GLuint slot, const GLuint texId)
+	{
+		if (mLastSlotTexId[slot] == texId)
+		{
+			mStateCounters.textureBindsSkipped += 1;
+			return;
+		}
+
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_2D, texId);
+
+		mLastSlotTexId[slot] = texId;
+		mStateCounters.textureBinds += 1;
+	}
+
 	bool SuperShader::BeginShading(FBRenderOptions* pRenderOptions, FBArrayTemplate<FBLight*>* pAffectingLightList)
 	{
 		mLastBinded = nullptr;
 		mLastLightmapId = 0;
+		ResetLastBinds();
 
 		if (!pRenderOptions->IsIDBufferRendering())
 		{
@@ -450,6 +474,8 @@ namespace Graphics {
 				glActiveTexture(GL_TEXTURE0+i);
 				glBindTexture(GL_TEXTURE_2D, 0);
 			}
+
+			ResetLastBinds();
 		}
 
 		if (0 != mLastTexId)
@@ -521,17 +547,31 @@ namespace Graphics {
 			if (!pRenderOptions->IsIDBufferRendering())
 			{
 				TMaterial lMaterial;
+				memset(&lMaterial, 0, sizeof(TMaterial));
 				SetMaterial(lMaterial, pMaterial);
 				lMaterial.shaderTransparency = static_cast<float>(pShaderTransparencyFactor);
 
 				// DONE: prepare SSBO
-				mBufferMaterial.UpdateData(sizeof(TMaterial), 1, &lMaterial);
+				const bool isNewBlock = (false == mHasLastMaterialBlock || true == forceUpdate
+					|| 0 != memcmp(&lMaterial, &mLastMaterialBlock, sizeof(TMaterial)));
+
+				// consecutive models with the same material are not a switch
+				if (pMaterial != mLastMaterial || isNewBlock)
+					mStateCounters.materialSwitches += 1;
+				mLastMaterial = pMaterial;
+
+				if (isNewBlock)
+				{
+					mBufferMaterial.UpdateData(sizeof(TMaterial), 1, &lMaterial);
+					mLastMaterialBlock = lMaterial;
+					mHasLastMaterialBlock = true;
+					mStateCounters.materialUploads += 1;
+				}
 				mBufferMaterial.Bind(1);
 
 				if (dispId > 0 && lMaterial.useDisplacement > 0.0f)
 				{
-					glActiveTexture(GL_TEXTURE0 + SAMPLER_SLOT_DISPLACE);
-					glBindTexture(GL_TEXTURE_2D, dispId);
+					BindSamplerTexture(SAMPLER_SLOT_DISPLACE, dispId);
 
 					FBColor dispColor = pMaterial->DisplacementColor;
 					const double *dispMatrix = pMaterial->GetTexture(kFBMaterialTextureDisplacementColor)->GetMatrix();
@@ -546,18 +586,15 @@ namespace Graphics {
 
 				if (specId > 0 && lMaterial.useSpecular > 0.0f)
 				{
-					glActiveTexture(GL_TEXTURE0 + SAMPLER_SLOT_SPECULAR);
-					glBindTexture(GL_TEXTURE_2D, specId);
+					BindSamplerTexture(SAMPLER_SLOT_SPECULAR, specId);
 				}
 				if (transId > 0 && lMaterial.useTransparency > 0.0f)
 				{
-					glActiveTexture(GL_TEXTURE0 + SAMPLER_SLOT_TRANSPARENCY);
-					glBindTexture(GL_TEXTURE_2D, transId);
+					BindSamplerTexture(SAMPLER_SLOT_TRANSPARENCY, transId);
 				}
 				if (normId > 0 && lMaterial.useNormalmap > 0.0f)
 				{
-					glActiveTexture(GL_TEXTURE0 + SAMPLER_SLOT_NORMAL);
-					glBindTexture(GL_TEXTURE_2D, normId);
+					BindSamplerTexture(SAMPLER_SLOT_NORMAL, normId);
 
 					glEnableVertexAttribArray(3);
 				}
@@ -567,8 +604,7 @@ namespace Graphics {
 				}
 				if (reflId > 0 && lMaterial.useReflect > 0.0f)
 				{
-					glActiveTexture(GL_TEXTURE0 + SAMPLER_SLOT_REFLECT);
-					glBindTexture(GL_TEXTURE_2D, reflId);
+					BindSamplerTexture(SAMPLER_SLOT_REFLECT, reflId);
 				}
 
 				if (ambId > 0)
@@ -837,7 +873,7 @@ namespace Graphics {
 
 		if (dirLights >= 0 || lights >= 0)
 		{
-			pShaderLights->Bind(mShaderShading->GetFragmentShader(), dirLights, lights);
+			pShaderLights->Bind(mShaderShading->GetProgramObj(), dirLights, lights);
 			UploadLightingInformation(pShaderLights->GetNumberOfTransformedDirLights(), pShaderLights->GetNumberOfTransformedSpotLights());
 
 			mLastLightsBinded = (LightGPUBuffersManager*)pShaderLights;
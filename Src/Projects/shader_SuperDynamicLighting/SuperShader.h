@@ -33,6 +33,18 @@ namespace Graphics
 	//////////////////////////////////////////////////////////////////
 	// SuperShader
 
+	// number of gl state changes during a shading pass
+	struct TStateCounters
+	{
+		int		models{ 0 };
+		int		cullChanges{ 0 };
+		int		materialSwitches{ 0 };		// material or its block differs from the previous model
+		int		materialUploads{ 0 };		// material block is uploaded only when it differs from the last one
+		int		textureBinds{ 0 };
+		int		textureBindsSkipped{ 0 };
+		int		vertexFormatChanges{ 0 };
+	};
+
 	class SuperShader
 	{
 	public:
@@ -56,6 +68,9 @@ namespace Graphics
 
 		void UploadModelViewMatrixArrayForDrawInstanced(const double* pModelViewMatrixArray, int pCount);
 
+		TStateCounters& GetStateCounters() { return mStateCounters; }
+		void ResetStateCounters() { mStateCounters = TStateCounters(); }
+
 	protected:
 
 		struct BufferIdLocations
@@ -96,6 +111,16 @@ namespace Graphics
 
 		TTransform					mLastTransform;
 
+		// skip redundant material uploads and texture binds
+		TMaterial					mLastMaterialBlock;
+		bool						mHasLastMaterialBlock{ false };
+		GLuint						mLastSlotTexId[8]{ 0 };
+
+		TStateCounters				mStateCounters;
+
+		void ResetLastBinds();
+		void BindSamplerTexture(const GLuint slot, const GLuint texId);
+
 		// DONE:: SSBO for transform and global settings, material, lights
 		GPUBufferSSBO				mBufferTransform;
 		GPUBufferSSBO				mBufferMaterial;
@@ -13,6 +13,13 @@
 
 #include "SuperShaderModelInfo.h"
 
+#include <map>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdint.h>
+
 #define VERTEX_ATTRIBUTE_POSITION		0
 #define VERTEX_ATTRIBUTE_NORMAL			2
 #define VERTEX_ATTRIBUTE_UV				1
@@ -21,6 +28,123 @@
 
 typedef unsigned char       BYTE;
 
+// number of not used cached buffers before the oldest one is freed
+#define MAX_UNUSED_UVSETS_BUFFERS		64
+// number of words taken from every geometry array for a topology hash
+#define UVSETS_HASH_SAMPLES				1024
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// uv sets buffers cache
+//  an expansion of a second uv set is heavy for a dense mesh, so the result is kept by geometry and uv set name,
+//  a topology hash tells when geometry is changed. Buffers stay in the cache when a shader is swapped
+
+struct UVSetsVertex
+{
+	float	uv0[2];
+	float	uv1[2];
+};
+
+struct UVSetsBuffer
+{
+	GLuint		id{ 0 };
+	int			count{ 0 };		// number of renderable vertices
+	uint64_t	hash{ 0 };
+	int			refCount{ 0 };
+	unsigned	lastUsed{ 0 };
+};
+
+typedef std::pair<FBGeometry*, std::string>	UVSetsKey;
+
+static std::map<UVSetsKey, UVSetsBuffer>	gUVSetsBuffers;
+static unsigned								gUVSetsCounter = 0;
+
+static uint64_t HashValue(uint64_t hash, const uint64_t value)
+{
+	// FNV-1a step over a whole word
+	hash ^= value;
+	hash *= 1099511628211ULL;
+	return hash;
+}
+
+// arrays are walked word-wise over an even sample, array pointers and counts are hashed as well,
+//  so a topology change shows up without reading every element of a dense mesh
+static uint64_t HashSample(uint64_t hash, const void *data, const int count, const int wordsPerElement)
+{
+	hash = HashValue(hash, (uint64_t) data);
+	hash = HashValue(hash, (uint64_t) count);
+
+	if (nullptr == data || count <= 0)
+		return hash;
+
+	const uint32_t *words = (const uint32_t*)data;
+	const size_t numberOfWords = static_cast<size_t>(count) * wordsPerElement;
+	const size_t step = (std::max)(size_t(1), numberOfWords / UVSETS_HASH_SAMPLES);
+
+	for (size_t i = 0; i < numberOfWords; i += step)
+		hash = HashValue(hash, words[i]);
+
+	return HashValue(hash, words[numberOfWords - 1]);
+}
+
+static void FreeOldestUnusedUVSetsBuffer()
+{
+	int numberOfUnused = 0;
+	auto oldest = end(gUVSetsBuffers);
+
+	for (auto iter = begin(gUVSetsBuffers); iter != end(gUVSetsBuffers); ++iter)
+	{
+		if (iter->second.refCount > 0)
+			continue;
+
+		numberOfUnused += 1;
+		if (oldest == end(gUVSetsBuffers) || iter->second.lastUsed < oldest->second.lastUsed)
+			oldest = iter;
+	}
+
+	if (numberOfUnused > MAX_UNUSED_UVSETS_BUFFERS && oldest != end(gUVSetsBuffers))
+	{
+		glDeleteBuffers(1, &oldest->second.id);
+		gUVSetsBuffers.erase(oldest);
+	}
+}
+
+void SuperShaderModelInfo::FreeUnusedUVSetsBuffers()
+{
+	for (auto iter = begin(gUVSetsBuffers); iter != end(gUVSetsBuffers); )
+	{
+		if (iter->second.refCount <= 0)
+		{
+			glDeleteBuffers(1, &iter->second.id);
+			iter = gUVSetsBuffers.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+// split [0; count) into ranges between threads
+template<typename F>
+static void ParallelRanges(const int count, F fn)
+{
+	const int numThreads = (std::max)(1, (std::min)(static_cast<int>(std::thread::hardware_concurrency()), count / 4096));
+
+	std::vector<std::thread>	threads;
+
+	auto computeRange = [&fn, count, numThreads](const int threadIndex)
+	{
+		fn(count * threadIndex / numThreads, count * (threadIndex + 1) / numThreads);
+	};
+
+	for (int i = 1; i < numThreads; ++i)
+		threads.emplace_back(computeRange, i);
+	computeRange(0);
+
+	for (auto &thread : threads)
+		thread.join();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 
@@ -29,7 +153,7 @@ void SuperShaderModelInfo::BufferData::Bind()
 	if (id > 0)
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, id);
-		glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)pOffset);
+		glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)pOffset);
 	}
 }
 
@@ -94,8 +218,10 @@ SuperShaderModelInfo::SuperShaderModelInfo(FBShader* pShader, HKModelRenderInfo
 	: FBShaderModelInfo(pShader, pInfo, pSubRegionIndex)
 	, mShader(pShader)
 {
-	mBufferCount = 0;
+	mUVSetsBuffer = nullptr;
 	mBufferId = 0;
+	mBufferOffset = nullptr;
+	mBufferStride = 0;
 	mLocationId = 0;
 
 	//mMeshIndex = 0;
@@ -104,11 +230,7 @@ SuperShaderModelInfo::SuperShaderModelInfo(FBShader* pShader, HKModelRenderInfo
 //! a destructor
 SuperShaderModelInfo::~SuperShaderModelInfo()
 {
-	if (mBufferId)
-	{
-		glDeleteBuffers( 1, &mBufferId );
-		mBufferId = 0;
-	}
+	ReleaseUVSets();
 
 	//FBShaderModelInfo::~FBShaderModelInfo();
 }
@@ -147,6 +269,22 @@ bool SuperShaderModelInfo::IsSecondUVSetNeeded()
 }
 
 
+void SuperShaderModelInfo::ReleaseUVSets()
+{
+	if (nullptr != mUVSetsBuffer)
+	{
+		mUVSetsBuffer->refCount -= 1;
+		mUVSetsBuffer->lastUsed = ++gUVSetsCounter;
+		mUVSetsBuffer = nullptr;
+
+		FreeOldestUnusedUVSetsBuffer();
+	}
+
+	mBufferId = 0;
+	mBufferOffset = nullptr;
+	mBufferStride = 0;
+}
+
 bool SuperShaderModelInfo::PrepareUVSets()
 {
 	FBModel *pModel = GetFBModel();
@@ -154,29 +292,41 @@ bool SuperShaderModelInfo::PrepareUVSets()
 
 	FBModelVertexData *lModelVertexData = pModel->ModelVertexData;
 	FBGeometry *pGeometry = pModel->Geometry;
+	if (nullptr == lModelVertexData || nullptr == pGeometry) return false;
+
 	const GLuint uvId = lModelVertexData->GetUVSetVBOId();
+	void *uvOffset = lModelVertexData->GetUVSetVBOOffset();
+
+	ReleaseUVSets();
+
+	// model uv buffer is used by default
+	mBufferId = uvId;
+	mBufferOffset = uvOffset;
 
-	FBString uvset("");
 	FBStringList uvSets = pGeometry->GetUVSets();
 
 	if (uvSets.GetCount() < 2) 
 	{
-		mBufferId = uvId;
 		return false;
 	}
 
+	// texture uv set, the first uv set is already in the model uv buffer
+	FBString uvset("");
+
 	for (int i=0; i<pModel->Textures.GetCount(); ++i)
 	{
 		FBTexture *pTexture = pModel->Textures[i];
 		FBProperty *lProp = pTexture->PropertyList.Find( "UVSet" );
 		if (lProp)
 		{
-			FBString str(lProp->AsString() );
+			const char *str = lProp->AsString();
+			if (nullptr == str || 0 == str[0])
+				continue;
 
-			for (int j=0; j<uvSets.GetCount(); ++j)
-				if ( str == uvSets[j] )
+			for (int j=1; j<uvSets.GetCount(); ++j)
+				if ( 0 == strcmp(str, uvSets[j]) )
 				{
-					uvset = lProp->AsString();
+					uvset = str;
 					break;
 				}
 		}
@@ -184,33 +334,27 @@ bool SuperShaderModelInfo::PrepareUVSets()
 
 	if (uvset == "")
 	{
-		mBufferId = uvId;
 		return false;
 	}
 
 	//
-	// lets manually prepare second uvset
-	
-	// TODO: include two uv sets in one buffer !
+	// lets manually prepare second uvset and put both uv sets in one buffer
 				
 	int uvIndCount = 0;
 	int uvCount = 0;
 			
 	FBGeometryReferenceMode refMode = pGeometry->GetUVSetReferenceMode( uvset );
-	FBGeometryMappingMode mapping = pGeometry->GetUVSetMappingMode( uvset );
 			
 	int *uvIndices = pGeometry->GetUVSetIndexArray(uvIndCount, uvset );
 	FBUV *uvs = pGeometry->GetUVSetDirectArray( uvCount, uvset );
 
-	//int *indices = lModelVertexData->GetIndexArray();
-
 	int vertCount = pGeometry->VertexCount();
 	int vertCountRenderable = lModelVertexData->GetVertexCount();
 
 	int dublicatedCount = 0;
 	const int *dublicatedIndices = lModelVertexData->GetVertexArrayDuplicationMap( (unsigned int &) dublicatedCount );
 
-	if (dublicatedCount < 0)
+	if (dublicatedCount < 0 || nullptr == dublicatedIndices)
 	{
 		dublicatedCount = 0;
 		dublicatedIndices = nullptr;
@@ -219,104 +363,144 @@ bool SuperShaderModelInfo::PrepareUVSets()
 	int numPolyIndices = 0;
 	const int *polyIndices = ( (FBMesh*) pGeometry)->PolygonVertexArrayGet( numPolyIndices );
 
-		
-	if (mBufferId && (uvIndCount != mBufferCount) )
-	{
-		glDeleteBuffers(1, &mBufferId);
-		mBufferId = 0;
-	}
+	if (0 == uvId || nullptr == uvs || vertCountRenderable <= 0 || vertCount > vertCountRenderable)
+		return false;
 
-	if (mBufferId == 0)
-	{
-				
-		switch(mapping)
-		{
-		case kFBGeometryMapping_BY_CONTROL_POINT:
-			break;
+	if (kFBGeometryReference_INDEX_TO_DIRECT == refMode && (nullptr == uvIndices || nullptr == polyIndices))
+		return false;
 
-		case kFBGeometryMapping_BY_POLYGON_VERTEX:
+	// topology hash
+	uint64_t hash = 14695981039346656037ULL;
+	hash = HashValue(hash, (uint64_t) vertCount);
+	hash = HashValue(hash, (uint64_t) vertCountRenderable);
+	hash = HashValue(hash, (uint64_t) refMode);
+	hash = HashValue(hash, (uint64_t) uvOffset);
+	hash = HashSample(hash, polyIndices, numPolyIndices, 1);
+	hash = HashSample(hash, uvIndices, uvIndCount, 1);
+	hash = HashSample(hash, dublicatedIndices, dublicatedCount, 1);
+	hash = HashSample(hash, uvs, uvCount, sizeof(FBUV) / sizeof(uint32_t));
+
+	const UVSetsKey key(pGeometry, std::string(uvset));
+	UVSetsBuffer &buffer = gUVSetsBuffers[key];
+
+	if (buffer.id > 0 && buffer.hash == hash && buffer.count == vertCountRenderable)
+	{
+		// cached
+		buffer.refCount += 1;
+		buffer.lastUsed = ++gUVSetsCounter;
+
+		mUVSetsBuffer = &buffer;
+		mBufferId = buffer.id;
+		mBufferOffset = (void*) sizeof(UVSetsVertex::uv0);
+		mBufferStride = sizeof(UVSetsVertex);
+		return true;
+	}
 
-			//printf ("polygon vertex" );
+	std::vector<UVSetsVertex> temp(vertCountRenderable);
 
-			break;
-		}
+	// the first uv set is taken from the model uv buffer, so it's exactly what the model is rendered with
+	std::vector<float> uv0(2 * vertCountRenderable);
+	glBindBuffer(GL_ARRAY_BUFFER, uvId);
+	glGetBufferSubData(GL_ARRAY_BUFFER, (GLintptr) uvOffset, sizeof(float) * 2 * vertCountRenderable, uv0.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		FBUV *temp = new FBUV[vertCountRenderable];
-		BYTE *flags = new BYTE[vertCount];
-		BYTE *dubFlags = (dublicatedCount>0) ? new BYTE[dublicatedCount] : nullptr;
+	// renderable vertex for every polygon vertex,
+	//  first time a control point is met it goes to itself, then to the next not used duplicate of it
+	std::vector<int> targets;
 
-		memset( flags, 0, sizeof(BYTE) * vertCount );
+	if (kFBGeometryReference_INDEX_TO_DIRECT == refMode)
+	{
+		std::vector<int> dubStart(vertCount + 1, 0);
+		std::vector<int> dubSlots(dublicatedCount);
 		
-		if (dublicatedCount > 0)
-			memset( dubFlags, 0, sizeof(BYTE) * dublicatedCount );
-
-		//int lastUpperIndex = vertCount;
-
-		for (int i=0; i<uvIndCount; ++i)
+		for (int j=0; j<dublicatedCount; ++j)
 		{
-			switch(refMode)
-			{
-			case kFBGeometryReference_DIRECT:
-				temp[i] = uvs[i];
-				break;
-			case kFBGeometryReference_INDEX_TO_DIRECT:
-
-				// i - index in polygon vertex space
-				// idx = index in control point space
-				int idx = polyIndices[i];
-
-				FBUV uv = uvs[ uvIndices[i] ];
-
-				if (flags[idx] == 0)
-				{
-					temp[idx] = uv;
-					flags[idx] = 1;
-				}
-				else
-				{
-					for (int j=0; j<dublicatedCount; ++j)
-					{
-						if ( (dublicatedIndices[j] == idx) && (dubFlags[j] == 0) )
-						{
-							temp[ vertCount + j ] = uv;
-
-							dubFlags[j] = 1;
-							break;
-						}
-					}
-
-				}
-
-				break;
-			}
+			const int idx = dublicatedIndices[j];
+			if (idx >= 0 && idx < vertCount)
+				dubStart[idx + 1] += 1;
 		}
+		for (int j=0; j<vertCount; ++j)
+			dubStart[j + 1] += dubStart[j];
 
-		glGenBuffers(1, &mBufferId);
-		glBindBuffer(GL_ARRAY_BUFFER, mBufferId);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * uvIndCount, temp, GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		mBufferCount = uvIndCount;
-			
-		// free mem
-		if (nullptr != dubFlags)
+		std::vector<int> dubNext(dubStart.begin(), dubStart.end() - 1);
+		for (int j=0; j<dublicatedCount; ++j)
 		{
-			delete [] dubFlags;
-			dubFlags = nullptr;
+			const int idx = dublicatedIndices[j];
+			if (idx >= 0 && idx < vertCount)
+				dubSlots[dubNext[idx]++] = j;
 		}
+		std::copy(dubStart.begin(), dubStart.end() - 1, dubNext.begin());
 
-		if (nullptr != flags)
+		std::vector<BYTE> flags(vertCount, 0);
+		const int count = (std::min)(uvIndCount, numPolyIndices);
+		targets.resize(count, -1);
+
+		for (int i=0; i<count; ++i)
 		{
-			delete [] flags;
-			flags = nullptr;
+			// i - index in polygon vertex space
+			// idx = index in control point space
+			const int idx = polyIndices[i];
+			if (idx < 0 || idx >= vertCount)
+				continue;
+
+			if (flags[idx] == 0)
+			{
+				targets[i] = idx;
+				flags[idx] = 1;
+			}
+			else if (dubNext[idx] < dubStart[idx + 1])
+			{
+				targets[i] = vertCount + dubSlots[dubNext[idx]++];
+			}
 		}
+	}
 
-		if (nullptr !=temp)
+	// interleave uv sets, vertices without a second uv get the first one
+	ParallelRanges(vertCountRenderable, [&temp, &uv0](const int begin, const int end) {
+		for (int i = begin; i < end; ++i)
 		{
-			delete [] temp;
-			temp = nullptr;
+			temp[i].uv0[0] = temp[i].uv1[0] = uv0[2 * i];
+			temp[i].uv0[1] = temp[i].uv1[1] = uv0[2 * i + 1];
 		}
+	});
+
+	if (kFBGeometryReference_DIRECT == refMode)
+	{
+		ParallelRanges((std::min)(uvCount, vertCountRenderable), [&temp, uvs](const int begin, const int end) {
+			for (int i = begin; i < end; ++i)
+				memcpy(temp[i].uv1, &uvs[i], sizeof(float) * 2);
+		});
+	}
+	else
+	{
+		// targets are unique, so threads never write the same vertex
+		ParallelRanges(static_cast<int>(targets.size()), [&temp, &targets, uvs, uvIndices, uvCount, vertCountRenderable](const int begin, const int end) {
+			for (int i = begin; i < end; ++i)
+			{
+				const int target = targets[i];
+				const int uvIndex = uvIndices[i];
+				if (target >= 0 && target < vertCountRenderable && uvIndex >= 0 && uvIndex < uvCount)
+					memcpy(temp[target].uv1, &uvs[uvIndex], sizeof(float) * 2);
+			}
+		});
 	}
+
+	if (0 == buffer.id)
+		glGenBuffers(1, &buffer.id);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(UVSetsVertex) * vertCountRenderable, temp.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	buffer.count = vertCountRenderable;
+	buffer.hash = hash;
+	buffer.refCount += 1;
+	buffer.lastUsed = ++gUVSetsCounter;
+
+	mUVSetsBuffer = &buffer;
+	mBufferId = buffer.id;
+	mBufferOffset = (void*) sizeof(UVSetsVertex::uv0);
+	mBufferStride = sizeof(UVSetsVertex);
 	
 	return true;
 }
@@ -329,12 +513,24 @@ void SuperShaderModelInfo::BindUVBuffer(const GLuint locationId)
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, mBufferId);
 		glEnableVertexAttribArray(locationId);
-		glVertexAttribPointer(locationId, 2, GL_FLOAT, GL_FALSE, sizeof(FBUV), (const GLvoid*) 0 );  // uv coords
+		glVertexAttribPointer(locationId, 2, GL_FLOAT, GL_FALSE, mBufferStride, (const GLvoid*) mBufferOffset );  // uv coords
 		
 		mLocationId = locationId;
 	}
 }
 
+unsigned int SuperShaderModelInfo::GetVertexFormat() const
+{
+	unsigned int format = 0;
+	if (mVertexData.tangent.id > 0)
+		format |= 1;
+	if (nullptr != mUVSetsBuffer)
+		format |= 2;
+	if (mBufferId > 0)
+		format |= 4;
+	return format;
+}
+
 void SuperShaderModelInfo::UnBindUVBuffer()
 {
 	if (mLocationId)
@@ -353,6 +549,10 @@ void SuperShaderModelInfo::UpdateModelShaderInfo(int pShader_Version)
 	{
 		PrepareUVSets();
 	}
+	else
+	{
+		ReleaseUVSets();
+	}
 
 	//CHECK_GL_ERROR_MOBU();
 
@@ -424,6 +624,18 @@ bool SuperShaderModelInfo::VertexDataFromFBModel(bool processTangentBuffer)
 	mVertexData.AssignBuffers( positionId, normalId, tangentId, uvId, uvId2, indexId );
 	mVertexData.AssignBufferOffsets( poffsets[0], poffsets[1], poffsets[2], poffsets[3], poffsets[4], nullptr );
 
+	// both uv sets are in the interleaved buffer
+	if (nullptr != mUVSetsBuffer)
+	{
+		mVertexData.uv.id = mUVSetsBuffer->id;
+		mVertexData.uv.pOffset = nullptr;
+		mVertexData.uv.stride = sizeof(UVSetsVertex);
+	}
+	else
+	{
+		mVertexData.uv.stride = 0;
+	}
+
 	// compute deformations on GPU
 	pVertexData->VertexArrayMappingRelease();
 
@@ -29,6 +29,9 @@
 
 const unsigned int	kFBGeometryArrayID_SecondUVSet          =  1 << 5;     //!< ID to the Second UVSet Array
 
+// interleaved uv0 / uv1 buffer, shared between model infos of the same geometry
+struct UVSetsBuffer;
+
 class SuperShaderModelInfo : public FBShaderModelInfo
 {
 public:
@@ -42,6 +45,9 @@ public:
 	//! To be overloaded, always be called when Model or Shader version out of date.
 	virtual void UpdateModelShaderInfo(int pShader_Version) override;
 
+	//! free cached uv sets buffers which are not used by any model info
+	static void FreeUnusedUVSetsBuffers();
+
 	// VAO
 	void	Bind();
 	void	UnBind();
@@ -51,6 +57,9 @@ public:
 	// only uv buffer
 	void	BindUVBuffer(const GLuint locationId);
 	void	UnBindUVBuffer();
+
+	// attributes layout of the model buffers, used to count format changes between draws
+	unsigned int GetVertexFormat() const;
 	/*
 	const int GetCachedMeshIndex() const {
 		return mMeshIndex;
@@ -61,8 +70,10 @@ protected:
 	FBShader			*mShader;
 
 	// buffer for support 2 sets of UVs
-	int					mBufferCount;
-	GLuint				mBufferId;
+	UVSetsBuffer		*mUVSetsBuffer;	// cached interleaved buffer, nullptr when second uv set is not used
+	GLuint				mBufferId;		// not owned, interleaved buffer or model uv buffer
+	void				*mBufferOffset;
+	GLsizei				mBufferStride;
 	GLuint				mLocationId;
 	
 	// 
@@ -71,6 +82,7 @@ protected:
 		GLuint		location;
 		GLuint		id;
 		GLuint		components;
+		GLsizei		stride;
 		void		*pOffset;
 
 		BufferData(GLuint _location, GLuint _components)
@@ -78,6 +90,7 @@ protected:
 			, components(_components)
 		{
 			id = 0;
+			stride = 0;
 			pOffset = nullptr;
 		}
 
@@ -117,5 +130,6 @@ protected:
 
 	bool			IsSecondUVSetNeeded();
 	bool			PrepareUVSets();	// make a buffer with two uvsets inside
+	void			ReleaseUVSets();
 	bool			VertexDataFromFBModel(bool processTangentBuffer);
 };
\ No newline at end of file
@@ -14,6 +14,16 @@
 //--- Class declaration
 #include "ortexture_advanceBlend_texture.h"
 #include <gl\glew.h>
+#include <exception>
+#include <algorithm>
+
+#include "FileUtils.h"
+
+#define LAYERS_VERTEX_SHADER		"\\GLSL\\compositeLayers.vsh"
+#define LAYERS_FRAGMENT_SHADER		"\\GLSL\\compositeLayers.fsh"
+
+// texture units of a single pass composition, masks go after layers
+#define LAYERS_MASK_UNIT			MAX_NUMBER_OF_BLEND_LAYERS
 
 FBClassImplementation( ORTextureAdvanceBlend );					        //Register class
 FBStorableCustomTextureImplementation( ORTextureAdvanceBlend, Texture );	//Register to the store/retrieve system
@@ -64,6 +74,14 @@ static void ORTextureAdvanceBlend_BlendMode2Set(HIObject pMbObject, ECompositeBl
     pFbObject->SetLayerConfigDirty();
 }
 
+template<int INDEX>
+static void ORTextureAdvanceBlend_LayerBlendModeSet(HIObject pMbObject, ECompositeBlendType pValue)
+{
+    ORTextureAdvanceBlend* pFbObject = FBCast<ORTextureAdvanceBlend>( pMbObject );
+    pFbObject->LayerBlendMode[INDEX].SetPropertyValue(pValue);
+    pFbObject->SetLayerConfigDirty();
+}
+
 /************************************************
  *	FiLMBOX Constructor.
  ************************************************/
@@ -77,6 +95,11 @@ bool ORTextureAdvanceBlend::FBCreate()
 	FBPropertyPublish(this, UseMask, "Use Mask", nullptr, ORTextureAdvanceBlend_UseMaskSet );
 	FBPropertyPublish(this, Mask, "Mask", nullptr, nullptr );
 	
+	static_assert(MAX_NUMBER_OF_BLEND_LAYERS == 4, "publish blend mode and mask properties for every additional layer");
+	FBPropertyPublish(this, LayerBlendMode[0], "Blend Mode Layer 3", nullptr, ORTextureAdvanceBlend_LayerBlendModeSet<0> );
+	FBPropertyPublish(this, LayerBlendMode[1], "Blend Mode Layer 4", nullptr, ORTextureAdvanceBlend_LayerBlendModeSet<1> );
+	FBPropertyPublish(this, LayerMask[0], "Mask Layer 3", nullptr, nullptr );
+	FBPropertyPublish(this, LayerMask[1], "Mask Layer 4", nullptr, nullptr );
 
 	BackgroundColor = FBColorAndAlpha(1.0, 1.0, 1.0, 1.0);
     CustomComposition = true;
@@ -88,6 +111,18 @@ bool ORTextureAdvanceBlend::FBCreate()
 	Mask.SetFilter( FBTexture::GetInternalClassId() );
 	Mask.SetSingleConnect(true);
 
+	for (int i = 0; i < MAX_NUMBER_OF_BLEND_LAYERS - 2; ++i)
+	{
+		LayerBlendMode[i] = eCompositeBlendAdd;
+		LayerMask[i].SetFilter( FBTexture::GetInternalClassId() );
+		LayerMask[i].SetSingleConnect(true);
+	}
+
+	memset(&mLayersBlock, 0, sizeof(LayersBlock));
+	mLastBackgroundColor = BackgroundColor;
+	for (int i = 0; i < MAX_NUMBER_OF_BLEND_LAYERS; ++i)
+		mLastLayerAlpha[i] = -1.0;
+
 	mLoaded = true;
 
     return true;
@@ -98,6 +133,7 @@ bool ORTextureAdvanceBlend::FBCreate()
  ************************************************/
 void ORTextureAdvanceBlend::FBDestroy()
 {
+	FreeLayersShader();
 	ParentClass::FBDestroy();
 }
 
@@ -138,14 +174,47 @@ bool ORTextureAdvanceBlend::EvaluateAnimationNodes( FBEvaluateInfo* pEvaluateInf
 {
     ParentClass::EvaluateAnimationNodes(pEvaluateInfo);
 
-    if (CustomComposition && BackgroundColor.IsAnimated())
+    if (CustomComposition)
     {
-        // Compute animatable property value in background evaluation thread.
-        FBPropertyAnimatableColorAndAlpha::ValueType lTmpValue;
-        BackgroundColor.GetData(lTmpValue.mValue, sizeof(lTmpValue.mValue), pEvaluateInfo);
+        bool lChanged = false;
 
-        // Trigger composition per frame.
-        SetLayerConfigDirty();
+        if (BackgroundColor.IsAnimated())
+        {
+            // Compute animatable property value in background evaluation thread.
+            FBPropertyAnimatableColorAndAlpha::ValueType lTmpValue;
+            BackgroundColor.GetData(lTmpValue.mValue, sizeof(lTmpValue.mValue), pEvaluateInfo);
+
+            for (int i = 0; i < 4; ++i)
+            {
+                if (lTmpValue.mValue[i] != mLastBackgroundColor[i])
+                {
+                    mLastBackgroundColor[i] = lTmpValue.mValue[i];
+                    lChanged = true;
+                }
+            }
+        }
+
+        // layer opacity is a part of a composition, default path doesn't track it
+        const int lCount = std::min(Layers.GetCount(), MAX_NUMBER_OF_BLEND_LAYERS);
+        for (int i = 1; i < lCount; ++i)
+        {
+            FBTexture* lLayer = Layers[i];
+            if (lLayer && lLayer->Alpha.IsAnimated())
+            {
+                double lAlpha = 1.0;
+                lLayer->Alpha.GetData(&lAlpha, sizeof(double), pEvaluateInfo);
+
+                if (lAlpha != mLastLayerAlpha[i])
+                {
+                    mLastLayerAlpha[i] = lAlpha;
+                    lChanged = true;
+                }
+            }
+        }
+
+        // Trigger composition only when an animated value is changed, not every frame.
+        if (lChanged)
+            SetLayerConfigDirty();
     }
 
     return true;
@@ -158,118 +227,351 @@ void ORTextureAdvanceBlend::TextureLayerComposition(FBTime pTime,FBTime pTimeInC
     //  Actually nothing is preventing user to do a more sophisticated real-time composition (keying and etc.,) 
     //  or even a full scene (or shadow map) RTT for advanced fancy tasks. 
     //
-	if (Layers.GetCount() <= 1 || !mSupported || !CustomComposition)
+	if (Layers.GetCount() <= 1 || Layers.GetCount() > MAX_NUMBER_OF_BLEND_LAYERS || !mSupported || !CustomComposition)
     {
         ParentClass::TextureLayerComposition(pTime, pTimeInCurrentTimeRef, pWidth, pHeight);
     }
-	else if (mLoaded && Layers.GetCount() == 2)
+	else if (mLoaded)
     {
-        //
-        //Render-To-Texture already setup. 
-        //
-
-        // Push GL states.
-        glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT);
-
-        // Clear Buffers.
-
-        // Default implementation use BackgroundColor property. Here AuxLayer is used for demo purpose. 
-        // FBColorAndAlpha lBgColor = BackgroundColor;
-        const FBColorAndAlpha lBgColor = BackgroundColor;
-        glClearColor(lBgColor[0], lBgColor[1], lBgColor[2], lBgColor[3]);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glViewport(0,0, pWidth, pHeight);
-
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
-        glLoadIdentity();
-        glOrtho(0, 1, 1, 0, -1, 1);
-
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_LIGHTING);
-        glDisable(GL_FOG);
-        glEnable(GL_TEXTURE_2D);
-        glDisable(GL_BLEND);
-		
-		// base, back layer
+		if (InitLayersShader())
+		{
+			ComposeLayers(pWidth, pHeight);
+		}
+		else if (Layers.GetCount() == 2)
+		{
+			// start every blend variant in background once, so a blend mode or a mask switch doesn't stall a viewport
+			if (false == mShadersRequested)
+			{
+				mShaderManager.RequestShaders(eCompositeShaderBlendNormal, eCompositeShaderBlendPhoenix, false);
+				mShaderManager.RequestShaders(eCompositeShaderBlendNormal, eCompositeShaderBlendPhoenix, true);
+				mShadersRequested = true;
+			}
+
+			const ECompositeShader shaderType = ECompositeShader(eCompositeShaderBlendNormal + BlendMode.AsInt());
+
+			// a blend variant is compiled in background, the default composition is used until it's linked
+			if (mShaderManager.IsShaderReady(shaderType, UseMask))
+			{
+				ComposeTwoLayers(pWidth, pHeight);
+			}
+			else if (mShaderManager.IsShaderPending(shaderType, UseMask))
+			{
+				ParentClass::TextureLayerComposition(pTime, pTimeInCurrentTimeRef, pWidth, pHeight);
+				SetLayerConfigDirty();
+			}
+			else
+			{
+				mLoaded = false;
+			}
+		}
+		else
+		{
+			ParentClass::TextureLayerComposition(pTime, pTimeInCurrentTimeRef, pWidth, pHeight);
+		}
+    }
+}
+
+bool ORTextureAdvanceBlend::InitLayersShader()
+{
+	if (mLayersShader)
+		return true;
+	if (mLayersShaderFailed)
+		return false;
+
+	try
+	{
+		if (!GLEW_VERSION_3_3 || !GLEW_ARB_uniform_buffer_object)
+			throw std::exception( "uniform buffers are not supported" );
+
+		char buffer[256]{ 0 };
+		if (false == FindEffectLocation( LAYERS_FRAGMENT_SHADER, buffer, 256) )
+			throw std::exception( "Failed to locate shader files" );
 
-		const ECompositeShader shaderType = ECompositeShader(eCompositeShaderBlendNormal + BlendMode.AsInt());
+		mLayersShader = new GLSLShader();
+		mLayersShader->SetHeaderText( "#version 330\n" );
 
-		FBTexture *lMask = (Mask.GetCount()>0) ? FBCast<FBTexture>(Mask.GetAt(0)) : nullptr;
-		const bool lUseMask = UseMask && (lMask != nullptr);
+		if (false == mLayersShader->LoadShaders( FBString(buffer, LAYERS_VERTEX_SHADER), FBString(buffer, LAYERS_FRAGMENT_SHADER) ) )
+			throw std::exception( "Failed to load shader" );
+
+		const GLuint program = static_cast<GLuint>(mLayersShader->GetProgramObj());
+		const GLuint blockIndex = glGetUniformBlockIndex(program, "LayersBlock");
+		if (GL_INVALID_INDEX == blockIndex)
+			throw std::exception( "Failed to find layers uniform block" );
+		
+		glUniformBlockBinding(program, blockIndex, 0);
 
-		if ( !mShaderManager.CheckAndLoadShader( shaderType, UseMask ) )
+		// samplers never change, assign texture units once
+		GLint layerUnits[MAX_NUMBER_OF_BLEND_LAYERS];
+		GLint maskUnits[MAX_NUMBER_OF_BLEND_LAYERS];
+		for (int i = 0; i < MAX_NUMBER_OF_BLEND_LAYERS; ++i)
 		{
-			mLoaded = false;
-			return;
+			layerUnits[i] = i;
+			maskUnits[i] = LAYERS_MASK_UNIT + i;
 		}
 
-		FBTexture* lTexture0 = Layers[0];
-		FBTexture* lTexture1 = Layers[1];
+		mLayersShader->Bind();
+		glUniform1iv(mLayersShader->findLocation("layerSamplers"), MAX_NUMBER_OF_BLEND_LAYERS, layerUnits);
+		glUniform1iv(mLayersShader->findLocation("maskSamplers"), MAX_NUMBER_OF_BLEND_LAYERS, maskUnits);
+		mLayersShader->UnBind();
+
+		const float quad[8] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+
+		glGenBuffers(1, &mQuadBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, mQuadBuffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		memset(&mLayersBlock, 0, sizeof(LayersBlock));
+
+		glGenBuffers(1, &mLayersBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, mLayersBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LayersBlock), &mLayersBlock, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+	catch (const std::exception &e)
+	{
+		FBTrace("[ORTextureAdvanceBlend] single pass composition is disabled - %s\n", e.what());
+		FreeLayersShader();
 		
-        // Binding the texture with proper parameters and matrix.
-        
-		const GLuint textureId0 = GetTextureId(lTexture0);
-		const GLuint textureId1 = GetTextureId(lTexture1);
+		// don't try to load it on every composition
+		mLayersShaderFailed = true;
+		return false;
+	}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textureId0);
+	return true;
+}
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, textureId1);
+void ORTextureAdvanceBlend::FreeLayersShader()
+{
+	if (mLayersShader)
+	{
+		delete mLayersShader;
+		mLayersShader = nullptr;
+	}
+	if (mLayersBuffer > 0)
+	{
+		glDeleteBuffers(1, &mLayersBuffer);
+		mLayersBuffer = 0;
+	}
+	if (mQuadBuffer > 0)
+	{
+		glDeleteBuffers(1, &mQuadBuffer);
+		mQuadBuffer = 0;
+	}
+}
 
-		if (lUseMask)
-		{
-			const GLuint maskId = GetTextureId(lMask);
+FBTexture *ORTextureAdvanceBlend::GetLayerMask(const int layerIndex)
+{
+	if (!UseMask || layerIndex <= 0)
+		return nullptr;
+
+	FBPropertyListObject &lMask = (layerIndex == 1) ? Mask : LayerMask[layerIndex - 2];
+	return (lMask.GetCount() > 0) ? FBCast<FBTexture>(lMask.GetAt(0)) : nullptr;
+}
+
+ECompositeBlendType ORTextureAdvanceBlend::GetLayerBlendMode(const int layerIndex)
+{
+	const int mode = (layerIndex <= 1) ? BlendMode.AsInt() : LayerBlendMode[layerIndex - 2].AsInt();
+	return static_cast<ECompositeBlendType>(mode);
+}
+
+void ORTextureAdvanceBlend::ComposeLayers(int pWidth, int pHeight)
+{
+	//
+	//Render-To-Texture already setup. 
+	//
+
+	const int lCount = Layers.GetCount();
+
+	// collect per layer parameters, the uniform buffer is updated only when something is changed
+
+	LayersBlock lBlock;
+	memset(&lBlock, 0, sizeof(LayersBlock));
+	lBlock.numberOfLayers[0] = lCount;
+
+	FBTexture *lMasks[MAX_NUMBER_OF_BLEND_LAYERS] = { nullptr };
+
+	for (int i = 1; i < lCount; ++i)
+	{
+		lMasks[i] = GetLayerMask(i);
+
+		lBlock.layerParams[i][0] = static_cast<float>(GetLayerBlendMode(i));
+		lBlock.layerParams[i][1] = static_cast<float>(Layers[i]->Alpha);
+		lBlock.layerParams[i][2] = (lMasks[i] != nullptr) ? 1.0f : 0.0f;
+	}
+
+	if (0 != memcmp(&lBlock, &mLayersBlock, sizeof(LayersBlock)))
+	{
+		mLayersBlock = lBlock;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, mLayersBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LayersBlock), &mLayersBlock);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT);
 
-			glActiveTexture(GL_TEXTURE7);
-			glBindTexture(GL_TEXTURE_2D, maskId);
+	const FBColorAndAlpha lBgColor = BackgroundColor;
+	glClearColor(lBgColor[0], lBgColor[1], lBgColor[2], lBgColor[3]);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glViewport(0,0, pWidth, pHeight);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	// all layers and masks are sampled in one fragment pass
+
+	for (int i = 0; i < lCount; ++i)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, GetTextureId(Layers[i]));
+
+		if (lMasks[i])
+		{
+			glActiveTexture(GL_TEXTURE0 + LAYERS_MASK_UNIT + i);
+			glBindTexture(GL_TEXTURE_2D, GetTextureId(lMasks[i]));
 		}
+	}
 
-		mShaderManager.Bind(shaderType, lUseMask);
-		float blendColor[4] = {1.0, 1.0, 1.0, 1.0};
-		mShaderManager.SetBlendUniforms(Layers[1]->Alpha, false, blendColor);
-
-        // TODO: replace this. Draw quad for blending.
-        glBegin(GL_POLYGON);
-        glTexCoord2f(0.0, 1.0);
-        glVertex2f(0.0, 0.0);
-        glTexCoord2f(0.0, 0.0);
-        glVertex2f(0.0, 1.0);
-        glTexCoord2f(1.0, 0.0);
-        glVertex2f(1.0, 1.0);
-        glTexCoord2f(1.0, 1.0);
-        glVertex2f(1.0, 0.0);						
-        glEnd();
-		
-		mShaderManager.UnBind();
+	mLayersShader->Bind();
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, mLayersBuffer);
+
+	// the shader works in normalized device coordinates, no need for fixed pipeline matrices
+	glBindBuffer(GL_ARRAY_BUFFER, mQuadBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glDisableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		if (lUseMask)
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, 0);
+	mLayersShader->UnBind();
+
+	for (int i = lCount - 1; i >= 0; --i)
+	{
+		if (lMasks[i])
 		{
-			glActiveTexture(GL_TEXTURE7);
+			glActiveTexture(GL_TEXTURE0 + LAYERS_MASK_UNIT + i);
 			glBindTexture(GL_TEXTURE_2D, 0);
 		}
 
-		glActiveTexture(GL_TEXTURE1);
+		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_2D, 0);
+	}
 
-		glActiveTexture(GL_TEXTURE0);
+	glPopAttrib();
+}
+
+void ORTextureAdvanceBlend::ComposeTwoLayers(int pWidth, int pHeight)
+{
+	//
+	//Render-To-Texture already setup. 
+	//
+
+	const ECompositeShader shaderType = ECompositeShader(eCompositeShaderBlendNormal + BlendMode.AsInt());
+
+	FBTexture *lMask = (Mask.GetCount()>0) ? FBCast<FBTexture>(Mask.GetAt(0)) : nullptr;
+	const bool lUseMask = UseMask && (lMask != nullptr);
+
+	if ( !mShaderManager.CheckAndLoadShader( shaderType, UseMask ) )
+	{
+		mLoaded = false;
+		return;
+	}
+
+	// Push GL states.
+	glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT);
+
+	// Clear Buffers.
+
+	// Default implementation use BackgroundColor property. Here AuxLayer is used for demo purpose. 
+	// FBColorAndAlpha lBgColor = BackgroundColor;
+	const FBColorAndAlpha lBgColor = BackgroundColor;
+	glClearColor(lBgColor[0], lBgColor[1], lBgColor[2], lBgColor[3]);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glViewport(0,0, pWidth, pHeight);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, 1, 1, 0, -1, 1);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_FOG);
+	glEnable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+		
+	// base, back layer
+
+	FBTexture* lTexture0 = Layers[0];
+	FBTexture* lTexture1 = Layers[1];
+		
+	// Binding the texture with proper parameters and matrix.
+    
+	const GLuint textureId0 = GetTextureId(lTexture0);
+	const GLuint textureId1 = GetTextureId(lTexture1);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textureId0);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, textureId1);
+
+	if (lUseMask)
+	{
+		const GLuint maskId = GetTextureId(lMask);
+
+		glActiveTexture(GL_TEXTURE7);
+		glBindTexture(GL_TEXTURE_2D, maskId);
+	}
+
+	mShaderManager.Bind(shaderType, lUseMask);
+	float blendColor[4] = {1.0, 1.0, 1.0, 1.0};
+	mShaderManager.SetBlendUniforms(Layers[1]->Alpha, false, blendColor);
+
+	// Draw quad for blending.
+	glBegin(GL_POLYGON);
+	glTexCoord2f(0.0, 1.0);
+	glVertex2f(0.0, 0.0);
+	glTexCoord2f(0.0, 0.0);
+	glVertex2f(0.0, 1.0);
+	glTexCoord2f(1.0, 0.0);
+	glVertex2f(1.0, 1.0);
+	glTexCoord2f(1.0, 1.0);
+	glVertex2f(1.0, 0.0);						
+	glEnd();
+		
+	mShaderManager.UnBind();
+
+	if (lUseMask)
+	{
+		glActiveTexture(GL_TEXTURE7);
 		glBindTexture(GL_TEXTURE_2D, 0);
+	}
 
-		//
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();
-        glMatrixMode(GL_MODELVIEW);
-        glPopMatrix();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-        // Pop GL states.
-        glPopAttrib();
-    }
+	//
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+
+	// Pop GL states.
+	glPopAttrib();
 }
 
 void ORTextureAdvanceBlend::SetUpBlendMode( const ECompositeBlendType mode )
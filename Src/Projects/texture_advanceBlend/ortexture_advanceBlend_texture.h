@@ -47,7 +47,7 @@
 //
 
 /**	Advance Blend modes texture.
-* Blend two texture layers with a given blend mode. Optionally it's possible to apply mask on second texture.
+* Blend up to MAX_NUMBER_OF_BLEND_LAYERS texture layers in one pass, every layer has own blend mode and optional mask.
 */
 FB_FORWARD(ORTextureAdvanceBlend);
 class ORTextureAdvanceBlend : public FBLayeredTexture
@@ -65,6 +65,10 @@ public:
 	FBPropertyBool						UseMask;
 	FBPropertyListObject				Mask;
 
+	// blend mode and mask for layers after the second one
+	FBPropertyBaseEnum<ECompositeBlendType>		LayerBlendMode[MAX_NUMBER_OF_BLEND_LAYERS - 2];
+	FBPropertyListObject				LayerMask[MAX_NUMBER_OF_BLEND_LAYERS - 2];
+
 	FBPropertyAnimatableColorAndAlpha   BackgroundColor;      //!< <b>Read/Write Property:</b> for a composition rendering, use the color as a background
     FBPropertyBool                      CustomComposition;    //!< <b>Read/Write Property:</b> Switch to default / custom composition method. 
 	/*
@@ -107,6 +111,7 @@ protected:
 
 	bool		mSupported{ false };
 	bool		mLoaded{ false };
+	bool		mShadersRequested{ false };	//!< blend variants are started up front on a first composition
 
 	void		SetUpBlendMode( const ECompositeBlendType mode );
 
@@ -114,6 +119,35 @@ protected:
 
 	CompositeShaderManager		mShaderManager;
 
+	//
+	// single pass composition of all layers
+
+	struct LayersBlock
+	{
+		float		layerParams[MAX_NUMBER_OF_BLEND_LAYERS][4];	// x - blend mode, y - opacity, z - use mask
+		int			numberOfLayers[4];
+	};
+
+	GLSLShader			*mLayersShader{ nullptr };
+	bool				mLayersShaderFailed{ false };
+
+	GLuint				mLayersBuffer{ 0 };		//!< uniform buffer with LayersBlock
+	GLuint				mQuadBuffer{ 0 };		//!< full screen quad vertices
+	LayersBlock			mLayersBlock;			//!< last uploaded uniform buffer data
+
+	// last evaluated values, composition is requested only when one of them is changed
+	FBColorAndAlpha		mLastBackgroundColor;
+	double				mLastLayerAlpha[MAX_NUMBER_OF_BLEND_LAYERS];
+
+	bool				InitLayersShader();
+	void				FreeLayersShader();
+
+	FBTexture			*GetLayerMask(const int layerIndex);
+	ECompositeBlendType	GetLayerBlendMode(const int layerIndex);
+
+	void				ComposeLayers(int pWidth, int pHeight);
+	void				ComposeTwoLayers(int pWidth, int pHeight);
+
 };
 
 
@@ -19,8 +19,12 @@
 #include "ClusterAdvance.h"
 #include "GeometryUtils.h"
 
+#include "BlendShapeToolkit_library.h"
+
 #include "tinyxml.h"
+#include "xmlPullParser.h"
 #include <string>
+#include <chrono>
 
 BlendShapeDeformerConstraint	*gTempConstraint = nullptr;		// this deform constraint is used for shaping
 
@@ -184,7 +188,7 @@ int AddBlendShape( FBModel *pBaseModel, FBModel *pModel )
 
 FBModel *CalculateDeformedMesh(FBModel *in)
 {
-	FBModel *pNewModel = MakeSnapshot(in, false);
+	FBModel *pNewModel = MakeSnapshot(in, false, true);
 
 	ClusterAdvance	clusterAdvance(in);
 	
@@ -555,168 +559,264 @@ void MakeNameUnique( const std::vector<std::string> &names, std::string &str )
 	}
 }
 
-bool	Blendshapes_LoadXML( FBModelList &modelList, const char *filename, const FBBlendShapeLoadMode mode )
+// find a shape to merge into or add a new one, name is made unique for the append mode
+int FindOrAddShape( FBGeometry *pGeometry, std::string &str, const FBBlendShapeLoadMode mode )
 {
+	int idx = -1;
+	if (mode == kFBShapeMerge)
+	{
+		for (int i=0; i<pGeometry->ShapeGetCount(); ++i)
+		{
+			FBString shapeName( pGeometry->ShapeGetName(i) );
+			if ( strcmp(shapeName, str.c_str() ) == 0 )
+			{
+				idx = i;
+				break;
+			}
+		}
+	}
+	else if (mode == kFBShapeAppend)
+	{
+		// check if the name is unique
+		std::vector< std::string > names;
+		names.resize(pGeometry->ShapeGetCount());
 
-	TiXmlDocument	doc;
+		for (int i=0; i<pGeometry->ShapeGetCount(); ++i)
+			names[i] = pGeometry->ShapeGetName(i);
 
-	if (doc.LoadFile( filename ) == false)
-	{
-		return false;
+		MakeNameUnique( names, str );
 	}
 
-	TiXmlNode *node = nullptr;
-	TiXmlElement *headElement = nullptr;
-	TiXmlElement *modelElement = nullptr;
-	TiXmlElement *shapeElement = nullptr;
-	TiXmlElement *difElement = nullptr;
-	TiXmlAttribute  *attrib = nullptr;
+	if (idx < 0) idx = pGeometry->ShapeAdd( str.c_str() );
+	return idx;
+}
+
+bool	Blendshapes_LoadXML( FBModelList &modelList, const char *filename, const FBBlendShapeLoadMode mode )
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// stream a file, a library could have millions of diff elements and a dom would keep all of them in memory
+	XmlPullParser	parser;
 
-	node = doc.FirstChild("Header");
-	if (node == nullptr)
+	if (parser.Open( filename ) == false)
 	{
 		return false;
 	}
 
-	headElement = node->ToElement();
-	if (headElement)
+	if (parser.NextChildElement(0) == false || parser.GetName().Equals("Header") == false)
 	{
-		modelElement = node->FirstChildElement("Model");
+		return false;
 	}
 
-	while (modelElement)
-	{
-		std::string str;
-		int numberOfShapes=0;
+	std::string str;
 
+	while (parser.NextChildElement(1, "Model"))
+	{
+		str = "";
+		
 		// enumerate attribs
-		for( attrib = modelElement->FirstAttribute();
-			 attrib;
-			 attrib = attrib->Next() )
+		for (int i=0; i<parser.GetNumberOfAttributes(); ++i)
 		{
-			const char * attribName = attrib->Name();
-			if ( strcmp(attribName, "name") == 0 )
-				str = attrib->ValueStr();
-			else if ( strcmp(attribName, "numberOfShapes") == 0 )
-				numberOfShapes = attrib->IntValue();
+			const XmlAttributeView &attrib = parser.GetAttribute(i);
+			if ( attrib.name.Equals("name") )
+				str = attrib.value.ToString();
 		}
 
+		// skip a model content when there is no such model in the scene
 		FBModel *pModel = FBFindModelByLabelName( str.c_str() );
-		if (pModel)
+		if (pModel == nullptr)
+			continue;
+
+		FBGeometry *pGeometry = pModel->Geometry;
+
+		if (mode == kFBShapeLoad)
+		{
+			pGeometry->ShapeClearAll();
+		}
+
+		while (parser.NextChildElement(2, "Shape"))
 		{
-			FBGeometry *pGeometry = pModel->Geometry;
-			shapeElement = modelElement->FirstChildElement( "Shape" );
+			str = "";
+			int numberOfDiffs = 0;
 
-			if (mode == kFBShapeLoad)
+			// enumerate attribs
+			for (int i=0; i<parser.GetNumberOfAttributes(); ++i)
 			{
-				pGeometry->ShapeClearAll();
+				const XmlAttributeView &attrib = parser.GetAttribute(i);
+				if ( attrib.name.Equals("name") )
+					str = attrib.value.ToString();
+				else if ( attrib.name.Equals("numberOfDiffs") )
+					numberOfDiffs = attrib.value.ToInt();
 			}
 
-			//pGeometry->GeometryBegin();
+			if (str == "")
+				continue;
 
-			while(shapeElement)
-			{
+			const int idx = FindOrAddShape( pGeometry, str, mode );
+			pGeometry->ShapeInit(idx, numberOfDiffs, true);
 
-				str = "";
-				int numberOfDiffs = 0;
+			for (int j=0; j<numberOfDiffs && parser.NextChildElement(3, "Diff"); ++j)
+			{
+				int OriIndex=0;
+				double posX=0.0;
+				double posY=0.0;
+				double posZ=0.0;
+				double norX=0.0;
+				double norY=0.0;
+				double norZ=0.0;
 
 				// enumerate attribs
-				for( attrib = shapeElement->FirstAttribute();
-					 attrib;
-					 attrib = attrib->Next() )
+				for (int i=0; i<parser.GetNumberOfAttributes(); ++i)
 				{
-					const char * attribName = attrib->Name();
-					if ( strcmp(attribName, "name") == 0 )
-						str = attrib->ValueStr();
-					else if ( strcmp(attribName, "numberOfDiffs") == 0 )
-						numberOfDiffs = attrib->IntValue();
+					const XmlAttributeView &attrib = parser.GetAttribute(i);
+					if ( attrib.name.Equals("OriIndex") )
+						OriIndex = attrib.value.ToInt();
+					else if ( attrib.name.Equals("PosX") )
+						posX = attrib.value.ToDouble();
+					else if ( attrib.name.Equals("PosY") )
+						posY = attrib.value.ToDouble();
+					else if ( attrib.name.Equals("PosZ") )
+						posZ = attrib.value.ToDouble();
+					else if ( attrib.name.Equals("NorX") )
+						norX = attrib.value.ToDouble();
+					else if ( attrib.name.Equals("NorY") )
+						norY = attrib.value.ToDouble();
+					else if ( attrib.name.Equals("NorZ") )
+						norZ = attrib.value.ToDouble();
 				}
 
-				if (str != "")
-				{
-					int idx = -1;
-					if (mode == kFBShapeMerge)
-					{
-						for (int i=0; i<pGeometry->ShapeGetCount(); ++i)
-						{
-							FBString shapeName( pGeometry->ShapeGetName(i) );
-							if ( strcmp(shapeName, str.c_str() ) == 0 )
-							{
-								idx = i;
-								break;
-							}
-						}
-					}
-					else if (mode == kFBShapeAppend)
-					{
-						// check if the name is unique
-						std::vector< std::string > names;
-						names.resize(pGeometry->ShapeGetCount());
+				pGeometry->ShapeSetDiffPoint( idx, j, OriIndex, FBVertex(posX, posY, posZ), FBNormal(norX, norY, norZ) );
+			}
+		}
 
-						for (int i=0; i<pGeometry->ShapeGetCount(); ++i)
-							names[i] = pGeometry->ShapeGetName(i);
+		pGeometry->ModifyNotify();
+		pModel->SetupPropertiesForShapes();
+	}
 
-						MakeNameUnique( names, str );
-					}
+	if (parser.GetEvent() == XmlPullParser::eXmlEventError)
+	{
+		FBTrace( "[BlendShape] failed to read xml library %s - %s (line %d)\n", filename, parser.GetErrorText(), parser.GetErrorLine() );
+		return false;
+	}
 
-					if (idx < 0) idx = pGeometry->ShapeAdd( str.c_str() );
-					
-					difElement = shapeElement->FirstChildElement( "Diff" );
-
-					int OriIndex=0;
-					double posX=0.0;
-					double posY=0.0;
-					double posZ=0.0;
-					double norX=0.0;
-					double norY=0.0;
-					double norZ=0.0;
-
-					pGeometry->ShapeInit(idx, numberOfDiffs, true);
-					for (int j=0; j<numberOfDiffs; ++j)
-					{
-						// enumerate attribs
-						for( attrib = difElement->FirstAttribute();
-							 attrib;
-							 attrib = attrib->Next() )
-						{
-							const char * attribName = attrib->Name();
-							if ( strcmp(attribName, "OriIndex") == 0 )
-								OriIndex = attrib->IntValue();
-							else if ( strcmp(attribName, "PosX") == 0 )
-								posX = attrib->DoubleValue();
-							else if ( strcmp(attribName, "PosY") == 0 )
-								posY = attrib->DoubleValue();
-							else if ( strcmp(attribName, "PosZ") == 0 )
-								posZ = attrib->DoubleValue();
-							else if ( strcmp(attribName, "NorX") == 0 )
-								norX = attrib->DoubleValue();
-							else if ( strcmp(attribName, "NorX") == 0 )
-								norY = attrib->DoubleValue();
-							else if ( strcmp(attribName, "NorX") == 0 )
-								norZ = attrib->DoubleValue();
-						}
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	FBTrace( "[BlendShape] xml library %s is loaded in %.2f ms\n", filename, 
+		std::chrono::duration<double, std::milli>(endTime - startTime).count() );
 
-						pGeometry->ShapeSetDiffPoint( idx, j, OriIndex, FBVertex(posX, posY, posZ), FBNormal(norX, norY, norZ) );
+	return true;
+}
 
-						difElement = difElement->NextSiblingElement();
-					}
-				}
+////////////////////////////////////////////////////////////////////////////////////////////
+//
+bool	Blendshapes_SaveBinary( FBModelList &modelList, const char *filename, const bool halfDeltas, const bool compress )
+{
+	static_assert(sizeof(FBVertex) == 4 * sizeof(float) && sizeof(FBNormal) == 4 * sizeof(float), "library expects 4 floats per diff");
+
+	BlendShapeLibraryWriter	writer( (halfDeltas) ? eBlendShapeDeltaHalf : eBlendShapeDeltaFloat, compress );
+
+	std::vector<int>		oriIndex;
+	std::vector<FBVertex>	posDiff;
+	std::vector<FBNormal>	normalDiff;
+
+	for (int nModel=0; nModel<modelList.GetCount(); ++nModel)
+	{
+		FBModel *pModel = modelList[nModel];
+		FBGeometry *pGeometry = pModel->Geometry;
+
+		writer.AddModel( pModel->LongName );
+
+		const int numberOfShapes = pGeometry->ShapeGetCount();
+		for (int nShape=0; nShape<numberOfShapes; ++nShape)
+		{
+			const int difCount = pGeometry->ShapeGetDiffPointCount(nShape);
 
-				shapeElement = shapeElement->NextSiblingElement();
+			oriIndex.resize(difCount);
+			posDiff.resize(difCount);
+			normalDiff.resize(difCount);
+
+			for (int i=0; i<difCount; ++i)
+			{
+				pGeometry->ShapeGetDiffPoint(nShape, i, oriIndex[i], posDiff[i], normalDiff[i]);
 			}
 
-			//pGeometry->GeometryEnd();
-			pGeometry->ModifyNotify();
+			writer.AddShape( pGeometry->ShapeGetName(nShape), difCount, oriIndex.data(),
+				reinterpret_cast<const float*>(posDiff.data()), reinterpret_cast<const float*>(normalDiff.data()) );
+		}
+	}
 
-			pModel->SetupPropertiesForShapes();
+	return writer.Save(filename);
+}
+
+bool	Blendshapes_LoadBinary( FBModelList &modelList, const char *filename, const FBBlendShapeLoadMode mode )
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	BlendShapeLibrary	library;
+	if (library.Open(filename) == false)
+	{
+		return false;
+	}
+
+	std::vector<int>		oriIndex;
+	std::vector<float>		posDiff;
+	std::vector<float>		normalDiff;
+
+	for (int nModel=0; nModel<library.GetNumberOfModels(); ++nModel)
+	{
+		// shapes of a missing model are never decoded
+		FBModel *pModel = FBFindModelByLabelName( library.GetModelName(nModel) );
+		if (pModel == nullptr)
+			continue;
+
+		FBGeometry *pGeometry = pModel->Geometry;
+
+		if (mode == kFBShapeLoad)
+		{
+			pGeometry->ShapeClearAll();
 		}
 
-		modelElement = modelElement->NextSiblingElement();
+		for (int nShape=0; nShape<library.GetNumberOfShapes(nModel); ++nShape)
+		{
+			std::string str( library.GetShapeName(nModel, nShape) );
+			if (str == "")
+				continue;
+
+			// deltas are checked against the scene model, a library could be made for another topology
+			if (library.DecodeShape(nModel, nShape, pGeometry->VertexCount(), oriIndex, posDiff, normalDiff) == false)
+			{
+				printf( "failed to decode a shape %s\n", str.c_str() );
+				continue;
+			}
+
+			const int idx = FindOrAddShape( pGeometry, str, mode );
+			const int numberOfDiffs = static_cast<int>(oriIndex.size());
+
+			pGeometry->ShapeInit(idx, numberOfDiffs, true);
+			for (int j=0; j<numberOfDiffs; ++j)
+			{
+				const float *pos = &posDiff[4 * j];
+				const float *nor = &normalDiff[4 * j];
+				pGeometry->ShapeSetDiffPoint( idx, j, oriIndex[j], FBVertex(pos[0], pos[1], pos[2]), FBNormal(nor[0], nor[1], nor[2]) );
+			}
+		}
+
+		pGeometry->ModifyNotify();
+		pModel->SetupPropertiesForShapes();
 	}
 
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	FBTrace( "[BlendShape] binary library %s is loaded in %.2f ms\n", filename, 
+		std::chrono::duration<double, std::milli>(endTime - startTime).count() );
+
 	return true;
 }
 
+bool	Blendshapes_IsBinaryFile( const char *filename )
+{
+	const char *ext = strrchr(filename, '.');
+	return (ext != nullptr && _stricmp(ext, BLENDSHAPE_LIBRARY_EXTENSION) == 0);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //
 
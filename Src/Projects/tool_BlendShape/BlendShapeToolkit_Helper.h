@@ -48,6 +48,11 @@ void ModifyGeometryShapes(FBGeometry *pGeometry, bool *checkList, const FBShapeC
 bool	Blendshapes_SaveXML( FBModelList &modelList, const char *filename );
 bool	Blendshapes_LoadXML( FBModelList &modelList, const char *filename, const FBBlendShapeLoadMode mode );
 
+// binary library (*.bsl), deltas in float or half precision, optional zlib compression
+bool	Blendshapes_SaveBinary( FBModelList &modelList, const char *filename, const bool halfDeltas, const bool compress );
+bool	Blendshapes_LoadBinary( FBModelList &modelList, const char *filename, const FBBlendShapeLoadMode mode );
+bool	Blendshapes_IsBinaryFile( const char *filename );
+
 //
 // get in mesh and compute out mesh according to the deformation information in the model
 //
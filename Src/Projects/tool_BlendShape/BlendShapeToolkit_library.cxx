@@ -0,0 +1,500 @@
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// file: BlendShapeToolkit_library.cxx
+//
+//	Author Sergey Solokhin (Neill3d)
+//
+//
+//	GitHub page - https://github.com/Neill3d/MoPlugs
+//	Licensed under BSD 3-Clause - https://github.com/Neill3d/MoPlugs/blob/master/LICENSE
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BlendShapeToolkit_library.h"
+
+#include "zlib.h"
+#include <stdio.h>
+#include <string.h>
+
+struct BlendShapeLibrary::FileHeader
+{
+	char		magic[4];			// BSLB
+	uint32_t	version;
+	uint32_t	numberOfModels;
+	uint32_t	numberOfShapes;
+
+	uint64_t	modelsOffset;
+	uint64_t	shapesOffset;
+	uint64_t	namesOffset;
+	uint64_t	namesSize;
+};
+
+struct BlendShapeLibrary::ModelEntry
+{
+	uint32_t	nameOffset;
+	uint32_t	firstShape;
+	uint32_t	numberOfShapes;
+	uint32_t	reserved;
+};
+
+struct BlendShapeLibrary::ShapeEntry
+{
+	uint32_t	nameOffset;
+	uint32_t	numberOfDiffs;
+	uint32_t	deltaFormat;		// EBlendShapeDeltaFormat
+	uint32_t	compression;		// EBlendShapeCompression
+
+	uint64_t	dataOffset;
+	uint64_t	dataSize;			// size of a block in the file
+	uint64_t	rawSize;			// size of a decompressed block
+};
+
+static_assert(sizeof(BlendShapeLibrary::FileHeader) == 48, "unexpected blendshape library header size");
+static_assert(sizeof(BlendShapeLibrary::ModelEntry) == 16, "unexpected blendshape library model entry size");
+static_assert(sizeof(BlendShapeLibrary::ShapeEntry) == 40, "unexpected blendshape library shape entry size");
+
+namespace
+{
+	const char LIBRARY_MAGIC[4] = { 'B', 'S', 'L', 'B' };
+
+	// denormals are flushed to zero, deltas that small are under a difference threshold anyway
+	uint16_t FloatToHalf(const float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(uint32_t));
+
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x007FFFFF;
+
+		if (exponent <= 0)
+			return static_cast<uint16_t>(sign);
+		if (exponent >= 31)
+			return static_cast<uint16_t>(sign | 0x7C00);
+
+		// round to nearest
+		mantissa += 0x00001000;
+		if (mantissa & 0x00800000)
+		{
+			mantissa = 0;
+			exponent += 1;
+			if (exponent >= 31)
+				return static_cast<uint16_t>(sign | 0x7C00);
+		}
+		return static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+	}
+
+	float HalfToFloat(const uint16_t value)
+	{
+		const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		const uint32_t exponent = (value >> 10) & 0x1F;
+		const uint32_t mantissa = value & 0x3FF;
+
+		uint32_t bits;
+		if (exponent == 0)
+			bits = sign;
+		else if (exponent == 31)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else
+			bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+		float result;
+		memcpy(&result, &bits, sizeof(float));
+		return result;
+	}
+
+	size_t GetDeltaSize(const uint32_t deltaFormat)
+	{
+		return (deltaFormat == eBlendShapeDeltaHalf) ? sizeof(uint16_t) : sizeof(float);
+	}
+
+	// offset and size come from a file, so offset + size is never computed, it could wrap
+	bool IsRangeInside(const uint64_t offset, const uint64_t size, const uint64_t total)
+	{
+		return offset <= total && size <= total - offset;
+	}
+
+	uint64_t GetRawBlockSize(const uint32_t numberOfDiffs, const uint32_t deltaFormat)
+	{
+		return static_cast<uint64_t>(numberOfDiffs) * (sizeof(int32_t) + 6 * GetDeltaSize(deltaFormat));
+	}
+
+	void WriteDelta(unsigned char *&dst, const double value, const uint32_t deltaFormat)
+	{
+		if (deltaFormat == eBlendShapeDeltaHalf)
+		{
+			const uint16_t half = FloatToHalf(static_cast<float>(value));
+			memcpy(dst, &half, sizeof(uint16_t));
+			dst += sizeof(uint16_t);
+		}
+		else
+		{
+			const float f = static_cast<float>(value);
+			memcpy(dst, &f, sizeof(float));
+			dst += sizeof(float);
+		}
+	}
+
+	double ReadDelta(const unsigned char *&src, const uint32_t deltaFormat)
+	{
+		if (deltaFormat == eBlendShapeDeltaHalf)
+		{
+			uint16_t half;
+			memcpy(&half, src, sizeof(uint16_t));
+			src += sizeof(uint16_t);
+			return static_cast<double>(HalfToFloat(half));
+		}
+
+		float f;
+		memcpy(&f, src, sizeof(float));
+		src += sizeof(float);
+		return static_cast<double>(f);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BlendShapeLibraryWriter
+
+BlendShapeLibraryWriter::BlendShapeLibraryWriter(const EBlendShapeDeltaFormat deltaFormat, const bool compress)
+	: mDeltaFormat(deltaFormat)
+	, mCompress(compress)
+{}
+
+uint32_t BlendShapeLibraryWriter::AddName(const char *name)
+{
+	const uint32_t offset = static_cast<uint32_t>(mNames.size());
+	const size_t len = (name) ? strlen(name) : 0;
+
+	mNames.insert(end(mNames), name, name + len);
+	mNames.push_back(0);
+	return offset;
+}
+
+void BlendShapeLibraryWriter::AddModel(const char *name)
+{
+	ModelItem item;
+	item.nameOffset = AddName(name);
+	item.firstShape = static_cast<uint32_t>(mShapes.size());
+	item.numberOfShapes = 0;
+	mModels.push_back(item);
+}
+
+void BlendShapeLibraryWriter::AddShape(const char *name, const int numberOfDiffs, const int *indices, const float *positions, const float *normals)
+{
+	if (mModels.empty())
+		return;
+
+	mShapes.emplace_back();
+	ShapeItem &item = mShapes.back();
+
+	item.nameOffset = AddName(name);
+	item.numberOfDiffs = static_cast<uint32_t>(numberOfDiffs);
+	item.compression = eBlendShapeCompressionNone;
+	item.rawSize = GetRawBlockSize(item.numberOfDiffs, mDeltaFormat);
+
+	std::vector<unsigned char> raw(static_cast<size_t>(item.rawSize));
+	unsigned char *dst = raw.data();
+
+	// indices are mostly sequential, deltas are compressed much better
+	int32_t prevIndex = 0;
+	for (int i = 0; i < numberOfDiffs; ++i)
+	{
+		const int32_t delta = static_cast<int32_t>(indices[i]) - prevIndex;
+		memcpy(dst, &delta, sizeof(int32_t));
+		dst += sizeof(int32_t);
+		prevIndex = static_cast<int32_t>(indices[i]);
+	}
+
+	for (int i = 0; i < numberOfDiffs; ++i)
+		for (int k = 0; k < 3; ++k)
+			WriteDelta(dst, positions[4 * i + k], mDeltaFormat);
+
+	for (int i = 0; i < numberOfDiffs; ++i)
+		for (int k = 0; k < 3; ++k)
+			WriteDelta(dst, normals[4 * i + k], mDeltaFormat);
+
+	if (mCompress && !raw.empty())
+	{
+		uLongf packedSize = compressBound(static_cast<uLong>(raw.size()));
+		item.block.resize(packedSize);
+
+		if (Z_OK == compress2(item.block.data(), &packedSize, raw.data(), static_cast<uLong>(raw.size()), Z_DEFAULT_COMPRESSION)
+			&& packedSize < raw.size())
+		{
+			item.block.resize(packedSize);
+			item.compression = eBlendShapeCompressionZLib;
+		}
+	}
+
+	if (item.compression == eBlendShapeCompressionNone)
+		item.block.swap(raw);
+
+	mModels.back().numberOfShapes += 1;
+}
+
+bool BlendShapeLibraryWriter::Save(const char *filename) const
+{
+	BlendShapeLibrary::FileHeader header;
+	memcpy(header.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+	header.version = BLENDSHAPE_LIBRARY_VERSION;
+	header.numberOfModels = static_cast<uint32_t>(mModels.size());
+	header.numberOfShapes = static_cast<uint32_t>(mShapes.size());
+	header.modelsOffset = sizeof(BlendShapeLibrary::FileHeader);
+	header.shapesOffset = header.modelsOffset + sizeof(BlendShapeLibrary::ModelEntry) * mModels.size();
+	header.namesOffset = header.shapesOffset + sizeof(BlendShapeLibrary::ShapeEntry) * mShapes.size();
+	header.namesSize = mNames.size();
+
+	std::vector<BlendShapeLibrary::ModelEntry> models(mModels.size());
+	for (size_t i = 0; i < mModels.size(); ++i)
+	{
+		models[i].nameOffset = mModels[i].nameOffset;
+		models[i].firstShape = mModels[i].firstShape;
+		models[i].numberOfShapes = mModels[i].numberOfShapes;
+		models[i].reserved = 0;
+	}
+
+	std::vector<BlendShapeLibrary::ShapeEntry> shapes(mShapes.size());
+	uint64_t dataOffset = header.namesOffset + header.namesSize;
+
+	for (size_t i = 0; i < mShapes.size(); ++i)
+	{
+		const ShapeItem &item = mShapes[i];
+
+		shapes[i].nameOffset = item.nameOffset;
+		shapes[i].numberOfDiffs = item.numberOfDiffs;
+		shapes[i].deltaFormat = static_cast<uint32_t>(mDeltaFormat);
+		shapes[i].compression = item.compression;
+		shapes[i].dataOffset = dataOffset;
+		shapes[i].dataSize = item.block.size();
+		shapes[i].rawSize = item.rawSize;
+
+		dataOffset += item.block.size();
+	}
+
+	FILE *fp = nullptr;
+	if (fopen_s(&fp, filename, "wb") != 0 || nullptr == fp)
+	{
+		printf("failed to open %s for writing\n", filename);
+		return false;
+	}
+
+	bool lSuccess = (1 == fwrite(&header, sizeof(header), 1, fp));
+
+	if (lSuccess && !models.empty())
+		lSuccess = (models.size() == fwrite(models.data(), sizeof(BlendShapeLibrary::ModelEntry), models.size(), fp));
+	if (lSuccess && !shapes.empty())
+		lSuccess = (shapes.size() == fwrite(shapes.data(), sizeof(BlendShapeLibrary::ShapeEntry), shapes.size(), fp));
+	if (lSuccess && !mNames.empty())
+		lSuccess = (mNames.size() == fwrite(mNames.data(), sizeof(char), mNames.size(), fp));
+
+	for (auto iter = begin(mShapes); lSuccess && iter != end(mShapes); ++iter)
+	{
+		if (!iter->block.empty())
+			lSuccess = (iter->block.size() == fwrite(iter->block.data(), sizeof(unsigned char), iter->block.size(), fp));
+	}
+
+	fclose(fp);
+	return lSuccess;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BlendShapeLibrary
+
+BlendShapeLibrary::~BlendShapeLibrary()
+{
+	Close();
+}
+
+bool BlendShapeLibrary::Open(const char *filename)
+{
+	Close();
+
+	mFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == mFile)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)))
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const unsigned char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	mSize = static_cast<uint64_t>(fileSize.QuadPart);
+
+	if (nullptr == mData || !Validate())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void BlendShapeLibrary::Close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (INVALID_HANDLE_VALUE != mFile)
+		CloseHandle(mFile);
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+	mSize = 0;
+
+	mHeader = nullptr;
+	mModels = nullptr;
+	mShapes = nullptr;
+	mNames = nullptr;
+}
+
+bool BlendShapeLibrary::Validate()
+{
+	mHeader = reinterpret_cast<const FileHeader*>(mData);
+
+	if (0 != memcmp(mHeader->magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)))
+		return false;
+
+	if (mHeader->version != BLENDSHAPE_LIBRARY_VERSION)
+	{
+		printf("unsupported blendshape library version %u\n", mHeader->version);
+		return false;
+	}
+
+	if (!IsRangeInside(mHeader->modelsOffset, sizeof(ModelEntry) * static_cast<uint64_t>(mHeader->numberOfModels), mSize)
+		|| !IsRangeInside(mHeader->shapesOffset, sizeof(ShapeEntry) * static_cast<uint64_t>(mHeader->numberOfShapes), mSize)
+		|| !IsRangeInside(mHeader->namesOffset, mHeader->namesSize, mSize)
+		|| (mHeader->modelsOffset % 8) != 0 || (mHeader->shapesOffset % 8) != 0)
+		return false;
+
+	// names must be null terminated inside the names block
+	if (mHeader->namesSize == 0 || 0 != mData[mHeader->namesOffset + mHeader->namesSize - 1])
+		return false;
+
+	mModels = reinterpret_cast<const ModelEntry*>(mData + mHeader->modelsOffset);
+	mShapes = reinterpret_cast<const ShapeEntry*>(mData + mHeader->shapesOffset);
+	mNames = reinterpret_cast<const char*>(mData + mHeader->namesOffset);
+
+	for (uint32_t i = 0; i < mHeader->numberOfModels; ++i)
+	{
+		const ModelEntry &model = mModels[i];
+		if (model.nameOffset >= mHeader->namesSize
+			|| static_cast<uint64_t>(model.firstShape) + model.numberOfShapes > mHeader->numberOfShapes)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < mHeader->numberOfShapes; ++i)
+	{
+		const ShapeEntry &shape = mShapes[i];
+		if (shape.nameOffset >= mHeader->namesSize
+			|| shape.deltaFormat > eBlendShapeDeltaHalf
+			|| !IsRangeInside(shape.dataOffset, shape.dataSize, mSize)
+			|| shape.rawSize != GetRawBlockSize(shape.numberOfDiffs, shape.deltaFormat))
+			return false;
+	}
+
+	return true;
+}
+
+int BlendShapeLibrary::GetNumberOfModels() const
+{
+	return (mHeader) ? static_cast<int>(mHeader->numberOfModels) : 0;
+}
+
+const char *BlendShapeLibrary::GetModelName(const int model) const
+{
+	return mNames + mModels[model].nameOffset;
+}
+
+int BlendShapeLibrary::GetNumberOfShapes(const int model) const
+{
+	return static_cast<int>(mModels[model].numberOfShapes);
+}
+
+const BlendShapeLibrary::ShapeEntry *BlendShapeLibrary::GetShapeEntry(const int model, const int shape) const
+{
+	return &mShapes[mModels[model].firstShape + shape];
+}
+
+const char *BlendShapeLibrary::GetShapeName(const int model, const int shape) const
+{
+	return mNames + GetShapeEntry(model, shape)->nameOffset;
+}
+
+int BlendShapeLibrary::GetNumberOfDiffs(const int model, const int shape) const
+{
+	return static_cast<int>(GetShapeEntry(model, shape)->numberOfDiffs);
+}
+
+bool BlendShapeLibrary::DecodeShape(const int model, const int shape, const int numberOfVertices, std::vector<int> &indices, std::vector<float> &positions, std::vector<float> &normals) const
+{
+	const ShapeEntry *entry = GetShapeEntry(model, shape);
+	const unsigned char *src = mData + entry->dataOffset;
+
+	std::vector<unsigned char> unpacked;
+
+	if (entry->compression == eBlendShapeCompressionZLib)
+	{
+		unpacked.resize(static_cast<size_t>(entry->rawSize));
+		uLongf unpackedSize = static_cast<uLongf>(entry->rawSize);
+
+		if (Z_OK != uncompress(unpacked.data(), &unpackedSize, src, static_cast<uLong>(entry->dataSize))
+			|| unpackedSize != entry->rawSize)
+		{
+			return false;
+		}
+		src = unpacked.data();
+	}
+	else if (entry->compression != eBlendShapeCompressionNone || entry->dataSize != entry->rawSize)
+	{
+		return false;
+	}
+
+	const int numberOfDiffs = static_cast<int>(entry->numberOfDiffs);
+	indices.resize(numberOfDiffs);
+	positions.resize(4 * static_cast<size_t>(numberOfDiffs));
+	normals.resize(4 * static_cast<size_t>(numberOfDiffs));
+
+	int32_t index = 0;
+	for (int i = 0; i < numberOfDiffs; ++i)
+	{
+		int32_t delta;
+		memcpy(&delta, src, sizeof(int32_t));
+		src += sizeof(int32_t);
+
+		// accumulate in 64 bits, a corrupted delta must not wrap back into the valid range
+		const int64_t nextIndex = static_cast<int64_t>(index) + delta;
+		if (nextIndex < 0 || nextIndex >= numberOfVertices)
+			return false;
+
+		index = static_cast<int32_t>(nextIndex);
+		indices[i] = index;
+	}
+
+	for (int i = 0; i < numberOfDiffs; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+			positions[4 * i + k] = static_cast<float>(ReadDelta(src, entry->deltaFormat));
+		positions[4 * i + 3] = 0.0f;
+	}
+
+	for (int i = 0; i < numberOfDiffs; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+			normals[4 * i + k] = static_cast<float>(ReadDelta(src, entry->deltaFormat));
+		normals[4 * i + 3] = 0.0f;
+	}
+
+	return true;
+}
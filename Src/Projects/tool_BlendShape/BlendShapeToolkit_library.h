@@ -0,0 +1,136 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// file: BlendShapeToolkit_library.h
+//
+//	Author Sergey Solokhin (Neill3d)
+//
+//
+//	GitHub page - https://github.com/Neill3d/MoPlugs
+//	Licensed under BSD 3-Clause - https://github.com/Neill3d/MoPlugs/blob/master/LICENSE
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <windows.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#define BLENDSHAPE_LIBRARY_VERSION		1
+#define BLENDSHAPE_LIBRARY_EXTENSION	".bsl"
+
+/*
+	binary blendshape library (*.bsl)
+
+	[header][model table][shape table][names][shape blocks]
+
+	every shape block is a sparse list of vertex indices (delta encoded) followed by position and normal deltas
+	 in float or half precision, a block could be compressed with zlib.
+	File is memory-mapped on load and a shape block is decoded only when it's requested.
+
+	Library has no sdk dependencies, positions and normals are passed as 4 floats per diff (FBVertex, FBNormal layout)
+*/
+
+enum EBlendShapeDeltaFormat
+{
+	eBlendShapeDeltaFloat = 0,
+	eBlendShapeDeltaHalf = 1
+};
+
+enum EBlendShapeCompression
+{
+	eBlendShapeCompressionNone = 0,
+	eBlendShapeCompressionZLib = 1
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BlendShapeLibraryWriter
+
+class BlendShapeLibraryWriter
+{
+public:
+
+	//! a constructor
+	BlendShapeLibraryWriter(const EBlendShapeDeltaFormat deltaFormat, const bool compress);
+
+	void AddModel(const char *name);
+
+	//! add a shape to the last added model
+	void AddShape(const char *name, const int numberOfDiffs, const int *indices, const float *positions, const float *normals);
+
+	bool Save(const char *filename) const;
+
+protected:
+
+	struct ModelItem
+	{
+		uint32_t		nameOffset;
+		uint32_t		firstShape;
+		uint32_t		numberOfShapes;
+	};
+
+	struct ShapeItem
+	{
+		uint32_t					nameOffset;
+		uint32_t					numberOfDiffs;
+		uint32_t					compression;
+		uint64_t					rawSize;
+		std::vector<unsigned char>	block;
+	};
+
+	EBlendShapeDeltaFormat		mDeltaFormat;
+	bool						mCompress;
+
+	std::vector<ModelItem>		mModels;
+	std::vector<ShapeItem>		mShapes;
+	std::vector<char>			mNames;
+
+	uint32_t AddName(const char *name);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BlendShapeLibrary
+
+class BlendShapeLibrary
+{
+public:
+
+	//! a destructor
+	~BlendShapeLibrary();
+
+	bool Open(const char *filename);
+	void Close();
+
+	bool IsOpen() const { return nullptr != mData; }
+
+	int GetNumberOfModels() const;
+	const char *GetModelName(const int model) const;
+
+	int GetNumberOfShapes(const int model) const;
+	const char *GetShapeName(const int model, const int shape) const;
+	int GetNumberOfDiffs(const int model, const int shape) const;
+
+	//! decode one shape block, returns false for a corrupted block or an index outside of [0; numberOfVertices)
+	bool DecodeShape(const int model, const int shape, const int numberOfVertices, std::vector<int> &indices, std::vector<float> &positions, std::vector<float> &normals) const;
+
+	struct FileHeader;
+	struct ModelEntry;
+	struct ShapeEntry;
+
+protected:
+
+	HANDLE					mFile{ INVALID_HANDLE_VALUE };
+	HANDLE					mMapping{ nullptr };
+
+	const unsigned char		*mData{ nullptr };
+	uint64_t				mSize{ 0 };
+
+	const FileHeader		*mHeader{ nullptr };
+	const ModelEntry		*mModels{ nullptr };
+	const ShapeEntry		*mShapes{ nullptr };
+	const char				*mNames{ nullptr };
+
+	bool Validate();
+	const ShapeEntry *GetShapeEntry(const int model, const int shape) const;
+};
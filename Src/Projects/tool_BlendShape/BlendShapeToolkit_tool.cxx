@@ -1526,7 +1526,8 @@ void ORTool_BlendShape::EventButtonLoadClick( HISender pSender, HKEvent pEvent )
 
 	FBFilePopup	lPopup;
 	lPopup.Caption = "Choose a file for loading blendshapes";
-	lPopup.FileName = "*.xml";
+	lPopup.Filter = "*.bsl;*.xml";
+	lPopup.FileName = "*.bsl";
 	lPopup.Style.SetPropertyValue(kFBFilePopupOpen);
 
 	if (lPopup.Execute() )
@@ -1542,7 +1543,10 @@ void ORTool_BlendShape::EventButtonLoadClick( HISender pSender, HKEvent pEvent )
 
 		if (modelList.GetCount() )
 		{
-			Blendshapes_LoadXML( modelList, fullFileName, (FBBlendShapeLoadMode) mode );
+			if (Blendshapes_IsBinaryFile(fullFileName) )
+				Blendshapes_LoadBinary( modelList, fullFileName, (FBBlendShapeLoadMode) mode );
+			else
+				Blendshapes_LoadXML( modelList, fullFileName, (FBBlendShapeLoadMode) mode );
 			UpdateBlendShapesView(true);
 		}
 		else
@@ -1559,7 +1563,8 @@ void ORTool_BlendShape::EventButtonSaveClick( HISender pSender, HKEvent pEvent )
 	//
 	FBFilePopup	lPopup;
 	lPopup.Caption = "Choose a file for saving blendshapes";
-	lPopup.FileName = "*.xml";
+	lPopup.Filter = "*.bsl;*.xml";
+	lPopup.FileName = "*.bsl";
 	lPopup.Style.SetPropertyValue(kFBFilePopupSave);
 
 	if (lPopup.Execute() )
@@ -1575,7 +1580,16 @@ void ORTool_BlendShape::EventButtonSaveClick( HISender pSender, HKEvent pEvent )
 
 		if (modelList.GetCount() )
 		{
-			Blendshapes_SaveXML( modelList, fullFileName );
+			if (Blendshapes_IsBinaryFile(fullFileName) )
+			{
+				// xml stays as an interchange format, binary library is compressed and could keep deltas in half precision
+				const int precision = FBMessageBox( szTitle, "Choose a precision of stored deltas", "Float", "Half" );
+				Blendshapes_SaveBinary( modelList, fullFileName, (precision == 2), true );
+			}
+			else
+			{
+				Blendshapes_SaveXML( modelList, fullFileName );
+			}
 		}
 		else
 		{